@@ -22,6 +22,12 @@ HEADERS += \
 	basicMath.h \
 	canvas.h \
 	datasetManager.h \
+	sampleMatrix.h \
+	mappedFile.h \
+	binaryDataset.h \
+	datasetStream.h \
+	parallel.h \
+	streamIntegrator.h \
 	optimization_test_functions.h \
 	gettimeofday.h \
 	drawUtils.h \
@@ -48,6 +54,13 @@ HEADERS += \
     dataImporter.h \
     contours.h \
     qcontour.h \
+    marchingSquares.h \
+    densitySplat.h \
+    sampleGrid.h \
+    pathLod.h \
+    bayesianOptimizer.h \
+    foldIndex.h \
+    gramCache.h \
     animationlabel.h \
     reinforcementProblem.h \
     kmeans.h \
@@ -57,6 +70,10 @@ HEADERS += \
 SOURCES += \
 	canvas.cpp \
 	datasetManager.cpp \
+	sampleMatrix.cpp \
+	mappedFile.cpp \
+	datasetStream.cpp \
+	streamIntegrator.cpp \
 	drawUtils.cpp \
 	drawSVG.cpp \
 	drawTimer.cpp \
@@ -69,6 +86,13 @@ SOURCES += \
     dataImporter.cpp \
     contours.cpp \
     qcontour.cpp \
+    marchingSquares.cpp \
+    densitySplat.cpp \
+    sampleGrid.cpp \
+    pathLod.cpp \
+    bayesianOptimizer.cpp \
+    foldIndex.cpp \
+    gramCache.cpp \
     animationlabel.cpp \
     reinforcementProblem.cpp \
     kmeans.cpp \
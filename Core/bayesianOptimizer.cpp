@@ -0,0 +1,268 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#include "bayesianOptimizer.h"
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+// observations below which the proposals are drawn at random
+const int surrogateMinPoints = 2;
+// improvement (in standard deviations of the values) below which a candidate is not worth it
+const double surrogateMinImprovement = 0.01;
+
+static double squaredDistance(const fvec &a, const fvec &b)
+{
+    double d = 0;
+    FOR(i, a.size()) d += (a[i]-b[i])*(a[i]-b[i]);
+    return d;
+}
+
+// factorizes K + noise I for the given hyperparameters and solves for the standardized values
+// returns the log marginal likelihood (up to a constant), -HUGE_VAL when the matrix is not positive definite
+static double factorize(SurrogateFit &fit, const dvec &y, const double lengthScale, const double noise)
+{
+    int n = fit.points.size();
+    fit.lengthScale = lengthScale;
+    fit.noise = noise;
+    dvec &L = fit.cholesky;
+    L.assign((size_t)n*n, 0.);
+    double g = -0.5 / (lengthScale*lengthScale);
+    FOR(i, n)
+    {
+        FOR(j, i+1)
+        {
+            double sum = exp(g*squaredDistance(fit.points[i], fit.points[j])) + (i == j ? noise : 0.);
+            for(u32 k=0; k<j; k++) sum -= L[i*n+k]*L[j*n+k];
+            if(i == j)
+            {
+                if(sum <= 0) return -HUGE_VAL;
+                L[i*n+i] = sqrt(sum);
+            }
+            else L[i*n+j] = sum / L[j*n+j];
+        }
+    }
+    // alpha = L^-T L^-1 y
+    dvec &alpha = fit.alpha;
+    alpha = y;
+    FOR(i, n)
+    {
+        for(u32 k=0; k<i; k++) alpha[i] -= L[i*n+k]*alpha[k];
+        alpha[i] /= L[i*n+i];
+    }
+    double fitTerm = 0, logDet = 0;
+    FOR(i, n)
+    {
+        fitTerm += alpha[i]*alpha[i];
+        logDet += log(L[i*n+i]);
+    }
+    for(int i=n-1; i>=0; i--)
+    {
+        for(int k=i+1; k<n; k++) alpha[i] -= L[k*n+i]*alpha[k];
+        alpha[i] /= L[i*n+i];
+    }
+    return -0.5*fitTerm - logDet;
+}
+
+// standardized mean and variance of the surrogate at point
+static void predict(const SurrogateFit &fit, const fvec &point, double &mean, double &variance)
+{
+    int n = fit.points.size();
+    double g = -0.5 / (fit.lengthScale*fit.lengthScale);
+    dvec k(n);
+    mean = 0;
+    FOR(i, n)
+    {
+        k[i] = exp(g*squaredDistance(fit.points[i], point));
+        mean += k[i]*fit.alpha[i];
+    }
+    // v = L^-1 k, the variance is what the observations do not explain
+    const dvec &L = fit.cholesky;
+    variance = 1.;
+    FOR(i, n)
+    {
+        for(u32 j=0; j<i; j++) k[i] -= L[i*n+j]*k[j];
+        k[i] /= L[i*n+i];
+        variance -= k[i]*k[i];
+    }
+    variance = max(variance, 1e-12);
+}
+
+static dvec standardize(const fvec &values, double &offset, double &scale)
+{
+    int n = values.size();
+    offset = 0;
+    FOR(i, n) offset += values[i];
+    offset = n ? offset / n : 0;
+    double variance = 0;
+    FOR(i, n) variance += (values[i]-offset)*(values[i]-offset);
+    scale = n > 1 ? sqrt(variance / (n-1)) : 0;
+    if(scale < 1e-12) scale = 1;
+    dvec y(n);
+    FOR(i, n) y[i] = (values[i]-offset) / scale;
+    return y;
+}
+
+BayesianOptimizer::BayesianOptimizer(const ivec &levels, const unsigned int seed)
+    : levels(levels), bFitted(false), rng(seed)
+{}
+
+int BayesianOptimizer::Best() const
+{
+    if(!values.size()) return -1;
+    return min_element(values.begin(), values.end()) - values.begin();
+}
+
+fvec BayesianOptimizer::Snap(const fvec &point) const
+{
+    fvec snapped = point;
+    FOR(d, levels.size())
+    {
+        float u = min(1.f, max(0.f, point[d]));
+        if(levels[d] > 0)
+        {
+            int level = min(levels[d]-1, (int)(u*levels[d]));
+            u = (level + 0.5f) / levels[d];
+        }
+        snapped[d] = u;
+    }
+    return snapped;
+}
+
+vector<fvec> BayesianOptimizer::InitialDesign(const int count)
+{
+    vector<fvec> design(max(0, count), fvec(Dim()));
+    uniform_real_distribution<float> uniform(0.f, 1.f);
+    ivec strata(design.size());
+    FOR(d, Dim())
+    {
+        FOR(i, strata.size()) strata[i] = i;
+        shuffle(strata.begin(), strata.end(), rng);
+        FOR(i, design.size()) design[i][d] = (strata[i] + uniform(rng)) / design.size();
+    }
+    FOR(i, design.size()) design[i] = Snap(design[i]);
+    return design;
+}
+
+void BayesianOptimizer::AddObservation(const fvec &point, const float value)
+{
+    points.push_back(Snap(point));
+    values.push_back(value);
+    bFitted = false;
+}
+
+void BayesianOptimizer::Fit()
+{
+    bFitted = true;
+    model = SurrogateFit();
+    model.points = points;
+    if(!points.size()) return;
+    dvec y = standardize(values, model.offset, model.scale);
+    // distances in the unit hypercube grow with the square root of the dimension
+    const double lengthScales[] = {0.05, 0.1, 0.2, 0.35, 0.6, 1.0};
+    const double noises[] = {1e-4, 1e-2, 1e-1};
+    double diameter = sqrt((double)max(1, Dim()));
+    double bestLikelihood = -HUGE_VAL, bestScale = 0.35*diameter, bestNoise = 1e-1;
+    FOR(i, sizeof(lengthScales)/sizeof(double))
+    {
+        FOR(j, sizeof(noises)/sizeof(double))
+        {
+            double likelihood = factorize(model, y, lengthScales[i]*diameter, noises[j]);
+            if(likelihood <= bestLikelihood) continue;
+            bestLikelihood = likelihood;
+            bestScale = lengthScales[i]*diameter;
+            bestNoise = noises[j];
+        }
+    }
+    factorize(model, y, bestScale, bestNoise);
+}
+
+float BayesianOptimizer::Mean(const fvec &point)
+{
+    if(!bFitted) Fit();
+    if(!model.points.size()) return 0.f;
+    double mean, variance;
+    predict(model, Snap(point), mean, variance);
+    return (float)(mean*model.scale + model.offset);
+}
+
+fvec BayesianOptimizer::Propose(const vector<fvec> &pending, const int candidateCount)
+{
+    uniform_real_distribution<float> uniform(0.f, 1.f);
+    fvec random(Dim());
+    FOR(d, Dim()) random[d] = uniform(rng);
+    random = Snap(random);
+    if(Count() < surrogateMinPoints) return random;
+    if(!bFitted) Fit();
+
+    // the pending points are added with the value the surrogate expects from them
+    SurrogateFit fit = model;
+    dvec y(Count());
+    FOR(i, Count()) y[i] = (values[i] - model.offset) / model.scale;
+    double best = *min_element(y.begin(), y.end());
+    FOR(i, pending.size())
+    {
+        double mean, variance;
+        fvec point = Snap(pending[i]);
+        predict(fit, point, mean, variance);
+        fit.points.push_back(point);
+        y.push_back(mean);
+    }
+    if(pending.size() && factorize(fit, y, model.lengthScale, model.noise) == -HUGE_VAL) fit = model;
+
+    // half of the candidates are drawn anywhere, the others around the best points so far
+    ivec order(Count());
+    FOR(i, order.size()) order[i] = i;
+    sort(order.begin(), order.end(), [&](int a, int b){return values[a] < values[b];});
+    int neighbours = min(5, Count());
+    normal_distribution<float> normal(0.f, 1.f);
+    fvec bestCandidate = random;
+    double bestImprovement = -1;
+    FOR(c, candidateCount)
+    {
+        fvec candidate(Dim());
+        if(c < candidateCount/2) FOR(d, Dim()) candidate[d] = uniform(rng);
+        else
+        {
+            const fvec &center = points[order[c % neighbours]];
+            float spread = c % 2 ? 0.02f : 0.1f;
+            FOR(d, Dim()) candidate[d] = center[d] + spread*normal(rng);
+        }
+        candidate = Snap(candidate);
+        double mean, variance;
+        predict(fit, candidate, mean, variance);
+        double sigma = sqrt(variance);
+        double gain = best - surrogateMinImprovement - mean;
+        double z = gain / sigma;
+        double improvement = gain*0.5*erfc(-z/sqrt(2.)) + sigma*exp(-0.5*z*z)/sqrt(2*M_PI);
+        if(improvement <= bestImprovement) continue;
+        // points already evaluated (or being evaluated) can only come back on discrete dimensions
+        bool bKnown = false;
+        FOR(i, fit.points.size())
+        {
+            if(squaredDistance(fit.points[i], candidate) >= 1e-10) continue;
+            bKnown = true;
+            break;
+        }
+        if(bKnown) continue;
+        bestImprovement = improvement;
+        bestCandidate = candidate;
+    }
+    return bestCandidate;
+}
@@ -0,0 +1,76 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#ifndef _BAYESIAN_OPTIMIZER_H_
+#define _BAYESIAN_OPTIMIZER_H_
+
+#include <vector>
+#include <random>
+#include "types.h"
+
+// gaussian process fitted to a set of points, with the values standardized
+struct SurrogateFit
+{
+    std::vector<fvec> points;
+    dvec alpha; // (K + noise I)^-1 y
+    dvec cholesky; // lower triangle of K + noise I, row by row
+    double lengthScale, noise;
+    double offset, scale; // mean and deviation of the values
+    SurrogateFit() : lengthScale(1), noise(1e-2), offset(0), scale(1){}
+};
+
+// sequential model-based minimization of a function over the unit hypercube
+// a gaussian process (squared exponential kernel, length scale and noise picked by marginal likelihood)
+// models the values observed so far, and the next point is the one with the largest expected improvement.
+// Dimensions with a number of levels are discrete: their coordinates are snapped to the center
+// of one of levels equal bins, which is also what the surrogate sees.
+// Points still being evaluated are given the value the surrogate predicts for them (the kriging believer)
+// so that several points can be proposed before the first ones come back
+class BayesianOptimizer
+{
+    ivec levels; // 0 for continuous dimensions
+    std::vector<fvec> points;
+    fvec values;
+    SurrogateFit model;
+    bool bFitted;
+    std::mt19937 rng;
+
+public:
+    BayesianOptimizer(const ivec &levels, const unsigned int seed=0);
+
+    int Dim() const {return levels.size();}
+    int Count() const {return values.size();}
+    const fvec &Point(const int i) const {return points[i];}
+    float Value(const int i) const {return values[i];}
+    int Best() const; // index of the lowest value, -1 when there is none
+
+    fvec Snap(const fvec &point) const;
+    // latin hypercube over the unit hypercube
+    std::vector<fvec> InitialDesign(const int count);
+
+    void AddObservation(const fvec &point, const float value);
+    // refits the surrogate to the observations
+    void Fit();
+    // surrogate mean at point, in the units of the values
+    float Mean(const fvec &point);
+
+    // the point to evaluate next, given the ones being evaluated already
+    fvec Propose(const std::vector<fvec> &pending=std::vector<fvec>(), const int candidateCount=2048);
+};
+
+#endif // _BAYESIAN_OPTIMIZER_H_
@@ -0,0 +1,69 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#ifndef _BINARY_DATASET_H_
+#define _BINARY_DATASET_H_
+
+#include <stdint.h>
+#include "sampleMatrix.h"
+
+// layout of the binary .ml files: a fixed header, a table of sections, then each section starting on a
+// SAMPLE_ALIGNMENT boundary so that the sample block can be used in place from a mapped file.
+// all values are stored in the native (little-endian) byte order, checked through endianTag.
+static const char binaryMagic[8] = {'M','L','D','E','M','O','S','B'};
+static const uint32_t binaryVersion = 1;
+static const uint32_t binaryEndianTag = 0x01020304;
+
+enum BinarySection
+{
+	BIN_SAMPLES = 1,
+	BIN_LABELS,
+	BIN_FLAGS,
+	BIN_SEQUENCES,
+	BIN_OBSTACLES,
+	BIN_REWARDS,
+	BIN_TIMESERIES,
+	BIN_CATEGORICAL
+};
+
+struct BinaryHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t endianTag;
+	uint32_t sampleCount;
+	uint32_t dim;
+	uint32_t sectionCount;
+	uint32_t reserved;
+	uint64_t payloadSize; // the text parameters of the interface are appended after the payload
+};
+
+struct BinarySectionEntry
+{
+	uint32_t type;
+	uint32_t reserved;
+	uint64_t offset;
+	uint64_t size;
+};
+
+static inline uint64_t AlignOffset(const uint64_t offset)
+{
+	return (offset + SAMPLE_ALIGNMENT - 1) / SAMPLE_ALIGNMENT * SAMPLE_ALIGNMENT;
+}
+
+#endif // _BINARY_DATASET_H_
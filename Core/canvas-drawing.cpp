@@ -30,6 +30,7 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 
 #include "expose.h"
 #include "public.h"
+#include "densitySplat.h"
 #include "basicMath.h"
 #include "canvas.h"
 #include "drawUtils.h"
@@ -63,7 +64,7 @@ void Canvas::Clear()
 void Canvas::PaintBufferedCanvas(QPainter &painter, bool bSvg)
 {
     bool bHighDPI = qApp->devicePixelRatio() > 1;
-    if(bHighDPI && data->GetSamples().size() > 0 && data->GetSamples().size() < 250) {
+    if(bHighDPI && data->GetCount() > 0 && data->GetCount() < 250) {
         PaintSequentialCanvas(painter, bSvg);
         return;
     }
@@ -686,6 +687,17 @@ void Canvas::RedrawAxes()
 void Canvas::DrawSamples(QPainter &painter)
 {
     int radius = 10;
+    if(data->GetCount() > sampleGlyphLimit)
+    {
+        ivec slots(data->GetCount(), 0);
+        if(!bDisplaySingle) FOR(i, slots.size()) slots[i] = SampleSlot(data->GetLabel(i));
+        QImage density = SampleDensity(slots, SamplePalette());
+        if(!density.isNull())
+        {
+            painter.drawImage(0, 0, density);
+            return;
+        }
+    }
     for(int i=0; i<data->GetCount(); i++)
     {
         if(data->GetFlag(i) == _TRAJ) continue;
@@ -698,6 +710,22 @@ void Canvas::DrawSamples(QPainter &painter)
 void Canvas::DrawSampleColors(QPainter &painter)
 {
     int radius = 10;
+    if(data->GetCount() > sampleGlyphLimit && sampleColors.size() >= (size_t)data->GetCount())
+    {
+        ivec slots(data->GetCount());
+        std::vector<QRgb> palette(data->GetCount());
+        FOR(i, slots.size())
+        {
+            slots[i] = i;
+            palette[i] = sampleColors[i].rgb();
+        }
+        QImage density = SampleDensity(slots, palette);
+        if(!density.isNull())
+        {
+            painter.drawImage(0, 0, density);
+            return;
+        }
+    }
     for(int i=0; i<data->GetCount(); i++)
     {
         if(i >= sampleColors.size()) continue;
@@ -724,6 +752,17 @@ void Canvas::DrawSamples()
     if(!maps.samples.isNull() && drawnSamples == data->GetCount()) return;
     if(drawnSamples > data->GetCount()) drawnSamples = 0;
 
+    // large datasets are redrawn entirely as a density map, going back to glyphs redraws them all as well
+    QImage density;
+    if(data->GetCount() > sampleGlyphLimit)
+    {
+        ivec slots(data->GetCount(), 0);
+        if(!bDisplaySingle) FOR(i, slots.size()) slots[i] = SampleSlot(data->GetLabel(i));
+        density = SampleDensity(slots, SamplePalette());
+    }
+    if(!density.isNull() || bDensitySamples) drawnSamples = 0;
+    bDensitySamples = !density.isNull();
+
     if(drawnSamples==0 || maps.samples.isNull())
     {
         int w = width();
@@ -733,6 +772,12 @@ void Canvas::DrawSamples()
         drawnSamples = 0;
     }
     QPainter painter(&maps.samples);
+    if(bDensitySamples)
+    {
+        painter.drawImage(0, 0, density);
+        drawnSamples = data->GetCount();
+        return;
+    }
     painter.setRenderHint(QPainter::Antialiasing, true);
     for(int i=drawnSamples; i<data->GetCount(); i++)
     {
@@ -746,6 +791,37 @@ void Canvas::DrawSamples()
     drawnSamples = data->GetCount();
 }
 
+std::vector<QRgb> Canvas::SamplePalette()
+{
+    std::vector<QRgb> palette(SampleColorCnt+1);
+    FOR(i, SampleColorCnt) palette[i] = SampleColor[i].rgb();
+    palette[SampleColorCnt] = qRgb(0,0,0);
+    return palette;
+}
+
+// density map of the samples, or a null image when few enough of them are on the canvas to be drawn one by one
+// slots[i] is the entry of palette used for sample i
+QImage Canvas::SampleDensity(const ivec &slots, const std::vector<QRgb> &palette)
+{
+    int dim = data->GetDimCount();
+    if(data->GetCount() <= sampleGlyphLimit || xIndex >= dim || yIndex >= dim) return QImage();
+    int w = width(), h = height();
+    // the same transform as toCanvasCoords
+    float sx = zoom*zooms[xIndex]*h, sy = zoom*zooms[yIndex]*h;
+    float ox = w/2 - center[xIndex]*sx, oy = h - h/2 + center[yIndex]*sy;
+    if(xIndex == yIndex) // as DrawSamples does, the samples lie on the middle line
+    {
+        sy = 0;
+        oy = h/2;
+    }
+    const std::vector<dsmFlags> &flags = data->GetFlags();
+    bvec mask(data->GetCount(), true);
+    FOR(i, min(mask.size(), flags.size())) mask[i] = flags[i] != _TRAJ;
+    DensitySplat splat(w, h);
+    if(splat.Project(data->GetSampleView(), xIndex, yIndex, sx, ox, -sy, oy, mask) <= sampleGlyphLimit) return QImage();
+    return splat.Render(slots, palette);
+}
+
 void Canvas::DrawTargets(QPainter &painter)
 {
     painter.setBrush(Qt::NoBrush);
@@ -976,30 +1052,69 @@ void Canvas::DrawTrajectories(QPainter &painter)
     }
 
     // let's draw the trajectories
+    vector<ivec> &lod = TrajectoryLod(0);
+    lod.resize(max(lod.size(), trajectories.size()*2));
     FOR(i, trajectories.size())
     {
-        fvec oldPt = trajectories[i][0];
-        int count = trajectories[i].size();
-        int label = trajLabels[i];
-        FOR(j, count-1)
-        {
-            fvec pt = trajectories[i][j+1];
-            painter.setPen(QPen(Qt::black, 0.5));
-            painter.drawLine(toCanvasCoords(pt), toCanvasCoords(oldPt));
-            if(j<count-2) Canvas::drawSample(painter, toCanvasCoords(pt), 5, bDisplaySingle ? 0 : label);
-            oldPt = pt;
-        }
+        // the trajectory being drawn changes at every frame, there is no point in caching it
+        bool bFinished = i < sequences.size()-1 || !bDrawing;
+        DrawTrajectory(painter, trajectories[i], trajLabels[i], bFinished ? &lod[i*2] : 0, bFinished ? &lod[i*2+1] : 0);
         painter.setBrush(Qt::NoBrush);
         painter.setPen(Qt::green);
         painter.drawEllipse(toCanvasCoords(trajectories[i][0]), 5, 5);
         if(!bDrawing)
         {
             painter.setPen(Qt::red);
-            painter.drawEllipse(toCanvasCoords(trajectories[i][count-1]), 5, 5);
+            painter.drawEllipse(toCanvasCoords(trajectories[i].back()), 5, 5);
         }
     }
 }
 
+vector<ivec> &Canvas::TrajectoryLod(const int mode)
+{
+    ivec variant(6);
+    variant[0] = mode;
+    variant[1] = xIndex;
+    variant[2] = yIndex;
+    variant[3] = trajectoryResampleType;
+    variant[4] = trajectoryResampleCount;
+    variant[5] = trajectoryCenterType;
+    return trajectoryLod.Paths(data->GetID(), data->GetRevision(), variant,
+                               zoom*zooms[xIndex]*height(), zoom*zooms[yIndex]*height());
+}
+
+void Canvas::DrawTrajectory(QPainter &painter, const vector<fvec> &trajectory, const int label, ivec *vertices, ivec *glyphs)
+{
+    int count = trajectory.size();
+    if(count < 2) return;
+    ivec simplified, thinned;
+    if(!vertices) vertices = &simplified;
+    if(!glyphs) glyphs = &thinned;
+    if(!vertices->size() || !glyphs->size())
+    {
+        // the line only needs to be within half a pixel of the samples, and the glyphs one pixel apart
+        fvec xy(count*2);
+        FOR(j, count)
+        {
+            QPointF point = toCanvasCoords(trajectory[j]);
+            xy[j*2] = point.x();
+            xy[j*2+1] = point.y();
+        }
+        *vertices = SimplifyPolyline(xy, 0.5f);
+        *glyphs = ThinPolyline(xy, 1.f);
+    }
+    QPolygonF line(vertices->size());
+    FOR(j, vertices->size()) line[j] = toCanvasCoords(trajectory[(*vertices)[j]]);
+    painter.setPen(QPen(Qt::black, 0.5));
+    painter.setBrush(Qt::NoBrush);
+    painter.drawPolyline(line);
+    // the first and last samples get a circle instead
+    for(int j=1; j<(int)glyphs->size()-1; j++)
+    {
+        Canvas::drawSample(painter, toCanvasCoords(trajectory[(*glyphs)[j]]), 5, bDisplaySingle ? 0 : label);
+    }
+}
+
 void Canvas::DrawTrajectories()
 {
     int w = width();
@@ -1062,27 +1177,19 @@ void Canvas::DrawTrajectories()
         if(trajectory.size()) trajectories.push_back(trajectory);
     }
     // let's draw the trajectories
+    vector<ivec> &lod = TrajectoryLod(1);
+    lod.resize(max(lod.size(), trajectories.size()*2));
     for(int i=drawnTrajectories; i<trajectories.size(); i++)
     {
-        fvec oldPt = trajectories[i][0];
-        int count = trajectories[i].size();
-        int label = trajLabels[i];
-        FOR(j, count-1)
-        {
-            fvec pt = trajectories[i][j+1];
-            painter.setPen(QPen(Qt::black, 0.5));
-            QPointF point = toCanvasCoords(pt);
-            painter.drawLine(point, toCanvasCoords(oldPt));
-            if(j<count-2) Canvas::drawSample(painter, point, 5, bDisplaySingle ? 0 : label);
-            oldPt = pt;
-        }
+        bool bFinished = i < data->GetSequences().size();
+        DrawTrajectory(painter, trajectories[i], trajLabels[i], bFinished ? &lod[i*2] : 0, bFinished ? &lod[i*2+1] : 0);
         painter.setBrush(Qt::NoBrush);
         painter.setPen(Qt::green);
         painter.drawEllipse(toCanvasCoords(trajectories[i][0]), 5, 5);
         if(!bDrawing)
         {
             painter.setPen(Qt::red);
-            painter.drawEllipse(toCanvasCoords(trajectories[i][count-1]), 5, 5);
+            painter.drawEllipse(toCanvasCoords(trajectories[i].back()), 5, 5);
         }
     }
     drawnTrajectories = !bDrawing ? sequences.size() : sequences.size()-1;
@@ -1133,7 +1240,7 @@ void Canvas::DrawTimeseries()
         drawnTimeseries = 0;
     }
 
-    vector<TimeSerie> timeseries = data->GetTimeSeries();
+    vector<TimeSerie> &timeseries = data->GetTimeSeries();
     if((!timeseries.size() && drawnTimeseries) || (timeseries.size() == drawnTimeseries)) return;
 
     if(drawnTimeseries > timeseries.size()) drawnTimeseries = 0;
@@ -1141,6 +1248,11 @@ void Canvas::DrawTimeseries()
     QPainter painter(&maps.timeseries);
     painter.setRenderHint(QPainter::Antialiasing);
 
+    // frames of each serie to draw at the current zoom
+    float sx = zoom*zooms[xIndex]*height(), sy = zoom*zooms[yIndex]*height();
+    vector<ivec> &lod = timeseriesLod.Paths(data->GetID(), data->GetRevision(), ivec(1, yIndex), sx, sy);
+    lod.resize(max(lod.size(), timeseries.size()));
+
     //qDebug() << "drawing: " << timeseries.size() << "series";
     // we draw all the timeseries, each with its own color
     for(int i=drawnTimeseries; i < timeseries.size(); i++)
@@ -1148,17 +1260,31 @@ void Canvas::DrawTimeseries()
         painter.setPen(QPen(SampleColor[i%(SampleColorCnt-1)+1],0.5));
         TimeSerie &t = timeseries[i];
         if(t.size() < 2) continue;
-        QPointF p0,p1;
         float count = t.timestamps.size();
-        p0 = toCanvasCoords(t.timestamps[0] / count, t.data[0][yIndex-1]);
-        FOR(j, t.size()-1)
+        ivec &frames = lod[i];
+        if(!frames.size())
         {
-            float value = t.data[j+1][yIndex-1];
-            p1 = toCanvasCoords(t.timestamps[j+1] / count, value);
-            if(t.timestamps[j] == -1 || t.timestamps[j+1] == -1) continue;
-            painter.drawLine(p0, p1);
-            p0 = p1;
+            // frames without a timestamp are skipped and the line goes on from the previous frame
+            frames.push_back(0);
+            FOR(j, t.size()-1)
+            {
+                if(t.timestamps[j] == -1 || t.timestamps[j+1] == -1) continue;
+                frames.push_back(j+1);
+            }
+            // the envelope of the frames in each column of pixels draws the same as all of them
+            fvec xy(frames.size()*2);
+            FOR(j, frames.size())
+            {
+                xy[j*2] = t.timestamps[frames[j]] / count * sx;
+                xy[j*2+1] = t.data[frames[j]][yIndex-1] * sy;
+            }
+            ivec kept = EnvelopePolyline(xy);
+            FOR(j, kept.size()) kept[j] = frames[kept[j]];
+            frames = kept;
         }
+        QPolygonF line(frames.size());
+        FOR(j, frames.size()) line[j] = toCanvasCoords(t.timestamps[frames[j]] / count, t.data[frames[j]][yIndex-1]);
+        painter.drawPolyline(line);
     }
     drawnTimeseries = timeseries.size();
 }
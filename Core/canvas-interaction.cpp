@@ -193,20 +193,48 @@ void Canvas::mouseMoveEvent( QMouseEvent *event )
     }
 }
 
+const SampleGrid &Canvas::SampleIndex()
+{
+    if(!data) sampleGrid.Clear();
+    else sampleGrid.Update(data->GetSampleView(), xIndex, yIndex, data->GetID(), data->GetRevision());
+    return sampleGrid;
+}
+
+// samples of the grid that may lie within reach pixels of center: the rectangle is padded
+// by a couple of pixels as the canvas positions are rounded before computing distances
+static void samplesAround(Canvas *canvas, const SampleGrid &grid, QPointF center, float reach, ivec &candidates)
+{
+    QPoint offset = canvas->mapToParent(QPoint(0,0));
+    fvec sample = canvas->toSampleCoords(center - offset);
+    float sx = fabsf(canvas->zoom*canvas->zooms[canvas->xIndex]*canvas->height());
+    float sy = fabsf(canvas->zoom*canvas->zooms[canvas->yIndex]*canvas->height());
+    float dx = (reach + 2.f) / sx, dy = (reach + 2.f) / sy;
+    float x = sample[canvas->xIndex], y = sample[canvas->yIndex];
+    grid.Query(x - dx, y - dy, x + dx, y + dy, candidates);
+}
+
 ivec Canvas::SelectSamples(QPointF center, float radius , fvec *weights)
 {
     ivec selection;
     if(weights) (*weights).clear();
-    int closest = 0;
-    float minDist = FLT_MAX;
-    FOR(i, data->GetCount())
+    const SampleGrid &grid = SampleIndex();
+    // squared distance in pixels between center and sample i as it is drawn
+    auto distance = [&](int i)
     {
-        QPointF dataPoint = toCanvasCoords(data->GetSample(i));
+        QPointF dataPoint = toCanvasCoords(grid.X(i), grid.Y(i));
         QPointF point = this->mapToParent(QPoint(dataPoint.x(), dataPoint.y()));
         point -= center;
-        float dist = point.x()*point.x() + point.y()*point.y();
-        if(radius > 0)
+        return (float)(point.x()*point.x() + point.y()*point.y());
+    };
+
+    ivec candidates;
+    if(radius > 0)
+    {
+        samplesAround(this, grid, center, weights ? radius*1.5f : radius, candidates);
+        FOR(c, candidates.size())
         {
+            int i = candidates[c];
+            float dist = distance(i);
             if(!weights)
             {
                 if(sqrtf(dist) < radius) selection.push_back(i);
@@ -221,35 +249,51 @@ ivec Canvas::SelectSamples(QPointF center, float radius , fvec *weights)
                 }
             }
         }
-        else
-        {
-            if(dist < minDist)
-            {
-                closest = i;
-                minDist = dist;
-            }
-        }
+        return selection;
     }
-    if(radius < 0)
+
+    // the grid gives us the closest sample, we then check the ones just as close once rounded to pixels
+    int closest = 0;
+    float minDist = FLT_MAX;
+    QPoint offset = mapToParent(QPoint(0,0));
+    fvec sample = toSampleCoords(center - offset);
+    float reach = 0;
+    int nearest = grid.Nearest(sample[xIndex], sample[yIndex],
+                               zoom*zooms[xIndex]*height(), zoom*zooms[yIndex]*height(), &reach);
+    if(nearest >= 0) samplesAround(this, grid, center, reach + 2.f, candidates);
+    FOR(c, candidates.size())
     {
-        selection.push_back(closest);
+        int i = candidates[c];
+        float dist = distance(i);
+        if(dist < minDist)
+        {
+            closest = i;
+            minDist = dist;
+        }
     }
+    selection.push_back(closest);
     return selection;
 }
 
 bool Canvas::DeleteData( QPointF center, float radius )
 {
     bool anythingDeleted = false;
-    FOR (i, data->GetCount()) {
-        QPointF dataPoint = toCanvasCoords(data->GetSample(i));
+    // we collect the samples to erase and remove them all at once
+    bvec removeMask(data->GetCount(), false);
+    const SampleGrid &grid = SampleIndex();
+    ivec candidates;
+    samplesAround(this, grid, center, radius, candidates);
+    FOR (c, candidates.size()) {
+        int i = candidates[c];
+        QPointF dataPoint = toCanvasCoords(grid.X(i), grid.Y(i));
         QPointF point = this->mapToParent(QPoint(dataPoint.x(), dataPoint.y()));
         point -= center;
         if (sqrt(point.x()*point.x() + point.y()*point.y()) < radius) {
             anythingDeleted = true;
-            data->RemoveSample(i);
-            i--;
+            removeMask[i] = true;
         }
     }
+    if (anythingDeleted) data->RemoveSamples(removeMask);
     FOR (i, data->GetObstacles().size()) {
         QPointF obstaclePoint= toCanvasCoords(data->GetObstacle(i).center);
         QPointF point = this->mapToParent(QPoint(obstaclePoint.x(), obstaclePoint.y()));
@@ -60,6 +60,7 @@ Canvas::Canvas(QWidget *parent)
       drawnSamples(0),
       drawnTrajectories(0),
       drawnTimeseries(0),
+      bDensitySamples(false),
       mouseAnchor(QPoint(-1,-1)),
       bDrawing(false),
       zoom(1.f),
@@ -21,6 +21,8 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 
 #include "datasetManager.h"
 #include "mymaths.h"
+#include "sampleGrid.h"
+#include "pathLod.h"
 #include <QWidget>
 #include <map>
 #include <QMouseEvent>
@@ -66,6 +68,7 @@ public:
     static bool bCrossesAsDots;
     bool DeleteData(QPointF center, float radius);
     ivec SelectSamples(QPointF center, float radius, fvec *weights=0);
+    const SampleGrid &SampleIndex();
     void DrawSamples();
     void DrawObstacles();
 	void DrawTrajectories();
@@ -73,8 +76,11 @@ public:
 	void DrawRewards();
 	void DrawObstacles(QPainter &painter);
 	void DrawTrajectories(QPainter &painter);
+    void DrawTrajectory(QPainter &painter, const std::vector<fvec> &trajectory, const int label, ivec *vertices=0, ivec *glyphs=0);
+    std::vector<ivec> &TrajectoryLod(const int mode);
 	void DrawSamples(QPainter &painter);
     void DrawSampleColors(QPainter &painter);
+    QImage SampleDensity(const ivec &slots, const std::vector<QRgb> &palette);
 	void DrawTargets(QPainter &painter);
 	void DrawLiveTrajectory(QPainter &painter);
     void DrawLegend(QPainter &painter);
@@ -155,6 +161,10 @@ public:
 	int drawnSamples;
 	int drawnTrajectories;
 	int drawnTimeseries;
+	bool bDensitySamples; // the samples pixmap holds a density map rather than glyphs
+	SampleGrid sampleGrid; // samples indexed on xIndex and yIndex for hit-testing, see SampleIndex()
+	PathLod trajectoryLod; // vertices and glyphs of each trajectory at the current zoom, see DrawTrajectory()
+	PathLod timeseriesLod; // frames of each time serie at the current zoom
 	std::vector<fvec> liveTrajectory;
 
     void PaintBufferedCanvas(QPainter &painter, bool bSvg=false);
@@ -223,6 +233,10 @@ public:
 		painter.drawEllipse(QRectF(x-radius/2.,y-radius/2.,radius,radius));
 	}
 
+    // colors of drawSample as a palette, SampleSlot gives the entry of a label
+    static std::vector<QRgb> SamplePalette();
+    static inline int SampleSlot(int label) {return label == -1 ? SampleColorCnt : max(label,0)%SampleColorCnt;}
+
     static QRgb GetColorMapValue(float value, int colorscheme);
 };
 
@@ -25,6 +25,9 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include <roc.h>
 #include <types.h>
 #include <mymaths.h>
+#include "sampleMatrix.h"
+
+struct GramScope;
 
 class Classifier
 {
@@ -36,6 +39,8 @@ protected:
 	bool bSingleClass;
 	bool bUsesDrawTimer;
 	bool bMultiClass;
+	bool bThreadSafe; // TestBatch leaves the model untouched and can run on several threads at once
+	bool bTrainThreadSafe; // Train and Test only touch this model and can run while other models do on other threads (set by the plugins that were checked)
 
 public:
     std::map<int,int> classMap, inverseMap;
@@ -45,8 +50,9 @@ public:
 	std::vector< std::vector<f32pair> > rocdata;
 	std::vector<const char *> roclabels;
     std::map<int, std::map<int, int> > confusionMatrix[2];
+    const GramScope *gramScope; // rows of a kernel cache the next training samples are, 0 when they are not
 
-    Classifier(): posClass(0), bSingleClass(true), bUsesDrawTimer(true), bMultiClass(false)
+    Classifier(): posClass(0), bSingleClass(true), bUsesDrawTimer(true), bMultiClass(false), bThreadSafe(false), bTrainThreadSafe(false), gramScope(0)
 	{
 		rocdata.push_back(std::vector<f32pair>());
 		rocdata.push_back(std::vector<f32pair>());
@@ -61,12 +67,61 @@ public:
     virtual fvec TestMulti(const fvec &sample) const { return fvec(1,Test(sample));}
     virtual float Test(const fvec &sample) const { return 0; }
     virtual float Test(const fVec &sample) const { if(dim==2) return Test((fvec)sample); fvec s = (fvec)sample; s.resize(dim,0); return Test(s);}
+    // tests all the rows of samples at once and returns the number of scores per row, stored row after row in scores:
+    // the output of TestMulti for multi-class classifiers, of Test otherwise (one score per row)
+    virtual int TestBatch(const SampleView &samples, fvec &scores) const
+    {
+        int rows = samples.Rows();
+        fvec sample(samples.Cols());
+        if(!bMultiClass)
+        {
+            scores.resize(rows);
+            FOR(i, rows)
+            {
+                if(sample.size()) samples.CopyRow(i, &sample[0]);
+                scores[i] = Test(sample);
+            }
+            return 1;
+        }
+        int outputs = 1;
+        FOR(i, rows)
+        {
+            if(sample.size()) samples.CopyRow(i, &sample[0]);
+            fvec res = TestMulti(sample);
+            if(!i)
+            {
+                outputs = std::max(1, (int)res.size());
+                scores.resize((size_t)rows*outputs);
+            }
+            FOR(j, outputs) scores[(size_t)i*outputs + j] = j < res.size() ? res[j] : 0;
+        }
+        if(!rows) scores.clear();
+        return outputs;
+    }
+    // scores of a classifier the way the interface reads them: its own TestBatch, or one score per classifier
+    // when a single-class classifier has been trained as a set of one-vs-all classifiers (classifierMulti)
+    static int TestBatch(const Classifier *classifier, const std::vector<Classifier*> &classifierMulti, const SampleView &samples, fvec &scores)
+    {
+        if(classifier->IsMultiClass() || !classifierMulti.size()) return classifier->TestBatch(samples, scores);
+        int count = classifierMulti.size();
+        int rows = samples.Rows();
+        fvec column;
+        scores.resize((size_t)rows*count);
+        FOR(c, count)
+        {
+            classifierMulti[c]->TestBatch(samples, column);
+            FOR(i, rows) scores[(size_t)i*count + c] = column[i];
+        }
+        return count;
+    }
     virtual const char *GetInfoString() const {return NULL;}
     virtual void SaveModel(const std::string filename) const {}
     virtual bool LoadModel(const std::string filename){return false;}
     bool SingleClass() const {return bSingleClass;}
     bool UsesDrawTimer() const {return bUsesDrawTimer;}
     bool IsMultiClass() const {return bMultiClass;}
+    bool IsThreadSafe() const {return bThreadSafe;}
+    bool IsTrainThreadSafe() const {return bTrainThreadSafe;}
     int Dim() const {return dim;}
 };
 
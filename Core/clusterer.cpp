@@ -21,12 +21,33 @@ fvec Clusterer::TestMany(const fvec &sampleMatrix, const int dim, const int coun
     return results;
 }
 
+vector<fvec> Clusterer::TestSamples(const vector<fvec> &samples)
+{
+    vector<fvec> results(samples.size());
+    if(!samples.size()) return results;
+    int dim = samples[0].size();
+    fvec sampleMatrix(samples.size()*dim);
+    FOR(i, samples.size()) {
+        // samples of different sizes cannot be packed together
+        if(samples[i].size() != dim) {
+            FOR(j, samples.size()) results[j] = Test(samples[j]);
+            return results;
+        }
+        if(dim) memcpy(&sampleMatrix[i*dim], &samples[i][0], dim*sizeof(float));
+    }
+    fvec res = TestMany(sampleMatrix, dim, samples.size());
+    int resDim = res.size() / samples.size();
+    FOR(i, samples.size()) results[i] = fvec(res.begin() + i*resDim, res.begin() + (i+1)*resDim);
+    return results;
+}
+
 float Clusterer::GetLogLikelihood(std::vector<fvec> samples){
     if(!samples.size()) return 0;
 
     vector< vector<fvec> > samplesPerCluster(nbClusters);
+    vector<fvec> allScores = TestSamples(samples);
     FOR(i, samples.size()) {
-        fvec scores = Test(samples[i]);
+        fvec &scores = allScores[i];
         float maxScore = 0;
         int clusterIndex = 0;
         FOR(j, nbClusters) {
@@ -21,6 +21,7 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 
 #include <vector>
 #include <mymaths.h>
+#include "sampleMatrix.h"
 
 class Clusterer
 {
@@ -28,24 +29,36 @@ protected:
 	u32 dim;
     u32 nbClusters;
 	bool bIterative;
+	bool bThreadSafe; // TestMany leaves the model untouched and can run on several threads at once
 
 public:
-    Clusterer() : dim(2), nbClusters(1), bIterative(false) {}
+    Clusterer() : dim(2), nbClusters(1), bIterative(false), bThreadSafe(false) {}
     virtual ~Clusterer(){}
     void Cluster(std::vector< fvec > allsamples) {Train(allsamples);}
     void SetIterative(bool iterative){bIterative = iterative;}
     int NbClusters(){return nbClusters;}
+    bool IsThreadSafe() const {return bThreadSafe;}
     virtual Clusterer* clone() const{ return new Clusterer(*this);}
 
     virtual void Train(std::vector< fvec > /*sample*/){}
     virtual fvec Test( const fvec &/*sample*/){ return fvec(); }
     virtual fvec Test(const fVec &sample){ return Test((fvec)sample); }
+    // tests count samples stored row-major in sampleMatrix, the results hold the same number of values for each sample
     virtual fvec TestMany( const fvec& sampleMatrix, const int dim, const int count);
+    // runs a set of samples through TestMany and splits the results back, one vector per sample
+    std::vector<fvec> TestSamples(const std::vector<fvec> &samples);
     virtual const char *GetInfoString(){ return NULL; }
     virtual bool SetClusterTestValue(int count, int /*max*/){ nbClusters = count; return true;}
     virtual float GetClusterTestValue() {return nbClusters;}
     virtual float GetLogLikelihood(std::vector<fvec> samples);
     virtual float GetParameterCount(){return nbClusters*dim;}
+
+    // out-of-core training: the samples are fed by blocks, in at most StreamPasses() passes over the data
+    // StreamEnd returns false once no further pass is needed
+    virtual int StreamPasses(){return 0;}
+    virtual void StreamBegin(const int /*pass*/, const int /*dim*/){}
+    virtual void StreamBlock(const SampleView &/*block*/){}
+    virtual bool StreamEnd(const int /*pass*/){return false;}
 };
 
 #endif // _CLUSTERING_H_
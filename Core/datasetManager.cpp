@@ -21,9 +21,11 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "basicMath.h"
 #include "mymaths.h"
 #include "datasetManager.h"
+#include "binaryDataset.h"
 #include <fstream>
 #include <algorithm>
 #include <map>
+#include <stdint.h>
 
 using namespace std;
 
@@ -39,7 +41,10 @@ DatasetManager::DatasetManager(const int dimension)
 {
     bProjected = false;
 	ID = IDCount++;
+	revision = 0;
 	perm = NULL;
+	mapping = NULL;
+	stream = NULL;
 }
 
 DatasetManager::~DatasetManager()
@@ -50,7 +55,10 @@ DatasetManager::~DatasetManager()
 void DatasetManager::Clear()
 {
     bProjected = false;
-	samples.clear();
+	revision++;
+	samples.Clear();
+	DEL(mapping);
+	DEL(stream);
 	obstacles.clear();
 	flags.clear();
 	labels.clear();
@@ -63,114 +71,173 @@ void DatasetManager::Clear()
 void DatasetManager::AddSample(const fvec sample, const int label, const dsmFlags flag)
 {
 	if (!sample.size()) return;
-    int dim = GetDimCount();
-	size = sample.size();
-    if(dim != size) // we need to go through all our data and adjust the dimensions
-    {
-        FOR(i, samples.size())
-        {
-            while(samples[i].size() < size) samples[i].push_back(0.f);
-        }
-    }
-	samples.push_back(sample);
+    // the store pads the existing samples with zeros if the dimension grows
+	samples.AddRow(sample);
+	size = samples.Cols();
 	labels.push_back(label);
 	flags.push_back(flag);
-	KILL(perm);
-	perm = randPerm(samples.size());
+	ExtendPerm(samples.size()-1);
 }
 
 void DatasetManager::AddSamples(const std::vector< fvec > newSamples, const ivec newLabels, const std::vector<dsmFlags> newFlags)
 {
     if(!newSamples.size()) return;
-    int dim = GetDimCount();
-    size = newSamples[0].size();
-    if(dim != size) // we need to go through all our data and adjust the dimensions
-    {
-        FOR(i, samples.size())
-        {
-            while(samples[i].size() < size) samples[i].push_back(0.f);
-        }
-    }
+    int oldCount = samples.size();
+    samples.Reserve(samples.size() + newSamples.size());
     FOR(i, newSamples.size())
 	{
 		if(newSamples[i].size())
 		{
-			samples.push_back(newSamples[i]);
+			samples.AddRow(newSamples[i]);
 			if(i < newFlags.size()) flags.push_back(newFlags[i]);
 			else flags.push_back(_UNUSED);
 		}
 	}
+    size = samples.Cols();
 	if(newLabels.size() == newSamples.size()) FOR(i, newLabels.size()) labels.push_back(newLabels[i]);
 	else FOR(i, newSamples.size()) labels.push_back(0);
-	KILL(perm);
-	perm = randPerm(samples.size());
+	ExtendPerm(oldCount);
 }
 
 void DatasetManager::AddSamples(const DatasetManager &newSamples)
 {
-	AddSamples(newSamples.GetSamples(), newSamples.GetLabels(), newSamples.GetFlags());
+	if(!newSamples.GetCount()) return;
+	// we append the rows directly from the other store instead of going through vector<fvec>
+	const SampleMatrix &other = newSamples.samples;
+	int oldCount = samples.size();
+	samples.Reserve(samples.size() + other.size());
+	FOR(i, other.size()) samples.AddRow(other.RowData(i), other.Cols());
+	size = samples.Cols();
+	labels.insert(labels.end(), newSamples.labels.begin(), newSamples.labels.end());
+	flags.insert(flags.end(), newSamples.flags.begin(), newSamples.flags.end());
+	ExtendPerm(oldCount);
+}
+
+// the samples appended after the first oldCount ones are shuffled into the random order of those
+// (inside-out Fisher-Yates): only the new samples are drawn, instead of the whole order again
+void DatasetManager::ExtendPerm(const int oldCount)
+{
+	int count = samples.size();
+	if(!perm || oldCount <= 0 || oldCount > count)
+	{
+		KILL(perm);
+		perm = randPerm(count);
+		return;
+	}
+	u32 *newPerm = new u32[count];
+	memcpy(newPerm, perm, oldCount*sizeof(u32));
+	for(int i=oldCount; i<count; i++)
+	{
+		int r = (RAND_MAX <= 0x7fff ? (rand()<<7) + rand() : rand()) % (i+1);
+		newPerm[i] = newPerm[r];
+		newPerm[r] = i;
+	}
+	KILL(perm);
+	perm = newPerm;
 }
 
 void DatasetManager::RemoveSample(const unsigned int index)
 {
 	if(index >= samples.size()) return;
-	if(samples.size() == 1)
+	bvec removeMask(samples.size(), false);
+	removeMask[index] = true;
+	RemoveSamples(removeMask);
+}
+
+void DatasetManager::RemoveSamples(ivec indices)
+{
+    if(!indices.size() || indices.size() > samples.size()) return;
+    bvec removeMask(samples.size(), false);
+    FOR(i, indices.size())
+    {
+        if(indices[i] < 0 || indices[i] >= samples.size()) continue;
+        removeMask[indices[i]] = true;
+    }
+    RemoveSamples(removeMask);
+}
+
+// removes all samples flagged in removeMask with a single compaction pass
+void DatasetManager::RemoveSamples(const bvec &removeMask)
+{
+	int count = samples.size();
+	// removedBefore[i] is the number of samples removed before index i
+	ivec removedBefore(count+1, 0);
+	FOR(i, count) removedBefore[i+1] = removedBefore[i] + (i < removeMask.size() && removeMask[i] ? 1 : 0);
+	int removedCount = removedBefore[count];
+	if(!removedCount) return;
+	if(removedCount == count)
 	{
 		Clear();
 		return;
 	}
-	samples[index].clear();
-	for (unsigned int i = index; i < samples.size()-1; i++)
+
+	bvec keep(count);
+	FOR(i, count) keep[i] = !(i < removeMask.size() && removeMask[i]);
+	samples.Compact(keep);
+	revision++;
+	int newCount = 0;
+	FOR(i, count)
 	{
-		samples[i] = samples[i+1];
-		labels[i] = labels[i+1];
-		flags[i] = flags[i+1];
+		if(!keep[i]) continue;
+		labels[newCount] = labels[i];
+		flags[newCount] = flags[i];
+		newCount++;
 	}
-	samples.pop_back();
-	labels.pop_back();
-	flags.pop_back();
+	labels.resize(newCount);
+	flags.resize(newCount);
 
-	// we need to check if a sequence needs to be shortened
+	// we shorten (or drop) the sequences that contained removed samples, in one sweep
+	// as removing the samples one by one would: a sequence loses one sample for each removed sample
+	// up to its end and moves back by one for each one before its start (even if it reaches past the samples)
+	int seqCount = 0;
 	FOR(i, sequences.size())
 	{
-		if(sequences[i].first > index) // later sequences
+		int first = sequences[i].first, second = sequences[i].second;
+		int newFirst = first - removedBefore[max(0, min(count, first))];
+		int newSecond = second - removedBefore[max(0, min(count, second+1))];
+		if(newFirst >= newSecond) // we need to pop out the sequence
 		{
-			sequences[i].first--;
-			sequences[i].second--;
+			if(newFirst == newSecond && newFirst >= 0 && newFirst < newCount) flags[newFirst] = _UNUSED;
+			continue;
 		}
-		else if(sequences[i].first == index || sequences[i].second >= index)
+		sequences[seqCount++] = ipair(newFirst, newSecond);
+	}
+	sequences.resize(seqCount);
+
+	// we keep the random order of the remaining samples
+	if(perm)
+	{
+		u32 *newPerm = new u32[newCount];
+		int permCount = 0;
+		FOR(i, count)
 		{
-			sequences[i].second--;
+			if(perm[i] >= (u32)count || !keep[perm[i]]) continue;
+			newPerm[permCount++] = perm[i] - removedBefore[perm[i]];
 		}
-		if(sequences[i].first >= sequences[i].second) // we need to pop out the sequence
+		KILL(perm);
+		if(permCount == newCount) perm = newPerm;
+		else
 		{
-			if(sequences[i].first == sequences[i].second)
-			{
-				flags[sequences[i].first] = _UNUSED;
-			}
-			for(int j=i; j<sequences.size()-1; j++)
-			{
-				sequences[j] = sequences[j+1];
-			}
-			sequences.pop_back();
-			i--;
+			delete [] newPerm;
+			perm = randPerm(newCount);
 		}
 	}
 }
 
-void DatasetManager::RemoveSamples(ivec indices)
+void DatasetManager::SetLabels(const ivec &indices, const int label)
 {
-    if(indices.size() > samples.size()) return;
-    // we sort the indices
-    sort(indices.begin(), indices.end(), less<int>());
-    int offset = 0;
-    FOR(i, indices.size())
-    {
-        int index = indices[i] - offset;
-        if(index < 0 || index > samples.size()) continue;
-        RemoveSample(index);
-        offset++;
-    }
+	FOR(i, indices.size())
+	{
+		if(indices[i] >= 0 && indices[i] < labels.size()) labels[indices[i]] = label;
+	}
+}
+
+void DatasetManager::SetFlags(const ivec &indices, const dsmFlags flag)
+{
+	FOR(i, indices.size())
+	{
+		if(indices[i] >= 0 && indices[i] < flags.size()) flags[indices[i]] = flag;
+	}
 }
 
 void DatasetManager::AddSequence(const int start, const int stop)
@@ -180,6 +247,7 @@ void DatasetManager::AddSequence(const int start, const int stop)
 	sequences.push_back(ipair(start,stop));
 	// sort sequences by starting value
 	std::sort(sequences.begin(), sequences.end());
+	revision++;
 }
 
 void DatasetManager::AddSequence(const ipair newSequence)
@@ -189,6 +257,7 @@ void DatasetManager::AddSequence(const ipair newSequence)
 	sequences.push_back(newSequence);
 	// sort sequences by starting value
 	std::sort(sequences.begin(), sequences.end());
+	revision++;
 }
 
 void DatasetManager::AddSequences(const std::vector< ipair > newSequences)
@@ -205,6 +274,7 @@ void DatasetManager::RemoveSequence(const unsigned int index)
 	if(index >= sequences.size()) return;
 	for(int i=index; i<sequences.size()-1; i++) sequences[i] = sequences[i+1];
 	sequences.pop_back();
+	revision++;
 }
 
 void DatasetManager::AddTimeSerie(const std::string name, const std::vector<fvec> data, const std::vector<long int>  timestamps)
@@ -230,6 +300,7 @@ void DatasetManager::RemoveTimeSerie(const unsigned int index)
 {
 	if(index >= series.size()) return;
 	series.erase(series.begin() + index);
+	revision++;
 }
 
 void DatasetManager::AddObstacle(const fvec center, const fvec axes, const float angle, const fvec power, const fvec repulsion)
@@ -268,10 +339,12 @@ double DatasetManager::Compare(const fvec sample) const
 
 	// now compute the differences
 	double minDist = 1.0;
+	int dim = min((int)sample.size(), samples.Cols());
 	FOR(i, samples.size())
 	{
+		const float *row = samples.RowData(i);
 		double dist = 0;
-		FOR(j, size) dist += fabs(sample[j]-samples[i][j]);
+		FOR(j, dim) dist += fabs(sample[j]-row[j]);
 		dist /= size;
 		if(minDist > dist)
 		{
@@ -294,7 +367,17 @@ void DatasetManager::ResetFlags()
 
 void DatasetManager::SetSample(const int index, const fvec sample)
 {
-    if(index >= 0 && index < samples.size()) samples[index] = sample;
+    if(index < 0 || index >= samples.size()) return;
+    samples.SetRow(index, sample);
+    revision++;
+}
+
+void DatasetManager::SetSamples(const std::vector<fvec> samples)
+{
+    this->samples.SetRows(samples);
+    revision++;
+    KILL(perm);
+    perm = randPerm(this->samples.size());
 }
 
 string DatasetManager::GetCategorical(const int dimension, const int value) const
@@ -312,90 +395,46 @@ bool DatasetManager::IsCategorical(const int dimension) const
     return categorical.count(dimension) > 0;
 }
 
-fvec DatasetManager::GetSampleDim(const int index, const ivec inputDims, const int outputDim) const
+// maps the input dimensions (and the output dimension, which always goes last)
+// to the columns of the sample store
+ivec DatasetManager::GetDimsColumns(const ivec inputDims, const int outputDim)
 {
-    if(index >= samples.size()) return fvec();
-    if(!inputDims.size()) return samples[index];
-    if(outputDim == -1)
-    {
-        fvec sample(inputDims.size());
-        FOR(d, inputDims.size()) sample[d] = samples[index][inputDims[d]];
-        return sample;
-    }
-    else
+    if(!inputDims.size()) return ivec();
+    ivec columns;
+    columns.reserve(inputDims.size()+1);
+    int outputIndex = -1;
+    FOR(d, inputDims.size())
     {
-        int outputIndex = -1;
-        FOR(d, inputDims.size())
-        {
-            if(outputDim == inputDims[d])
-            {
-                outputIndex = d;
-                break;
-            }
-        }
-        fvec sample(inputDims.size() + (outputIndex==-1 ? 0 : 1));
-        FOR(d, inputDims.size())
+        if(outputDim != -1 && outputDim == inputDims[d])
         {
-            if(d==outputIndex) sample.back() = samples[index][inputDims[d]];
-            else sample[d<outputIndex ? d : d-1] = samples[index][inputDims[d]];
+            outputIndex = d;
+            continue;
         }
-        if(outputIndex == -1) sample.back() = samples[index][outputDim];
-        return sample;
+        columns.push_back(inputDims[d]);
     }
+    if(outputDim != -1) columns.push_back(outputIndex == -1 ? outputDim : inputDims[outputIndex]);
+    return columns;
+}
 
-    int dim = inputDims.size();
-    fvec sample(dim + outputDim!=-1?1:0);
-    FOR(d, dim) sample[d] = samples[index][inputDims[d]];
-    if(outputDim != -1) sample[dim] = samples[index][outputDim];
-    return sample;
+SampleView DatasetManager::GetSampleDimsView(const ivec inputDims, const int outputDim) const
+{
+    return samples.View(GetDimsColumns(inputDims, outputDim));
+}
+
+fvec DatasetManager::GetSampleDim(const int index, const ivec inputDims, const int outputDim) const
+{
+    if(index >= samples.size()) return fvec();
+    return GetSampleDimsView(inputDims, outputDim).Row(index);
 }
 
 std::vector<fvec> DatasetManager::GetSamples() const
 {
-    return samples;
+    return samples.ToVector();
 }
 
 std::vector< fvec > DatasetManager::GetSampleDims(const ivec inputDims, const int outputDim) const
 {
-    if ( !inputDims.size() ) return samples;
-
-    vector<fvec> newSamples = samples;
-    int newDim = inputDims.size();
-    if ( outputDim == -1 ) {
-        FOR ( i, samples.size() ) {
-            fvec newSample(newDim);
-            FOR ( d, inputDims.size() ) {
-                newSample[d] = samples[i][inputDims[d]];
-            }
-            newSamples[i] = newSample;
-        }
-    } else {
-        newDim++;
-        int outputIndex = -1;
-        FOR ( d, inputDims.size() ) {
-            if ( outputDim == inputDims[d] ) {
-                outputIndex = d;
-                newDim--;
-                break;
-            }
-        }
-        FOR ( i, samples.size() ) {
-            fvec newSample(newDim);
-            if ( outputIndex == -1 ) {
-                FOR ( d, newDim-1 ) {
-                    newSample[d] = samples[i][inputDims[d]];
-                }
-                newSample[newDim-1] = samples[i][outputDim];
-            } else {
-                FOR ( d, newDim ) {
-                    if ( d == outputIndex ) newSample[newDim-1] = samples[i][inputDims[d]];
-                    else newSample[d<outputIndex?d:d-1] = samples[i][inputDims[d]];
-                }
-            }
-            newSamples[i] = newSample;
-        }
-    }
-    return newSamples;
+    return GetSampleDimsView(inputDims, outputDim).ToVector();
 }
 
 std::vector< fvec > DatasetManager::GetSampleDims(const std::vector<fvec> samples, const ivec inputDims, const int outputDim) const
@@ -452,7 +491,7 @@ std::vector< fvec > DatasetManager::GetSamples(const u32 count, const dsmFlags f
 		{
 			if ( flags[perm[i]] == flag)
 			{
-				selected.push_back(samples[perm[i]]);
+				selected.push_back(samples.Row(perm[i]));
 				flags[perm[i]] = replaceWith;
 			}
 		}
@@ -463,7 +502,7 @@ std::vector< fvec > DatasetManager::GetSamples(const u32 count, const dsmFlags f
 	{
 		if ( flags[perm[i]] == flag )
 		{
-			selected.push_back(samples[perm[i]]);
+			selected.push_back(samples.Row(perm[i]));
 			flags[perm[i]] = replaceWith;
 			cnt++;
 		}
@@ -478,7 +517,7 @@ std::vector< std::vector < fvec > > DatasetManager::GetTrajectories(const int re
 	// we split the data into trajectories
 	vector< vector<fvec> > trajectories;
 	if(!sequences.size() || !samples.size()) return trajectories;
-	int dim = samples[0].size();
+	int dim = samples.Cols();
 	trajectories.resize(sequences.size());
 	FOR(i, sequences.size())
 	{
@@ -488,7 +527,8 @@ std::vector< std::vector < fvec > > DatasetManager::GetTrajectories(const int re
 		{
 			trajectories[i][j].resize(dim*2);
 			// copy data
-			FOR(d, dim) trajectories[i][j][d] = samples[sequences[i].first + j][d];
+			const float *row = samples.RowData(sequences[i].first + j);
+			FOR(d, dim) trajectories[i][j][d] = row[d];
 		}
 	}
 
@@ -544,7 +584,7 @@ std::vector< std::vector < fvec > > DatasetManager::GetTrajectories(const int re
 				centers[label] = center;
 				counts[label] = 0;
 			}
-			centers[label] += samples[index];
+			centers[label] += samples.Row(index);
 			counts[label]++;
 		}
 		for(map<int,int>::iterator p = counts.begin(); p!=counts.end(); ++p)
@@ -628,21 +668,33 @@ std::vector< std::vector < fvec > > DatasetManager::GetTrajectories(const int re
 }
 
 
-void DatasetManager::Save(const char *filename)
+bool DatasetManager::Save(const char *filename, const bool bBinary)
 {
-    if(!samples.size() && rewards.Empty()) return;
+    if(stream && stream->GetFilename() == filename) return false;
+    // the file may be the one the samples are mapped from: they are copied out of it before it is truncated
+    samples.Detach();
+    DEL(mapping);
+    // an empty dataset leaves an empty file, the parameters of the algorithms can still be appended to it
+    if(!samples.size() && rewards.Empty() && (!bBinary || !series.size()))
+    {
+        ofstream file(filename);
+        return file.is_open();
+    }
+    if(bBinary) return SaveBinary(filename);
 	u32 sampleCnt = samples.size();
-    if(sampleCnt) size = samples[0].size();
+    if(sampleCnt) size = samples.Cols();
 
 	ofstream file(filename);
-	if(!file.is_open()) return;
+	if(!file.is_open()) return false;
 
+	const SampleMatrix &store = samples;
 	file << sampleCnt << " " << size << "\n";
 	FOR(i, sampleCnt)
 	{
+		const float *row = store.RowData(i);
 		FOR(j,size)
 		{
-			file << samples[i][j] << " ";
+			file << row[j] << " ";
 		}
 		file << labels[i] << " ";
 		file << flags[i] << " ";
@@ -686,35 +738,50 @@ void DatasetManager::Save(const char *filename)
         }
     }
 
+	bool bOk = file.good();
 	file.close();
+	return bOk;
 }
 
 bool DatasetManager::Load(const char *filename)
 {
+	if(IsBinaryFile(filename)) return LoadBinary(filename);
 	ifstream file(filename);
 	if(!file.is_open()) return false;
 	Clear();
 
-	int sampleCnt;
+	int sampleCnt = -1, dim = 0;
 	file >> sampleCnt;
-	file >> size;
-
-	// we load the samples
-	FOR(i, sampleCnt)
+	file >> dim;
+	// a truncated or corrupt header must not size the store: every value takes at least two characters of the file
+	streampos start = file.tellg();
+	file.seekg(0, ios::end);
+	size_t bytes = file.good() ? (size_t)file.tellg() : 0;
+	file.seekg(start);
+	if(!file.good() || sampleCnt < 0 || dim <= 0 || (size_t)dim > bytes/2) return false;
+	size = dim;
+	sampleCnt = (int)min((size_t)sampleCnt, bytes / (2*((size_t)size+2)));
+
+	// we load the samples straight into the store, and keep the ones read in full if the file ends early
+	samples.Resize(sampleCnt, size);
+	labels.reserve(sampleCnt);
+	flags.reserve(sampleCnt);
+	int count = 0;
+	for(; count<sampleCnt; count++)
 	{
-		fvec sample;
-		sample.resize(size,0);
+		float *row = samples.RowData(count);
 		int label, flag;
 		FOR(j, size)
 		{
-			file >> sample[j];
+			file >> row[j];
 		}
 		file >> label;
 		file >> flag;
-		samples.push_back(sample);
+		if(file.fail()) break;
 		labels.push_back(label);
 		flags.push_back((dsmFlags)flag);
 	}
+	if(count < sampleCnt) samples.Resize(count, size);
 
 	// we load the sequences
 	char tmp[255];
@@ -798,10 +865,443 @@ bool DatasetManager::Load(const char *filename)
 	return samples.size() > 0;
 }
 
+/******************************************/
+/*                                        */
+/*    BINARY DATASETS                     */
+/*                                        */
+/******************************************/
+// helper to serialize the variable-size sections into a byte buffer
+struct BinaryWriter
+{
+	std::vector<char> buffer;
+	template<typename T> void Put(const T &value) {Put(&value, sizeof(T));}
+	void Put(const void *data, size_t size)
+	{
+		if(!size) return;
+		size_t offset = buffer.size();
+		buffer.resize(offset + size);
+		memcpy(&buffer[offset], data, size);
+	}
+	void PutString(const std::string &s) {Put((uint32_t)s.size()); Put(s.data(), s.size());}
+	void PutFloats(const fvec &v, const uint32_t count)
+	{
+		FOR(i, count) Put(i < v.size() ? v[i] : 0.f);
+	}
+};
+
+// bounds-checked reader over a section of the file
+struct BinaryReader
+{
+	const char *data;
+	size_t size, position;
+	bool bValid;
+	BinaryReader(const char *data, size_t size) : data(data), size(size), position(0), bValid(true) {}
+	template<typename T> T Get() {T value = T(); Get(&value, sizeof(T)); return value;}
+	void Get(void *dst, size_t count)
+	{
+		if(!bValid || position + count > size) {bValid = false; return;}
+		memcpy(dst, data + position, count);
+		position += count;
+	}
+	std::string GetString()
+	{
+		uint32_t length = Get<uint32_t>();
+		if(!bValid || position + length > size) {bValid = false; return std::string();}
+		std::string s(data + position, length);
+		position += length;
+		return s;
+	}
+	fvec GetFloats(const uint32_t count)
+	{
+		fvec v;
+		if(!bValid || position + (size_t)count*sizeof(float) > size) {bValid = false; return v;}
+		v.resize(count);
+		if(count) Get(&v[0], count*sizeof(float));
+		return v;
+	}
+};
+
+bool DatasetManager::IsBinaryFile(const char *filename, size_t *payloadSize)
+{
+	ifstream file(filename, ios::binary);
+	if(!file.is_open()) return false;
+	BinaryHeader header;
+	file.read((char *)&header, sizeof(BinaryHeader));
+	if(file.gcount() != sizeof(BinaryHeader)) return false;
+	if(memcmp(header.magic, binaryMagic, sizeof(binaryMagic))) return false;
+	if(payloadSize) *payloadSize = (size_t)header.payloadSize;
+	return true;
+}
+
+bool DatasetManager::SaveBinary(const char *filename) const
+{
+	if(!samples.size() && rewards.Empty() && !series.size()) return false;
+
+	vector< pair<uint32_t, BinaryWriter> > sections;
+
+	// the samples are written straight from the store, the other sections are serialized first
+	if(labels.size())
+	{
+		sections.push_back(make_pair((uint32_t)BIN_LABELS, BinaryWriter()));
+		FOR(i, labels.size()) sections.back().second.Put((int32_t)labels[i]);
+	}
+	if(flags.size())
+	{
+		sections.push_back(make_pair((uint32_t)BIN_FLAGS, BinaryWriter()));
+		FOR(i, flags.size()) sections.back().second.Put((int32_t)flags[i]);
+	}
+	if(sequences.size())
+	{
+		sections.push_back(make_pair((uint32_t)BIN_SEQUENCES, BinaryWriter()));
+		BinaryWriter &w = sections.back().second;
+		w.Put((uint32_t)sequences.size());
+		FOR(i, sequences.size())
+		{
+			w.Put((int32_t)sequences[i].first);
+			w.Put((int32_t)sequences[i].second);
+		}
+	}
+	if(obstacles.size())
+	{
+		sections.push_back(make_pair((uint32_t)BIN_OBSTACLES, BinaryWriter()));
+		BinaryWriter &w = sections.back().second;
+		w.Put((uint32_t)obstacles.size());
+		FOR(i, obstacles.size())
+		{
+			const Obstacle &o = obstacles[i];
+			uint32_t dim = o.center.size();
+			w.Put(dim);
+			w.PutFloats(o.center, dim);
+			w.PutFloats(o.axes, dim);
+			w.Put(o.angle);
+			w.PutFloats(o.power, dim);
+			w.PutFloats(o.repulsion, dim);
+		}
+	}
+	if(!rewards.Empty())
+	{
+		sections.push_back(make_pair((uint32_t)BIN_REWARDS, BinaryWriter()));
+		BinaryWriter &w = sections.back().second;
+		w.Put((uint32_t)rewards.dim);
+		w.Put((uint32_t)rewards.length);
+		FOR(d, rewards.dim) w.Put((int32_t)rewards.size[d]);
+		w.PutFloats(rewards.lowerBoundary, rewards.dim);
+		w.PutFloats(rewards.higherBoundary, rewards.dim);
+		w.Put(rewards.rewards, rewards.length*sizeof(double));
+	}
+	if(series.size())
+	{
+		sections.push_back(make_pair((uint32_t)BIN_TIMESERIES, BinaryWriter()));
+		BinaryWriter &w = sections.back().second;
+		w.Put((uint32_t)series.size());
+		FOR(i, series.size())
+		{
+			const TimeSerie &serie = series[i];
+			uint32_t frames = serie.data.size();
+			uint32_t dim = frames ? serie.data[0].size() : 0;
+			w.PutString(serie.name);
+			w.Put(frames);
+			w.Put(dim);
+			FOR(j, frames) w.Put((int64_t)(j < serie.timestamps.size() ? serie.timestamps[j] : j));
+			FOR(j, frames) w.PutFloats(serie.data[j], dim);
+		}
+	}
+	if(categorical.size())
+	{
+		sections.push_back(make_pair((uint32_t)BIN_CATEGORICAL, BinaryWriter()));
+		BinaryWriter &w = sections.back().second;
+		w.Put((uint32_t)categorical.size());
+		for(map<int, vector<string> >::const_iterator it = categorical.begin(); it != categorical.end(); it++)
+		{
+			w.Put((int32_t)it->first);
+			w.Put((uint32_t)it->second.size());
+			FOR(i, it->second.size()) w.PutString(it->second[i]);
+		}
+	}
+
+	BinaryHeader header;
+	memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+	header.version = binaryVersion;
+	header.endianTag = binaryEndianTag;
+	header.sampleCount = samples.Rows();
+	header.dim = samples.Cols();
+	header.sectionCount = sections.size() + (samples.size() ? 1 : 0);
+	header.reserved = 0;
+
+	// we compute the offsets of every section
+	vector<BinarySectionEntry> table;
+	uint64_t offset = AlignOffset(sizeof(BinaryHeader) + header.sectionCount*sizeof(BinarySectionEntry));
+	if(samples.size())
+	{
+		BinarySectionEntry entry = {BIN_SAMPLES, 0, offset, (uint64_t)samples.Rows()*samples.Cols()*sizeof(float)};
+		table.push_back(entry);
+		offset = AlignOffset(offset + entry.size);
+	}
+	FOR(i, sections.size())
+	{
+		BinarySectionEntry entry = {sections[i].first, 0, offset, (uint64_t)sections[i].second.buffer.size()};
+		table.push_back(entry);
+		offset = AlignOffset(offset + entry.size);
+	}
+	header.payloadSize = offset;
+
+	ofstream file(filename, ios::binary | ios::trunc);
+	if(!file.is_open()) return false;
+	const char padding[SAMPLE_ALIGNMENT] = {0};
+	file.write((const char *)&header, sizeof(BinaryHeader));
+	if(table.size()) file.write((const char *)&table[0], table.size()*sizeof(BinarySectionEntry));
+	uint64_t written = sizeof(BinaryHeader) + table.size()*sizeof(BinarySectionEntry);
+	FOR(i, table.size())
+	{
+		file.write(padding, table[i].offset - written);
+		if(table[i].type == BIN_SAMPLES) file.write((const char *)samples.Data(), table[i].size);
+		else if(table[i].size) file.write(&sections[i - (samples.size() ? 1 : 0)].second.buffer[0], table[i].size);
+		written = table[i].offset + table[i].size;
+	}
+	file.write(padding, header.payloadSize - written);
+	bool bOk = file.good();
+	file.close();
+	return bOk;
+}
+
+// parses a section of a binary dataset other than the samples, unknown sections from newer versions are skipped
+void DatasetManager::LoadSection(const int type, const char *data, const size_t length)
+{
+	BinaryReader r(data, length);
+	switch(type)
+	{
+	case BIN_LABELS:
+	{
+		labels.resize(length / sizeof(int32_t));
+		FOR(j, labels.size()) labels[j] = r.Get<int32_t>();
+	}
+		break;
+	case BIN_FLAGS:
+	{
+		flags.resize(length / sizeof(int32_t));
+		FOR(j, flags.size()) flags[j] = (dsmFlags)r.Get<int32_t>();
+	}
+		break;
+	case BIN_SEQUENCES:
+	{
+		uint32_t count = r.Get<uint32_t>();
+		FOR(j, count)
+		{
+			int start = r.Get<int32_t>();
+			int stop = r.Get<int32_t>();
+			if(!r.bValid) break;
+			sequences.push_back(ipair(start, stop));
+		}
+	}
+		break;
+	case BIN_OBSTACLES:
+	{
+		uint32_t count = r.Get<uint32_t>();
+		FOR(j, count)
+		{
+			Obstacle o;
+			uint32_t dim = r.Get<uint32_t>();
+			o.center = r.GetFloats(dim);
+			o.axes = r.GetFloats(dim);
+			o.angle = r.Get<float>();
+			o.power = r.GetFloats(dim);
+			o.repulsion = r.GetFloats(dim);
+			if(!r.bValid) break;
+			obstacles.push_back(o);
+		}
+	}
+		break;
+	case BIN_REWARDS:
+	{
+		uint32_t dim = r.Get<uint32_t>();
+		uint32_t rewardLength = r.Get<uint32_t>();
+		ivec rewardSize(dim);
+		int testLength = 1;
+		FOR(d, dim)
+		{
+			rewardSize[d] = r.Get<int32_t>();
+			testLength *= rewardSize[d];
+		}
+		fvec lowerBoundary = r.GetFloats(dim);
+		fvec higherBoundary = r.GetFloats(dim);
+		if(!r.bValid || testLength != (int)rewardLength || r.position + rewardLength*sizeof(double) > r.size) break;
+		rewards.SetReward((const double *)(data + r.position), rewardSize, lowerBoundary, higherBoundary);
+	}
+		break;
+	case BIN_TIMESERIES:
+	{
+		uint32_t count = r.Get<uint32_t>();
+		FOR(j, count)
+		{
+			TimeSerie serie;
+			serie.name = r.GetString();
+			uint32_t frames = r.Get<uint32_t>();
+			uint32_t dim = r.Get<uint32_t>();
+			if(!r.bValid || r.position + (size_t)frames*(sizeof(int64_t) + dim*sizeof(float)) > r.size) break;
+			serie.timestamps.resize(frames);
+			FOR(k, frames) serie.timestamps[k] = (long int)r.Get<int64_t>();
+			serie.data.resize(frames);
+			FOR(k, frames) serie.data[k] = r.GetFloats(dim);
+			series.push_back(serie);
+		}
+	}
+		break;
+	case BIN_CATEGORICAL:
+	{
+		uint32_t count = r.Get<uint32_t>();
+		FOR(j, count)
+		{
+			int dim = r.Get<int32_t>();
+			uint32_t values = r.Get<uint32_t>();
+			vector<string> names;
+			FOR(k, values)
+			{
+				names.push_back(r.GetString());
+				if(!r.bValid) break;
+			}
+			if(!r.bValid) break;
+			categorical[dim] = names;
+		}
+	}
+		break;
+	default:
+		break;
+	}
+}
+
+bool DatasetManager::LoadBinary(const char *filename)
+{
+	Clear();
+	mapping = new MappedFile();
+	std::vector<char> fallback;
+	const char *base = 0;
+	size_t length = 0;
+	if(mapping->Open(filename))
+	{
+		base = mapping->Data();
+		length = mapping->Size();
+	}
+	else
+	{
+		// we could not map the file, we read it in memory instead
+		DEL(mapping);
+		ifstream file(filename, ios::binary | ios::ate);
+		if(!file.is_open()) return false;
+		length = (size_t)file.tellg();
+		if(length < sizeof(BinaryHeader)) return false;
+		fallback.resize(length);
+		file.seekg(0);
+		file.read(&fallback[0], length);
+		base = &fallback[0];
+	}
+
+	BinaryHeader header;
+	if(length < sizeof(BinaryHeader))
+	{
+		Clear();
+		return false;
+	}
+	memcpy(&header, base, sizeof(BinaryHeader));
+	if(memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) || header.version > binaryVersion ||
+			header.endianTag != binaryEndianTag || header.payloadSize > length ||
+			sizeof(BinaryHeader) + (uint64_t)header.sectionCount*sizeof(BinarySectionEntry) > length)
+	{
+		Clear();
+		return false;
+	}
+	vector<BinarySectionEntry> table(header.sectionCount);
+	if(header.sectionCount) memcpy(&table[0], base + sizeof(BinaryHeader), header.sectionCount*sizeof(BinarySectionEntry));
+	size = header.dim ? header.dim : size;
+
+	FOR(i, table.size())
+	{
+		const BinarySectionEntry &entry = table[i];
+		if(entry.offset + entry.size > length) continue;
+		const char *data = base + entry.offset;
+		switch(entry.type)
+		{
+		case BIN_SAMPLES:
+		{
+			if(entry.size != (uint64_t)header.sampleCount*header.dim*sizeof(float)) break;
+			// the samples stay in the mapped file until they are modified
+			if(mapping) samples.SetExternal((const float *)data, header.sampleCount, header.dim);
+			else
+			{
+				samples.Resize(header.sampleCount, header.dim);
+				memcpy(samples.Data(), data, entry.size);
+			}
+		}
+			break;
+		default: // everything but the samples is parsed the same way when streaming
+			LoadSection(entry.type, data, entry.size);
+			break;
+		}
+	}
+	// we make sure labels and flags match the samples
+	labels.resize(samples.size(), 0);
+	flags.resize(samples.size(), _UNUSED);
+	if(!samples.IsExternal()) DEL(mapping);
+
+	KILL(perm);
+	perm = randPerm(samples.size());
+	return samples.size() > 0 || !rewards.Empty() || series.size() > 0;
+}
+
+bool DatasetManager::LoadStream(const char *filename, const int previewCount, const int blockRows, const int maxCachedBlocks)
+{
+	Clear();
+	stream = new DatasetStream();
+	if(!stream->Open(filename, blockRows, maxCachedBlocks))
+	{
+		DEL(stream);
+		return false;
+	}
+	// the canvas and the interactive tools work on a uniform subset of the file
+	ivec indices;
+	stream->Reservoir(previewCount, samples, labels, indices);
+	flags.resize(samples.size(), _UNUSED);
+	size = stream->Dim();
+
+	// the other sections are read as they would be from the whole file, but for the flags of the subset
+	// the sequences are left out, they are ranges of rows that are not in the subset
+	ifstream file(filename, ios::binary);
+	BinaryHeader header;
+	if(file.read((char *)&header, sizeof(BinaryHeader)))
+	{
+		vector<BinarySectionEntry> table(header.sectionCount);
+		if(header.sectionCount) file.read((char *)&table[0], header.sectionCount*sizeof(BinarySectionEntry));
+		if(!file) table.clear();
+		FOR(i, table.size())
+		{
+			const BinarySectionEntry &entry = table[i];
+			if(entry.type == BIN_SAMPLES || entry.type == BIN_LABELS || entry.type == BIN_SEQUENCES) continue;
+			if(entry.type == BIN_FLAGS)
+			{
+				FOR(j, indices.size())
+				{
+					int32_t flag = _UNUSED;
+					if((uint64_t)(indices[j]+1)*sizeof(int32_t) > entry.size) continue;
+					file.seekg(entry.offset + (uint64_t)indices[j]*sizeof(int32_t));
+					if(!file.read((char *)&flag, sizeof(int32_t))) break;
+					flags[j] = flag == _TRAJ ? _UNUSED : (dsmFlags)flag;
+				}
+				file.clear();
+				continue;
+			}
+			vector<char> buffer(entry.size);
+			file.seekg(entry.offset);
+			if(entry.size && file.read(&buffer[0], entry.size)) LoadSection(entry.type, &buffer[0], entry.size);
+			file.clear();
+		}
+	}
+	perm = randPerm(samples.size());
+	return samples.size() > 0;
+}
+
 int DatasetManager::GetDimCount() const
 {
 	int dim = 2;
-    if(samples.size()) dim = samples.at(0).size();
+    if(samples.size()) dim = samples.Cols();
     if(series.size() && series.at(0).size()) {
         dim = series.at(0).at(0).size()+1;
 	}
@@ -811,16 +1311,17 @@ int DatasetManager::GetDimCount() const
 std::pair<fvec, fvec> DatasetManager::GetBounds() const
 {
     if(!samples.size()) return make_pair(fvec(),fvec());
-    int dim = samples[0].size();
+    int dim = samples.Cols();
+    int count = samples.Rows();
     fvec mins(dim,FLT_MAX), maxes(dim,-FLT_MAX);
-    FOR(i, samples.size())
+    // a single pass over the rows, rather than building a column-major copy of the whole set
+    FOR(i, count)
     {
-        const fvec& sample = samples.at(i);
-        int dim = sample.size();
-        FOR(d,dim)
+        const float *row = samples.RowData(i);
+        FOR(d, dim)
         {
-            if(mins[d] > sample[d]) mins[d] = sample.at(d);
-            if(maxes[d] < sample[d]) maxes[d] = sample.at(d);
+            mins[d] = min(mins[d], row[d]);
+            maxes[d] = max(maxes[d], row[d]);
         }
     }
     return make_pair(mins, maxes);
@@ -21,6 +21,9 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 
 #include <vector>
 #include "public.h"
+#include "sampleMatrix.h"
+#include "mappedFile.h"
+#include "datasetStream.h"
 #include <string.h>
 
 enum DatasetManagerFlags
@@ -140,10 +143,11 @@ protected:
 	static u32 IDCount;
 
 	u32 ID;
+	u32 revision; // bumped whenever samples, sequences or time series are changed or removed, appending samples keeps it
 
 	int size; // the samples size (dimension)
 
-	std::vector< fvec > samples;
+	SampleMatrix samples;
 	std::vector< ipair > sequences;
 	std::vector<dsmFlags> flags;
 	std::vector<Obstacle> obstacles;
@@ -153,6 +157,11 @@ protected:
 	ivec labels;
 
 	u32 *perm;
+	MappedFile *mapping; // backing file of the samples when loaded from a binary dataset
+	DatasetStream *stream; // out-of-core samples, the store then only holds a reservoir subset of them
+
+	void LoadSection(const int type, const char *data, const size_t length);
+	void ExtendPerm(const int oldCount);
 
 public:
     bool bProjected;
@@ -166,8 +175,10 @@ public:
 	void Clear();
     double Compare(const fvec sample) const;
 
+    u32 GetID() const {return ID;}
+    u32 GetRevision() const {return revision;}
     int GetSize() const {return size;}
-    int GetCount() const {return samples.size();}
+    int GetCount() const {return samples.Rows();}
     int GetDimCount() const;
     std::pair<fvec, fvec> GetBounds() const;
     static u32 GetClassCount(const ivec classes);
@@ -178,20 +189,28 @@ public:
     void AddSamples(const DatasetManager &newSamples);
     void RemoveSample(const unsigned int index);
     void RemoveSamples(ivec indices);
+    void RemoveSamples(const bvec &removeMask);
 
-    fvec GetSample(const int index=0) const { return (index < samples.size()) ? samples[index] : fvec(); }
+    fvec GetSample(const int index=0) const { return samples.Row(index); }
     fvec GetSampleDim(const int index, const ivec inputDims, const int outputDim=-1) const;
     std::vector< fvec > GetSamples() const;
     std::vector< fvec > GetSamples(const u32 count, const dsmFlags flag=_UNUSED, const dsmFlags replaceWith=_TRAIN);
     std::vector< fvec > GetSampleDims(const ivec inputDims, const int outputDim=-1) const ;
     std::vector< fvec > GetSampleDims(const std::vector<fvec> samples, const ivec inputDims, const int outputDim=-1) const ;
     void SetSample(const int index, const fvec sample);
-    void SetSamples(const std::vector<fvec> samples){this->samples = samples;}
+    void SetSamples(const std::vector<fvec> samples);
+
+    // zero-copy access to the sample store, valid until the dataset is modified
+    const SampleMatrix &GetSampleMatrix() const {return samples;}
+    SampleView GetSampleView() const {return samples.View();}
+    SampleView GetSampleDimsView(const ivec inputDims, const int outputDim=-1) const;
+    static ivec GetDimsColumns(const ivec inputDims, const int outputDim=-1);
 
     int GetLabel(const int index) const {return index < labels.size() ? labels[index] : 0;}
-    ivec GetLabels() const {return labels;}
+    const ivec &GetLabels() const {return labels;}
 	void SetLabel(int index, int label){if(index<labels.size())labels[index] = label;}
     void SetLabels(ivec labels){this->labels = labels;}
+    void SetLabels(const ivec &indices, const int label);
 
     std::string GetCategorical(const int dimension,const  int value) const ;
     bool IsCategorical(const int dimension) const ;
@@ -203,7 +222,7 @@ public:
     void RemoveSequence(const unsigned int index);
 
     ipair const GetSequence(const unsigned int index) const {return index < sequences.size() ? sequences[index] : ipair(-1,-1);}
-    std::vector< ipair > GetSequences() const {return sequences;}
+    const std::vector< ipair > &GetSequences() const {return sequences;}
     std::vector< std::vector<fvec> > GetTrajectories(const int resampleType, const int resampleCount, const int centerType, const float dT, const int zeroEnding) const ;
 
 	// functions to manage obstacles
@@ -211,7 +230,7 @@ public:
     void AddObstacle(const fvec center, const fvec axes, const float angle, const fvec power, const fvec repulsion);
     void AddObstacles(const std::vector<Obstacle> newObstacles);
     void RemoveObstacle(const unsigned int index);
-    std::vector< Obstacle > GetObstacles() const {return obstacles;}
+    const std::vector< Obstacle > &GetObstacles() const {return obstacles;}
     Obstacle GetObstacle(const unsigned int index) const {return index < obstacles.size() ? obstacles[index] : Obstacle();}
 
 	// functions to manage rewards
@@ -228,12 +247,22 @@ public:
 	// functions to manage flags
     dsmFlags GetFlag(const int index) const {return index < flags.size() ? flags[index] : _UNUSED;}
     void SetFlag(const int index, const dsmFlags flag){if(index < flags.size()) flags[index] = flag;}
-    std::vector<dsmFlags> GetFlags() const {return flags;}
+    void SetFlags(const ivec &indices, const dsmFlags flag);
+    const std::vector<dsmFlags> &GetFlags() const {return flags;}
     std::vector<bool> GetFreeFlags() const ;
 	void ResetFlags();
 
-    void Save(const char *filename);
+    // in streaming mode only the subset is saved, and never over the file being streamed
+    bool Save(const char *filename, const bool bBinary=false);
 	bool Load(const char *filename);
+    bool SaveBinary(const char *filename) const;
+    bool LoadBinary(const char *filename);
+    static bool IsBinaryFile(const char *filename, size_t *payloadSize=0);
+
+    // streaming mode: the samples stay on disk and only previewCount of them are loaded for display
+    bool LoadStream(const char *filename, const int previewCount=100000, const int blockRows=65536, const int maxCachedBlocks=8);
+    bool IsStreaming() const {return stream != 0;}
+    const DatasetStream *GetStream() const {return stream;}
 };
 
 #endif // _DATASET_MANAGER_H_
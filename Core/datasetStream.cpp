@@ -0,0 +1,185 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#include "datasetStream.h"
+#include "binaryDataset.h"
+#include <vector>
+
+using namespace std;
+
+DatasetStream::DatasetStream()
+    : sampleOffset(0), labelOffset(0), count(0), dim(0), blockRows(65536), maxCachedBlocks(8)
+{}
+
+DatasetStream::~DatasetStream()
+{
+    Close();
+}
+
+bool DatasetStream::Open(const char *filename, const int blockRows, const int maxCachedBlocks)
+{
+    Close();
+    file.open(filename, ios::binary);
+    if(!file.is_open()) return false;
+
+    BinaryHeader header;
+    file.read((char *)&header, sizeof(BinaryHeader));
+    if(file.gcount() != sizeof(BinaryHeader) || memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) ||
+            header.version > binaryVersion || header.endianTag != binaryEndianTag)
+    {
+        Close();
+        return false;
+    }
+    vector<BinarySectionEntry> table(header.sectionCount);
+    if(header.sectionCount) file.read((char *)&table[0], header.sectionCount*sizeof(BinarySectionEntry));
+    if(!file.good())
+    {
+        Close();
+        return false;
+    }
+    FOR(i, table.size())
+    {
+        if(table[i].type == BIN_SAMPLES && table[i].size == (uint64_t)header.sampleCount*header.dim*sizeof(float)) sampleOffset = table[i].offset;
+        if(table[i].type == BIN_LABELS && table[i].size == (uint64_t)header.sampleCount*sizeof(int32_t)) labelOffset = table[i].offset;
+    }
+    if(!sampleOffset || !header.sampleCount || !header.dim)
+    {
+        Close();
+        return false;
+    }
+    this->filename = filename;
+    this->blockRows = max(1, blockRows);
+    this->maxCachedBlocks = max(1, maxCachedBlocks);
+    count = header.sampleCount;
+    dim = header.dim;
+    return true;
+}
+
+void DatasetStream::Close()
+{
+    if(file.is_open()) file.close();
+    file.clear();
+    blocks.clear();
+    blockMap.clear();
+    filename.clear();
+    sampleOffset = labelOffset = 0;
+    count = dim = 0;
+}
+
+const DatasetStream::Block &DatasetStream::Fetch(const int index) const
+{
+    map<int, list<Block>::iterator>::iterator it = blockMap.find(index);
+    if(it != blockMap.end())
+    {
+        // move the block to the front of the usage list
+        blocks.splice(blocks.begin(), blocks, it->second);
+        return blocks.front();
+    }
+
+    // we recycle the least recently used block instead of reallocating its buffers
+    if((int)blocks.size() >= maxCachedBlocks)
+    {
+        blockMap.erase(blocks.back().index);
+        blocks.splice(blocks.begin(), blocks, --blocks.end());
+    }
+    else blocks.push_front(Block());
+    Block &block = blocks.front();
+    block.index = index;
+    blockMap[index] = blocks.begin();
+
+    int start = index*blockRows;
+    int rows = max(0, min(blockRows, count - start));
+    block.samples.Resize(rows, dim);
+    block.labels.resize(rows, 0);
+    if(!rows) return block;
+
+    file.clear();
+    file.seekg(sampleOffset + (uint64_t)start*dim*sizeof(float));
+    file.read((char *)block.samples.Data(), (size_t)rows*dim*sizeof(float));
+    if(labelOffset)
+    {
+        vector<int32_t> buffer(rows);
+        file.seekg(labelOffset + (uint64_t)start*sizeof(int32_t));
+        file.read((char *)&buffer[0], rows*sizeof(int32_t));
+        FOR(i, rows) block.labels[i] = buffer[i];
+    }
+    else std::fill(block.labels.begin(), block.labels.end(), 0);
+    return block;
+}
+
+SampleView DatasetStream::GetBlockView(const int block) const
+{
+    if(block < 0 || block >= BlockCount()) return SampleView();
+    return Fetch(block).samples.View();
+}
+
+SampleView DatasetStream::GetBlockView(const int block, const ivec &columns) const
+{
+    if(block < 0 || block >= BlockCount()) return SampleView();
+    return Fetch(block).samples.View(columns);
+}
+
+const ivec &DatasetStream::GetBlockLabels(const int block) const
+{
+    static const ivec empty;
+    if(block < 0 || block >= BlockCount()) return empty;
+    return Fetch(block).labels;
+}
+
+fvec DatasetStream::GetSample(const int index) const
+{
+    if(index < 0 || index >= count) return fvec();
+    return Fetch(index / blockRows).samples.Row(index % blockRows);
+}
+
+int DatasetStream::GetLabel(const int index) const
+{
+    if(index < 0 || index >= count) return 0;
+    return Fetch(index / blockRows).labels[index % blockRows];
+}
+
+void DatasetStream::Reservoir(const int k, SampleMatrix &subset, ivec &subsetLabels, ivec &subsetIndices, const int seed) const
+{
+    int size = min(k, count);
+    subset.Resize(size, dim);
+    subsetLabels.resize(size);
+    subsetIndices.resize(size);
+    if(!size) return;
+
+    // rand() does not reach past RAND_MAX, we use a 64 bit LCG to cover the whole file
+    uint64_t state = (uint64_t)seed*6364136223846793005ULL + 1442695040888963407ULL;
+    FOR(b, BlockCount())
+    {
+        const Block &block = Fetch(b);
+        int start = b*blockRows;
+        FOR(i, block.samples.Rows())
+        {
+            int index = start + i;
+            int slot = index;
+            if(index >= size)
+            {
+                state = state*6364136223846793005ULL + 1442695040888963407ULL;
+                slot = (int)((state >> 33) % (uint64_t)(index+1));
+                if(slot >= size) continue;
+            }
+            memcpy(subset.RowData(slot), block.samples.RowData(i), dim*sizeof(float));
+            subsetLabels[slot] = block.labels[i];
+            subsetIndices[slot] = index;
+        }
+    }
+}
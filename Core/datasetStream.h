@@ -0,0 +1,95 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#ifndef _DATASET_STREAM_H_
+#define _DATASET_STREAM_H_
+
+#include <fstream>
+#include <list>
+#include <map>
+#include <string>
+#include <stdint.h>
+#include "sampleMatrix.h"
+
+// out-of-core access to the samples of a binary .ml dataset
+// the samples are read by blocks of consecutive rows, at most maxCachedBlocks of them are kept in memory
+// and the least recently used one is evicted when a new block is needed
+class DatasetStream
+{
+    struct Block
+    {
+        int index;
+        SampleMatrix samples;
+        ivec labels;
+    };
+
+    std::string filename;
+    mutable std::ifstream file;
+    uint64_t sampleOffset, labelOffset;
+    int count, dim;
+    int blockRows, maxCachedBlocks;
+
+    mutable std::list<Block> blocks; // most recently used first
+    mutable std::map<int, std::list<Block>::iterator> blockMap;
+
+    const Block &Fetch(const int index) const;
+
+    DatasetStream(const DatasetStream &);
+    DatasetStream& operator= (const DatasetStream &);
+
+public:
+    DatasetStream();
+    ~DatasetStream();
+
+    bool Open(const char *filename, const int blockRows=65536, const int maxCachedBlocks=8);
+    void Close();
+    bool IsOpen() const {return count > 0;}
+    std::string GetFilename() const {return filename;}
+
+    int Count() const {return count;}
+    int Dim() const {return dim;}
+    int BlockRows() const {return blockRows;}
+    int BlockCount() const {return count ? (count + blockRows - 1) / blockRows : 0;}
+    int BlockStart(const int block) const {return block*blockRows;}
+    bool HasLabels() const {return labelOffset != 0;}
+
+    // views are valid until maxCachedBlocks other blocks have been requested
+    SampleView GetBlockView(const int block) const;
+    SampleView GetBlockView(const int block, const ivec &columns) const;
+    const ivec &GetBlockLabels(const int block) const;
+    fvec GetSample(const int index) const;
+    int GetLabel(const int index) const;
+
+    // uniform subset of k samples drawn in a single pass over the file (reservoir sampling)
+    void Reservoir(const int k, SampleMatrix &subset, ivec &subsetLabels, ivec &subsetIndices, const int seed=0) const;
+
+    // feeds every block to a learner exposing the StreamPasses/StreamBegin/StreamBlock/StreamEnd hooks
+    template<typename T> void Train(T *learner, const ivec &columns=ivec()) const
+    {
+        int passes = learner->StreamPasses();
+        int dimCount = columns.size() ? columns.size() : dim;
+        for(int pass=0; pass<passes; pass++)
+        {
+            learner->StreamBegin(pass, dimCount);
+            for(int b=0; b<BlockCount(); b++) learner->StreamBlock(GetBlockView(b, columns));
+            if(!learner->StreamEnd(pass)) break;
+        }
+    }
+};
+
+#endif // _DATASET_STREAM_H_
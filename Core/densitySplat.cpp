@@ -0,0 +1,118 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#include "densitySplat.h"
+#include "parallel.h"
+#include <atomic>
+#include <math.h>
+
+using namespace std;
+
+// smallest block of samples (or rows of pixels) worth a thread of its own
+const int splatSamplesPerThread = 16384;
+const int splatRowsPerThread = 32;
+// opacity of a pixel holding a single sample, the densest pixel is opaque
+const float splatMinAlpha = 0.35f;
+
+DensitySplat::DensitySplat(const int width, const int height)
+    : width(width), height(height), visible(0)
+{}
+
+int DensitySplat::Project(const SampleView &samples, const int xIndex, const int yIndex,
+                          const float sx, const float ox, const float sy, const float oy, const bvec &mask, const int threads)
+{
+    int count = samples.Rows();
+    pixels.assign(count, -1);
+    visible = 0;
+    if(!count || xIndex < 0 || yIndex < 0 || xIndex >= samples.Cols() || yIndex >= samples.Cols()) return 0;
+    atomic<int> total(0);
+    int threadCount = max(1, min(threads > 0 ? threads : ThreadCount(), count / splatSamplesPerThread));
+    ParallelRanges(count, [&](int start, int stop)
+    {
+        int inside = 0;
+        for(int i=start; i<stop; i++)
+        {
+            if(mask.size() && !mask[i]) continue;
+            const float *sample = samples.RowData(i);
+            float x = sx*sample[xIndex] + ox, y = sy*sample[yIndex] + oy;
+            if(!(x >= 0 && y >= 0 && x < width && y < height)) continue;
+            pixels[i] = (int)y*width + (int)x;
+            inside++;
+        }
+        total += inside;
+    }, threadCount);
+    visible = total;
+    return visible;
+}
+
+QImage DensitySplat::Render(const ivec &slots, const vector<QRgb> &palette, const int threads) const
+{
+    QImage image(max(1, width), max(1, height), QImage::Format_ARGB32);
+    image.fill(Qt::transparent);
+    if(!visible || !palette.size()) return image;
+    uchar *bits = image.bits(); // detaches once before the workers write to their own rows
+    int bytesPerLine = image.bytesPerLine();
+
+    // every band of rows goes through all the samples and accumulates the ones that fall in it
+    int bandCount = max(1, min(threads > 0 ? threads : ThreadCount(), height / splatRowsPerThread));
+    vector<int> bandMax(bandCount, 0);
+    vector< vector<float> > bandSums(bandCount);
+    ParallelFor(bandCount, [&](int b)
+    {
+        int y0 = (int)((long long)height*b/bandCount), y1 = (int)((long long)height*(b+1)/bandCount);
+        int first = y0*width, last = y1*width;
+        vector<float> &sums = bandSums[b]; // r,g,b,count of each pixel of the band
+        sums.assign((size_t)(last-first)*4, 0.f);
+        FOR(i, pixels.size())
+        {
+            int pixel = pixels[i];
+            if(pixel < first || pixel >= last) continue;
+            int slot = i < slots.size() ? slots[i] : 0;
+            QRgb color = palette[slot >= 0 && slot < (int)palette.size() ? slot : 0];
+            float *sum = &sums[(size_t)(pixel-first)*4];
+            sum[0] += qRed(color);
+            sum[1] += qGreen(color);
+            sum[2] += qBlue(color);
+            sum[3] += 1.f;
+        }
+        int densest = 0;
+        for(size_t p=3; p<sums.size(); p+=4) densest = max(densest, (int)sums[p]);
+        bandMax[b] = densest;
+    }, bandCount);
+
+    int densest = *max_element(bandMax.begin(), bandMax.end());
+    float logScale = densest > 1 ? (1.f - splatMinAlpha) / logf((float)densest) : 0.f;
+    ParallelFor(bandCount, [&](int b)
+    {
+        int y0 = (int)((long long)height*b/bandCount), y1 = (int)((long long)height*(b+1)/bandCount);
+        const vector<float> &sums = bandSums[b];
+        for(int y=y0; y<y1; y++)
+        {
+            QRgb *line = (QRgb *)(bits + (size_t)y*bytesPerLine);
+            const float *sum = &sums[(size_t)(y-y0)*width*4];
+            FOR(x, width)
+            {
+                float n = sum[x*4+3];
+                if(!n) continue;
+                float alpha = min(1.f, splatMinAlpha + logf(n)*logScale);
+                line[x] = qRgba((int)(sum[x*4]/n), (int)(sum[x*4+1]/n), (int)(sum[x*4+2]/n), (int)(alpha*255));
+            }
+        }
+    }, bandCount);
+    return image;
+}
@@ -0,0 +1,51 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#ifndef _DENSITY_SPLAT_H_
+#define _DENSITY_SPLAT_H_
+
+#include <vector>
+#include <QImage>
+#include "types.h"
+#include "sampleMatrix.h"
+
+// number of visible samples above which the canvas draws a density map instead of one glyph per sample
+const int sampleGlyphLimit = 20000;
+
+// density rendering of large sets of samples: every sample is binned into the pixel it falls on
+// and each pixel is painted with the mean color of its samples, more opaque where there are more of them
+class DensitySplat
+{
+    int width, height;
+    ivec pixels; // pixel index of each sample, -1 when it is off the canvas
+    int visible;
+
+public:
+    DensitySplat(const int width, const int height);
+
+    // bins the rows of samples at (sx*x + ox, sy*y + oy), x and y being their xIndex and yIndex columns
+    // rows with a false entry in mask are left out, returns the number of samples that landed on the canvas
+    int Project(const SampleView &samples, const int xIndex, const int yIndex,
+                const float sx, const float ox, const float sy, const float oy, const bvec &mask=bvec(), const int threads=0);
+    int Visible() const {return visible;}
+
+    // the color of sample i is palette[slots[i]]
+    QImage Render(const ivec &slots, const std::vector<QRgb> &palette, const int threads=0) const;
+};
+
+#endif // _DENSITY_SPLAT_H_
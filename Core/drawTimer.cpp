@@ -26,13 +26,20 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "public.h"
 #include "basicMath.h"
 #include "drawTimer.h"
+#include "parallel.h"
+#include "streamIntegrator.h"
 
 using namespace std;
 
+// side of the tiles of the decision maps and number of them kept in the cache (about 20kB each)
+const int mapTileSize = 64;
+const int maxCachedTiles = 1024;
+
 DrawTimer::DrawTimer(Canvas *canvas, QMutex *mutex)
     : refineLevel(0),
       refineMax(10),
-      perm(0),
+      bMapView(false),
+      cacheGeneration(0),
       canvas(canvas),
       w(0), h(0),
       dim(2),
@@ -47,13 +54,12 @@ DrawTimer::DrawTimer(Canvas *canvas, QMutex *mutex)
       bPaused(false),
       bRunning(false),
       bColorMap(true),
+      bAdaptiveMap(true),
       maximumVisitedCount(0)
 {}
 
 DrawTimer::~DrawTimer()
-{
-    KILL(perm);
-}
+{}
 
 void DrawTimer::Stop()
 {
@@ -64,16 +70,13 @@ void DrawTimer::Clear()
 {
     refineLevel = 0;
     maximumVisitedCount = 0;
-    //if(!perm || w != canvas->width() || h != canvas->height())
-    //{
-    //    KILL(perm);
-    //    perm = randPerm(w*h);
-    //}
     w = canvas->width();
     h = canvas->height();
     drawMutex.lock();
-    KILL(perm);
-    perm = randPerm(w*h);
+    // the model has changed, none of the cached tiles can be reused
+    caches.clear();
+    cacheGeneration++;
+    bMapView = false;
     bigMap = QImage(QSize(w,h), QImage::Format_ARGB32);
     bigMap.fill(0xffffff);
     modelMap = QImage(QSize(w,h), QImage::Format_ARGB32);
@@ -93,6 +96,66 @@ void DrawTimer::Clear()
     */
 }
 
+// the canvas has been panned, zoomed or resized: the maps are painted again but the cached tiles are kept
+void DrawTimer::ViewChanged()
+{
+    refineLevel = 0;
+    maximumVisitedCount = 0;
+}
+
+// needs the canvas mutex
+MapView DrawTimer::CurrentView()
+{
+    MapView view;
+    view.width = canvas->width();
+    view.height = canvas->height();
+    view.xIndex = canvas->xIndex;
+    view.yIndex = canvas->yIndex;
+    view.bRestrictedDims = inputDims.size() == 2 && view.xIndex == inputDims.front() && view.yIndex == inputDims.back();
+    view.sx = 1.f / (canvas->zoom*canvas->zooms[view.xIndex]*view.height);
+    view.sy = 1.f / (canvas->zoom*canvas->zooms[view.yIndex]*view.height);
+    fvec center = canvas->center;
+    view.ox = (int)floor(center[view.xIndex] / (double)view.sx - view.width*0.5 + 0.5);
+    view.oy = (int)floor(-center[view.yIndex] / (double)view.sy - view.height*0.5 + 0.5);
+    if(view.bRestrictedDims) {
+        fvec newCenter(2,0);
+        newCenter[0] = center[view.xIndex];
+        newCenter[1] = center[view.yIndex];
+        center = newCenter;
+    }
+    view.center = center;
+    return view;
+}
+
+// starts painting the current view, the map of the previous one is stretched over it until its tiles are ready
+void DrawTimer::ResetView()
+{
+    refineLevel = 0;
+    maximumVisitedCount = 0;
+    mutex->lock();
+    MapView view = CurrentView();
+    mutex->unlock();
+    drawMutex.lock();
+    QImage previous = bigMap;
+    w = view.width;
+    h = view.height;
+    bigMap = QImage(QSize(w,h), QImage::Format_ARGB32);
+    bigMap.fill(0xffffff);
+    if(bMapView && !previous.isNull() && view.xIndex == mapView.xIndex && view.yIndex == mapView.yIndex &&
+            view.bRestrictedDims == mapView.bRestrictedDims) {
+        float scaleX = mapView.sx / view.sx, scaleY = mapView.sy / view.sy;
+        QPainter painter(&bigMap);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.translate(mapView.ox*scaleX - view.ox, mapView.oy*scaleY - view.oy);
+        painter.scale(scaleX, scaleY);
+        painter.drawImage(0, 0, previous);
+    }
+    mapView = view;
+    modelMap = QImage(QSize(w,h), QImage::Format_ARGB32);
+    modelMap.fill(qRgba(255, 255, 255, 0));
+    drawMutex.unlock();
+}
+
 void DrawTimer::run()
 {
     bRunning = true;
@@ -177,38 +240,31 @@ void DrawTimer::Animate()
         vector<fvec> targets = canvas->targets;
         ivec ages = canvas->targetAge;
         drawMutex.unlock();
-        if((*dynamical)->avoid) (*dynamical)->avoid->SetObstacles(obstacles);
 
         vector< vector<fvec> > trajectories(targets.size());
-        // animate each target
         FOR(i, targets.size())
         {
             ages[i]++;
             if(ages[i] > 400) ages[i] = 0; // we restart
-
-            vector<fvec> targetTrajectory(ages[i]+1);
-            fvec sample = targets[i];
-            targetTrajectory[0] = sample;
-            FOR(j, ages[i])
-            {
-                fvec res = (*dynamical)->Test(sample);
-                if((*dynamical)->avoid)
-                {
-                    fvec newRes = (*dynamical)->avoid->Avoid(sample, res);
-                    sample += newRes*dT;
-                }
-                else sample += res*dT;
-                targetTrajectory[j+1] = sample;
-            }
-            if(ages[i] > 2)
-            {
-                fvec diff = targetTrajectory[ages[i]] - targetTrajectory[ages[i]-1];
-                float speed = 0;
-                FOR(d, diff.size()) speed += diff[d]*diff[d];
-                speed = sqrtf(speed);
-                if(speed <= 1e-5) ages[i] = 0;
-            }
-            trajectories[i] = targetTrajectory;
+            trajectories[i].push_back(targets[i]);
+        }
+        // all the targets move together, each one for as many steps as its age
+        StreamIntegrator integrator(*dynamical);
+        integrator.dT = dT;
+        integrator.stopSpeed = 1e-5f/dT;
+        integrator.SetObstacles(obstacles);
+        SampleMatrix positions(targets);
+        bvec active(targets.size(), true);
+        for(int j=0;; j++)
+        {
+            FOR(i, targets.size()) if(j >= ages[i]) active[i] = false;
+            if(!integrator.Step(positions, active)) break;
+            FOR(i, targets.size()) if(active[i]) trajectories[i].push_back(positions.Row(i));
+        }
+        // the targets that stopped at an attractor start over
+        FOR(i, targets.size())
+        {
+            if(ages[i] > 2 && (int)trajectories[i].size() < ages[i]+1) ages[i] = 0;
         }
         mutex->unlock();
 
@@ -368,12 +424,12 @@ void DrawTimer::Refine()
         return;
     }
     if(canvas->width() != w || canvas->height() != h) {
-        Clear();
+        ResetView();
         return;
     }
     bool bRefined = true;
     if(refineLevel == 0) {
-        Clear();
+        ResetView();
         if((maximizer && (*maximizer)) || (reinforcement && (*reinforcement))) {
             refineMax = 100;
         }
@@ -386,11 +442,6 @@ void DrawTimer::Refine()
             refineMax = 32;
         }
     } else {
-        int count = (w*h) / refineMax;
-        int start = count * (refineLevel-1);
-        int stop = count * refineLevel;
-        if(refineLevel == refineMax) stop = w*h; // we want to be sure we paint everything in the end
-
         if(maximizer && (*maximizer)) {
             Maximization();
             if((*maximizer)->hasConverged()) refineLevel=refineMax+1;
@@ -411,7 +462,8 @@ void DrawTimer::Refine()
         mutex->unlock();
 
         if(dim == 2) {
-            bRefined &= TestFast(start,stop); // we finish the current batch
+            bRefined &= TestFast(refineMax); // we paint the next slice of every tile
+            if(bRefined && !(dynamical && (*dynamical)) && MapComplete()) refineLevel = refineMax; // every tile is finished
             if(dynamical && (*dynamical)) {
                 int cnt = 10000 / refineMax;
                 int steps = 8;
@@ -444,39 +496,50 @@ bool DrawTimer::Vectors(int count, int steps)
     vector<Obstacle> obstacles = canvas->data->GetObstacles();
     mutex->unlock();
     //float dT = 0.02f;
-    fvec sample(2,0);
     int w = canvas->width();
     int h = canvas->height();
     QMutexLocker drawLock(&drawMutex);
     QPainter painter(&modelMap);
     painter.setRenderHint(QPainter::Antialiasing, true);
 
+    // all the streamlines are integrated together, the ones that reach an attractor stop being drawn
+    SampleMatrix samples;
+    vector<QPointF> oldPoints(count);
     FOR(i, count)
     {
         QPointF samplePre(rand()/(float)RAND_MAX * w, rand()/(float)RAND_MAX * h);
-        sample = canvas->toSampleCoords(samplePre);
-        float color = 0; // 255 - (rand()/(float)RAND_MAX*0.7f)*255.f;
-        QPointF oldPoint = canvas->toCanvasCoords(sample);
-        FOR(j, steps)
+        fvec sample = canvas->toSampleCoords(samplePre);
+        samples.AddRow(sample);
+        oldPoints[i] = canvas->toCanvasCoords(sample);
+    }
+    int dim = samples.Cols();
+    int xIndex = canvas->xIndex, yIndex = canvas->yIndex;
+    float color = 0; // 255 - (rand()/(float)RAND_MAX*0.7f)*255.f;
+    QColor c(color,color,color);
+    painter.setPen(QPen(c, 0.25));
+    bvec active(count, true);
+    FOR(j, steps)
+    {
+        fvec previous(samples.Data(), samples.Data() + count*dim);
         {
+            QMutexLocker lock(mutex);
             if(!(*dynamical)) return false;
-            mutex->lock();
-            fvec res = (*dynamical)->Test(sample);
-            if((*dynamical)->avoid)
-            {
-                (*dynamical)->avoid->SetObstacles(obstacles);
-                fvec newRes = (*dynamical)->avoid->Avoid(sample, res);
-                res = newRes;
-            }
-            mutex->unlock();
-            sample += res*dT;
-            float speed = sqrtf(res[0]*res[0] + res[1]*res[1]);
-            QPointF point = canvas->toCanvasCoords(sample);
+            StreamIntegrator integrator(*dynamical);
+            integrator.dT = dT;
+            integrator.SetObstacles(obstacles);
+            if(!integrator.Step(samples, active)) break;
+        }
+        float *data = samples.Data();
+        FOR(i, count)
+        {
+            if(!active[i]) continue;
+            float dx = data[i*dim + xIndex] - previous[i*dim + xIndex];
+            float dy = data[i*dim + yIndex] - previous[i*dim + yIndex];
+            float speed = sqrtf(dx*dx + dy*dy) / dT;
+            QPointF point = canvas->toCanvasCoords(data[i*dim + xIndex], data[i*dim + yIndex]);
             painter.setOpacity(1 - speed);
-            QColor c(color,color,color);
-            painter.setPen(QPen(c, 0.25));
-            painter.drawLine(point, oldPoint);
-            oldPoint = point;
+            painter.drawLine(point, oldPoints[i]);
+            oldPoints[i] = point;
         }
     }
     return true;
@@ -725,47 +788,55 @@ bool DrawTimer::VectorsFast(int count, int steps)
 {
     if(!(*dynamical)) return false;
     if(!bRunning || !mutex) return false;
-    QPointF oldPoint(-FLT_MAX,-FLT_MAX);
-    QPointF oldPointUp(-FLT_MAX,-FLT_MAX);
-    QPointF oldPointDown(-FLT_MAX,-FLT_MAX);
     mutex->lock();
     float dT = (*dynamical)->dT;// * (dynamical->count/100.f);
     mutex->unlock();
     //float dT = 0.02f;
-    fvec sample;
-    sample.resize(2,0);
     int w = canvas->width();
     int h = canvas->height();
     QMutexLocker drawLock(&drawMutex);
     QPainter painter(&modelMap);
     painter.setRenderHint(QPainter::Antialiasing, true);
     vector<Obstacle> obstacles = canvas->data->GetObstacles();
+
+    // all the streamlines are integrated together, the ones that reach an attractor stop being drawn
+    SampleMatrix samples;
+    vector<QPointF> oldPoints(count);
     FOR(i, count)
     {
         QPointF samplePre(rand()/(float)RAND_MAX * w, rand()/(float)RAND_MAX * h);
-        sample = canvas->toSampleCoords(samplePre);
-        float color = bColorMap ? 255 : 0;
-        QPointF oldPoint = canvas->toCanvasCoords(sample);
-        FOR(j, steps)
+        fvec sample = canvas->toSampleCoords(samplePre);
+        samples.AddRow(sample);
+        oldPoints[i] = canvas->toCanvasCoords(sample);
+    }
+    int dim = samples.Cols();
+    int xIndex = canvas->xIndex, yIndex = canvas->yIndex;
+    float color = bColorMap ? 255 : 0;
+    QColor c(color,color,color);
+    painter.setPen(QPen(c, 0.25));
+    bvec active(count, true);
+    FOR(j, steps)
+    {
+        fvec previous(samples.Data(), samples.Data() + count*dim);
         {
+            QMutexLocker lock(mutex);
             if(!(*dynamical)) return false;
-            mutex->lock();
-            fvec res = (*dynamical)->Test(sample);
-            if((*dynamical)->avoid)
-            {
-                (*dynamical)->avoid->SetObstacles(obstacles);
-                fvec newRes = (*dynamical)->avoid->Avoid(sample, res);
-                res = newRes;
-            }
-            mutex->unlock();
-            sample += res*dT;
-            float speed = sqrtf(res[0]*res[0] + res[1]*res[1]);
-            QPointF point = canvas->toCanvasCoords(sample);
+            StreamIntegrator integrator(*dynamical);
+            integrator.dT = dT;
+            integrator.SetObstacles(obstacles);
+            if(!integrator.Step(samples, active)) break;
+        }
+        float *data = samples.Data();
+        FOR(i, count)
+        {
+            if(!active[i]) continue;
+            float dx = data[i*dim + xIndex] - previous[i*dim + xIndex];
+            float dy = data[i*dim + yIndex] - previous[i*dim + yIndex];
+            float speed = sqrtf(dx*dx + dy*dy) / dT;
+            QPointF point = canvas->toCanvasCoords(data[i*dim + xIndex], data[i*dim + yIndex]);
             painter.setOpacity(speed);
-            QColor c(color,color,color);
-            painter.setPen(QPen(c, 0.25));
-            painter.drawLine(point, oldPoint);
-            oldPoint = point;
+            painter.drawLine(point, oldPoints[i]);
+            oldPoints[i] = point;
         }
     }
     return true;
@@ -780,212 +851,455 @@ QColor DrawTimer::GetColor(Classifier *classifier, fvec sample, std::vector<Clas
         sample = newSample;
     }
 
-    QColor c;
-    if(classifier->IsMultiClass())
+    fvec val;
+    if(classifier->IsMultiClass()) val = classifier->TestMulti(sample);
+    else if(classifierMulti && (*classifierMulti).size())
     {
-        fvec val = classifier->TestMulti(sample);
-        if(!val.size()) return QColor(0,0,0);
-        else if(val.size() == 1)
-        {
-            float v = val[0];
-            int color = fabs(v)*128;
-            color = max(0,min(color, 255));
-            if(v > 0) c = QColor(color,0,0);
-            else c = QColor(color,color,color);
-        }
-        else
-        {
-            // we find the max
-            int maxVal = 0;
-            FOR(i, val.size()) if (val[maxVal] < val[i]) maxVal = i;
-            val[maxVal] *= 3;
-            float sum = 0;
-            FOR(i, val.size()) sum += fabs(val[i]);
-            sum = 1.f/sum;
+        val.resize((*classifierMulti).size(),0);
+        FOR(j, (*classifierMulti).size()) val[j] = (*classifierMulti)[j]->Test(sample);
+    }
+    else val.push_back(classifier->Test(sample));
+    if(!val.size()) return QColor(0,0,0);
+    return GetColor(classifier, &val[0], val.size());
+}
 
-            float r=0,g=0,b=0;
-            FOR(j, val.size())
-            {
-                int index = (classifier->inverseMap[j]%SampleColorCnt);
-                r += SampleColor[index].red()*val[j]*sum;
-                g += SampleColor[index].green()*val[j]*sum;
-                b += SampleColor[index].blue()*val[j]*sum;
-            }
-            r = max(0.f, min(255.f, r));
-            g = max(0.f, min(255.f, g));
-            b = max(0.f, min(255.f, b));
-            c = QColor(r,g,b);
-        }
+QColor DrawTimer::GetColor(Classifier *classifier, const float *scores, const int count)
+{
+    QColor c;
+    if(count == 1)
+    {
+        float v = scores[0];
+        int color = (int)(fabs(v)*128);
+        color = max(0,min(color, 255));
+        if(v > 0) c = QColor(color,0,0);
+        else c = QColor(color,color,color);
+        return c;
     }
-    else
+
+    // we find the max
+    fvec val(scores, scores + count);
+    int maxVal = 0;
+    FOR(i, count) if (val[maxVal] < val[i]) maxVal = i;
+    val[maxVal] *= 3;
+    float sum = 0;
+    FOR(i, count) sum += fabs(val[i]);
+    sum = 1.f/sum;
+
+    float r=0,g=0,b=0;
+    FOR(j, count)
     {
-        if(classifierMulti && (*classifierMulti).size())
-        {
-            // we find the max
-            int maxClass = 0;
-            float maxRes = -FLT_MAX;
-            fvec val((*classifierMulti).size(),0);
-            FOR(j, (*classifierMulti).size())
-            {
-                float res = (*classifierMulti)[j]->Test(sample);
-                val[j] = res;
-                if(res > maxRes)
-                {
-                    maxRes = res;
-                    maxClass = j;
-                }
-            }
-            val[maxClass] *= 3;
-            float sum = 0;
-            FOR(i, val.size()) sum += fabs(val[i]);
-            sum = 1.f/sum;
+        // operator[] would insert missing classes, and several workers color pixels at once
+        std::map<int,int>::const_iterator it = classifier->inverseMap.find(j);
+        int index = ((it != classifier->inverseMap.end() ? it->second : 0)%SampleColorCnt);
+        r += SampleColor[index].red()*val[j]*sum;
+        g += SampleColor[index].green()*val[j]*sum;
+        b += SampleColor[index].blue()*val[j]*sum;
+    }
+    r = max(0.f, min(255.f, r));
+    g = max(0.f, min(255.f, g));
+    b = max(0.f, min(255.f, b));
+    c = QColor(r,g,b);
+    return c;
+}
 
-            float r=0,g=0,b=0;
-            FOR(j, val.size())
-            {
-                //int index = j%SampleColorCnt;
-                int index = classifier->inverseMap[j]%SampleColorCnt;
-                r += SampleColor[index].red()*val[j]*sum;
-                g += SampleColor[index].green()*val[j]*sum;
-                b += SampleColor[index].blue()*val[j]*sum;
+// model space position of a node of the lattice
+inline void fromLattice(fvec &sample, const int x, const int y, const MapView &view)
+{
+    sample = view.center;
+    sample[view.bRestrictedDims ? 0 : view.xIndex] = x*view.sx;
+    sample[view.bRestrictedDims ? 1 : view.yIndex] = -y*view.sy;
+}
+
+// lattice tiles covered by the canvas, bounds included
+inline void visibleTiles(const MapView &view, int &tx0, int &ty0, int &tx1, int &ty1)
+{
+    tx0 = (int)floor(view.ox / (double)mapTileSize);
+    ty0 = (int)floor(view.oy / (double)mapTileSize);
+    tx1 = (int)floor((view.ox + view.width - 1) / (double)mapTileSize);
+    ty1 = (int)floor((view.oy + view.height - 1) / (double)mapTileSize);
+}
+
+// copies the part of a tile that lies on the canvas, from the tile to the map or the other way around
+inline void copyTile(MapTile &tile, QImage &map, const MapView &view, const bool bToMap)
+{
+    int x0 = max(0, tile.x - view.ox), x1 = min(view.width, tile.x - view.ox + mapTileSize);
+    int y0 = max(0, tile.y - view.oy), y1 = min(view.height, tile.y - view.oy + mapTileSize);
+    if(x0 >= x1) return;
+    for(int y=y0; y<y1; y++) {
+        QRgb *line = (QRgb *)map.scanLine(y) + x0;
+        QRgb *pixels = &tile.pixels[(y + view.oy - tile.y)*mapTileSize + x0 + view.ox - tile.x];
+        if(bToMap) memcpy(line, pixels, (x1-x0)*sizeof(QRgb));
+        else memcpy(pixels, line, (x1-x0)*sizeof(QRgb));
+    }
+}
+
+// slice of the pixels of a tile painted at a given refine level, the last level takes whatever is left
+inline void tileSlice(const int count, const int level, const int levels, int &start, int &stop)
+{
+    start = (int)((long long)count*(level-1)/levels);
+    stop = level >= levels ? count : (int)((long long)count*level/levels);
+}
+
+// spacing of the first grid tested in adaptive mode. A cell is interpolated rather than subdivided
+// when its corners differ by less than mapCellThreshold, or when the corners it just got through the model
+// were already within mapCellError of what its parent cell interpolated there
+const int mapCellSize = 8;
+const int mapCellThreshold = 8;
+const int mapCellError = 4;
+
+inline QRgb mixColors(const QRgb a, const QRgb b, const QRgb c, const QRgb d, const float u, const float v)
+{
+    float wa = (1-u)*(1-v), wb = u*(1-v), wc = (1-u)*v, wd = u*v;
+    int r = (int)(qRed(a)*wa + qRed(b)*wb + qRed(c)*wc + qRed(d)*wd + 0.5f);
+    int g = (int)(qGreen(a)*wa + qGreen(b)*wb + qGreen(c)*wc + qGreen(d)*wd + 0.5f);
+    int bl = (int)(qBlue(a)*wa + qBlue(b)*wb + qBlue(c)*wc + qBlue(d)*wd + 0.5f);
+    return qRgb(r, g, bl);
+}
+
+inline int colorDistance(const QRgb a, const QRgb b)
+{
+    return max(abs(qRed(a)-qRed(b)), max(abs(qGreen(a)-qGreen(b)), abs(qBlue(a)-qBlue(b))));
+}
+
+inline bool similarColors(const QRgb a, const QRgb b, const QRgb c, const QRgb d)
+{
+    int r0 = min(min(qRed(a), qRed(b)), min(qRed(c), qRed(d))), r1 = max(max(qRed(a), qRed(b)), max(qRed(c), qRed(d)));
+    int g0 = min(min(qGreen(a), qGreen(b)), min(qGreen(c), qGreen(d))), g1 = max(max(qGreen(a), qGreen(b)), max(qGreen(c), qGreen(d)));
+    int b0 = min(min(qBlue(a), qBlue(b)), min(qBlue(c), qBlue(d))), b1 = max(max(qBlue(a), qBlue(b)), max(qBlue(c), qBlue(d)));
+    return r1-r0 <= mapCellThreshold && g1-g0 <= mapCellThreshold && b1-b0 <= mapCellThreshold;
+}
+
+// one level of adaptive refinement of a tile: the corners of its pending cells go through the model,
+// every cell is filled by interpolating its corners and the cells whose corners disagree are split in four
+// tile.evaluated holds 1 + the distance between the color of a pixel and its interpolation before it was evaluated
+template<typename Evaluate>
+void refineTile(MapTile &tile, Evaluate evaluate)
+{
+    const int width = mapTileSize, height = mapTileSize;
+    bool bInit = tile.evaluated.empty();
+    if(bInit) {
+        tile.evaluated.assign(width*height, 0);
+        tile.cells.clear();
+        ivec xs, ys;
+        for(int x=0; x<width-1; x+=mapCellSize) xs.push_back(x);
+        for(int y=0; y<height-1; y+=mapCellSize) ys.push_back(y);
+        xs.push_back(width-1);
+        ys.push_back(height-1);
+        FOR(j, max(1, (int)ys.size()-1)) {
+            FOR(i, max(1, (int)xs.size()-1)) {
+                MapCell cell = {xs[i], ys[j], xs[min(i+1, (int)xs.size()-1)], ys[min(j+1, (int)ys.size()-1)]};
+                tile.cells.push_back(cell);
             }
-            r = max(0.f, min(255.f, r));
-            g = max(0.f, min(255.f, g));
-            b = max(0.f, min(255.f, b));
-            c = QColor(r,g,b);
         }
-        else
-        {
-            float v = classifier->Test(sample);
-            int color = (int)(fabs(v)*128);
-            color = max(0,min(color, 255));
-            if(v > 0) c = QColor(color,0,0);
-            else c = QColor(color,color,color);
+    }
+    if(tile.cells.empty()) return;
+
+    vector<u32> indices;
+    FOR(c, tile.cells.size()) {
+        const MapCell &cell = tile.cells[c];
+        u32 corners[4] = {(u32)(cell.y0*width + cell.x0), (u32)(cell.y0*width + cell.x1),
+                          (u32)(cell.y1*width + cell.x0), (u32)(cell.y1*width + cell.x1)};
+        FOR(k, 4) {
+            if(tile.evaluated[corners[k]]) continue;
+            tile.evaluated[corners[k]] = 255;
+            indices.push_back(corners[k]);
         }
     }
-    return c;
-}
+    sort(indices.begin(), indices.end());
+    vector<QRgb> colors;
+    if(indices.size() && !evaluate(&indices[0], indices.size(), colors)) {
+        FOR(i, indices.size()) tile.evaluated[indices[i]] = 0;
+        return;
+    }
+    FOR(i, indices.size()) {
+        if(!bInit) tile.evaluated[indices[i]] = 1 + min(253, colorDistance(tile.pixels[indices[i]], colors[i]));
+        tile.pixels[indices[i]] = colors[i];
+    }
 
-inline void fromCanvas(fvec &sample, const float x, const float y,
-                       const int height, const int width,
-                       const float zxh, const float zyh,
-                       int xIndex, int yIndex, const fvec &center, const bool bRestrictedDims)
-{
-    sample = center;
-    if(bRestrictedDims) {
-        sample[0] += (x - width*0.5f)*zxh;
-        sample[1] += (-y + height*0.5f)*zyh;
-    } else {
-        sample[xIndex] += (x - width*0.5f)*zxh;
-        sample[yIndex] += (-y + height*0.5f)*zyh;
+    vector<MapCell> children;
+    FOR(c, tile.cells.size()) {
+        const MapCell &cell = tile.cells[c];
+        QRgb a = tile.pixels[cell.y0*width + cell.x0], b = tile.pixels[cell.y0*width + cell.x1];
+        QRgb cc = tile.pixels[cell.y1*width + cell.x0], d = tile.pixels[cell.y1*width + cell.x1];
+        float du = cell.x1 > cell.x0 ? 1.f/(cell.x1-cell.x0) : 0;
+        float dv = cell.y1 > cell.y0 ? 1.f/(cell.y1-cell.y0) : 0;
+        for(int y=cell.y0; y<=cell.y1; y++) {
+            for(int x=cell.x0; x<=cell.x1; x++) {
+                if(tile.evaluated[y*width + x]) continue;
+                tile.pixels[y*width + x] = mixColors(a, b, cc, d, (x-cell.x0)*du, (y-cell.y0)*dv);
+            }
+        }
+        if(cell.x1-cell.x0 <= 1 && cell.y1-cell.y0 <= 1) continue; // all its pixels are corners
+        if(similarColors(a, b, cc, d)) continue;
+        if(!bInit) {
+            // the corners the cell got at this level tell how well its parent was interpolated
+            int error = 0, fresh = 0;
+            u32 corners[4] = {(u32)(cell.y0*width + cell.x0), (u32)(cell.y0*width + cell.x1),
+                              (u32)(cell.y1*width + cell.x0), (u32)(cell.y1*width + cell.x1)};
+            FOR(k, 4) {
+                if(!binary_search(indices.begin(), indices.end(), corners[k])) continue;
+                error = max(error, tile.evaluated[corners[k]]-1);
+                fresh++;
+            }
+            if(fresh && error <= mapCellError) continue;
+        }
+        // cells one pixel wide (or high) are only split along the other direction
+        int xs[3] = {cell.x0, (cell.x0+cell.x1)/2, cell.x1}, xCount = 3;
+        int ys[3] = {cell.y0, (cell.y0+cell.y1)/2, cell.y1}, yCount = 3;
+        if(cell.x1-cell.x0 <= 1) xs[1] = xs[2], xCount = 2;
+        if(cell.y1-cell.y0 <= 1) ys[1] = ys[2], yCount = 2;
+        FOR(j, yCount-1) {
+            FOR(i, xCount-1) {
+                MapCell child = {xs[i], ys[j], xs[i+1], ys[j+1]};
+                children.push_back(child);
+            }
+        }
     }
+    tile.cells.swap(children);
 }
 
-bool DrawTimer::TestFast(int start, int stop)
+bool DrawTimer::TestFast(int levels)
 {
-    if(stop < 0 || stop > w*h) stop = w*h;
     mutex->lock();
     int dim=canvas->data->GetDimCount();
     vector<Obstacle> obstacles = canvas->data->GetObstacles();
-    int xIndex = canvas->xIndex;
-    int yIndex = canvas->yIndex;
-    bool bRestrictedDims = false;
-    if(inputDims.size() == 2 && xIndex == inputDims.front() && yIndex == inputDims.back()) {
-        bRestrictedDims = true;
-        dim = 2;
-    }
-    int cheight = canvas->height();
-    int cwidth = canvas->width();
-    float zxh = 1.f / (canvas->zoom*canvas->zooms[xIndex]*cheight);
-    float zyh = 1.f / (canvas->zoom*canvas->zooms[yIndex]*cheight);
-    fvec center = canvas->center;
-    if(bRestrictedDims) {
-        fvec newCenter(2,0);
-        newCenter[0] = center[xIndex];
-        newCenter[1] = center[yIndex];
-        center = newCenter;
+    MapView view = CurrentView();
+    if(view.bRestrictedDims) dim = 2;
+    if(dim > 2) { // we dont want to draw multidimensional stuff, it's ... problematic
+        mutex->unlock();
+        return false;
+    }
+
+    // the workers test the models we see now, each of them writes the colors of its own tile
+    // and bigMap is only touched once they are all done
+    Classifier *classifierModel = *classifier;
+    bool bDynamical = !classifierModel && !(*regressor) && !(*clusterer) && *dynamical && bColorMap;
+    Dynamical *dynamicalModel = bDynamical ? *dynamical : 0;
+    Clusterer *clustererModel = !classifierModel && !(*regressor) ? *clusterer : 0;
+    bool bClassifier = classifierModel != 0, bClusterer = clustererModel != 0;
+    if(!bClassifier && !bDynamical && !bClusterer) {
+        mutex->unlock();
+        return true;
     }
+    vector<Classifier*> multi;
+    if(bClassifier && classifierMulti) multi = *classifierMulti;
+    ObstacleAvoidance *avoid = 0;
+    bool bThreadSafe = false;
+    if(bClassifier) {
+        bThreadSafe = classifierModel->IsThreadSafe();
+        if(!classifierModel->IsMultiClass()) FOR(i, multi.size()) bThreadSafe &= multi[i]->IsThreadSafe();
+    } else if(bDynamical) {
+        avoid = dynamicalModel->avoid;
+        if(avoid) avoid->SetObstacles(obstacles);
+        bThreadSafe = dynamicalModel->IsThreadSafe() && (!avoid || avoid->IsThreadSafe());
+    } else bThreadSafe = clustererModel->IsThreadSafe();
     mutex->unlock();
-    if(dim > 2) return false; // we dont want to draw multidimensional stuff, it's ... problematic
-    fvec sampleMatrix(dim*(stop-start));
-    vector<fvec> samples(stop-start);
-    vector<int> X(stop-start);
-    vector<int> Y(stop-start);
-    FOR(i, stop-start) {
-        drawMutex.lock();
-        if(!perm) perm = randPerm(w*h);
-        int x = perm[i+start]%w;
-        int y = perm[i+start]/w;
-        if(x >= bigMap.width() || y >= bigMap.height())
-        {
-            drawMutex.unlock();
-            continue;
+
+    // the unfinished tiles covering the canvas are taken out of the cache of the current scale while the workers run
+    // new tiles start from the preview ResetView left in bigMap
+    int tx0, ty0, tx1, ty1;
+    visibleTiles(view, tx0, ty0, tx1, ty1);
+    vector<MapTile> levelTiles;
+    drawMutex.lock();
+    int generation = cacheGeneration;
+    if((int)tileOrder.size() != mapTileSize*mapTileSize) {
+        u32 *perm = randPerm(mapTileSize*mapTileSize);
+        tileOrder.assign(perm, perm + mapTileSize*mapTileSize);
+        KILL(perm);
+    }
+    list<MapCache>::iterator cache = caches.begin();
+    while(cache != caches.end() && !cache->view.SameScale(view)) cache++;
+    if(cache == caches.end()) {
+        caches.push_front(MapCache());
+        caches.front().view = view;
+    } else caches.splice(caches.begin(), caches, cache);
+    map<pair<int,int>, MapTile> &cached = caches.front().tiles;
+    bool bPreview = bMapView && mapView == view && bigMap.width() == view.width && bigMap.height() == view.height;
+    for(int ty=ty0; ty<=ty1; ty++) {
+        for(int tx=tx0; tx<=tx1; tx++) {
+            map<pair<int,int>, MapTile>::iterator it = cached.find(make_pair(tx, ty));
+            if(it != cached.end()) {
+                if(it->second.bDone) continue;
+                levelTiles.push_back(std::move(it->second));
+                cached.erase(it);
+                continue;
+            }
+            MapTile tile;
+            tile.x = tx*mapTileSize;
+            tile.y = ty*mapTileSize;
+            tile.level = 0;
+            tile.bDone = false;
+            tile.pixels.assign(mapTileSize*mapTileSize, qRgba(255,255,255,0));
+            if(bPreview) copyTile(tile, bigMap, view, false);
+            levelTiles.push_back(std::move(tile));
         }
-        drawMutex.unlock();
-        X[i] = x;
-        Y[i] = y;
-        fromCanvas(samples[i], x, y, cheight, cwidth, zxh, zyh, xIndex, yIndex, center, bRestrictedDims);
     }
+    drawMutex.unlock();
 
-    FOR(i, stop-start) {
-        fvec& sample = samples[i];
-        int x = X[i];
-        int y = Y[i];
+    // colors of a set of pixels of a tile, the velocity field is never refined adaptively
+    bool bAdaptive = bAdaptiveMap && !bDynamical;
+    auto evaluate = [&](const MapTile &tile, const u32 *indices, const int count, vector<QRgb> &colors) -> bool
+    {
+        SampleMatrix samples;
+        samples.Resize(count, dim);
+        fvec sample;
+        FOR(i, count) {
+            u32 index = indices[i];
+            fromLattice(sample, tile.x + index%mapTileSize, tile.y + index/mapTileSize, view);
+            samples.SetRow(i, sample);
+        }
 
-        QMutexLocker lock(mutex);
-        if((*classifier)) {
-            QColor c = GetColor(*classifier, sample, classifierMulti);
-            drawMutex.lock();
-            bigMap.setPixel(x,y,c.rgb());
-            drawMutex.unlock();
-        } else if(*regressor) {
-            //fvec val = (*regressor)->Test(sample);
-        } else if(*clusterer) {
-            fvec res = (*clusterer)->Test(sample);
-            float r=0,g=0,b=0;
-            if(res.size() > 1) {
-                FOR(j, res.size()) {
-                    r += SampleColor[(j+1)%SampleColorCnt].red()*res[j];
-                    g += SampleColor[(j+1)%SampleColorCnt].green()*res[j];
-                    b += SampleColor[(j+1)%SampleColorCnt].blue()*res[j];
+        colors.resize(count);
+        if(bClassifier) {
+            fvec scores;
+            int outputs = Classifier::TestBatch(classifierModel, multi, samples.View(), scores);
+            if(!outputs) return false;
+            FOR(i, count) colors[i] = GetColor(classifierModel, &scores[(size_t)i*outputs], outputs).rgb();
+        } else if(bDynamical) {
+            fvec velocities, val(dim);
+            dynamicalModel->TestBatch(samples.View(), velocities);
+            if(avoid) avoid->AvoidBatch(samples.View(), velocities);
+            FOR(i, count) {
+                FOR(d, dim) val[d] = velocities[i*dim + d];
+                float speed = dim > 1 ? sqrtf(val[0]*val[0] + val[1]*val[1]) : fabs(val[0]);
+                speed = min(1.f,speed);
+                QColor color;
+                const int colorStyle = 1;
+                if(colorStyle == 0) {// velocity as colors
+                    int hue = (int)((atan2(val[0], val[1]) / (2*M_PI) + 0.5) * 359);
+                    hue = max(0, min(359,hue));
+                    color = QColor::fromHsv(hue, 255, 255);
+                    color.setRed(255*(1-speed) + color.red()*speed);
+                    color.setGreen(255*(1-speed) + color.green()*speed);
+                    color.setBlue(255*(1-speed) + color.blue()*speed);
+                } else if(colorStyle == 1) {// speed as color
+                    color = QColor(Canvas::GetColorMapValue(speed, 2));
                 }
-            } else if(res.size()) {
-                r = (1-res[0])*255 + res[0]* 255;
-                g = (1-res[0])*255;
-                b = (1-res[0])*255;
-            }
-            if( r < 10 && g < 10 && b < 10) r = b = g = 255;
-            r = max(0.f,min(255.f, r));
-            g = max(0.f,min(255.f, g));
-            b = max(0.f,min(255.f, b));
-            QColor c(r,g,b);
-            drawMutex.lock();
-            bigMap.setPixel(x,y,c.rgb());
-            drawMutex.unlock();
-        } else if(*dynamical && bColorMap) {
-            QColor color;
-            fvec val = (*dynamical)->Test(sample);
-            if((*dynamical)->avoid) {
-                (*dynamical)->avoid->SetObstacles(obstacles);
-                fVec newRes = (*dynamical)->avoid->Avoid(sample, val);
-                val = newRes;
+                colors[i] = color.rgb();
             }
-            float speed = sqrtf(val[0]*val[0] + val[1]*val[1]);
-            speed = min(1.f,speed);
-            const int colorStyle = 1;
-            if(colorStyle == 0) {// velocity as colors
-                int hue = (int)((atan2(val[0], val[1]) / (2*M_PI) + 0.5) * 359);
-                hue = max(0, min(359,hue));
-                color = QColor::fromHsv(hue, 255, 255);
-                color.setRed(255*(1-speed) + color.red()*speed);
-                color.setGreen(255*(1-speed) + color.green()*speed);
-                color.setBlue(255*(1-speed) + color.blue()*speed);
-            } else if(colorStyle == 1) {// speed as color
-                color = QColor(Canvas::GetColorMapValue(speed, 2));
+        } else {
+            fvec sampleMatrix(samples.Data(), samples.Data() + count*dim);
+            fvec results = clustererModel->TestMany(sampleMatrix, dim, count);
+            int resDim = results.size() / count;
+            FOR(i, count) {
+                const float *res = resDim ? &results[i*resDim] : 0;
+                float r=0,g=0,b=0;
+                if(resDim > 1) {
+                    FOR(j, resDim) {
+                        r += SampleColor[(j+1)%SampleColorCnt].red()*res[j];
+                        g += SampleColor[(j+1)%SampleColorCnt].green()*res[j];
+                        b += SampleColor[(j+1)%SampleColorCnt].blue()*res[j];
+                    }
+                } else if(resDim) {
+                    r = (1-res[0])*255 + res[0]* 255;
+                    g = (1-res[0])*255;
+                    b = (1-res[0])*255;
+                }
+                if( r < 10 && g < 10 && b < 10) r = b = g = 255;
+                r = max(0.f,min(255.f, r));
+                g = max(0.f,min(255.f, g));
+                b = max(0.f,min(255.f, b));
+                colors[i] = qRgb(r,g,b);
             }
-            drawMutex.lock();
-            bigMap.setPixel(x,y,color.rgb());
-            drawMutex.unlock();
+        }
+        return true;
+    };
+
+    auto paintTile = [&](MapTile &tile)
+    {
+        if(bAdaptive) {
+            refineTile(tile, [&](const u32 *indices, const int count, vector<QRgb> &colors)
+            {
+                return evaluate(tile, indices, count, colors);
+            });
+            tile.bDone = tile.evaluated.size() && tile.cells.empty();
+            if(tile.bDone) vector<unsigned char>().swap(tile.evaluated);
+            return;
+        }
+        // every tile goes through the same order, starting from a different point of it
+        int count = tileOrder.size(), start, stop;
+        tileSlice(count, tile.level+1, levels, start, stop);
+        u32 shift = ((u32)(tile.x/mapTileSize)*7919u + (u32)(tile.y/mapTileSize)*104729u) % count;
+        vector<u32> indices(stop-start);
+        FOR(i, stop-start) indices[i] = tileOrder[(start + i + shift) % count];
+        vector<QRgb> colors;
+        if(indices.size() && !evaluate(tile, &indices[0], indices.size(), colors)) return;
+        FOR(i, indices.size()) tile.pixels[indices[i]] = colors[i];
+        tile.level++;
+        tile.bDone = tile.level >= levels;
+    };
+
+    // the model is locked for one round of tiles at a time (one tile per worker), the gui thread paints,
+    // draws and trains under the same mutex and never waits for more than a round. Between two rounds
+    // the model may have been replaced (Clear bumps the generation before the old one is deleted)
+    // models that keep a scratch state while testing get a single worker
+    int workers = bThreadSafe ? ThreadCount() : 1;
+    for(int first=0; first<(int)levelTiles.size() && bRunning; first += workers) {
+        QMutexLocker lock(mutex);
+        drawMutex.lock();
+        bool bChanged = generation != cacheGeneration;
+        drawMutex.unlock();
+        bChanged |= *classifier != classifierModel || (bDynamical && *dynamical != dynamicalModel) || (bClusterer && *clusterer != clustererModel);
+        if(bChanged) return false;
+        int count = min(workers, (int)levelTiles.size() - first);
+        ParallelFor(count, [&](int t)
+        {
+            if(bRunning) paintTile(levelTiles[first + t]);
+        }, count);
+    }
+
+    QMutexLocker drawLock(&drawMutex);
+    if(generation != cacheGeneration) return false; // the model has changed in the meantime
+    cache = caches.begin();
+    while(cache != caches.end() && !cache->view.SameScale(view)) cache++;
+    if(cache == caches.end()) return false;
+    FOR(t, levelTiles.size()) {
+        MapTile &tile = levelTiles[t];
+        cache->tiles[make_pair(tile.x/mapTileSize, tile.y/mapTileSize)] = std::move(tile);
+    }
+
+    // we keep a bounded number of tiles, other scales go first and then the tiles out of sight
+    int tileCount = 0;
+    for(list<MapCache>::iterator it = caches.begin(); it != caches.end(); it++) tileCount += it->tiles.size();
+    while(tileCount > maxCachedTiles && caches.size() > 1) {
+        list<MapCache>::iterator last = --caches.end();
+        if(last == cache) last--;
+        tileCount -= last->tiles.size();
+        caches.erase(last);
+    }
+    for(map<pair<int,int>, MapTile>::iterator it = cache->tiles.begin(); tileCount > maxCachedTiles && it != cache->tiles.end();) {
+        int tx = it->first.first, ty = it->first.second;
+        if(tx >= tx0 && tx <= tx1 && ty >= ty0 && ty <= ty1) it++;
+        else {
+            cache->tiles.erase(it++);
+            tileCount--;
+        }
+    }
+
+    if(!bRunning) return false;
+    if(!(mapView == view) || bigMap.width() != view.width || bigMap.height() != view.height) return false;
+    for(int ty=ty0; ty<=ty1; ty++) {
+        for(int tx=tx0; tx<=tx1; tx++) {
+            map<pair<int,int>, MapTile>::iterator it = cache->tiles.find(make_pair(tx, ty));
+            if(it != cache->tiles.end()) copyTile(it->second, bigMap, view, true);
+        }
+    }
+    bMapView = true;
+    return true;
+}
+
+// true once every tile of the canvas is finished
+bool DrawTimer::MapComplete()
+{
+    QMutexLocker drawLock(&drawMutex);
+    if(!bMapView || caches.empty() || !caches.front().view.SameScale(mapView)) return false;
+    const map<pair<int,int>, MapTile> &cached = caches.front().tiles;
+    int tx0, ty0, tx1, ty1;
+    visibleTiles(mapView, tx0, ty0, tx1, ty1);
+    for(int ty=ty0; ty<=ty1; ty++) {
+        for(int tx=tx0; tx<=tx1; tx++) {
+            map<pair<int,int>, MapTile>::const_iterator it = cached.find(make_pair(tx, ty));
+            if(it == cached.end() || !it->second.bDone) return false;
         }
     }
     return true;
@@ -31,6 +31,56 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "glwidget.h"
 #include <QMutex>
 #include <QMutexLocker>
+#include <list>
+#include <atomic>
+
+// corners of a quadtree cell of a tile, in pixels from the top left of the tile
+struct MapCell
+{
+    int x0, y0, x1, y1;
+};
+
+// a square of the decision map, its pixels are painted in a random order, one slice per refine level
+// tiles sit on a lattice of model space with one node per pixel, which lets them survive a pan of the canvas
+struct MapTile
+{
+    int x, y; // lattice coordinates of the top left pixel
+    int level; // refine levels already painted
+    bool bDone;
+    std::vector<QRgb> pixels;
+
+    // adaptive refinement: which pixels went through the model
+    // and the cells whose corners disagree, which will be subdivided at the next level
+    std::vector<unsigned char> evaluated;
+    std::vector<MapCell> cells;
+};
+
+// the part of model space shown by the canvas, the lattice node of pixel (x,y) is (x+ox, y+oy)
+// and sits at sx*(x+ox), -sy*(y+oy) along the displayed dimensions
+struct MapView
+{
+    int width, height;
+    int xIndex, yIndex;
+    bool bRestrictedDims;
+    float sx, sy;
+    int ox, oy;
+    fvec center;
+    bool SameScale(const MapView &v) const
+    {
+        return xIndex == v.xIndex && yIndex == v.yIndex && bRestrictedDims == v.bRestrictedDims && sx == v.sx && sy == v.sy;
+    }
+    bool operator==(const MapView &v) const
+    {
+        return SameScale(v) && width == v.width && height == v.height && ox == v.ox && oy == v.oy;
+    }
+};
+
+// tiles already computed for one scale of the view
+struct MapCache
+{
+    MapView view;
+    std::map<std::pair<int,int>, MapTile> tiles;
+};
 
 class DrawTimer : public QThread
 {
@@ -41,7 +91,13 @@ private:
 	QImage bigMap;
 	QImage modelMap;
     QImage animationImage;
-	u32 *perm;
+    std::vector<u32> tileOrder; // painting order of the pixels of a tile
+    std::list<MapCache> caches; // most recently used scale first
+    MapView mapView; // view bigMap was painted for
+    bool bMapView;
+    int cacheGeneration;
+    MapView CurrentView();
+    void ResetView();
 	Canvas *canvas;
 	int w, h, dim;
 
@@ -52,7 +108,9 @@ public:
 	void Refine();
     void Animate();
 	void Clear();
-    bool TestFast(int start, int stop);
+    void ViewChanged();
+    bool TestFast(int levels);
+    bool MapComplete();
     bool Vectors(int count, int steps);
     bool VectorsGL(int count, int steps);
     bool VectorsFast(int count, int steps);
@@ -60,6 +118,7 @@ public:
     void Reinforce();
 	void Stop();
     static QColor GetColor(Classifier *classifier, fvec sample, std::vector<Classifier*> *classifierMulti=0, ivec sourceDims=ivec());
+    static QColor GetColor(Classifier *classifier, const float *scores, const int count);
 
 	Classifier **classifier;
 	Regressor **regressor;
@@ -73,8 +132,9 @@ public:
 	QMutex *mutex, drawMutex;
     GLWidget *glw;
     bool bPaused;
-	bool bRunning;
+	std::atomic<bool> bRunning;
 	bool bColorMap;
+    bool bAdaptiveMap; // classifier and clusterer maps are only tested where the colors change
     int maximumVisitedCount;
     ivec inputDims;
 
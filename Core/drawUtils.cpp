@@ -1233,22 +1233,29 @@ fvec ComputeDynamicalEntropy(Dynamical *dynamical, fvec mins, fvec maxes, int gr
     // we begin by generating a dense grid of values
     qDebug() << "dumping vectors to memory";
     vector<fvec> grid(gridSteps*gridSteps*gridSteps);
-    fvec sample(3);
+    SampleMatrix gridSamples;
+    gridSamples.Resize(grid.size(), 3);
     FOR(z, gridSteps)
     {
-        sample[2] = z / (float)gridSteps * (maxes[2]-mins[2]) + mins[2];
         FOR(y, gridSteps)
         {
-            sample[1] = y / (float)gridSteps * (maxes[1]-mins[1]) + mins[1];
             FOR(x, gridSteps)
             {
+                float *sample = gridSamples.RowData(x + (y + z*gridSteps)*gridSteps);
                 sample[0] = x / (float)gridSteps * (maxes[0]-mins[0]) + mins[0];
-                fvec res = dynamical->Test(sample);
-//                res = res/sqrtf(res*res); // we normalize it
-                grid[x + (y + z*gridSteps)*gridSteps] = res;
+                sample[1] = y / (float)gridSteps * (maxes[1]-mins[1]) + mins[1];
+                sample[2] = z / (float)gridSteps * (maxes[2]-mins[2]) + mins[2];
             }
         }
     }
+    // the whole grid goes through the model in a single batch
+    fvec velocities;
+    dynamical->TestBatch(gridSamples.View(), velocities);
+    FOR(i, grid.size())
+    {
+        grid[i] = fvec(velocities.begin() + i*3, velocities.begin() + (i+1)*3);
+//        grid[i] = grid[i]/sqrtf(grid[i]*grid[i]); // we normalize it
+    }
 
     if(!tesssphere) tesssphere = tessellatedSphere(1);
 
@@ -1751,6 +1758,29 @@ void Draw2DDynamical(Canvas *canvas, Dynamical *dynamical)
     int iterations = 4;
     float dT = 0.004;
     vector<Obstacle> obstacles = canvas->data->GetObstacles();
+    // the flow does not change between iterations, we evaluate it once on the whole image
+    SampleMatrix samples;
+    FOR(y, h)
+    {
+        FOR(x, w) samples.AddRow(canvas->fromCanvas(x,y));
+    }
+    fvec velocities;
+    dynamical->TestBatch(samples.View(), velocities);
+    int dim = samples.Cols();
+    if(dynamical->avoid) dynamical->avoid->SetObstacles(obstacles);
+    vector<QPointF> targets(w*h);
+    FOR(i, w*h)
+    {
+        fvec sample = samples.Row(i);
+        fvec res(velocities.begin() + i*dim, velocities.begin() + (i+1)*dim);
+        if(dynamical->avoid)
+        {
+            fvec newRes = dynamical->avoid->Avoid(sample, res);
+            res = newRes;
+        }
+        sample += res*dT;
+        targets[i] = canvas->toCanvasCoords(sample);
+    }
     qDebug() << "processing noise";
     FOR(i, iterations)
     {
@@ -1761,18 +1791,8 @@ void Draw2DDynamical(Canvas *canvas, Dynamical *dynamical)
             {
                 QPoint point(x,y);
                 QRgb val = pixels.pixel(point);
-                fvec sample = canvas->fromCanvas(x,y);
-                fvec res = dynamical->Test(sample);
-                if(dynamical->avoid)
-                {
-                    dynamical->avoid->SetObstacles(obstacles);
-                    fvec newRes = dynamical->avoid->Avoid(sample, res);
-                    res = newRes;
-                }
-                sample += res*dT;
-                QPointF point2 = canvas->toCanvasCoords(sample);
                 painter.setPen(QColor(val));
-                painter.drawLine(point, point2);
+                painter.drawLine(point, targets[x + y*w]);
                 //if(point.x() < 0 || point.x() >= w || point.y() < 0 || point.y() >= h) continue;
                 //pixels.setPixel(point.x(), point.y(), val);
             }
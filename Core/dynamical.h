@@ -22,6 +22,7 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include <mymaths.h>
 #include <obstacles.h>
 #include <vector>
+#include "sampleMatrix.h"
 
 extern "C" enum {DYN_SVR, DYN_RVM, DYN_GMR, DYN_GPR, DYN_KNN, DYN_MLP, DYN_LINEAR, DYN_LWPR, DYN_KRLS, DYN_SEDS, DYN_NONE} dynamicalType;
 
@@ -32,6 +33,7 @@ protected:
 	ivec classes;
 	ivec labels;
 	u32 dim;
+	bool bThreadSafe; // TestBatch leaves the model untouched and can run on several threads at once
 
 public:
 	std::vector<fvec> crossval;
@@ -42,15 +44,30 @@ public:
 	u32 count;
 	ObstacleAvoidance *avoid;
 
-	Dynamical(): type(DYN_NONE), count(100), dT(0.02f), avoid(0){}
+	Dynamical(): bThreadSafe(false), type(DYN_NONE), count(100), dT(0.02f), avoid(0){}
     virtual ~Dynamical(){if(avoid) delete avoid;}
     std::vector< std::vector<fvec> > GetTrajectories(){return trajectories;}
     int Dim(){return dim;}
+    bool IsThreadSafe() const {return bThreadSafe;}
 
     virtual void Train(std::vector< std::vector<fvec> > trajectories, ivec labels){}
     virtual std::vector<fvec> Test( const fvec &sample, const int count){ return std::vector<fvec>(); }
     virtual fvec Test( const fvec &sample){ return fvec(); }
     virtual fVec Test(const fVec &sample){ return fVec(Test((fvec)sample)); }
+    // computes the velocity at every row of samples at once: velocities receives samples.Cols() values per row (row-major)
+    // the output is resized to fit, which keeps its storage when it is reused across calls
+    virtual void TestBatch(const SampleView &samples, fvec &velocities)
+    {
+        int rows = samples.Rows(), cols = samples.Cols();
+        velocities.resize(rows*cols);
+        fvec sample(cols);
+        FOR(i, rows)
+        {
+            if(cols) samples.CopyRow(i, &sample[0]);
+            fvec res = Test(sample);
+            FOR(d, cols) velocities[i*cols + d] = d < (int)res.size() ? res[d] : 0;
+        }
+    }
     virtual const char *GetInfoString(){return NULL;}
     virtual void SaveModel(std::string filename){}
     virtual bool LoadModel(std::string filename){return false;}
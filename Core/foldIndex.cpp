@@ -0,0 +1,58 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#include "foldIndex.h"
+#include "basicMath.h"
+
+using namespace std;
+
+void FoldIndex::Windows(const int count, const int folds, const float trainRatio)
+{
+    Clear();
+    if(folds <= 0) return;
+    train.resize(folds);
+    test.resize(folds);
+    if(count <= 0) return;
+    int trainCount = (int)(trainRatio * count);
+    u32 *perm = randPerm(count);
+    FOR(f, folds)
+    {
+        int foldOffset = (f*count/folds);
+        ivec &trainRows = train[f], &testRows = test[f];
+        trainRows.resize(trainCount);
+        testRows.resize(count-trainCount);
+        FOR(i, count)
+        {
+            int index = perm[(foldOffset + i) % count];
+            if(i < trainCount) trainRows[i] = index;
+            else testRows[i-trainCount] = index;
+        }
+    }
+    KILL(perm);
+}
+
+SampleMatrix FoldIndex::Gather(const SampleView &samples, const ivec &indices)
+{
+    int cols = samples.Cols();
+    SampleMatrix rows(cols);
+    rows.Resize(indices.size(), cols);
+    if(!indices.size()) return rows;
+    float *data = rows.Data();
+    FOR(i, indices.size()) samples.CopyRow(indices[i], data + (size_t)i*cols);
+    return rows;
+}
@@ -0,0 +1,45 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#ifndef _FOLD_INDEX_H_
+#define _FOLD_INDEX_H_
+
+#include <vector>
+#include "types.h"
+#include "sampleMatrix.h"
+
+// the folds of a cross-validation as lists of rows of one sample block
+// the samples stay where they are: a fold only holds indices into them, shared by every model it evaluates
+class FoldIndex
+{
+    std::vector<ivec> train, test;
+
+public:
+    // every fold trains on a window of the same random permutation of the count rows and tests on the rest
+    void Windows(const int count, const int folds, const float trainRatio);
+    void Clear() {train.clear(); test.clear();}
+
+    int Count() const {return train.size();}
+    const ivec &Train(const int fold) const {return train[fold];}
+    const ivec &Test(const int fold) const {return test[fold];}
+
+    // the rows of samples listed in indices, in one block (e.g. for TestBatch)
+    static SampleMatrix Gather(const SampleView &samples, const ivec &indices);
+};
+
+#endif // _FOLD_INDEX_H_
@@ -0,0 +1,169 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#include "gramCache.h"
+#include "parallel.h"
+#include <math.h>
+
+using namespace std;
+
+// smallest matrix worth computing on several threads
+const int gramRowsPerThread = 256;
+
+// integer power by squaring, as libsvm computes its polynomial kernel
+static double powi(double base, int times)
+{
+    double value = 1.0;
+    for(int t=times; t>0; t/=2)
+    {
+        if(t%2 == 1) value *= base;
+        base *= base;
+    }
+    return value;
+}
+
+bool GramKernel::operator< (const GramKernel &k) const
+{
+    if(type != k.type) return type < k.type;
+    if(type != GRAM_LINEAR)
+    {
+        if(gamma != k.gamma) return gamma < k.gamma;
+        if(type != GRAM_RBF)
+        {
+            if(coef0 != k.coef0) return coef0 < k.coef0;
+            if(type == GRAM_POLY && degree != k.degree) return degree < k.degree;
+        }
+    }
+    return columns < k.columns;
+}
+
+double GramKernel::operator()(const float *a, const float *b, const double squareA, const double squareB) const
+{
+    int dim = columns.size();
+    double sum = 0;
+    switch(type)
+    {
+    case GRAM_RBF:
+        FOR(d, dim) sum += (double)a[d]*b[d];
+        return exp(-gamma*(squareA+squareB-2*sum));
+    case GRAM_POLY:
+        FOR(d, dim) sum += (double)a[d]*b[d];
+        return powi(gamma*sum + coef0, degree);
+    case GRAM_SIGMOID:
+        FOR(d, dim) sum += (double)a[d]*b[d];
+        return tanh(gamma*sum + coef0);
+    default:
+        FOR(d, dim) sum += (double)a[d]*b[d];
+        return sum;
+    }
+}
+
+GramMatrix::GramMatrix(const SampleView &samples, const GramKernel &kernel, const int threads)
+    : size(samples.Rows())
+{
+    values.resize((size_t)size*size);
+    // the kernel columns of every row and their <x,x>, packed once
+    int dim = kernel.columns.size();
+    vector<float> rows((size_t)size*dim + 1);
+    vector<double> squares(size, 0.);
+    FOR(i, size)
+    {
+        FOR(d, dim)
+        {
+            float value = samples(i, kernel.columns[d]);
+            rows[(size_t)i*dim + d] = value;
+            squares[i] += (double)value*value;
+        }
+    }
+    ParallelFor(size, [&](int i)
+    {
+        const float *a = &rows[(size_t)i*dim];
+        for(int j=i; j<size; j++)
+        {
+            double value = kernel(a, &rows[(size_t)j*dim], squares[i], squares[j]);
+            values[(size_t)i*size + j] = value;
+            values[(size_t)j*size + i] = value;
+        }
+    }, size >= gramRowsPerThread ? threads : 1);
+}
+
+GramCache::GramCache(const SampleView &samples, const size_t maxBytes, const int threads)
+    : samples(samples), maxBytes(maxBytes), bytes(0), threads(threads)
+{}
+
+shared_ptr<const GramMatrix> GramCache::Get(const GramKernel &kernel)
+{
+    size_t size = (size_t)samples.Rows()*samples.Rows()*sizeof(double);
+    if(!samples.Rows() || size > maxBytes) return shared_ptr<const GramMatrix>();
+    FOR(d, kernel.columns.size())
+    {
+        if(kernel.columns[d] < 0 || kernel.columns[d] >= samples.Cols()) return shared_ptr<const GramMatrix>();
+    }
+    shared_ptr<Entry> entry;
+    {
+        lock_guard<std::mutex> lock(mutex);
+        map< GramKernel, shared_ptr<Entry> >::iterator it = entries.find(kernel);
+        if(it != entries.end()) entry = it->second;
+        else
+        {
+            while(order.size() && bytes + size > maxBytes)
+            {
+                entries.erase(order.front());
+                order.pop_front();
+                bytes -= size;
+            }
+            entry = entries[kernel] = make_shared<Entry>();
+            order.push_back(kernel);
+            bytes += size;
+        }
+    }
+    // computed outside of the lock, the other threads asking for the same kernel wait here
+    call_once(entry->once, [&]{entry->gram = make_shared<GramMatrix>(samples, kernel, threads);});
+    return entry->gram;
+}
+
+bool GramScope::Match(const vector<fvec> &samples, const ivec &columns) const
+{
+    if(!cache || rows.size() != samples.size() || !samples.size()) return false;
+    const SampleView &block = cache->Samples();
+    FOR(d, columns.size())
+    {
+        if(columns[d] < 0 || columns[d] >= block.Cols()) return false;
+    }
+    // every sample is compared with its row, to be sure we were handed what the scope says
+    FOR(i, samples.size())
+    {
+        const fvec &sample = samples[i];
+        int row = rows[i];
+        if(row < 0 || row >= block.Rows()) return false;
+        FOR(d, columns.size())
+        {
+            if(columns[d] >= (int)sample.size() || sample[columns[d]] != block(row, columns[d])) return false;
+        }
+    }
+    return true;
+}
+
+shared_ptr<const GramMatrix> GramScope::Lookup(const GramScope *scope, const vector<fvec> &samples,
+                                               const GramKernel &kernel, ivec &rows)
+{
+    if(!scope || !scope->Match(samples, kernel.columns)) return shared_ptr<const GramMatrix>();
+    shared_ptr<const GramMatrix> gram = scope->cache->Get(kernel);
+    if(gram) rows = scope->rows;
+    return gram;
+}
@@ -0,0 +1,109 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#ifndef _GRAM_CACHE_H_
+#define _GRAM_CACHE_H_
+
+#include <vector>
+#include <map>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include "types.h"
+#include "sampleMatrix.h"
+
+// kernels of the cache, numbered as the libsvm kernel types
+enum {GRAM_LINEAR, GRAM_POLY, GRAM_RBF, GRAM_SIGMOID};
+
+// largest amount of memory the kernel matrices of one cache may take
+const size_t gramCacheBytes = 256*1024*1024;
+
+// a kernel and the columns of the samples it is computed on
+//   linear: <x,y>   poly: (gamma <x,y> + coef0)^degree   rbf: exp(-gamma (<x,x> + <y,y> - 2<x,y>))   sigmoid: tanh(gamma <x,y> + coef0)
+// the values are computed in double precision with the very operations of libsvm, which gets the same kernel
+// from the matrix as it would have computed itself
+struct GramKernel
+{
+    int type, degree;
+    double gamma, coef0;
+    ivec columns;
+    GramKernel(const int type=GRAM_RBF, const int degree=1, const double gamma=1, const double coef0=0, const ivec &columns=ivec())
+        : type(type), degree(degree), gamma(gamma), coef0(coef0), columns(columns) {}
+    bool operator< (const GramKernel &k) const;
+    // a and b hold the kernel columns only, squareA and squareB their <x,x> (used by the rbf kernel)
+    double operator()(const float *a, const float *b, const double squareA=0, const double squareB=0) const;
+};
+
+// symmetric kernel matrix of every pair of rows of a block of samples
+class GramMatrix
+{
+    int size;
+    std::vector<double> values;
+
+public:
+    GramMatrix(const SampleView &samples, const GramKernel &kernel, const int threads=0);
+    int Size() const {return size;}
+    const double *Data() const {return &values[0];}
+    double operator()(const int i, const int j) const {return values[(size_t)i*size + j];}
+};
+
+// kernel matrices of one immutable block of samples, shared by everything trained on rows of it
+// (e.g. the folds and parameters of a cross-validation). A matrix is computed the first time its kernel
+// is asked for, the threads asking for it meanwhile wait for it, and the oldest ones are dropped
+// when the cache is full (the learners still using them keep them until they are done)
+class GramCache
+{
+    struct Entry
+    {
+        std::once_flag once;
+        std::shared_ptr<const GramMatrix> gram;
+    };
+
+    SampleView samples;
+    size_t maxBytes, bytes;
+    int threads;
+    std::mutex mutex;
+    std::map< GramKernel, std::shared_ptr<Entry> > entries;
+    std::deque<GramKernel> order; // oldest first
+
+public:
+    // threads compute each matrix (0 for all of them), the cross-validations training their models
+    // on a pool of workers keep it to 1 so that the matrices are not computed by a pool inside the pool
+    GramCache(const SampleView &samples, const size_t maxBytes=gramCacheBytes, const int threads=0);
+    const SampleView &Samples() const {return samples;}
+
+    // returns nothing when the matrix does not fit in the cache
+    std::shared_ptr<const GramMatrix> Get(const GramKernel &kernel);
+};
+
+// where the training samples of a learner come from: rows of the block of a cache
+// the cross-validations hand it to their models (gramScope of Classifier and Regressor) while they train them
+struct GramScope
+{
+    GramCache *cache;
+    ivec rows;
+    GramScope(GramCache *cache=0, const ivec &rows=ivec()) : cache(cache), rows(rows) {}
+
+    // samples are the rows of the scope, as far as the kernel columns go
+    bool Match(const std::vector<fvec> &samples, const ivec &columns) const;
+    // the kernel matrix of the block samples come from and their rows in it, nothing without a matching scope
+    static std::shared_ptr<const GramMatrix> Lookup(const GramScope *scope, const std::vector<fvec> &samples,
+                                                    const GramKernel &kernel, ivec &rows);
+};
+
+#endif // _GRAM_CACHE_H_
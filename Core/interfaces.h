@@ -481,6 +481,7 @@ public:
     virtual const char* QueryReinforcementSignal() = 0; // void QueryReinforcement(std::vector<fvec> samples);
     virtual const char* SetDataSignal() = 0; // void SetData(std::vector<fvec> samples, ivec labels, std::vector<ipair> trajectories);
 	virtual const char* SetTimeseriesSignal() = 0; // void SetTimeseriesSignal(std::vector<TimeSerie> series);
+    virtual const char* AddDataSignal() {return 0;} // optional, void AddData(std::vector<fvec> samples, ivec labels, bool bLast); appends to the data sent through SetData, bLast is false while more batches are coming (an empty batch can say so)
 	virtual const char* FetchResultsSlot() = 0; // void FetchResults(std::vector<fvec> results);
 	virtual QObject *object() = 0; // trick to get access to the QObject interface for signals and slots
 	virtual const char* DoneSignal() = 0; // void Done(QObject *);
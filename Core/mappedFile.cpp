@@ -0,0 +1,114 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#include "mappedFile.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef WIN32
+MappedFile::MappedFile()
+    : data(0), length(0), fileHandle(INVALID_HANDLE_VALUE), mapHandle(0)
+{}
+#else
+MappedFile::MappedFile()
+    : data(0), length(0), fileHandle(-1)
+{}
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#ifdef WIN32
+bool MappedFile::Open(const char *filename)
+{
+    Close();
+    fileHandle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+    mapHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(!mapHandle)
+    {
+        Close();
+        return false;
+    }
+    data = (const char *)MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0);
+    if(!data)
+    {
+        Close();
+        return false;
+    }
+    length = (size_t)fileSize.QuadPart;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if(data) UnmapViewOfFile(data);
+    if(mapHandle) CloseHandle(mapHandle);
+    if(fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+    data = 0;
+    length = 0;
+    mapHandle = 0;
+    fileHandle = INVALID_HANDLE_VALUE;
+}
+#else
+bool MappedFile::Open(const char *filename)
+{
+    Close();
+    fileHandle = open(filename, O_RDONLY);
+    if(fileHandle < 0) return false;
+    struct stat info;
+    if(fstat(fileHandle, &info) != 0 || info.st_size == 0)
+    {
+        Close();
+        return false;
+    }
+    void *address = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fileHandle, 0);
+    if(address == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    data = (const char *)address;
+    length = info.st_size;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if(data) munmap((void *)data, length);
+    if(fileHandle >= 0) close(fileHandle);
+    data = 0;
+    length = 0;
+    fileHandle = -1;
+}
+#endif
@@ -0,0 +1,50 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <stddef.h>
+
+// read-only memory mapping of a whole file, pages are loaded by the OS on first access
+class MappedFile
+{
+    const char *data;
+    size_t length;
+#ifdef WIN32
+    void *fileHandle;
+    void *mapHandle;
+#else
+    int fileHandle;
+#endif
+
+    MappedFile(const MappedFile &);
+    MappedFile& operator= (const MappedFile &);
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool Open(const char *filename);
+    void Close();
+    bool IsOpen() const {return data != 0;}
+    const char *Data() const {return data;}
+    size_t Size() const {return length;}
+};
+
+#endif // _MAPPED_FILE_H_
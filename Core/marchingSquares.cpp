@@ -0,0 +1,187 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#include "marchingSquares.h"
+#include "parallel.h"
+#include <algorithm>
+#include <unordered_map>
+
+using namespace std;
+
+// smallest band of rows worth a thread of its own
+const int contourRowsPerThread = 16;
+
+// segments of one level found in a band of rows
+struct ContourSegments
+{
+    ivec edges; // edge where each segment starts and edge where it ends
+    fvec points; // x,y of the start and of the end of each segment
+};
+
+MarchingSquares::MarchingSquares(const double *values, const int w, const int h)
+    : values(values), w(w), h(h)
+{}
+
+dvec MarchingSquares::Levels(const double vmin, const double vmax, const int count)
+{
+    if(count <= 0) return dvec();
+    if(count == 1) return dvec(1, (vmin + vmax)*0.5);
+    dvec levels(count);
+    double step = (vmax - vmin) / (count - 1);
+    FOR(i, count) levels[i] = vmin + step*i;
+    return levels;
+}
+
+// the cell with its top-left corner at (x,y) has its corners numbered clockwise from there
+// and edge e goes from corner e to corner (e+1)%4. Edges are identified across cells by
+// 2*(y*w + x) for the horizontal edge right of a node and 2*(y*w + x)+1 for the vertical one below it
+// a segment starts where walking the edges goes from above the level to below it, and ends where it comes back
+// which orients all the segments the same way and makes the end of one the start of its neighbour
+static void contourBand(const double *values, const int w, const int y0, const int y1,
+                        const dvec &levels, vector<ContourSegments> &segments)
+{
+    const int cx[4] = {0, 1, 1, 0}, cy[4] = {0, 0, 1, 1};
+    segments.resize(levels.size());
+    for(int y=y0; y<y1; y++)
+    {
+        const double *row0 = values + (size_t)y*w, *row1 = row0 + w;
+        for(int x=0; x<w-1; x++)
+        {
+            const double v[4] = {row0[x], row0[x+1], row1[x+1], row1[x]};
+            double sum = v[0] + v[1] + v[2] + v[3];
+            if(sum != sum) continue; // undefined values leave a hole
+            double vmin = min(min(v[0], v[1]), min(v[2], v[3]));
+            double vmax = max(max(v[0], v[1]), max(v[2], v[3]));
+            // a level crosses the cell when some corners are at or above it and some below
+            int first = upper_bound(levels.begin(), levels.end(), vmin) - levels.begin();
+            int last = upper_bound(levels.begin(), levels.end(), vmax) - levels.begin();
+            const int edgeIds[4] = {2*(y*w + x), 2*(y*w + x+1) + 1, 2*((y+1)*w + x), 2*(y*w + x) + 1};
+            for(int k=first; k<last; k++)
+            {
+                const double level = levels[k];
+                int ids[4], count = 0;
+                float px[4], py[4];
+                bool bExit[4];
+                FOR(e, 4)
+                {
+                    int a = e, b = (e+1)&3;
+                    bool bA = v[a] >= level, bB = v[b] >= level;
+                    if(bA == bB) continue;
+                    double t = (level - v[a]) / (v[b] - v[a]);
+                    ids[count] = edgeIds[e];
+                    px[count] = (float)(x + cx[a] + t*(cx[b] - cx[a]));
+                    py[count] = (float)(y + cy[a] + t*(cy[b] - cy[a]));
+                    bExit[count] = bA;
+                    count++;
+                }
+                // on a saddle the value at the center decides whether the two parts above the level are connected
+                bool bCenter = sum*0.25 >= level;
+                ContourSegments &s = segments[k];
+                FOR(i, count)
+                {
+                    if(!bExit[i]) continue;
+                    int j = count == 2 ? 1-i : (bCenter ? (i+1)&3 : (i+3)&3);
+                    s.edges.push_back(ids[i]);
+                    s.edges.push_back(ids[j]);
+                    s.points.push_back(px[i]);
+                    s.points.push_back(py[i]);
+                    s.points.push_back(px[j]);
+                    s.points.push_back(py[j]);
+                }
+            }
+        }
+    }
+}
+
+// chains the segments of level k into polylines: every edge is the start of at most one segment
+static void stitchSegments(const vector< vector<ContourSegments> > &bands, const int k, ContourLines &lines)
+{
+    ivec edges;
+    fvec points;
+    FOR(b, bands.size())
+    {
+        const ContourSegments &band = bands[b][k];
+        edges.insert(edges.end(), band.edges.begin(), band.edges.end());
+        points.insert(points.end(), band.points.begin(), band.points.end());
+    }
+    int count = edges.size()/2;
+    lines.starts.push_back(0);
+    if(!count) return;
+
+    unordered_map<int,int> byStart;
+    byStart.reserve(count*2);
+    FOR(i, count) byStart[edges[i*2]] = i;
+    ivec next(count, -1);
+    bvec hasPrevious(count, false), visited(count, false);
+    FOR(i, count)
+    {
+        unordered_map<int,int>::const_iterator it = byStart.find(edges[i*2+1]);
+        if(it == byStart.end()) continue;
+        next[i] = it->second;
+        hasPrevious[it->second] = true;
+    }
+
+    lines.points.reserve((size_t)count*2 + 64);
+    // the open lines start at segments nobody leads to, whatever is left after them are loops
+    FOR(pass, 2)
+    {
+        FOR(i, count)
+        {
+            if(visited[i] || (!pass && hasPrevious[i])) continue;
+            lines.points.push_back(points[i*4]);
+            lines.points.push_back(points[i*4+1]);
+            int s = i;
+            while(s >= 0 && !visited[s])
+            {
+                visited[s] = true;
+                lines.points.push_back(points[s*4+2]);
+                lines.points.push_back(points[s*4+3]);
+                s = next[s];
+            }
+            lines.starts.push_back(lines.points.size()/2);
+            lines.closed.push_back(s == (int)i);
+        }
+    }
+}
+
+vector<ContourLines> MarchingSquares::Extract(const dvec &levels, const int threads) const
+{
+    vector<ContourLines> lines(levels.size());
+    FOR(k, levels.size())
+    {
+        lines[k].level = levels[k];
+        lines[k].starts.assign(1, 0);
+    }
+    if(!values || w < 2 || h < 2 || !levels.size()) return lines;
+
+    int rows = h-1;
+    int bandCount = max(1, min(threads > 0 ? threads : ThreadCount(), rows / contourRowsPerThread));
+    vector< vector<ContourSegments> > bands(bandCount);
+    ParallelFor(bandCount, [&](int b)
+    {
+        int y0 = (int)((long long)rows*b/bandCount), y1 = (int)((long long)rows*(b+1)/bandCount);
+        contourBand(values, w, y0, y1, levels, bands[b]);
+    }, bandCount);
+
+    ParallelFor(levels.size(), [&](int k)
+    {
+        lines[k].starts.clear();
+        stitchSegments(bands, k, lines[k]);
+    }, threads);
+    return lines;
+}
@@ -0,0 +1,58 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#ifndef _MARCHING_SQUARES_H_
+#define _MARCHING_SQUARES_H_
+
+#include <vector>
+#include "types.h"
+
+// polylines of one iso-level, in grid coordinates (x along the rows, y down the columns)
+struct ContourLines
+{
+    double level;
+    fvec points; // x,y of every vertex, one line after the other
+    ivec starts; // index of the first vertex of each line, followed by the total vertex count
+    bvec closed; // the line comes back to its first vertex (which is repeated at its end)
+
+    int Count() const {return closed.size();}
+    int Length(const int i) const {return starts[i+1] - starts[i];}
+    const float *Line(const int i) const {return &points[starts[i]*2];}
+};
+
+// iso-contours of a w x h grid of values for several levels at once
+// the rows of cells are split across threads, each cell is visited once for all the levels it spans
+// and its segments go to flat per-level arrays. Segments are oriented (larger values on the same side)
+// and their ends are identified by the grid edge they cross, so the polylines are stitched
+// by following a hash of edges rather than by comparing points
+class MarchingSquares
+{
+    const double *values;
+    int w, h;
+
+public:
+    MarchingSquares(const double *values, const int w, const int h);
+
+    // levels must be sorted in increasing order, threads=0 uses every core
+    std::vector<ContourLines> Extract(const dvec &levels, const int threads=0) const;
+
+    // count levels evenly spaced between vmin and vmax, both included
+    static dvec Levels(const double vmin, const double vmax, const int count);
+};
+
+#endif // _MARCHING_SQUARES_H_
@@ -25,9 +25,14 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 
 class ObstacleAvoidance
 {
+protected:
+	bool bThreadSafe; // AvoidBatch only reads the obstacles and can run on several threads at once
+
 public:
+	ObstacleAvoidance(): bThreadSafe(false){}
     virtual ~ObstacleAvoidance(){};
 	std::vector< Obstacle > obstacles;
+	bool IsThreadSafe() const {return bThreadSafe;}
 	virtual void SetObstacles(std::vector< Obstacle > obstacles)
 	{
 		this->obstacles = obstacles;
@@ -44,6 +49,21 @@ public:
 		fvec vx=x, vxdot=xdot;
 		return fVec(Avoid(vx, vxdot));
 	}
+	// modulates the velocities of every row of samples at once, against the obstacles of the last SetObstacles
+	// velocities holds samples.Cols() values per row (row-major) and is modified in place
+	virtual void AvoidBatch(const SampleView &samples, fvec &velocities)
+	{
+		int rows = samples.Rows(), cols = samples.Cols();
+		if(!cols || (int)velocities.size() < rows*cols) return;
+		fvec sample(cols), xdot(cols);
+		FOR(i, rows)
+		{
+			samples.CopyRow(i, &sample[0]);
+			FOR(d, cols) xdot[d] = velocities[i*cols + d];
+			fvec res = Avoid(sample, xdot);
+			FOR(d, std::min(cols, (int)res.size())) velocities[i*cols + d] = res[d];
+		}
+	}
 };
 
 #endif // _OBSTACLES_H_
@@ -0,0 +1,74 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+// number of worker threads used by the parallel loops
+inline int ThreadCount()
+{
+    int count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+// splits [0,count) in one contiguous range per thread and calls body(start, stop) on each of them
+// the calling thread takes the first range and returns once all of them are done
+template<typename Body>
+void ParallelRanges(const int count, Body body, int threads=0)
+{
+    if(count <= 0) return;
+    if(threads <= 0) threads = ThreadCount();
+    threads = std::min(threads, count);
+    if(threads == 1)
+    {
+        body(0, count);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(threads-1);
+    for(int t=1; t<threads; t++)
+    {
+        int start = (int)((long long)count*t/threads);
+        int stop = (int)((long long)count*(t+1)/threads);
+        workers.push_back(std::thread(body, start, stop));
+    }
+    body(0, (int)((long long)count/threads));
+    for(size_t t=0; t<workers.size(); t++) workers[t].join();
+}
+
+// calls body(i) for every i in [0,count), the indices are handed out one at a time
+// which balances the load when the items have very different costs
+template<typename Body>
+void ParallelFor(const int count, Body body, int threads=0)
+{
+    if(count <= 0) return;
+    if(threads <= 0) threads = ThreadCount();
+    threads = std::min(threads, count);
+    std::atomic<int> next(0);
+    ParallelRanges(threads, [&](int, int)
+    {
+        for(int i = next++; i < count; i = next++) body(i);
+    }, threads);
+}
+
+#endif // _PARALLEL_H_
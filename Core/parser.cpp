@@ -18,7 +18,12 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 *********************************************************************/
 #include <QDebug>
 #include <basicMath.h>
+#include <unordered_map>
+#include <limits>
+#include <chrono>
+#include <string.h>
 #include "parser.h"
+#include "parallel.h"
 
 /* CSVRow stuff */
 
@@ -167,121 +172,628 @@ bool CSVIterator::operator==(CSVIterator const& rhs)
     return ((this == &rhs) || ((this->m_str == NULL) && (rhs.m_str == NULL)));
 }
 
+/* fast CSV scanning */
+
+// a cell of a line, pointing in the file contents
+struct CSVCell
+{
+    const char *begin, *end;
+    bool bQuoted; // the cell contains separators between quotes, which are read as '_'
+};
+
+// splits a line the same way as CSVRow::readNextRow: separators between quotes do not split, a trailing empty cell is dropped
+static void splitLine(const char *begin, const char *end, const char separator, vector<CSVCell> &cells)
+{
+    cells.clear();
+    const char *cellBegin = begin;
+    bool bQuoted = false;
+    const char *quote = (const char *)memchr(begin, '"', end-begin);
+    if(!quote)
+    {
+        const char *c;
+        while((c = (const char *)memchr(cellBegin, separator, end-cellBegin)))
+        {
+            CSVCell cell = {cellBegin, c, false};
+            cells.push_back(cell);
+            cellBegin = c+1;
+        }
+    }
+    else
+    {
+        const char *lastQuote = end-1;
+        while(*lastQuote != '"') lastQuote--;
+        bool bInside = false;
+        for(const char *c=begin; c<end; c++)
+        {
+            if(*c == '"') bInside = !bInside;
+            else if(*c == separator)
+            {
+                // a quote without its closing counterpart does not protect the separators
+                if(bInside && c < lastQuote)
+                {
+                    bQuoted = true;
+                    continue;
+                }
+                CSVCell cell = {cellBegin, c, bQuoted};
+                cells.push_back(cell);
+                cellBegin = c+1;
+                bQuoted = false;
+            }
+        }
+    }
+    if(cellBegin < end)
+    {
+        CSVCell cell = {cellBegin, end, bQuoted};
+        cells.push_back(cell);
+    }
+}
+
+// lines with no cells (or with only the carriage return of a windows line ending) are skipped
+static bool isEmptyLine(const char *begin, const char *end)
+{
+    return begin == end || (end-begin == 1 && *begin == '\r');
+}
+
+// empty cells (or cells made only of blanks) are replaced by MISSING_VALUE
+static bool isMissingCell(const CSVCell &cell)
+{
+    for(const char *c=cell.begin; c<cell.end; c++) if(*c != ' ') return false;
+    return true;
+}
+
+static string cellString(const CSVCell &cell, const bool bLast, const char separator)
+{
+    if(isMissingCell(cell)) return MISSING_VALUE;
+    string s(cell.begin, cell.end);
+    if(cell.bQuoted) std::replace(s.begin(), s.end(), separator, '_');
+    // remove remaining line carrys, *nix only
+#if !(defined WIN32 || defined _WIN32)
+    if(bLast) s.erase(std::remove(s.begin(), s.end(), '\r'), s.end());
+#endif
+    return s;
+}
+
+// the dictionary index of a text cell is kept as the bits of its float slot, a float would
+// only hold the first 2^24 of them exactly
+static inline float textCode(const int code)
+{
+    float value;
+    memcpy(&value, &code, sizeof(value));
+    return value;
+}
+
+static inline int textCode(const float value)
+{
+    int code;
+    memcpy(&code, &value, sizeof(code));
+    return code;
+}
+
+static inline bool isBlank(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+static bool matchWord(const char *c, const char *end, const char *word)
+{
+    for(; *word; word++, c++)
+    {
+        if(c == end || tolower(*c) != *word) return false;
+    }
+    return c == end;
+}
+
+// parses a number with the syntax accepted by QString::toFloat (which does not depend on the locale, unlike strtof)
+static bool parseFloat(const char *c, const char *end, float &value)
+{
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    while(c < end && isBlank(*c)) c++;
+    while(end > c && isBlank(end[-1])) end--;
+    if(c == end) return false;
+    bool bNegative = false;
+    if(*c == '+' || *c == '-')
+    {
+        bNegative = *c == '-';
+        c++;
+    }
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool bDigits = false;
+    for(; c < end && *c >= '0' && *c <= '9'; c++)
+    {
+        bDigits = true;
+        if(digits < 19)
+        {
+            mantissa = mantissa*10 + (*c - '0');
+            if(mantissa) digits++;
+        }
+        else exponent++;
+    }
+    if(c < end && *c == '.')
+    {
+        for(c++; c < end && *c >= '0' && *c <= '9'; c++)
+        {
+            bDigits = true;
+            if(digits < 19)
+            {
+                mantissa = mantissa*10 + (*c - '0');
+                if(mantissa) digits++;
+                exponent--;
+            }
+        }
+    }
+    if(!bDigits)
+    {
+        if(matchWord(c, end, "nan")) value = std::numeric_limits<float>::quiet_NaN();
+        else if(matchWord(c, end, "inf") || matchWord(c, end, "infinity")) value = bNegative ? -FLT_MAX*2 : FLT_MAX*2;
+        else return false;
+        return true;
+    }
+    if(c < end && (*c == 'e' || *c == 'E'))
+    {
+        c++;
+        bool bNegativeExponent = false;
+        if(c < end && (*c == '+' || *c == '-'))
+        {
+            bNegativeExponent = *c == '-';
+            c++;
+        }
+        if(c == end || *c < '0' || *c > '9') return false;
+        int e = 0;
+        for(; c < end && *c >= '0' && *c <= '9'; c++) if(e < 10000) e = e*10 + (*c - '0');
+        exponent += bNegativeExponent ? -e : e;
+    }
+    if(c != end) return false;
+    double v = (double)mantissa;
+    if(v != 0)
+    {
+        if(exponent >= -22 && exponent <= 22) v = exponent < 0 ? v / powers[-exponent] : v * powers[exponent];
+        else v *= pow(10., exponent);
+    }
+    if(fabs(v) > FLT_MAX) return false; // out of range for a float
+    value = (float)(bNegative ? -v : v);
+    return true;
+}
+
 /* CSVParser stuff */
 CSVParser::CSVParser()
+    : mapping(0), text(0), textLength(0), separator(','), estimatedCount(0)
 {
     bFirstRowAsHeader = false;
     outputLabelColumn = 2;
 }
 
+CSVParser::~CSVParser()
+{
+    DEL(mapping);
+}
+
 void CSVParser::clear()
 {
     outputLabelColumn = 0;
     classLabels.clear();
-    data.clear();
     dataTypes.clear();
+    rowBegin.clear();
+    rowEnd.clear();
+    rowSizes.clear();
+    values.Clear();
+    cellTypes.clear();
+    dictionaries.clear();
+    columns.clear();
+    DEL(mapping);
+    buffer.clear();
+    text = 0;
+    textLength = 0;
+    estimatedCount = 0;
 }
 
-void CSVParser::parse(const char* fileName, int separatorType)
+// maps the file (or reads it in buffer for the wide encodings) and points text after its byte order mark
+bool CSVParser::openText(const char* fileName)
 {
-    // init
     uint8_t offset = getBOMsize(fileName);
-    file.open(fileName,std::ios_base::binary);
-    if(!file.is_open()) return;
+    if(offset != 2 && offset != 4)
+    {
+        mapping = new MappedFile();
+        if(mapping->Open(fileName) && mapping->Size() >= offset)
+        {
+            text = mapping->Data() + offset;
+            textLength = mapping->Size() - offset;
+            return true;
+        }
+        DEL(mapping);
+    }
+    ifstream file(fileName, std::ios_base::binary);
+    if(!file.is_open()) return false;
+    file.seekg(offset, ios::beg);
+    buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    // remove null character noise when coming from UTF-X
+    // we assume that the data has only ASCII characters
+    if(offset) buffer.erase(std::remove(buffer.begin(), buffer.end(), '\0'), buffer.end());
+    text = buffer.data();
+    textLength = buffer.size();
+    return true;
+}
 
-    std::string separators[] = {",", ";", "\t", " "};
+char CSVParser::findSeparator(int separatorType) const
+{
+    char separators[] = {',', ';', '\t', ' '};
     int separatorCount = 4;
+    if(separatorType) return separators[separatorType-1];
     int bestSeparator = 0;
-    int dim=0;
-
-    if(!separatorType)
+    vector<CSVCell> cells;
+    const char *textEnd = text + textLength;
+    // we test the separators on the second line, as the first one might be a header line
+    const char *line = (const char *)memchr(text, '\n', textLength);
+    if(line && ++line < textEnd)
     {
-        // we test the separators to find which one is best
+        const char *lineEnd = (const char *)memchr(line, '\n', textEnd-line);
+        if(!lineEnd) lineEnd = textEnd;
+        size_t dim = 0;
         for(int i=0; i<separatorCount; i++)
         {
-            file.seekg(offset,ios::beg);
-            // Parse CSV input file
-            CSVIterator parser(file, separators[i]);
-            ++parser; // we skip the first line as it might be a header line
-            if(parser.eof() || !parser->size()) continue;
-            vector<string> parsed = parser->getParsedLine();
-            //qDebug() << "separator: " << separators[i].c_str() << ":" << parsed.size();
-            if(parsed.size() > dim)
+            splitLine(line, lineEnd, separators[i], cells);
+            if(cells.size() > dim)
             {
-                dim = parsed.size();
+                dim = cells.size();
                 bestSeparator = i;
             }
         }
     }
-    else bestSeparator = separatorType-1;
+    return separators[bestSeparator];
+}
 
-    file.seekg(offset,ios::beg);
+vector< vector<string> > CSVParser::preview(const char* fileName, int prefixRows, int sampledRows, int timeBudget, int separatorType)
+{
+    int outputColumn = outputLabelColumn;
+    clear();
+    outputLabelColumn = outputColumn;
+    vector< vector<string> > rows;
+    if(!openText(fileName)) return rows;
+    separator = findSeparator(separatorType);
 
-    data.clear();
-    for(CSVIterator parser(file, separators[bestSeparator]);!parser.eof(); ++parser)
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const char *textEnd = text + textLength;
+    vector<CSVCell> cells;
+    size_t lineBytes = 0;
+    int lineCount = 0;
+    bool bTimeout = false;
+    // reads the line starting at line, returns the beginning of the next one
+    auto readLine = [&](const char *line) -> const char *
     {
-        if(!parser->size()) continue;
-        vector<string> parsed = parser->getParsedLine();
-        if(!parsed.size()) continue;
+        const char *lineEnd = (const char *)memchr(line, '\n', textEnd-line);
+        if(!lineEnd) lineEnd = textEnd;
+        lineBytes += lineEnd - line + 1;
+        lineCount++;
+        if(!isEmptyLine(line, lineEnd)) splitLine(line, lineEnd, separator, cells);
+        else cells.clear();
+        if(cells.size())
+        {
+            vector<string> row(cells.size());
+            FOR(i, cells.size()) row[i] = cellString(cells[i], i == cells.size()-1, separator);
+            rows.push_back(row);
+        }
+        bTimeout = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() >= timeBudget;
+        return lineEnd+1;
+    };
 
-        // check for remaining line carrys, *nix only
-        string::size_type pos = 0;
-#if !(defined WIN32 || defined _WIN32)
-        while ( ( pos = parsed.back().find ("\r",pos) ) != string::npos )
-            parsed.back().erase ( pos, 1 );
-#endif
-        // remove null character noise when coming from UTF-X
-        // we assume that the data has only ASCII characters
-        if (offset)
-            for(size_t i = 0; i < parsed.size(); i++)
+    const char *line = text;
+    while(line < textEnd && (int)rows.size() < prefixRows && !bTimeout) line = readLine(line);
+    const char *prefixEnd = line;
+
+    // the remaining lines are taken at regular intervals, starting from the line following each stride
+    if(line < textEnd && sampledRows > 0)
+    {
+        size_t remaining = textEnd - prefixEnd;
+        for(int i=0; i<sampledRows && !bTimeout; i++)
+        {
+            const char *position = prefixEnd + remaining*i/sampledRows;
+            if(position < line) continue; // the previous sample was longer than the stride
+            if(position != prefixEnd)
+            {
+                const char *newline = (const char *)memchr(position, '\n', textEnd-position);
+                if(!newline) break;
+                position = newline+1;
+            }
+            if(position >= textEnd) break;
+            line = readLine(position);
+        }
+    }
+
+    // we extrapolate the number of rows from the average length of the lines we have seen
+    if(prefixEnd >= textEnd) estimatedCount = rows.size();
+    else estimatedCount = lineCount ? (int)min((double)std::numeric_limits<int>::max(), (double)textLength*rows.size()/lineBytes) : 0;
+    return rows;
+}
+
+// the part of the file handled by one thread, it always starts at the beginning of a line
+struct CSVChunk
+{
+    const char *begin, *end;
+    int firstRow, rowCount, cellCount;
+    vector< vector<string> > keys; // text values of each column, in order of appearance
+};
+
+void CSVParser::parse(const char* fileName, int separatorType)
+{
+    // init
+    int outputColumn = outputLabelColumn;
+    clear();
+    outputLabelColumn = outputColumn;
+    if(!openText(fileName)) return;
+    size_t length = textLength;
+    const char *textEnd = text + length;
+    separator = findSeparator(separatorType);
+
+    // the progress is reported every few megabytes read, the first pass counts for 40% and the second for 50%
+    std::atomic<size_t> bytesDone(0);
+    std::atomic<bool> bCanceled(false);
+    const size_t reportBytes = 4<<20;
+    auto report = [&](const size_t bytes, const float passStart, const float passSpan)
+    {
+        size_t done = (bytesDone += bytes);
+        if(!progressCallback || bCanceled) return;
+        float fraction = length ? min(1.f, (float)done/length) : 1.f;
+        if(!progressCallback(passStart + passSpan*fraction)) bCanceled = true;
+    };
+
+    // we cut the file in one chunk per thread, on line boundaries
+    int chunkCount = (int)min((size_t)ThreadCount(), length / (1<<20) + 1);
+    vector<CSVChunk> chunks(chunkCount);
+    const char *position = text;
+    FOR(i, chunkCount)
+    {
+        chunks[i].begin = position;
+        if(i == chunkCount-1) position = textEnd;
+        else
+        {
+            const char *split = max(position, text + length*(i+1)/chunkCount);
+            const char *newline = (const char *)memchr(split, '\n', textEnd-split);
+            position = newline ? newline+1 : textEnd;
+        }
+        chunks[i].end = position;
+    }
+
+    // first pass: we count the rows and cells of each chunk
+    const char sep = separator;
+    ParallelFor(chunkCount, [&](int i)
+    {
+        CSVChunk &chunk = chunks[i];
+        vector<CSVCell> lineCells;
+        chunk.rowCount = chunk.cellCount = 0;
+        const char *reported = chunk.begin;
+        for(const char *line = chunk.begin; line < chunk.end && !bCanceled; )
+        {
+            if((size_t)(line - reported) >= reportBytes)
+            {
+                report(line - reported, 0.f, 0.4f);
+                reported = line;
+            }
+            const char *lineEnd = (const char *)memchr(line, '\n', chunk.end-line);
+            if(!lineEnd) lineEnd = chunk.end;
+            if(!isEmptyLine(line, lineEnd))
             {
-                pos = 0;
-                while ( ( pos = parsed.at(i).find ('\0',pos) ) != string::npos )
-                    parsed.at(i).erase ( pos, 1 );
+                splitLine(line, lineEnd, sep, lineCells);
+                if(lineCells.size())
+                {
+                    chunk.rowCount++;
+                    chunk.cellCount = max(chunk.cellCount, (int)lineCells.size());
+                }
+            }
+            line = lineEnd+1;
+        }
+    });
+    if(bCanceled)
+    {
+        clear();
+        return;
+    }
+    bytesDone = 0;
 
+    int rowCount = 0, cols = 0;
+    FOR(i, chunkCount)
+    {
+        chunks[i].firstRow = rowCount;
+        rowCount += chunks[i].rowCount;
+        cols = max(cols, chunks[i].cellCount);
+    }
+    if(!rowCount) return;
+    rowBegin.resize(rowCount);
+    rowEnd.resize(rowCount);
+    rowSizes.resize(rowCount);
+    values.Resize(rowCount, cols);
+    cellTypes.resize((size_t)rowCount*cols, CELL_NONE);
+    float *valueData = values.Data();
+
+    // second pass: the numbers are parsed in place, the text cells are numbered per chunk and column
+    ParallelFor(chunkCount, [&](int i)
+    {
+        CSVChunk &chunk = chunks[i];
+        vector<CSVCell> lineCells;
+        vector< unordered_map<string,int> > lookup(cols);
+        chunk.keys.resize(cols);
+        int row = chunk.firstRow;
+        const char *reported = chunk.begin;
+        for(const char *line = chunk.begin; line < chunk.end && !bCanceled; )
+        {
+            if((size_t)(line - reported) >= reportBytes)
+            {
+                report(line - reported, 0.4f, 0.5f);
+                reported = line;
+            }
+            const char *lineEnd = (const char *)memchr(line, '\n', chunk.end-line);
+            if(!lineEnd) lineEnd = chunk.end;
+            if(!isEmptyLine(line, lineEnd)) splitLine(line, lineEnd, sep, lineCells);
+            else lineCells.clear();
+            if(lineCells.size())
+            {
+                rowBegin[row] = line - text;
+                rowEnd[row] = lineEnd - text;
+                rowSizes[row] = lineCells.size();
+                float *rowValues = valueData + (size_t)row*cols;
+                uint8_t *rowTypes = &cellTypes[(size_t)row*cols];
+                FOR(d, lineCells.size())
+                {
+                    const CSVCell &cell = lineCells[d];
+                    if(!cell.bQuoted && !isMissingCell(cell) && parseFloat(cell.begin, cell.end, rowValues[d]))
+                    {
+                        rowTypes[d] = CELL_NUMBER;
+                        continue;
+                    }
+                    string key = cellString(cell, d == lineCells.size()-1, sep);
+                    unordered_map<string,int>::iterator it = lookup[d].find(key);
+                    if(it == lookup[d].end())
+                    {
+                        it = lookup[d].insert(make_pair(key, (int)chunk.keys[d].size())).first;
+                        chunk.keys[d].push_back(key);
+                    }
+                    rowValues[d] = textCode(it->second);
+                    rowTypes[d] = CELL_TEXT;
+                }
+                row++;
             }
+            line = lineEnd+1;
+        }
+    });
+    if(bCanceled)
+    {
+        clear();
+        return;
+    }
 
-        // Fill dataset
-        data.push_back(parsed);
+    // we merge the dictionaries of the chunks in order, which keeps the order of appearance over the whole file
+    dictionaries.resize(cols);
+    vector< vector<ivec> > remaps(chunkCount, vector<ivec>(cols));
+    vector<bool> bRemapped(chunkCount, false);
+    FOR(d, cols)
+    {
+        unordered_map<string,int> lookup;
+        FOR(i, chunkCount)
+        {
+            const vector<string> &keys = chunks[i].keys[d];
+            ivec &remap = remaps[i][d];
+            remap.resize(keys.size());
+            FOR(k, keys.size())
+            {
+                unordered_map<string,int>::iterator it = lookup.find(keys[k]);
+                if(it == lookup.end())
+                {
+                    it = lookup.insert(make_pair(keys[k], (int)dictionaries[d].size())).first;
+                    dictionaries[d].push_back(keys[k]);
+                }
+                remap[k] = it->second;
+                if(remap[k] != (int)k) bRemapped[i] = true;
+            }
+        }
     }
+    ParallelFor(chunkCount, [&](int i)
+    {
+        if(!bRemapped[i]) return;
+        for(int row = chunks[i].firstRow; row < chunks[i].firstRow + chunks[i].rowCount; row++)
+        {
+            float *rowValues = valueData + (size_t)row*cols;
+            const uint8_t *rowTypes = &cellTypes[(size_t)row*cols];
+            FOR(d, cols)
+            {
+                if(rowTypes[d] == CELL_TEXT) rowValues[d] = textCode(remaps[i][d][textCode(rowValues[d])]);
+            }
+        }
+    });
+    columns.resize(cols);
+    FOR(d, cols) columns[d] = d;
+    estimatedCount = rowCount;
 
-    cout << "Parsing done, read " << data.size() << " entries" << endl;
-    cout << "Found " << data.at(0).size() << " input labels / columns" << endl;
+    cout << "Parsing done, read " << rowCount << " entries" << endl;
+    cout << "Found " << getRowSize(0) << " input labels / columns" << endl;
 
     // look for data types
-    for(size_t i = 0; i < data.at(1).size(); i++)
+    for(size_t i = 0; rowCount > 1 && i < getRowSize(1); i++)
     {
         // Look for a non-empty cell
         // start with 2nd row as first might be input labels
-        size_t testRow = 1;
-        while(data.at(testRow++).at(i) == "?" && testRow != data.size());
+        int testRow = 1;
+        while(isMissing(testRow++, i) && testRow != rowCount);
 
-
-        if (testRow == data.size())
+        if (testRow == rowCount)
         {
             // if the whole column is missing data... delete it
             cout << "Warning: Found empty column, deleting..." << endl;
-            for (size_t j = 0; j < data.size(); j++)
-                data.at(j).erase(data.at(j).begin()+i);
-
+            columns.erase(columns.begin()+i);
         } else // save input type
-            dataTypes.push_back(getType(data.at(testRow).at(i)));
+            dataTypes.push_back(getType(getCell(testRow, i)));
     }
 
-    cout << data.at(0).size() << " input labels / columns remaining after cleanup" << endl;
+    cout << getRowSize(0) << " input labels / columns remaining after cleanup" << endl;
+    // the output (class) labels are read on request through getOutputLabelTypes
+}
+
+// number of columns in use that are present in the row
+int CSVParser::getRowSize(const int row) const
+{
+    if(row < 0 || row >= (int)rowSizes.size()) return 0;
+    return std::lower_bound(columns.begin(), columns.end(), rowSizes[row]) - columns.begin();
+}
 
-//    cout << "Contents: " << endl;
-//    for (size_t j=0; j<data.size(); j++)
-//    {
-//        cout << "|";
-//        for (size_t i=0; i<data.at(1).size(); i++)
-//            cout << data.at(j).at(i) << "|";
-//        cout << endl;
-//    }
+bool CSVParser::isMissing(const int row, const int column) const
+{
+    if(row < 0 || row >= getCount() || column < 0 || column >= getRowSize(row)) return false;
+    size_t index = (size_t)row*values.Cols() + columns[column];
+    return cellTypes[index] == CELL_TEXT && dictionaries[columns[column]][textCode(values.Data()[index])] == MISSING_VALUE;
+}
 
-    // Read output (class) labels
-    getOutputLabelTypes(true);
-    file.close();
+string CSVParser::getCell(const int row, const int column) const
+{
+    if(row < 0 || row >= getCount() || column < 0 || column >= getRowSize(row)) return string();
+    vector<CSVCell> cells;
+    splitLine(text + rowBegin[row], text + rowEnd[row], separator, cells);
+    int index = columns[column];
+    return cellString(cells[index], index == (int)cells.size()-1, separator);
+}
+
+vector<string> CSVParser::getColumnCells(const int column, const int firstRow) const
+{
+    vector<string> cellStrings(max(0, getCount() - firstRow));
+    ParallelRanges(cellStrings.size(), [&](int start, int stop)
+    {
+        vector<CSVCell> cells;
+        for(int i=start; i<stop; i++)
+        {
+            int row = i + firstRow;
+            if(column < 0 || column >= getRowSize(row)) continue;
+            int index = columns[column];
+            size_t cell = (size_t)row*values.Cols() + index;
+            // text cells are in the dictionary, only the numbers need to be read again
+            if(cellTypes[cell] == CELL_TEXT)
+            {
+                cellStrings[i] = dictionaries[index][textCode(values.Data()[cell])];
+                continue;
+            }
+            splitLine(text + rowBegin[row], text + rowEnd[row], separator, cells);
+            cellStrings[i] = cellString(cells[index], index == (int)cells.size()-1, separator);
+        }
+    });
+    return cellStrings;
+}
+
+vector< vector<string> > CSVParser::getRawData()
+{
+    vector< vector<string> > data(getCount());
+    ParallelRanges(data.size(), [&](int start, int stop)
+    {
+        vector<CSVCell> cells;
+        for(int row=start; row<stop; row++)
+        {
+            splitLine(text + rowBegin[row], text + rowEnd[row], separator, cells);
+            int size = getRowSize(row);
+            data[row].resize(size);
+            FOR(j, size)
+            {
+                int index = columns[j];
+                data[row][j] = cellString(cells[index], index == (int)cells.size()-1, separator);
+            }
+        }
+    });
+    return data;
 }
 
 void CSVParser::setOutputColumn(int column)
@@ -292,14 +804,34 @@ void CSVParser::setOutputColumn(int column)
 
 map<string,unsigned int> CSVParser::getOutputLabelTypes(bool reparse)
 {
-    if (!reparse) return classLabels;
+    if (!reparse || !getCount()) return classLabels;
     unsigned int id = 0;
     pair<map<string,unsigned int>::iterator,bool> ret;
     // Use by default the last column as output class
-    if ((data.size() && outputLabelColumn == -1) || outputLabelColumn >= data.size()) outputLabelColumn = data.at(0).size()-1;
-    for(vector<vector<string> >::iterator it = data.begin(); it<data.end(); it++)
+    if (outputLabelColumn == -1 || outputLabelColumn >= getCount()) outputLabelColumn = getRowSize(0)-1;
+    if(outputLabelColumn < 0) return classLabels;
+    int column = columns[outputLabelColumn];
+    vector<bool> bSeen(dictionaries[column].size(), false);
+    vector<CSVCell> cells;
+    FOR(i, getCount())
     {
-        ret = classLabels.insert( pair<string,unsigned int>(it->at(outputLabelColumn),id) );
+        if(outputLabelColumn >= getRowSize(i)) continue;
+        size_t cell = (size_t)i*values.Cols() + column;
+        string label;
+        // the text labels are taken from the dictionary, once each
+        if(cellTypes[cell] == CELL_TEXT)
+        {
+            int code = textCode(values.Data()[cell]);
+            if(bSeen[code]) continue;
+            bSeen[code] = true;
+            label = dictionaries[column][code];
+        }
+        else
+        {
+            splitLine(text + rowBegin[i], text + rowEnd[i], separator, cells);
+            label = cellString(cells[column], column == (int)cells.size()-1, separator);
+        }
+        ret = classLabels.insert( pair<string,unsigned int>(label,id) );
         if (ret.second == true) id++; // new class found
     }
     return classLabels;
@@ -308,236 +840,206 @@ map<string,unsigned int> CSVParser::getOutputLabelTypes(bool reparse)
 vector<size_t> CSVParser::getMissingValIndex()
 {
     vector<size_t> missingValIndex;
-    size_t nbCols = data.at(0).size();
-    for (size_t i = 0; i < data.size(); i++)
+    size_t nbCols = getRowSize(0);
+    for (size_t i = 0; i < getCount(); i++)
         for (size_t j = 0; j < nbCols; j++)
-            if (data[i][j] == "?") missingValIndex.push_back(i);
+            if (isMissing(i, j)) missingValIndex.push_back(i);
     return missingValIndex;
 }
 
 bool CSVParser::hasData()
 {
-    return data.size();
+    return getCount();
 }
 
 void CSVParser::cleanData(unsigned int acceptedTypes)
 {
-    vector<string>::iterator it_str;
-    vector<unsigned int>::iterator it_uint = dataTypes.begin();
-    for(size_t i = 0; i < dataTypes.size(); i++)
+    for(size_t i = 0; i < dataTypes.size() && i < columns.size(); i++)
         if (!(dataTypes[i]&acceptedTypes) &&  // data type does not correspond to a requested one
-           (i != outputLabelColumn))       // output labels are stored separately, ignore
+           ((int)i != outputLabelColumn))      // output labels are stored separately, ignore
         {
             cout << "Removing colum " << i << " of type " << dataTypes[i] <<  " ... ";
-            for(size_t j = 0; j < data.size(); j++)
-            {
-                /* @note it seems that if we have --i instead of (i-1), the compiler produces bad code (SIGSEGV) */
-                it_str = data.at(j).begin() + (i-1);
-                data.at(j).erase(it_str); // delete the column
-            }
+            columns.erase(columns.begin() + i); // delete the column
             cout << "and matching type reference ...  " ;
-            it_uint = dataTypes.begin() + (i-1);
-            dataTypes.erase(it_uint); // delete the input to stay consistant
-            i--; if (i < outputLabelColumn) outputLabelColumn--;
+            dataTypes.erase(dataTypes.begin() + i); // delete the input to stay consistant
+            if ((int)i < outputLabelColumn) outputLabelColumn--;
+            i--;
         }
 }
 
-pair<vector<fvec>,ivec> CSVParser::getData(ivec excludeIndex, int maxSamples)
+// position of a column of the file among the columns in use, -1 if it was dropped
+int CSVParser::getColumnIndex(const int fileColumn) const
 {
-    int count = data.size();
-    if(bFirstRowAsHeader) count--;
-    int headerSkip = bFirstRowAsHeader?1:0;
-    if(count <= 0) return pair<vector<fvec>,ivec>();
-    vector<fvec> samples(count);
-    ivec labels(count);
-    int dim = data[0].size();
-    if(outputLabelColumn != -1) outputLabelColumn = min(dim-1, outputLabelColumn);
+    ivec::const_iterator it = std::lower_bound(columns.begin(), columns.end(), fileColumn);
+    return it != columns.end() && *it == fileColumn ? it - columns.begin() : -1;
+}
+
+bool CSVParser::beginData(ivec excludeIndex, int maxSamples)
+{
+    cursor = DataCursor();
     classNames.clear();
     categorical.clear();
-    vector< map<string,int> > labelMaps(dim);
-    ivec labelCounters(dim,0);
-    pair<map<string,int>::iterator,bool> ret;
-    FOR(i, data.size())
-    {
-        if(!i && bFirstRowAsHeader) continue;
-        // check if it's always a number
-        fvec& sample = samples[i-headerSkip];
-        sample.resize((outputLabelColumn==-1) ? dim : dim-1);
-        FOR(j, dim)
-        {
-            if(data[i].size() < dim) {
-                qDebug() << "Something is wrong with the data, exiting!";
-                vector<fvec> newSamples;
-                ivec newLabels;
-                return pair<vector<fvec>,ivec>(newSamples,newLabels);
-            }
-            QString s(data[i][j].c_str());
-            bool ok;
-            float val = s.toFloat(&ok);
-            if(j==outputLabelColumn || !ok)
-            {
-                if(labelMaps[j].count(data[i][j]) > 0) val = labelMaps[j][data[i][j]];
-                else
-                {
-                    val = (float)labelCounters[j];
-                    ret = labelMaps[j].insert(pair<string,int>(data[i][j], val));
-                    if(ret.second) labelCounters[j]++;
-                }
-            }
-            if(j!=outputLabelColumn)
-            {
-                if(outputLabelColumn==-1) sample[j] = val;
-                else
-                {
-                    int index = j < outputLabelColumn ? j : j-1;
-                    sample[index] = val;
-                }
-            }
+    int rowCount = getCount();
+    int headerSkip = bFirstRowAsHeader?1:0;
+    int count = rowCount - headerSkip;
+    if(count <= 0) return false;
+    int dim = getRowSize(0);
+    if(outputLabelColumn != -1) outputLabelColumn = min(dim-1, outputLabelColumn);
+    for(int i=headerSkip; i<rowCount; i++)
+    {
+        if(getRowSize(i) < dim) {
+            qDebug() << "Something is wrong with the data, exiting!";
+            return false;
         }
     }
+
+    // the samples hold the columns in use but for the output and the excluded ones
+    vector<bool> bExclude(dim, false);
+    FOR(i, excludeIndex.size())
+    {
+        if(excludeIndex[i] >= 0 && excludeIndex[i] < dim) bExclude[excludeIndex[i]] = true;
+    }
     FOR(j, dim)
     {
-        if(j == outputLabelColumn) continue;
-        bool bNumerical = true;
-        FORIT(labelMaps[j], string, int)
-        {
-            bool ok;
-            QString(it->first.c_str()).toFloat(&ok);
-            if(!ok && it->first != "?")
-            {
-                bNumerical = false;
-                break;
-            }
-        }
-        if(bNumerical) continue;
-        int itemCount = 0;
-        FORIT(labelMaps[j], string, int)
-        {
-            itemCount = max(itemCount, it->second);
-        }
-        itemCount++;
-        vector<string> cat(itemCount);
-        FORIT(labelMaps[j], string, int)
-        {
-            int index = it->second;
-            cat[index] = it->first;
-        }
-        categorical[ j>outputLabelColumn ? j-1 : j ] = cat;
+        if(!bExclude[j] && (int)j != outputLabelColumn) cursor.inputs.push_back(j);
     }
+    cursor.codes.resize(cursor.inputs.size());
+    cursor.codeCounts.resize(cursor.inputs.size(), 0);
+    FOR(k, cursor.inputs.size()) cursor.codes[k].resize(dictionaries[columns[cursor.inputs[k]]].size(), -1);
 
-    if(labelMaps[outputLabelColumn].size() && outputLabelColumn != -1)
+    // a random subset of maxSamples rows, or all of them in order
+    if(maxSamples != -1 && maxSamples < count)
     {
-        bool bNumerical = true;
-        FORIT(labelMaps[outputLabelColumn], string, int)
-        {
-            bool ok;
-            QString(it->first.c_str()).toFloat(&ok);
-            if(!ok && it->first != "?")
-            {
-                bNumerical = false;
-                break;
-            }
-        }
-        if(!bNumerical)
-        {
-            FORIT(labelMaps[outputLabelColumn], string, int)
-            {
-                classNames[it->second] = QString(it->first.c_str());
-                //else classNames[it->second] = QString("Class %1").arg(QString(it->first.c_str()).toFloat());
-            }
-        }
-        else classNames.clear();
+        u32 *perm = randPerm(count);
+        cursor.rows.resize(maxSamples);
+        FOR(i, maxSamples) cursor.rows[i] = perm[i] + headerSkip;
+        delete [] perm;
+    }
+    else
+    {
+        cursor.rows.resize(count);
+        FOR(i, count) cursor.rows[i] = i + headerSkip;
     }
-    if(outputLabelColumn == -1)
+
+    // the labels are used as they are only if they are all numbers
+    if(outputLabelColumn != -1)
     {
-        FOR(i, data.size())
+        int cols = values.Cols();
+        int column = columns[outputLabelColumn];
+        for(int i=headerSkip; i<rowCount && cursor.bNumericalLabels; i++)
         {
-            if(!i && bFirstRowAsHeader) continue;
-            labels[i-headerSkip] = 0;
+            if(cellTypes[(size_t)i*cols + column] != CELL_NUMBER) cursor.bNumericalLabels = false;
         }
     }
-    else
+    return true;
+}
+
+bool CSVParser::getDataBatch(int batchSize, vector<fvec> &samples, ivec &labels)
+{
+    samples.clear();
+    labels.clear();
+    int stop = min((int)cursor.rows.size(), cursor.position + max(1, batchSize));
+    if(cursor.position >= stop) return false;
+    int cols = values.Cols();
+    const float *valueData = values.Data();
+    int dim = cursor.inputs.size();
+    samples.resize(stop - cursor.position, fvec(dim));
+    labels.resize(stop - cursor.position, 0);
+    vector<CSVCell> cells;
+    for(int i=cursor.position; i<stop; i++)
     {
-        bool numerical = true;
-        FOR(i, data.size())
+        int row = cursor.rows[i];
+        const float *rowValues = valueData + (size_t)row*cols;
+        const uint8_t *rowTypes = &cellTypes[(size_t)row*cols];
+        fvec &sample = samples[i - cursor.position];
+        // the text cells of each column are numbered in order of appearance
+        FOR(k, dim)
         {
-            if(!i && bFirstRowAsHeader) continue;
-            bool ok;
-            QString(data[i][outputLabelColumn].c_str()).toFloat(&ok);
-            if(!ok)
+            int column = columns[cursor.inputs[k]];
+            float val = rowValues[column];
+            if(rowTypes[column] == CELL_TEXT)
             {
-                numerical = false;
-                break;
+                int &code = cursor.codes[k][textCode(val)];
+                if(code == -1) code = cursor.codeCounts[k]++;
+                val = code;
             }
+            sample[k] = val;
         }
-        FOR(i, data.size())
+        if(outputLabelColumn == -1) continue;
+        int column = columns[outputLabelColumn];
+        int &label = labels[i - cursor.position];
+        if(cursor.bNumericalLabels)
         {
-            if(!i && bFirstRowAsHeader) continue;
-            bool ok;
-            float val = QString(data[i][outputLabelColumn].c_str()).toFloat(&ok);
-            if(numerical)
-            {
-                labels[i-headerSkip] = val;
-            }
-            else
-            {
-                int label = labelMaps[outputLabelColumn][data[i][outputLabelColumn]];
-                labels[i-headerSkip] = label;
-            }
+            label = rowValues[column];
+            continue;
+        }
+        string cell;
+        if(rowTypes[column] == CELL_TEXT) cell = dictionaries[column][textCode(rowValues[column])];
+        else
+        {
+            splitLine(text + rowBegin[row], text + rowEnd[row], separator, cells);
+            cell = cellString(cells[column], column == (int)cells.size()-1, separator);
         }
+        label = cursor.labelMap.insert(pair<string,int>(cell, cursor.labelMap.size())).first->second;
     }
-    if(maxSamples != -1 && maxSamples < samples.size())
+    cursor.position = stop;
+    if(cursor.position == (int)cursor.rows.size()) endData();
+    return true;
+}
+
+// the names of the text cells and labels, once all the rows have been read
+void CSVParser::endData()
+{
+    FOR(k, cursor.inputs.size())
     {
-        vector<fvec> newSamples(maxSamples);
-        ivec newLabels(maxSamples);
-        u32 *perm = randPerm(samples.size());
-        FOR(i, maxSamples)
+        bool bNumerical = true;
+        const vector<string> &dictionary = dictionaries[columns[cursor.inputs[k]]];
+        vector<string> cat(cursor.codeCounts[k]);
+        FOR(c, cursor.codes[k].size())
         {
-            newSamples[i] = samples[perm[i]];
-            newLabels[i] = labels[perm[i]];
+            if(cursor.codes[k][c] == -1) continue;
+            cat[cursor.codes[k][c]] = dictionary[c];
+            if(dictionary[c] != MISSING_VALUE) bNumerical = false;
         }
-        samples = newSamples;
-        labels = newLabels;
-        count = samples.size();
-        delete [] perm;
+        if(bNumerical) continue;
+        categorical[k] = cat;
     }
-    if(!excludeIndex.size()) return pair<vector<fvec>,ivec>(samples,labels);
-    vector<fvec> newSamples(count);
-    int newDim = dim - excludeIndex.size();
-    if(outputLabelColumn != -1) newDim--;
-    //qDebug() << "Indices to be excluded: " << excludeIndex.size() << "(newDim: " << newDim << ")";
-    FOR(i, excludeIndex.size())
+    bool bNumerical = true;
+    FORIT(cursor.labelMap, string, int)
     {
-        //qDebug() << i << ":" << excludeIndex[i];
-        // if it's the output we can ignore it but we need to reincrement the number of dimensions
-        if(excludeIndex[i] == outputLabelColumn)
+        bool ok;
+        QString(it->first.c_str()).toFloat(&ok);
+        if(!ok && it->first != "?")
         {
-            newDim++;
+            bNumerical = false;
             break;
         }
     }
-    vector<bool> bExclude(dim, false);
-    FOR(i, excludeIndex.size())
+    if(!bNumerical)
     {
-        bExclude[excludeIndex[i]] = true;
-    }
-    FOR(i, samples.size())
-    {
-        newSamples[i].resize(newDim);
-        int nD = 0;
-        FOR(d, dim)
+        FORIT(cursor.labelMap, string, int)
         {
-            if(bExclude[d] || d == outputLabelColumn) continue;
-            if(outputLabelColumn == -1) newSamples[i][nD] = samples[i][d];
-            else if (d < outputLabelColumn) newSamples[i][nD] = samples[i][d];
-            else if(d > outputLabelColumn) newSamples[i][nD] = samples[i][d-1];
-            nD++;
+            classNames[it->second] = QString(it->first.c_str());
         }
     }
-    qDebug() << "Imported samples: " << newSamples.size() << " labels: " << labels.size();
-    return pair<vector<fvec>,ivec>(newSamples,labels);
 }
 
+pair<vector<fvec>,ivec> CSVParser::getData(ivec excludeIndex, int maxSamples)
+{
+    pair<vector<fvec>,ivec> data;
+    if(!beginData(excludeIndex, maxSamples)) return data;
+    data.first.reserve(getDataCount());
+    data.second.reserve(getDataCount());
+    vector<fvec> samples;
+    ivec labels;
+    while(getDataBatch(65536, samples, labels))
+    {
+        data.first.insert(data.first.end(), samples.begin(), samples.end());
+        data.second.insert(data.second.end(), labels.begin(), labels.end());
+    }
+    qDebug() << "Imported samples: " << data.first.size() << " labels: " << data.second.size();
+    return data;
+}
 
 uint8_t CSVParser::getBOMsize(const char* fileName)
 {
@@ -42,6 +42,9 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include <types.h>
 #include <QString>
 #include <stdint.h>
+#include <functional>
+#include "sampleMatrix.h"
+#include "mappedFile.h"
 
 using namespace std;
 
@@ -106,32 +109,86 @@ class CSVParser
 {
 public:
     CSVParser();
+    ~CSVParser();
     void clear();
     void parse(const char* fileName, int separatorType=0);
+    // reads the first prefixRows lines, then up to sampledRows lines spread evenly over the rest of the file,
+    // and stops early once timeBudget milliseconds have passed. The file is not parsed, use parse() for that
+    vector< vector<string> > preview(const char* fileName, int prefixRows, int sampledRows, int timeBudget, int separatorType=0);
+    int getEstimatedCount() const {return estimatedCount;} // number of rows extrapolated from the preview
+    // called during parse() with the fraction done (from any of the parsing threads), returning false cancels the parsing
+    void setProgressCallback(std::function<bool(float)> callback){progressCallback = callback;}
     vector<size_t> getMissingValIndex();
     void cleanData(unsigned int acceptedTypes);
     pair<vector<fvec>,ivec> getData(ivec excludeIndex = ivec(), int maxSamples=-1);
+    // getData in batches of rows: beginData once, then getDataBatch until it returns false
+    // the class names and categorical values are known once the last batch has been read
+    bool beginData(ivec excludeIndex = ivec(), int maxSamples=-1);
+    bool getDataBatch(int batchSize, vector<fvec> &samples, ivec &labels);
+    int getDataCount() const {return cursor.rows.size();}
+    // position of a column of the file among the columns in use (e.g. after parse() dropped the empty ones), -1 if it was dropped
+    int getColumnIndex(const int fileColumn) const;
     map<string,unsigned int> getOutputLabelTypes(bool reparse);
     void setOutputColumn(int column);
     void setFirstRowAsHeader(bool value){bFirstRowAsHeader = value;}
     bool hasData();
     vector<unsigned int> getDataType(){return dataTypes;}
-    int getCount(){return data.size();}
-    vector< vector<string> > getRawData(){return data;}
+    int getCount() const {return rowBegin.size();}
+    vector< vector<string> > getRawData();
     static pair<vector<fvec>, ivec> numericFromRawData(vector< vector<string> > rawData);
     map<int,QString> getClassNames(){return classNames;}
     map<int, vector<string> > getCategorical(){return categorical;}
 
 private:
+    enum CellType {CELL_NONE=0, CELL_NUMBER, CELL_TEXT};
+
     bool bFirstRowAsHeader;
     int outputLabelColumn;
-    ifstream file;
     map<string,unsigned int> classLabels;
     map<int, QString> classNames;
-    vector<vector<string> > data;
     vector<unsigned int> dataTypes;
     map<int, vector<string> > categorical;
+
+    // the rows are kept as offsets in the (mapped) file, their cells are parsed once in values:
+    // numbers are stored as they are, text cells as their index in the dictionary of their column (the bits of an int)
+    MappedFile *mapping;
+    string buffer; // file contents when it cannot be mapped as is (e.g. wide encodings)
+    const char *text;
+    size_t textLength;
+    char separator;
+    int estimatedCount;
+    std::function<bool(float)> progressCallback;
+    vector<uint64_t> rowBegin, rowEnd;
+    ivec rowSizes;
+    SampleMatrix values;
+    vector<uint8_t> cellTypes;
+    vector< vector<string> > dictionaries;
+    ivec columns; // columns still in use, empty columns are dropped after parsing
+
+    // where getData is in the rows
+    struct DataCursor
+    {
+        ivec rows; // rows of the file, in the order they are returned
+        int position;
+        ivec inputs; // columns in use that go in the samples
+        vector<ivec> codes; // code of each text cell of the inputs, in order of appearance
+        ivec codeCounts;
+        map<string,int> labelMap;
+        bool bNumericalLabels;
+        DataCursor() : position(0), bNumericalLabels(true) {}
+    } cursor;
+
+    CSVParser(const CSVParser &);
+    CSVParser& operator= (const CSVParser &);
+
     uint8_t getBOMsize(const char* fileName);
+    bool openText(const char* fileName);
+    char findSeparator(int separatorType) const;
+    int getRowSize(const int row) const;
+    bool isMissing(const int row, const int column) const;
+    string getCell(const int row, const int column) const;
+    vector<string> getColumnCells(const int column, const int firstRow=0) const;
+    void endData();
 };
 
 #endif // PARSER_H
@@ -0,0 +1,140 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#include "pathLod.h"
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+// number of zoom levels kept in a PathLod
+const int lodLevelCount = 4;
+
+// distance from p to the segment ab
+static inline float segmentDistance(const float *p, const float *a, const float *b)
+{
+    float dx = b[0] - a[0], dy = b[1] - a[1];
+    float px = p[0] - a[0], py = p[1] - a[1];
+    float length = dx*dx + dy*dy;
+    float t = length > 0 ? max(0.f, min(1.f, (px*dx + py*dy) / length)) : 0.f;
+    px -= t*dx;
+    py -= t*dy;
+    return sqrtf(px*px + py*py);
+}
+
+ivec ThinPolyline(const fvec &xy, const float spacing)
+{
+    int count = xy.size()/2;
+    ivec kept;
+    if(!count) return kept;
+    kept.push_back(0);
+    float spacing2 = spacing*spacing;
+    for(int i=1; i<count-1; i++)
+    {
+        const float *last = &xy[kept.back()*2];
+        float dx = xy[i*2] - last[0], dy = xy[i*2+1] - last[1];
+        if(dx*dx + dy*dy >= spacing2) kept.push_back(i);
+    }
+    if(count > 1) kept.push_back(count-1);
+    return kept;
+}
+
+ivec SimplifyPolyline(const fvec &xy, const float tolerance)
+{
+    // dropping the vertices closer than the tolerance to their predecessor first
+    // brings densely sampled recordings down to a few vertices per pixel for the recursive pass
+    ivec candidates = ThinPolyline(xy, tolerance);
+    int count = candidates.size();
+    if(count < 3) return candidates;
+
+    bvec keep(count, false);
+    keep[0] = keep[count-1] = true;
+    vector<ipair> stack(1, ipair(0, count-1));
+    while(stack.size())
+    {
+        ipair range = stack.back();
+        stack.pop_back();
+        const float *a = &xy[candidates[range.first]*2], *b = &xy[candidates[range.second]*2];
+        int farthest = -1;
+        float distance = tolerance;
+        for(int i=range.first+1; i<range.second; i++)
+        {
+            float d = segmentDistance(&xy[candidates[i]*2], a, b);
+            if(d <= distance) continue;
+            distance = d;
+            farthest = i;
+        }
+        if(farthest < 0) continue;
+        keep[farthest] = true;
+        stack.push_back(ipair(range.first, farthest));
+        stack.push_back(ipair(farthest, range.second));
+    }
+    ivec kept;
+    FOR(i, count) if(keep[i]) kept.push_back(candidates[i]);
+    return kept;
+}
+
+ivec EnvelopePolyline(const fvec &xy)
+{
+    int count = xy.size()/2;
+    ivec kept;
+    int i = 0;
+    while(i < count)
+    {
+        // the run of vertices falling in the same column
+        float column = floorf(xy[i*2]);
+        int first = i, lowest = i, highest = i;
+        for(i++; i<count && floorf(xy[i*2]) == column; i++)
+        {
+            if(xy[i*2+1] < xy[lowest*2+1]) lowest = i;
+            if(xy[i*2+1] > xy[highest*2+1]) highest = i;
+        }
+        int last = i-1;
+        int run[4] = {first, min(lowest, highest), max(lowest, highest), last};
+        FOR(j, 4) if(kept.empty() || run[j] != kept.back()) kept.push_back(run[j]);
+    }
+    return kept;
+}
+
+PathLod::PathLod()
+    : source(0), revision(0)
+{}
+
+vector<ivec> &PathLod::Paths(const u32 source, const u32 revision, const ivec &variant, const float sx, const float sy)
+{
+    if(source != this->source || revision != this->revision || variant != this->variant)
+    {
+        levels.clear();
+        this->source = source;
+        this->revision = revision;
+        this->variant = variant;
+    }
+    fvec scale(2);
+    scale[0] = sx;
+    scale[1] = sy;
+    int level = 0;
+    while(level < (int)levels.size() && levels[level].first != scale) level++;
+    if(level == (int)levels.size())
+    {
+        if(levels.size() >= lodLevelCount) levels.pop_back();
+        levels.push_back(make_pair(scale, vector<ivec>()));
+        level = levels.size()-1;
+    }
+    rotate(levels.begin(), levels.begin() + level, levels.begin() + level + 1);
+    return levels[0].second;
+}
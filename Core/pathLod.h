@@ -0,0 +1,54 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#ifndef _PATH_LOD_H_
+#define _PATH_LOD_H_
+
+#include <vector>
+#include "types.h"
+
+// level of detail of the polylines drawn on the canvas (trajectories and time series)
+// the polylines are given as x,y pairs already scaled to pixels, the functions return
+// the indices of the vertices to draw, always including the first and the last one
+
+// Douglas-Peucker on the vertices at least tolerance apart: the simplified line passes
+// within about tolerance of every vertex (never more than twice)
+ivec SimplifyPolyline(const fvec &xy, const float tolerance=0.5f);
+// vertices at least spacing away from the last one kept
+ivec ThinPolyline(const fvec &xy, const float spacing=1.f);
+// for a polyline going from left to right: the first, lowest, highest and last vertex of every pixel column
+ivec EnvelopePolyline(const fvec &xy);
+
+// simplified paths for the last few zoom levels. The scale is all the simplification depends on,
+// so the paths survive panning, and they are dropped as soon as the data they come from changes
+class PathLod
+{
+    u32 source, revision;
+    ivec variant;
+    std::vector< std::pair<fvec, std::vector<ivec> > > levels; // most recently used first
+
+public:
+    PathLod();
+
+    void Clear() {levels.clear();}
+    // paths cached at scale (sx, sy), the caller fills the empty ones. variant holds
+    // anything else the paths depend on (projected dimensions, resampling...)
+    std::vector<ivec> &Paths(const u32 source, const u32 revision, const ivec &variant, const float sx, const float sy);
+};
+
+#endif // _PATH_LOD_H_
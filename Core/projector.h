@@ -3,6 +3,7 @@
 
 #include <vector>
 #include "mymaths.h"
+#include "sampleMatrix.h"
 
 class Projector
 {
@@ -19,6 +20,48 @@ public:
     virtual fvec Project(const fvec &sample){ return sample; }
     virtual float Project1D(const fvec &sample){ fvec proj = Project(sample); return proj.size() ? proj[0] : 0; }
     virtual fvec Project(const fVec &sample){ return Project((fvec)sample); }
+    // projects all the rows of samples at once and returns the number of projected dimensions per row,
+    // stored row after row in projections (the output is resized to fit)
+    virtual int ProjectBatch(const SampleView &samples, fvec &projections)
+    {
+        int rows = samples.Rows();
+        int outputs = 0;
+        fvec sample(samples.Cols());
+        FOR(i, rows)
+        {
+            if(sample.size()) samples.CopyRow(i, &sample[0]);
+            fvec res = Project(sample);
+            if(!i)
+            {
+                outputs = res.size();
+                projections.resize((size_t)rows*outputs);
+            }
+            FOR(d, outputs) projections[(size_t)i*outputs + d] = d < (int)res.size() ? res[d] : 0;
+        }
+        if(!rows) projections.clear();
+        return outputs;
+    }
+    // runs a set of samples through ProjectBatch and splits the results back, one vector per sample
+    std::vector<fvec> ProjectSamples(const std::vector<fvec> &samples)
+    {
+        std::vector<fvec> results(samples.size());
+        if(!samples.size()) return results;
+        int dim = samples[0].size();
+        FOR(i, samples.size())
+        {
+            // samples of different sizes cannot be packed together
+            if((int)samples[i].size() != dim)
+            {
+                FOR(j, samples.size()) results[j] = Project(samples[j]);
+                return results;
+            }
+        }
+        SampleMatrix matrix(samples);
+        fvec projections;
+        int outputs = ProjectBatch(matrix.View(), projections);
+        FOR(i, samples.size()) results[i] = fvec(projections.begin() + (size_t)i*outputs, projections.begin() + (size_t)(i+1)*outputs);
+        return results;
+    }
     virtual const char *GetInfoString(){return NULL;}
     virtual std::vector<fvec> GetProjected(){ return projected; }
 };
@@ -88,48 +88,44 @@ void QContour::ShowValueImage()
 void QContour::Paint(QPainter &painter, int levels, int zoom)
 {
     if(vmin == vmax) return;
-    CContourMap map;
-    levels = (int)(levels*sqrt(zoom));
-    map.generate_levels(vmin,vmax,levels);
-    map.contour(&valueMap);
-    //map.dump();
-    map.consolidate(); // connect all the lines
-    //map.dump();
     int w = valueMap.w, h = valueMap.h;
+    levels = (int)(levels*sqrt(zoom));
+    // all the levels are extracted in a single pass over the grid, and already connected into lines
+    MarchingSquares marching(valueMap.data(), w, h);
+    vector<ContourLines> lines = marching.Extract(MarchingSquares::Levels(vmin, vmax, levels));
     int W = painter.viewport().width();
     int H = painter.viewport().height();
 
     QList<QPainterPath> paths;
     QList<double> altitudes;
-    for(int i=0; i<levels; i++)
+    for(int i=0; i<lines.size(); i++)
     {
-        CContourLevel *level = map.level(i);
-        if(!level || !level->contour_lines) continue;
-        for(int j=0; j<level->contour_lines->size(); j++)
+        const ContourLines &level = lines[i];
+        if(!level.Count()) continue;
+        for(int j=0; j<level.Count(); j++)
         {
-            CContour *line = level->contour_lines->at(j);
-            vector<SPoint> points = line->contourPoints();
+            const float *points = level.Line(j);
+            int count = level.Length(j);
             QPointF oldPoint;
             int emptyCount = 0;
             QPainterPath path;
-            for(int p=0; p<points.size(); p++)
+            for(int p=0; p<count; p++)
             {
-                QPointF point(points[p].x*W/(w-2), points[p].y*H/(h-2));
+                QPointF point(points[p*2]*W/(w-2), points[p*2+1]*H/(h-2));
                 if(p)
                 {
                     path.lineTo(point);
-//                    painter.drawLine(point, oldPoint);
                     QPointF diff = point - oldPoint;
                     if(diff.x() == 0 || diff.y() == 0) emptyCount++;
                 }
                 else path.moveTo(point);
-                if(emptyCount > points.size()*0.2f) break;
-                oldPoint = point;                
+                if(emptyCount > count*0.2f) break;
+                oldPoint = point;
             }
-            if(emptyCount / (float) points.size() > 0.2) continue; // we dont want stuff that has loads of empty segments
+            if(emptyCount / (float) count > 0.2) continue; // we dont want stuff that has loads of empty segments
             paths.push_back(path);
         }
-        altitudes.push_back(map.alt(i));
+        altitudes.push_back(level.level);
     }
 
     painter.setRenderHint(QPainter::Antialiasing);
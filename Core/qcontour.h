@@ -2,6 +2,7 @@
 #define QCONTOUR_H
 
 #include "contours.h"
+#include "marchingSquares.h"
 #include <QPainter>
 
 // implementation of the CRaster class for contour lines creation
@@ -12,6 +13,7 @@ public:
     int w, h;
     ValueMap(double *values=0, int w=0, int h=0):values(values), w(w), h(h){}
     double value(double x,double y){return values && w ? values[int(y)*w + int(x)] : 0;}
+    const double *data() const {return values;}
     SPoint upper_bound(){return SPoint(w-1,h-1);}
     SPoint lower_bound(){return SPoint(0,0);}
 };
@@ -21,6 +21,9 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 
 #include <vector>
 #include <mymaths.h>
+#include "sampleMatrix.h"
+
+struct GramScope;
 
 extern "C" enum {REGR_SVR, REGR_RVM, REGR_GMR, REGR_GPR, REGR_KNN, REGR_MLP, REGR_LINEAR, REGR_LWPR, REGR_KRLS, REGR_NONE} regressorType;
 
@@ -40,6 +43,7 @@ protected:
 	s32 class2labels[255];
 	ivec labels2class;
 	bool bFixedThreshold;
+	bool bTrainThreadSafe; // Train and Test only touch this model and can run while other models do on other threads (set by the plugins that were checked)
 
 public:
 	std::vector<fvec> crossval;
@@ -47,18 +51,43 @@ public:
 	fvec trainErrors, testErrors;
 	int type;
     int outputDim;
+    const GramScope *gramScope; // rows of a kernel cache the next training samples are, 0 when they are not
 
-    Regressor() : posClass(0), bFixedThreshold(true), classThresh(0.5f), classSpan(0.1f), outputDim(-1), type(REGR_NONE){}
+    Regressor() : posClass(0), bFixedThreshold(true), bTrainThreadSafe(false), classThresh(0.5f), classSpan(0.1f), outputDim(-1), type(REGR_NONE), gramScope(0){}
     std::vector <fvec> GetSamples(){return samples;}
     void SetOutputDim(int outputDim){this->outputDim = outputDim;}
+    bool IsTrainThreadSafe() const {return bTrainThreadSafe;}
     virtual ~Regressor(){}
 
     virtual void Train(std::vector< fvec > samples, ivec labels){}
     virtual fvec Test( const fvec &sample){ return fvec(); }
     virtual fVec Test(const fVec &sample){ if (dim==2) return fVec(Test((fvec)sample)); fvec s = (fvec)sample; s.resize(dim,0); return Test(s);}
+    // tests all the rows of samples at once: means[i] and confidences[i] receive the two values Test returns for row i
+    // the outputs are resized to the number of rows, which keeps their storage when they are reused across calls
+    virtual void TestBatch(const SampleView &samples, fvec &means, fvec &confidences)
+    {
+        int rows = samples.Rows();
+        means.resize(rows);
+        confidences.resize(rows);
+        fvec sample(samples.Cols());
+        FOR(i, rows)
+        {
+            if(sample.size()) samples.CopyRow(i, &sample[0]);
+            fvec res = Test(sample);
+            means[i] = res.size() ? res[0] : 0;
+            confidences[i] = res.size() > 1 ? res[1] : 0;
+        }
+    }
     virtual const char *GetInfoString(){return NULL;}
     virtual void SaveModel(std::string filename){}
     virtual bool LoadModel(std::string filename){return false;}
+
+    // out-of-core training: the samples are fed by blocks, in at most StreamPasses() passes over the data
+    // StreamEnd returns false once no further pass is needed
+    virtual int StreamPasses(){return 0;}
+    virtual void StreamBegin(const int pass, const int dim){}
+    virtual void StreamBlock(const SampleView &block){}
+    virtual bool StreamEnd(const int pass){return false;}
 };
 
 #endif // _REGRESSOR_H_
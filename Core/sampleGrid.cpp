@@ -0,0 +1,254 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#include "sampleGrid.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+using namespace std;
+
+// average number of samples per cell when the grid is built
+const float gridSamplesPerCell = 4.f;
+// cells further than this from the origin are folded onto the border of the grid
+const double gridMaxCell = 1 << 28;
+
+static inline long long cellKey(const int cx, const int cy)
+{
+    return ((long long)cx << 32) ^ (unsigned int)cy;
+}
+
+SampleGrid::SampleGrid()
+    : xIndex(-1), yIndex(-1), source(0), revision(0), builtCount(0),
+      x0(0), y0(0), cellW(1), cellH(1), minCx(0), minCy(0), maxCx(-1), maxCy(-1)
+{}
+
+void SampleGrid::Clear()
+{
+    xIndex = yIndex = -1;
+    builtCount = 0;
+    xs.clear();
+    ys.clear();
+    cells.clear();
+    minCx = minCy = 0;
+    maxCx = maxCy = -1;
+}
+
+bool SampleGrid::Cell(const float x, const float y, int &cx, int &cy) const
+{
+    if(!(fabsf(x) <= FLT_MAX && fabsf(y) <= FLT_MAX)) return false; // nan and inf are not indexed
+    double fx = floor((x - x0) / cellW), fy = floor((y - y0) / cellH);
+    cx = (int)max(-gridMaxCell, min(gridMaxCell, fx));
+    cy = (int)max(-gridMaxCell, min(gridMaxCell, fy));
+    return true;
+}
+
+const ivec *SampleGrid::Samples(const int cx, const int cy) const
+{
+    unordered_map<long long, ivec>::const_iterator it = cells.find(cellKey(cx, cy));
+    return it == cells.end() ? 0 : &it->second;
+}
+
+void SampleGrid::Insert(const int i)
+{
+    int cx, cy;
+    if(!Cell(xs[i], ys[i], cx, cy)) return;
+    if(maxCx < minCx)
+    {
+        minCx = maxCx = cx;
+        minCy = maxCy = cy;
+    }
+    else
+    {
+        minCx = min(minCx, cx);
+        maxCx = max(maxCx, cx);
+        minCy = min(minCy, cy);
+        maxCy = max(maxCy, cy);
+    }
+    cells[cellKey(cx, cy)].push_back(i);
+}
+
+void SampleGrid::Build(const SampleView &samples, const int xIndex, const int yIndex)
+{
+    Clear();
+    this->xIndex = xIndex;
+    this->yIndex = yIndex;
+    int count = samples.Rows();
+    builtCount = count;
+    xs.resize(count);
+    ys.resize(count);
+    // dimensions the samples do not have are drawn at 0
+    bool bX = xIndex >= 0 && xIndex < samples.Cols(), bY = yIndex >= 0 && yIndex < samples.Cols();
+    float xmin = FLT_MAX, xmax = -FLT_MAX, ymin = FLT_MAX, ymax = -FLT_MAX;
+    int finite = 0;
+    FOR(i, count)
+    {
+        const float *sample = samples.RowData(i);
+        float x = bX ? sample[xIndex] : 0.f, y = bY ? sample[yIndex] : 0.f;
+        xs[i] = x;
+        ys[i] = y;
+        if(!(fabsf(x) <= FLT_MAX && fabsf(y) <= FLT_MAX)) continue;
+        xmin = min(xmin, x);
+        xmax = max(xmax, x);
+        ymin = min(ymin, y);
+        ymax = max(ymax, y);
+        finite++;
+    }
+    if(!finite) return;
+
+    // as many cells along each axis, so that the cells follow the aspect of the data
+    int side = max(1, (int)sqrtf(finite / gridSamplesPerCell));
+    x0 = xmin;
+    y0 = ymin;
+    cellW = (xmax - xmin) / side;
+    cellH = (ymax - ymin) / side;
+    if(!(cellW > 0)) cellW = cellH > 0 ? cellH : 1.f;
+    if(!(cellH > 0)) cellH = cellW;
+    cells.reserve(min(finite, side*side));
+    FOR(i, count) Insert(i);
+}
+
+void SampleGrid::Update(const SampleView &samples, const int xIndex, const int yIndex, const u32 source, const u32 revision)
+{
+    int count = samples.Rows();
+    // the cells are sized for the samples present at the last build, we start over once the dataset has doubled
+    bool bRebuild = xIndex != this->xIndex || yIndex != this->yIndex
+            || source != this->source || revision != this->revision
+            || count < Count() || count > 2*builtCount + 64;
+    this->source = source;
+    this->revision = revision;
+    if(bRebuild)
+    {
+        Build(samples, xIndex, yIndex);
+        return;
+    }
+    bool bX = xIndex >= 0 && xIndex < samples.Cols(), bY = yIndex >= 0 && yIndex < samples.Cols();
+    for(int i=Count(); i<count; i++)
+    {
+        const float *sample = samples.RowData(i);
+        xs.push_back(bX ? sample[xIndex] : 0.f);
+        ys.push_back(bY ? sample[yIndex] : 0.f);
+        Insert(i);
+    }
+}
+
+void SampleGrid::Query(const float xmin, const float ymin, const float xmax, const float ymax, ivec &indices) const
+{
+    indices.clear();
+    int cx0, cy0, cx1, cy1;
+    if(cells.empty() || !Cell(xmin, ymin, cx0, cy0) || !Cell(xmax, ymax, cx1, cy1)) return;
+    cx0 = max(cx0, minCx);
+    cy0 = max(cy0, minCy);
+    cx1 = min(cx1, maxCx);
+    cy1 = min(cy1, maxCy);
+    if(cx0 > cx1 || cy0 > cy1) return;
+
+    // when the rectangle spans more cells than there are occupied ones we go through those instead
+    double span = (double)(cx1 - cx0 + 1)*(cy1 - cy0 + 1);
+    vector<const ivec *> hits;
+    if(span > cells.size())
+    {
+        for(unordered_map<long long, ivec>::const_iterator it = cells.begin(); it != cells.end(); it++)
+        {
+            const float x = xs[it->second[0]], y = ys[it->second[0]];
+            int cx, cy;
+            Cell(x, y, cx, cy);
+            if(cx >= cx0 && cx <= cx1 && cy >= cy0 && cy <= cy1) hits.push_back(&it->second);
+        }
+    }
+    else
+    {
+        for(int cy=cy0; cy<=cy1; cy++)
+        {
+            for(int cx=cx0; cx<=cx1; cx++)
+            {
+                const ivec *cell = Samples(cx, cy);
+                if(cell) hits.push_back(cell);
+            }
+        }
+    }
+    FOR(h, hits.size())
+    {
+        const ivec &cell = *hits[h];
+        FOR(j, cell.size())
+        {
+            int i = cell[j];
+            if(xs[i] >= xmin && xs[i] <= xmax && ys[i] >= ymin && ys[i] <= ymax) indices.push_back(i);
+        }
+    }
+    sort(indices.begin(), indices.end());
+}
+
+int SampleGrid::Nearest(const float x, const float y, const float sx, const float sy, float *distance) const
+{
+    int closest = -1;
+    float best = FLT_MAX;
+    int cx, cy;
+    if(cells.empty() || !Cell(x, y, cx, cy)) return -1;
+
+    // we visit rings of cells around the one holding (x,y): once the closest sample found so far
+    // is nearer than the inner border of the ring, nothing further away can beat it
+    float ringStep = min(fabsf(sx)*cellW, fabsf(sy)*cellH);
+    int last = max(max(cx - minCx, maxCx - cx), max(cy - minCy, maxCy - cy));
+    size_t visited = 0;
+    for(int r=max(0, max(max(minCx - cx, cx - maxCx), max(minCy - cy, cy - maxCy))); r<=last; r++)
+    {
+        if(closest >= 0 && best <= (r-1)*ringStep) break;
+        if(visited > cells.size() + 16) // the occupied cells are sparse around here, checking every sample is cheaper
+        {
+            closest = -1;
+            best = FLT_MAX;
+            FOR(i, xs.size())
+            {
+                float dx = (xs[i] - x)*sx, dy = (ys[i] - y)*sy;
+                float d = sqrtf(dx*dx + dy*dy);
+                if(d < best)
+                {
+                    best = d;
+                    closest = i;
+                }
+            }
+            break;
+        }
+        for(int j=max(cy - r, minCy); j<=min(cy + r, maxCy); j++)
+        {
+            bool bEdge = j == cy - r || j == cy + r;
+            int step = bEdge ? 1 : 2*r;
+            for(int i=cx - r; i<=cx + r; i+=max(step, 1))
+            {
+                if(i < minCx || i > maxCx) continue;
+                visited++;
+                const ivec *cell = Samples(i, j);
+                if(!cell) continue;
+                FOR(k, cell->size())
+                {
+                    int s = (*cell)[k];
+                    float dx = (xs[s] - x)*sx, dy = (ys[s] - y)*sy;
+                    float d = sqrtf(dx*dx + dy*dy);
+                    if(d < best || (d == best && s < closest))
+                    {
+                        best = d;
+                        closest = s;
+                    }
+                }
+            }
+        }
+    }
+    if(distance) *distance = best;
+    return closest;
+}
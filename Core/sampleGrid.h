@@ -0,0 +1,64 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#ifndef _SAMPLE_GRID_H_
+#define _SAMPLE_GRID_H_
+
+#include <vector>
+#include <unordered_map>
+#include "types.h"
+#include "sampleMatrix.h"
+
+// spatial index of the samples projected on two of their dimensions, used by the canvas
+// to find the samples under the mouse without going through the whole dataset.
+// The samples are hashed into a uniform grid in sample space (so that panning and zooming
+// do not invalidate it), new samples are inserted as they are appended to the dataset
+// and any other change to the dataset rebuilds the grid on the next query
+class SampleGrid
+{
+    int xIndex, yIndex;
+    u32 source, revision; // dataset and dataset revision the grid was built for
+    int builtCount;
+    fvec xs, ys; // projected coordinates of every sample
+    float x0, y0, cellW, cellH;
+    int minCx, minCy, maxCx, maxCy; // extent of the occupied cells
+    std::unordered_map<long long, ivec> cells;
+
+    void Insert(const int i);
+    bool Cell(const float x, const float y, int &cx, int &cy) const;
+    const ivec *Samples(const int cx, const int cy) const;
+
+public:
+    SampleGrid();
+
+    void Clear();
+    void Build(const SampleView &samples, const int xIndex, const int yIndex);
+    // rebuilds or extends the grid to match samples, source and revision identify the state of the dataset
+    void Update(const SampleView &samples, const int xIndex, const int yIndex, const u32 source, const u32 revision);
+
+    int Count() const {return xs.size();}
+    float X(const int i) const {return xs[i];}
+    float Y(const int i) const {return ys[i];}
+
+    // indices (in increasing order) of the samples inside the rectangle
+    void Query(const float xmin, const float ymin, const float xmax, const float ymax, ivec &indices) const;
+    // closest sample to (x,y) when distances along x and y are scaled by sx and sy, -1 if there are none
+    int Nearest(const float x, const float y, const float sx=1.f, const float sy=1.f, float *distance=0) const;
+};
+
+#endif // _SAMPLE_GRID_H_
@@ -0,0 +1,326 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#include "sampleMatrix.h"
+#include <stdlib.h>
+#include <stdint.h>
+
+using namespace std;
+
+// we over-allocate and keep the original pointer just before the aligned block
+// (posix_memalign and _aligned_malloc are not available on all our platforms)
+float *AllocSampleBuffer(const size_t count)
+{
+    if(!count) return 0;
+    size_t bytes = count*sizeof(float) + SAMPLE_ALIGNMENT + sizeof(void*);
+    char *raw = (char *)malloc(bytes);
+    if(!raw) return 0;
+    uintptr_t address = (uintptr_t)(raw + sizeof(void*));
+    address = (address + SAMPLE_ALIGNMENT - 1) & ~(uintptr_t)(SAMPLE_ALIGNMENT - 1);
+    ((void **)address)[-1] = raw;
+    return (float *)address;
+}
+
+void FreeSampleBuffer(float *buffer)
+{
+    if(!buffer) return;
+    free(((void **)buffer)[-1]);
+}
+
+/******************************************/
+/*                                        */
+/*    SAMPLE VIEW                         */
+/*                                        */
+/******************************************/
+void SampleView::CopyRow(const int i, float *dst) const
+{
+    const float *row = RowData(i);
+    if(!columns.size())
+    {
+        memcpy(dst, row, stride*sizeof(float));
+        return;
+    }
+    FOR(d, columns.size()) dst[d] = row[columns[d]];
+}
+
+fvec SampleView::Row(const int i) const
+{
+    if(i < 0 || i >= rows) return fvec();
+    fvec sample(Cols());
+    CopyRow(i, &sample[0]);
+    return sample;
+}
+
+std::vector<fvec> SampleView::ToVector() const
+{
+    vector<fvec> samples(rows);
+    if(!rows || !Cols()) return samples;
+    FOR(i, rows)
+    {
+        samples[i].resize(Cols());
+        CopyRow(i, &samples[i][0]);
+    }
+    return samples;
+}
+
+std::vector<fvec> SampleView::ToVector(const ivec &indices) const
+{
+    vector<fvec> samples(indices.size());
+    if(!Cols()) return samples;
+    FOR(i, indices.size())
+    {
+        samples[i].resize(Cols());
+        CopyRow(indices[i], &samples[i][0]);
+    }
+    return samples;
+}
+
+void SampleView::CopyTo(float *dst) const
+{
+    if(!rows) return;
+    if(!columns.size())
+    {
+        memcpy(dst, data, (size_t)rows*stride*sizeof(float));
+        return;
+    }
+    int dim = columns.size();
+    FOR(i, rows) CopyRow(i, dst + (size_t)i*dim);
+}
+
+/******************************************/
+/*                                        */
+/*    SAMPLE MATRIX                       */
+/*                                        */
+/******************************************/
+SampleMatrix::SampleMatrix(const int cols)
+    : data(0), rows(0), cols(cols), capacity(0), bExternal(false)
+{}
+
+SampleMatrix::SampleMatrix(const SampleMatrix &m)
+    : data(0), rows(0), cols(m.cols), capacity(0), bExternal(false)
+{
+    Reserve(m.rows, m.cols);
+    rows = m.rows;
+    if(rows) memcpy(data, m.data, (size_t)rows*cols*sizeof(float));
+}
+
+SampleMatrix::SampleMatrix(const std::vector<fvec> &samples)
+    : data(0), rows(0), cols(0), capacity(0), bExternal(false)
+{
+    SetRows(samples);
+}
+
+SampleMatrix::~SampleMatrix()
+{
+    if(!bExternal) FreeSampleBuffer(data);
+}
+
+SampleMatrix& SampleMatrix::operator= (const SampleMatrix &m)
+{
+    if(this != &m)
+    {
+        rows = 0;
+        if(cols != m.cols || bExternal)
+        {
+            if(!bExternal) FreeSampleBuffer(data);
+            data = 0;
+            capacity = 0;
+            cols = m.cols;
+            bExternal = false;
+        }
+        Reserve(m.rows, m.cols);
+        rows = m.rows;
+        if(rows) memcpy(data, m.data, (size_t)rows*cols*sizeof(float));
+    }
+    return *this;
+}
+
+void SampleMatrix::Clear()
+{
+    if(!bExternal) FreeSampleBuffer(data);
+    data = 0;
+    rows = capacity = 0;
+    bExternal = false;
+}
+
+// grows the buffer to hold at least rowCount rows of colCount dimensions
+// the existing rows are kept (and padded with zeros if the dimension grows)
+void SampleMatrix::Reserve(const int rowCount, const int colCount)
+{
+    if(!bExternal && colCount == cols && rowCount <= capacity) return;
+    int newCapacity = colCount == cols ? max(rowCount, capacity*2) : max(rowCount, capacity);
+    if(newCapacity < 16) newCapacity = 16;
+    float *newData = colCount ? AllocSampleBuffer((size_t)newCapacity*colCount) : 0;
+    if(rows && data && newData)
+    {
+        if(colCount == cols) memcpy(newData, data, (size_t)rows*cols*sizeof(float));
+        else
+        {
+            int common = min(cols, colCount);
+            FOR(i, rows)
+            {
+                memcpy(newData + (size_t)i*colCount, data + (size_t)i*cols, common*sizeof(float));
+                FOR(d, colCount-common) newData[(size_t)i*colCount + common + d] = 0.f;
+            }
+        }
+    }
+    if(!bExternal) FreeSampleBuffer(data);
+    data = newData;
+    capacity = newCapacity;
+    cols = colCount;
+    bExternal = false;
+}
+
+void SampleMatrix::Resize(const int rowCount, const int colCount)
+{
+    Reserve(rowCount, colCount);
+    if(rowCount > rows) memset(data + (size_t)rows*cols, 0, (size_t)(rowCount-rows)*cols*sizeof(float));
+    rows = rowCount;
+}
+
+void SampleMatrix::SetCols(const int colCount)
+{
+    if(colCount == cols) return;
+    Reserve(rows, colCount);
+}
+
+void SampleMatrix::AddRow(const float *sample, const int dim)
+{
+    if(!rows && !capacity) cols = dim;
+    if(dim > cols) SetCols(dim);
+    Reserve(rows+1, cols);
+    float *row = data + (size_t)rows*cols;
+    memcpy(row, sample, min(dim, cols)*sizeof(float));
+    for(int d=dim; d<cols; d++) row[d] = 0.f;
+    rows++;
+}
+
+void SampleMatrix::AddRow(const fvec &sample)
+{
+    if(!sample.size()) return;
+    AddRow(&sample[0], sample.size());
+}
+
+void SampleMatrix::AddRows(const std::vector<fvec> &samples)
+{
+    int dim = 0;
+    FOR(i, samples.size()) dim = max(dim, (int)samples[i].size());
+    if(!dim) return;
+    if(!rows && !capacity) cols = dim;
+    if(dim > cols) SetCols(dim);
+    Reserve(rows + samples.size(), cols);
+    FOR(i, samples.size())
+    {
+        if(!samples[i].size()) continue;
+        AddRow(&samples[i][0], samples[i].size());
+    }
+}
+
+void SampleMatrix::SetRow(const int i, const fvec &sample)
+{
+    if(i < 0 || i >= rows) return;
+    Detach();
+    if((int)sample.size() > cols) SetCols(sample.size());
+    float *row = data + (size_t)i*cols;
+    int dim = min((int)sample.size(), cols);
+    if(dim) memcpy(row, &sample[0], dim*sizeof(float));
+    for(int d=dim; d<cols; d++) row[d] = 0.f;
+}
+
+void SampleMatrix::SetRows(const std::vector<fvec> &samples)
+{
+    rows = 0;
+    int dim = 0;
+    FOR(i, samples.size()) dim = max(dim, (int)samples[i].size());
+    if(dim != cols || bExternal)
+    {
+        if(!bExternal) FreeSampleBuffer(data);
+        data = 0;
+        capacity = 0;
+        cols = dim;
+        bExternal = false;
+    }
+    AddRows(samples);
+}
+
+void SampleMatrix::RemoveRow(const int i)
+{
+    if(i < 0 || i >= rows) return;
+    Detach();
+    if(i < rows-1) memmove(data + (size_t)i*cols, data + (size_t)(i+1)*cols, (size_t)(rows-i-1)*cols*sizeof(float));
+    rows--;
+}
+
+// keeps only the rows flagged in keep, in a single pass over the buffer
+void SampleMatrix::Compact(const bvec &keep)
+{
+    Detach();
+    int count = 0;
+    for(int i=0; i<rows; )
+    {
+        // we move whole runs of consecutive rows at once
+        if(i < keep.size() && !keep[i])
+        {
+            i++;
+            continue;
+        }
+        int start = i;
+        while(i < rows && (i >= keep.size() || keep[i])) i++;
+        if(start != count) memmove(data + (size_t)count*cols, data + (size_t)start*cols, (size_t)(i-start)*cols*sizeof(float));
+        count += i-start;
+    }
+    rows = count;
+}
+
+void SampleMatrix::SetExternal(const float *data, const int rows, const int cols)
+{
+    Clear();
+    this->data = (float *)data;
+    this->rows = rows;
+    this->cols = cols;
+    capacity = rows;
+    bExternal = true;
+}
+
+void SampleMatrix::CopyExternal()
+{
+    size_t count = (size_t)rows*cols;
+    float *newData = count ? AllocSampleBuffer(count) : 0;
+    if(newData) memcpy(newData, data, count*sizeof(float));
+    data = newData;
+    capacity = rows;
+    bExternal = false;
+}
+
+fvec SampleMatrix::Row(const int i) const
+{
+    if(i < 0 || i >= rows) return fvec();
+    const float *row = data + (size_t)i*cols;
+    return fvec(row, row + cols);
+}
+
+std::vector<fvec> SampleMatrix::ToVector() const
+{
+    vector<fvec> samples(rows);
+    FOR(i, rows)
+    {
+        const float *row = data + (size_t)i*cols;
+        samples[i].assign(row, row + cols);
+    }
+    return samples;
+}
@@ -0,0 +1,114 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#ifndef _SAMPLE_MATRIX_H_
+#define _SAMPLE_MATRIX_H_
+
+#include <vector>
+#include <string.h>
+#include "types.h"
+
+// alignment (in bytes) of the sample buffers, one cache line
+#define SAMPLE_ALIGNMENT 64
+
+float *AllocSampleBuffer(const size_t count);
+void FreeSampleBuffer(float *buffer);
+
+// non-owning view over a block of row-major samples
+// columns (if not empty) remaps the dimensions of each row: (i,d) -> data[i*stride + columns[d]]
+struct SampleView
+{
+    const float *data;
+    int rows;
+    int stride;
+    ivec columns;
+
+    SampleView() : data(0), rows(0), stride(0) {}
+    SampleView(const float *data, const int rows, const int stride, const ivec columns=ivec())
+        : data(data), rows(rows), stride(stride), columns(columns) {}
+
+    int Rows() const {return rows;}
+    int Cols() const {return columns.size() ? columns.size() : stride;}
+    bool Empty() const {return !data || !rows;}
+    bool Contiguous() const {return !columns.size();}
+    const float *RowData(const int i) const {return data + (size_t)i*stride;}
+    float operator()(const int i, const int d) const {return columns.size() ? data[(size_t)i*stride + columns[d]] : data[(size_t)i*stride + d];}
+
+    void CopyRow(const int i, float *dst) const;
+    fvec Row(const int i) const;
+    std::vector<fvec> ToVector() const;
+    std::vector<fvec> ToVector(const ivec &indices) const;
+    void CopyTo(float *dst) const;
+};
+
+// flat, cache-aligned row-major float matrix
+class SampleMatrix
+{
+    float *data;
+    int rows, cols, capacity;
+    bool bExternal; // data points to memory we do not own (e.g. a mapped file)
+
+    void Reserve(const int rowCount, const int colCount);
+    void CopyExternal();
+
+public:
+    SampleMatrix(const int cols=0);
+    SampleMatrix(const SampleMatrix &m);
+    SampleMatrix(const std::vector<fvec> &samples);
+    ~SampleMatrix();
+    SampleMatrix& operator= (const SampleMatrix &m);
+
+    int Rows() const {return rows;}
+    int Cols() const {return cols;}
+    int size() const {return rows;}
+    bool Empty() const {return !rows;}
+
+    void Clear();
+    void Reserve(const int rowCount) {Reserve(rowCount, cols);}
+    void Resize(const int rowCount, const int colCount);
+    void SetCols(const int colCount);
+
+    void AddRow(const fvec &sample);
+    void AddRow(const float *sample, const int dim);
+    void AddRows(const std::vector<fvec> &samples);
+    void SetRow(const int i, const fvec &sample);
+    void SetRows(const std::vector<fvec> &samples);
+    void RemoveRow(const int i);
+    void Compact(const bvec &keep);
+
+    // uses an external read-only block as storage, it is copied on the first modification
+    void SetExternal(const float *data, const int rows, const int cols);
+    bool IsExternal() const {return bExternal;}
+    // copies an external block into a buffer of our own, of exactly its size
+    void Detach() {if(bExternal) CopyExternal();}
+
+    float *Data() {Detach(); return data;}
+    const float *Data() const {return data;}
+    float *RowData(const int i) {Detach(); return data + (size_t)i*cols;}
+    const float *RowData(const int i) const {return data + (size_t)i*cols;}
+    float &operator()(const int i, const int d) {Detach(); return data[(size_t)i*cols + d];}
+    float operator()(const int i, const int d) const {return data[(size_t)i*cols + d];}
+
+    fvec Row(const int i) const;
+    std::vector<fvec> ToVector() const;
+
+    SampleView View() const {return SampleView(data, rows, cols);}
+    SampleView View(const ivec &columns) const {return SampleView(data, rows, cols, columns);}
+};
+
+#endif // _SAMPLE_MATRIX_H_
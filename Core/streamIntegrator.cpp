@@ -0,0 +1,174 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#include "streamIntegrator.h"
+#include "parallel.h"
+#include <math.h>
+
+using namespace std;
+
+// smallest block of particles worth a thread of its own
+const int streamRowsPerThread = 256;
+
+StreamIntegrator::StreamIntegrator(Dynamical *dynamical, const int method)
+    : dynamical(dynamical), method(method), dT(dynamical ? dynamical->dT : 0.02f),
+      tolerance(1e-3f), stopSpeed(1e-4f), threads(0)
+{}
+
+void StreamIntegrator::Velocities(const SampleView &positions, fvec &velocities)
+{
+    int rows = positions.Rows(), dim = positions.Cols();
+    velocities.resize((size_t)rows*dim);
+    if(!dynamical || !rows || !dim) return;
+    // the obstacles were handed to the avoidance by Step, every stage only modulates the velocities
+    ObstacleAvoidance *avoid = dynamical->avoid;
+    int threadCount = 1;
+    if(dynamical->IsThreadSafe() && (!avoid || avoid->IsThreadSafe())) threadCount = min(threads > 0 ? threads : ThreadCount(), rows / streamRowsPerThread);
+    if(threadCount <= 1)
+    {
+        dynamical->TestBatch(positions, velocities);
+        if(avoid) avoid->AvoidBatch(positions, velocities);
+        return;
+    }
+    ParallelRanges(rows, [&](int start, int stop)
+    {
+        SampleView block(positions.RowData(start), stop-start, positions.stride, positions.columns);
+        fvec blockVelocities;
+        dynamical->TestBatch(block, blockVelocities);
+        if(avoid) avoid->AvoidBatch(block, blockVelocities);
+        memcpy(&velocities[(size_t)start*dim], &blockVelocities[0], (size_t)(stop-start)*dim*sizeof(float));
+    }, threadCount);
+}
+
+int StreamIntegrator::Step(SampleMatrix &positions, bvec &active)
+{
+    int count = positions.Rows(), dim = positions.Cols();
+    if((int)active.size() != count) active.resize(count, true);
+    if(method == STREAM_ADAPTIVE && (int)steps.size() != count) steps.assign(count, dT);
+
+    // the particles still moving are packed together
+    ivec rows;
+    FOR(i, count) if(active[i]) rows.push_back(i);
+    int n = rows.size();
+    if(!n || !dim) return 0;
+    if(dynamical && dynamical->avoid) dynamical->avoid->SetObstacles(obstacles);
+    SampleMatrix y;
+    y.Resize(n, dim);
+    float *p = y.Data();
+    FOR(i, n) memcpy(p + (size_t)i*dim, positions.RowData(rows[i]), dim*sizeof(float));
+
+    // the ones that barely move have reached an attractor and are dropped before the other stages
+    fvec k1, k2, k3, k4;
+    Velocities(y.View(), k1);
+    int moving = 0;
+    FOR(i, n)
+    {
+        float speed = 0;
+        FOR(d, dim) speed += k1[i*dim + d]*k1[i*dim + d];
+        if(sqrtf(speed) < stopSpeed)
+        {
+            active[rows[i]] = false;
+            continue;
+        }
+        if(moving != i)
+        {
+            rows[moving] = rows[i];
+            memcpy(p + (size_t)moving*dim, p + (size_t)i*dim, dim*sizeof(float));
+            memcpy(&k1[(size_t)moving*dim], &k1[(size_t)i*dim], dim*sizeof(float));
+        }
+        moving++;
+    }
+    n = moving;
+    if(!n) return 0;
+    k1.resize((size_t)n*dim);
+
+    fvec h(n, dT);
+    if(method == STREAM_ADAPTIVE) FOR(i, n) h[i] = steps[rows[i]];
+
+    // positions of the next stage: y + a*h*k
+    SampleMatrix stage;
+    stage.Resize(n, dim);
+    float *s = stage.Data();
+    auto offset = [&](const fvec &k, const float a) -> SampleView
+    {
+        FOR(i, n) FOR(d, dim) s[i*dim + d] = p[i*dim + d] + a*h[i]*k[i*dim + d];
+        return SampleView(s, n, dim);
+    };
+
+    if(method == STREAM_EULER)
+    {
+        FOR(i, n) FOR(d, dim) p[i*dim + d] += h[i]*k1[i*dim + d];
+    }
+    else if(method == STREAM_RK4)
+    {
+        Velocities(offset(k1, 0.5f), k2);
+        Velocities(offset(k2, 0.5f), k3);
+        Velocities(offset(k3, 1.f), k4);
+        FOR(i, n) FOR(d, dim)
+        {
+            int j = i*dim + d;
+            p[j] += h[i]/6.f*(k1[j] + 2*k2[j] + 2*k3[j] + k4[j]);
+        }
+    }
+    else
+    {
+        // Bogacki-Shampine 3(2): the second order solution gives the local error of the third order one
+        // a step is accepted when its error is below tolerance, and the step of each particle is adjusted to match it
+        Velocities(offset(k1, 0.5f), k2);
+        Velocities(offset(k2, 0.75f), k3);
+        FOR(i, n) FOR(d, dim)
+        {
+            int j = i*dim + d;
+            s[j] = p[j] + h[i]*(2.f/9.f*k1[j] + 1.f/3.f*k2[j] + 4.f/9.f*k3[j]);
+        }
+        Velocities(SampleView(s, n, dim), k4);
+        float minStep = dT / 64, maxStep = dT * 16;
+        FOR(i, n)
+        {
+            float error = 0;
+            FOR(d, dim)
+            {
+                int j = i*dim + d;
+                error = max(error, fabsf(h[i]*(-5.f/72.f*k1[j] + 1.f/12.f*k2[j] + 1.f/9.f*k3[j] - 1.f/8.f*k4[j])));
+            }
+            float factor = error > 0 ? 0.9f*powf(tolerance/error, 1.f/3.f) : 5.f;
+            factor = max(0.2f, min(5.f, factor));
+            if(error <= tolerance || h[i] <= minStep) memcpy(p + (size_t)i*dim, s + (size_t)i*dim, dim*sizeof(float));
+            steps[rows[i]] = max(minStep, min(maxStep, h[i]*factor));
+        }
+    }
+
+    FOR(i, n) memcpy(positions.RowData(rows[i]), p + (size_t)i*dim, dim*sizeof(float));
+    return n;
+}
+
+vector< vector<fvec> > StreamIntegrator::Integrate(const vector<fvec> &starts, const int count)
+{
+    vector< vector<fvec> > trajectories(starts.size());
+    if(!starts.size() || count <= 0) return trajectories;
+    Reset();
+    SampleMatrix positions(starts);
+    bvec active(starts.size(), true);
+    FOR(i, starts.size()) trajectories[i].push_back(starts[i]);
+    for(int j=1; j<count; j++)
+    {
+        if(!Step(positions, active)) break;
+        FOR(i, starts.size()) if(active[i]) trajectories[i].push_back(positions.Row(i));
+    }
+    return trajectories;
+}
@@ -0,0 +1,63 @@
+/*********************************************************************
+MLDemos: A User-Friendly visualization toolkit for machine learning
+Copyright (C) 2010  Basilio Noris
+Contact: mldemos@b4silio.com
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License,
+version 3 as published by the Free Software Foundation.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free
+Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*********************************************************************/
+#ifndef _STREAM_INTEGRATOR_H_
+#define _STREAM_INTEGRATOR_H_
+
+#include <vector>
+#include "dynamical.h"
+#include "sampleMatrix.h"
+
+enum {STREAM_EULER, STREAM_RK4, STREAM_ADAPTIVE};
+
+// integrates the trajectories of many particles through the velocity field of a dynamical model
+// the particles move in lock-step: every stage of the scheme is one batched velocity evaluation
+// for all the particles still moving, spread over several threads when the model allows it
+// particles slower than stopSpeed have reached an attractor and are left where they are
+// the caller is responsible for locking the model while the integrator runs
+class StreamIntegrator
+{
+    Dynamical *dynamical;
+    std::vector<Obstacle> obstacles;
+    fvec steps; // current time step of each particle (adaptive)
+
+public:
+    int method;
+    float dT; // time step, or initial time step of the adaptive scheme
+    float tolerance; // largest local error of an adaptive step, in model units
+    float stopSpeed;
+    int threads; // 0 uses every core
+
+    StreamIntegrator(Dynamical *dynamical, const int method=STREAM_RK4);
+
+    void SetObstacles(const std::vector<Obstacle> &obstacles) {this->obstacles = obstacles;}
+    void Reset() {steps.clear();}
+
+    // velocity at every row of positions, including obstacle avoidance when the model has one
+    // the obstacles are handed to the avoidance once per Step rather than at every stage
+    void Velocities(const SampleView &positions, fvec &velocities);
+
+    // advances every active particle (row of positions) by one step and deactivates the ones that stopped
+    // returns the number of particles still active
+    int Step(SampleMatrix &positions, bvec &active);
+
+    // trajectories of up to count points from each start, a trajectory ends early when its particle stops
+    std::vector< std::vector<fvec> > Integrate(const std::vector<fvec> &starts, const int count);
+};
+
+#endif // _STREAM_INTEGRATOR_H_
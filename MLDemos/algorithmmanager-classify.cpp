@@ -19,6 +19,7 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 *********************************************************************/
 #include "algorithmmanager.h"
 #include "mldemos.h"
+#include "densitySplat.h"
 
 using namespace std;
 
@@ -78,11 +79,13 @@ void AlgorithmManager::Classify()
         if(canvas->canvasType) emit CanvasOptionsChanged();
         // we fill in the canvas sampleColors
         ivec inputDims = GetInputDimensions();
-        vector<fvec> samples = canvas->data->GetSampleDims(inputDims);
-        canvas->sampleColors.resize(samples.size());
-        FOR(i, samples.size())
+        SampleView samples = canvas->data->GetSampleDimsView(inputDims);
+        canvas->sampleColors.resize(samples.Rows());
+        fvec scores;
+        int outputs = Classifier::TestBatch(classifier, classifierMulti, samples, scores);
+        FOR(i, samples.Rows())
         {
-            canvas->sampleColors[i] = DrawTimer::GetColor(classifier, samples[i], &classifierMulti, inputDims);
+            canvas->sampleColors[i] = outputs ? DrawTimer::GetColor(classifier, &scores[(size_t)i*outputs], outputs) : QColor(0,0,0);
         }
         if(canvas->canvasType)
         {
@@ -120,47 +123,56 @@ void AlgorithmManager::DrawClassifiedSamples(Canvas *canvas, Classifier *classif
 
     // we draw the samples
     painter.setRenderHint(QPainter::Antialiasing, true);
-    FOR(i, canvas->data->GetCount()) {
-        fvec sample = sourceDims.size() ? canvas->data->GetSampleDim(i, sourceDims) : canvas->data->GetSample(i);
+    SampleView sampleView = canvas->data->GetSampleDimsView(sourceDims);
+    fvec scores;
+    int outputs = Classifier::TestBatch(classifier, classifierMulti, sampleView, scores);
+    if(!outputs) return;
+
+    // the samples the classifier got right are drawn as dots, the others as crosses
+    int count = canvas->data->GetCount();
+    int negativeLabel = classifier->inverseMap[-1];
+    ivec colors(count, 0);
+    bvec correct(count, true);
+    FOR(i, count) {
         int label = canvas->data->GetLabel(i);
-        QPointF point = canvas->toCanvasCoords(canvas->data->GetSample(i));
-        fvec res;
-        if(classifier->IsMultiClass()) {
-            res = classifier->TestMulti(sample);
-        }
-        else if(classifierMulti.size()) {
-            FOR(c, classifierMulti.size()) {
-                res.push_back(classifierMulti[c]->Test(sample));
-            }
-        }
-        else res.push_back(classifier->Test(sample));
-        if(res.size()==1) {
+        const float *res = &scores[(size_t)i*outputs];
+        if(outputs==1) {
             float response = res[0];
             if(forcedPositive != -1) {// we forced binary classification
-                if(response > 0) {
-                    if(label == forcedPositive) Canvas::drawSample(painter, point, 9, 1);
-                    else Canvas::drawCross(painter, point, 6, 2);
-                } else {
-                    if(label != forcedPositive) Canvas::drawSample(painter, point, 9, 0);
-                    else Canvas::drawCross(painter, point, 6, 0);
-                }
+                if(response > 0) correct[i] = label == forcedPositive;
+                else correct[i] = label != forcedPositive;
             } else {
-                if(response > 0) {
-                    if(label != classifier->inverseMap[-1]) Canvas::drawSample(painter, point, 9, 1);
-                    else Canvas::drawCross(painter, point, 6, 2);
-                } else {
-                    if(label == classifier->inverseMap[-1]) Canvas::drawSample(painter, point, 9, 0);
-                    else Canvas::drawCross(painter, point, 6, 0);
-                }
+                if(response > 0) correct[i] = label != negativeLabel;
+                else correct[i] = label == negativeLabel;
             }
+            colors[i] = response > 0 ? (correct[i] ? 1 : 2) : 0;
         } else {
             int max = 0;
-            for(int i=1; i<(int)res.size(); i++) if(res[max] < res[i]) max = i;
+            for(int i=1; i<outputs; i++) if(res[max] < res[i]) max = i;
             int resp = classifier->inverseMap[max];
-            if(label == resp) Canvas::drawSample(painter, point, 9, label);
-            else Canvas::drawCross(painter, point, 6, label);
+            correct[i] = label == resp;
+            colors[i] = label;
+        }
+    }
+
+    // too many samples on the canvas become a density map, with the misclassified ones in a darker shade
+    if(count > sampleGlyphLimit) {
+        std::vector<QRgb> palette = Canvas::SamplePalette();
+        int slotCount = palette.size();
+        FOR(i, slotCount) palette.push_back(QColor(palette[i]).darker(250).rgb());
+        ivec slots(count);
+        FOR(i, count) slots[i] = Canvas::SampleSlot(colors[i]) + (correct[i] ? 0 : slotCount);
+        QImage density = canvas->SampleDensity(slots, palette);
+        if(!density.isNull()) {
+            painter.drawImage(0, 0, density);
+            return;
         }
     }
+    FOR(i, count) {
+        QPointF point = canvas->toCanvasCoords(canvas->data->GetSample(i));
+        if(correct[i]) Canvas::drawSample(painter, point, 9, colors[i]);
+        else Canvas::drawCross(painter, point, 6, colors[i]);
+    }
 }
 
 bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trainList, int positiveIndex, std::vector<fvec> samples, ivec labels)
@@ -168,11 +180,44 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
     if(!classifier) return false;
     if(!labels.size()) labels = canvas->data->GetLabels();
     ivec inputDims = GetInputDimensions();
-    if(!samples.size()) samples = canvas->data->GetSampleDims(inputDims);
-    else samples = canvas->data->GetSampleDims(samples, inputDims);
+    // we read the samples through a view on the dataset store instead of copying the whole dataset
+    SampleMatrix sampleBuffer;
+    SampleView sampleView;
+    if(!samples.size()) sampleView = canvas->data->GetSampleDimsView(inputDims);
+    else
+    {
+        sampleBuffer.SetRows(samples);
+        sampleView = sampleBuffer.View(DatasetManager::GetDimsColumns(inputDims));
+    }
     sourceDims = inputDims;
     canvas->sourceDims = inputDims;
 
+    // binary classifiers learn multiclass problems with one model per class (one-vs-all)
+    int classCount = DatasetManager::GetClassCount(labels);
+    if(!classifier->IsMultiClass() && positiveIndex == -1 && classCount > 2)
+    {
+        classifierMulti.push_back(classifier);
+        for(int c=1; c<classCount; c++) classifierMulti.push_back(classifiers[tabUsedForTraining]->GetClassifier());
+    }
+    if(!TrainClassifier(classifier, classifierMulti, sampleView, labels, trainRatio, trainList, positiveIndex, &lastTrainingInfo)) return false;
+
+    emit Trained();
+    //bIsRocNew = true;
+    //bIsCrossNew = true;
+    //SetROCInfo();
+    return true;
+}
+
+// trains classifier on the rows of samples (already restricted to the input dimensions) and fills in its roc data
+// classifierMulti holds one model per class, classifier first, when a binary classifier goes one-vs-all
+// nothing but the arguments is touched, so that the comparisons can train several models at once
+bool AlgorithmManager::TrainClassifier(Classifier *classifier, std::vector<Classifier *> &classifierMulti, const SampleView &sampleView,
+                                       ivec labels, float trainRatio, const bvec &trainList, int positiveIndex, QString *info,
+                                       GramCache *gram)
+{
+    if(!classifier) return false;
+    int sampleCount = sampleView.Rows();
+
     ivec newLabels;
     std::map<int,int> binaryClassMap, binaryInverseMap;
     int classCount = DatasetManager::GetClassCount(labels);
@@ -214,11 +259,14 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
         newLabels = labels;
         if(binaryClassMap.size() > 2) binaryClassMap.clear(); // standard multiclass, no problems
     }
+    // a binary classifier going one-vs-all needs all of its models
+    if(!classifier->IsMultiClass() && bMulticlass && (int)classifierMulti.size() < classCount) return false;
     classifier->rocdata.clear();
     classifier->roclabels.clear();
 
     vector<fvec> trainSamples, testSamples;
     ivec trainLabels, testLabels;
+    ivec trainRows, testRows; // where the samples are in sampleView, for the kernel matrices of gram
     u32 *perm = 0;
     int trainCnt, testCnt;
     if(trainList.size())
@@ -227,13 +275,15 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
         {
             if(trainList[i])
             {
-                trainSamples.push_back(samples[i]);
+                trainSamples.push_back(sampleView.Row(i));
                 trainLabels.push_back(newLabels[i]);
+                trainRows.push_back(i);
             }
             else
             {
-                testSamples.push_back(samples[i]);
+                testSamples.push_back(sampleView.Row(i));
                 testLabels.push_back(newLabels[i]);
+                testRows.push_back(i);
             }
         }
         //trainCnt = trainSamples.size();
@@ -247,22 +297,24 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
             classCnt[newLabels[i]]++;
         }
 
-        trainCnt = (int)(samples.size()*trainRatio);
-        testCnt = samples.size() - trainCnt;
+        trainCnt = (int)(sampleCount*trainRatio);
+        testCnt = sampleCount - trainCnt;
         trainSamples.resize(trainCnt);
         trainLabels.resize(trainCnt);
         testSamples.resize(testCnt);
         testLabels.resize(testCnt);
-        perm = randPerm(samples.size());
+        perm = randPerm(sampleCount);
+        trainRows.assign(perm, perm + trainCnt);
+        testRows.assign(perm + trainCnt, perm + sampleCount);
         FOR(i, trainCnt)
         {
-            trainSamples[i] = samples[perm[i]];
+            trainSamples[i] = sampleView.Row(perm[i]);
             trainLabels[i] = newLabels[perm[i]];
             trainClassCnt[trainLabels[i]]++;
         }
-        for(int i=trainCnt; i<samples.size(); i++)
+        for(int i=trainCnt; i<sampleCount; i++)
         {
-            testSamples[i-trainCnt] = samples[perm[i]];
+            testSamples[i-trainCnt] = sampleView.Row(perm[i]);
             testLabels[i-trainCnt] = newLabels[perm[i]];
             testClassCnt[testLabels[i-trainCnt]]++;
         }
@@ -276,8 +328,10 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
                     if(testLabels[i] != it->first) continue;
                     trainSamples.push_back(testSamples[i]);
                     trainLabels.push_back(testLabels[i]);
+                    trainRows.push_back(testRows[i]);
                     testSamples.erase(testSamples.begin() + i);
                     testLabels.erase(testLabels.begin() + i);
+                    testRows.erase(testRows.begin() + i);
                     trainCnt++;
                     testCnt--;
                     break;
@@ -287,9 +341,12 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
     }
 
     // do the actual training
+    GramScope scope(gram, trainRows);
     if(classifier->IsMultiClass() || !bMulticlass)
     {
+        classifier->gramScope = &scope;
         classifier->Train(trainSamples, trainLabels);
+        classifier->gramScope = 0;
         // fix the labels for binary classification
         if(classCount == 2)
         {
@@ -321,16 +378,16 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
                 if(trainLabels[i] == realClass) trainLabelsBinary[i] = +1;
                 else trainLabelsBinary[i] = -1;
             }
-            if(c==0) classifierMulti.push_back(classifier);
-            else classifierMulti.push_back(classifiers[tabUsedForTraining]->GetClassifier());
-            classifierMulti.back()->Train(trainSamples, trainLabelsBinary);
+            classifierMulti[c]->gramScope = &scope;
+            classifierMulti[c]->Train(trainSamples, trainLabelsBinary);
+            classifierMulti[c]->gramScope = 0;
         }
         classifier->classMap = binaryClassMap;
         classifier->inverseMap = binaryInverseMap;
     }
 
     // compute test results
-    lastTrainingInfo = "";
+    QString trainingInfo;
     map<int, int> truePerClass;
     map<int, int> falsePerClass;
     map<int, int> countPerClass;
@@ -339,13 +396,15 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
     // we generate the roc curve for this guy
     bool bTrueMulti = bMulticlass;
     vector<f32pair> rocData;
+    fvec scores;
+    int outputs = trainSamples.size() ? Classifier::TestBatch(classifier, classifierMulti, SampleMatrix(trainSamples).View(), scores) : 0;
     FOR(i, trainSamples.size())
     {
         int label = trainLabels[i];
         if(bMulticlass && binaryClassMap.size()) label = binaryClassMap[label];
         if(classifier->IsMultiClass())
         {
-            fvec res = classifier->TestMulti(trainSamples[i]);
+            fvec res(&scores[(size_t)i*outputs], &scores[(size_t)i*outputs] + outputs);
             if(res.size() == 1)
             {
                 rocData.push_back(f32pair(res[0], label));
@@ -380,7 +439,7 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
                 float maxResp = -FLT_MAX;
                 FOR(c, classifierMulti.size())
                 {
-                    float res = classifierMulti[c]->Test(trainSamples[i]);
+                    float res = scores[(size_t)i*outputs + c];
                     if(res > maxResp)
                     {
                         maxResp = res;
@@ -395,7 +454,7 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
             }
             else
             {
-                float resp = classifier->Test(trainSamples[i]);
+                float resp = scores[i];
                 rocData.push_back(f32pair(resp, label));
                 if(resp > 0 && label == 1) truePerClass[1]++;
                 else if(resp > 0 && label != 1) falsePerClass[0]++;
@@ -409,7 +468,7 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
     if(!bTrueMulti) rocData = FixRocData(rocData);
     classifier->rocdata.push_back(rocData);
     classifier->roclabels.push_back("training");
-    lastTrainingInfo += QString("\nTraining Set (%1 samples):\n").arg(trainSamples.size());
+    trainingInfo += QString("\nTraining Set (%1 samples):\n").arg(trainSamples.size());
     int posClass = 1;
     if(bTrueMulti)
     {
@@ -430,13 +489,13 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
             float recall = tp / float(count);
             macroFMeasure += 2*precision*recall/(precision+recall);
             float ratio = it->second != 0 ? tp / (float)it->second : 0;
-            lastTrainingInfo += QString("Class %1 (%5 samples): %2 correct (%4%)\n%3 incorrect\n").arg(c).arg(tp).arg(fp).arg((int)(ratio*100)).arg(it->second);
+            trainingInfo += QString("Class %1 (%5 samples): %2 correct (%4%)\n%3 incorrect\n").arg(c).arg(tp).arg(fp).arg((int)(ratio*100)).arg(it->second);
         }
         macroFMeasure /= countPerClass.size();
         microPrecision = microTP / float(microTP + microFP);
         microRecall = microTP / float(microCount);
         microFMeasure = 2*microPrecision*microRecall/(microPrecision + microRecall);
-        lastTrainingInfo += QString("F-Measure: %1 (micro) \t %2 (macro)\n").arg(microFMeasure, 0, 'f', 3).arg(macroFMeasure, 0, 'f', 3);
+        trainingInfo += QString("F-Measure: %1 (micro) \t %2 (macro)\n").arg(microFMeasure, 0, 'f', 3).arg(macroFMeasure, 0, 'f', 3);
     }
     else
     {
@@ -448,25 +507,26 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
         int fp = posClass ? falsePerClass[1] : truePerClass[1];
         int count = countPerClass[1];
         float ratio = count != 0 ? tp/(float)count : 1;
-        lastTrainingInfo += QString("Positive (%4 samples): %1 correct (%3%)\n%2 incorrect\n").arg(tp).arg(fp).arg((int)(ratio*100)).arg(count);
+        trainingInfo += QString("Positive (%4 samples): %1 correct (%3%)\n%2 incorrect\n").arg(tp).arg(fp).arg((int)(ratio*100)).arg(count);
         tp = posClass ? truePerClass[0] : falsePerClass[0];
         fp = posClass ? falsePerClass[0] : truePerClass[0];
         count = countPerClass[0];
         ratio = count != 0 ? tp/(float)count : 1;
-        lastTrainingInfo += QString("Negative (%4 samples): %1 correct (%3%)\n%2 incorrect\n").arg(tp).arg(fp).arg((int)(ratio*100)).arg(count);
+        trainingInfo += QString("Negative (%4 samples): %1 correct (%3%)\n%2 incorrect\n").arg(tp).arg(fp).arg((int)(ratio*100)).arg(count);
     }
 
     truePerClass.clear();
     falsePerClass.clear();
     countPerClass.clear();
     rocData.clear();
+    outputs = testSamples.size() ? Classifier::TestBatch(classifier, classifierMulti, SampleMatrix(testSamples).View(), scores) : 0;
     FOR(i, testSamples.size())
     {
         int label = testLabels[i];
         if(bMulticlass && binaryClassMap.size()) label = binaryClassMap[label];
         if(classifier->IsMultiClass())
         {
-            fvec res = classifier->TestMulti(testSamples[i]);
+            fvec res(&scores[(size_t)i*outputs], &scores[(size_t)i*outputs] + outputs);
             if(res.size() == 1)
             {
                 rocData.push_back(f32pair(res[0], label));
@@ -497,7 +557,7 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
                 float maxResp = -FLT_MAX;
                 FOR(c, classifierMulti.size())
                 {
-                    float res = classifierMulti[c]->Test(testSamples[i]);
+                    float res = scores[(size_t)i*outputs + c];
                     if(res > maxResp)
                     {
                         maxResp = res;
@@ -511,7 +571,7 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
                 else truePerClass[c]++;
             }            else
             {
-                float resp = classifier->Test(testSamples[i]);
+                float resp = scores[i];
                 rocData.push_back(f32pair(resp, label));
                 if(resp > 0 && label == 1) truePerClass[1]++;
                 else if(resp > 0 && label != 1) falsePerClass[0]++;
@@ -527,7 +587,7 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
     classifier->roclabels.push_back("test");
     classifier->confusionMatrix[0] = confusionMatrix[0];
     classifier->confusionMatrix[1] = confusionMatrix[1];
-    lastTrainingInfo += QString("\nTesting Set (%1 samples):\n").arg(testSamples.size());
+    trainingInfo += QString("\nTesting Set (%1 samples):\n").arg(testSamples.size());
     if(bTrueMulti)
     {
         float macroFMeasure = 0.f, microFMeasure = 0.f;
@@ -547,13 +607,13 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
             float recall = tp / float(count);
             macroFMeasure += 2*precision*recall/(precision+recall);
             float ratio = it->second != 0 ? tp / (float)it->second : 0;
-            lastTrainingInfo += QString("Class %1 (%5 samples): %2 correct (%4%)\n%3 incorrect\n").arg(c).arg(tp).arg(fp).arg((int)(ratio*100)).arg(it->second);
+            trainingInfo += QString("Class %1 (%5 samples): %2 correct (%4%)\n%3 incorrect\n").arg(c).arg(tp).arg(fp).arg((int)(ratio*100)).arg(it->second);
         }
         macroFMeasure /= countPerClass.size();
         microPrecision = microTP / float(microTP + microFP);
         microRecall = microTP / float(microCount);
         microFMeasure = 2*microPrecision*microRecall/(microPrecision + microRecall);
-        lastTrainingInfo += QString("F-Measure: %1 (micro) \t %2 (macro)\n").arg(microFMeasure, 0, 'f', 3).arg(macroFMeasure, 0, 'f', 3);
+        trainingInfo += QString("F-Measure: %1 (micro) \t %2 (macro)\n").arg(microFMeasure, 0, 'f', 3).arg(macroFMeasure, 0, 'f', 3);
     }
     else
     {
@@ -561,18 +621,14 @@ bool AlgorithmManager::Train(Classifier *classifier, float trainRatio, bvec trai
         int fp = posClass ? falsePerClass[1] : truePerClass[1];
         int count = countPerClass[1];
         float ratio = count != 0 ? tp/(float)count : 1;
-        lastTrainingInfo += QString("Positive (%4 samples): %1 correct (%3%)\n%2 incorrect\n").arg(tp).arg(fp).arg((int)(ratio*100)).arg(count);
+        trainingInfo += QString("Positive (%4 samples): %1 correct (%3%)\n%2 incorrect\n").arg(tp).arg(fp).arg((int)(ratio*100)).arg(count);
         tp = posClass ? truePerClass[0] : falsePerClass[0];
         fp = posClass ? falsePerClass[0] : truePerClass[0];
         count = countPerClass[0];
         ratio = count != 0 ? tp/(float)count : 1;
-        lastTrainingInfo += QString("Negative (%4 samples): %1 correct (%3%)\n%2 incorrect\n").arg(tp).arg(fp).arg((int)(ratio*100)).arg(count);
+        trainingInfo += QString("Negative (%4 samples): %1 correct (%3%)\n%2 incorrect\n").arg(tp).arg(fp).arg((int)(ratio*100)).arg(count);
     }
     KILL(perm);
-
-    emit Trained();
-    //bIsRocNew = true;
-    //bIsCrossNew = true;
-    //SetROCInfo();
+    if(info) *info = trainingInfo;
     return true;
 }
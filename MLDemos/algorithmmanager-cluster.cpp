@@ -134,9 +134,10 @@ void AlgorithmManager::Cluster()
     float f1ratios[] = {0.01f, 0.05f, 0.1f, 0.2f, 1.f/3.f, 0.5f, 0.75f, 1.f};
     float f1ratio = f1ratios[f1ratioIndex];
     vector<fvec> clusterScores(samples.size());
+    vector<fvec> results = clusterer->TestSamples(samples);
     FOR(i, samples.size())
     {
-        fvec result = clusterer->Test(samples[i]);
+        fvec &result = results[i];
         if(clusterer->NbClusters()==1) clusterScores[i] = result;
         else if(result.size()>1) clusterScores[i] = result;
         else if(result.size())
@@ -171,9 +172,10 @@ void AlgorithmManager::Cluster()
     // we fill in the canvas sampleColors for the alternative display types
     if(canvas->canvasType != 0) {
         canvas->sampleColors.resize(samples.size());
+        vector<fvec> results = clusterer->TestSamples(samples);
         FOR(i, samples.size())
         {
-            fvec res = clusterer->Test(samples[i]);
+            fvec &res = results[i];
             float r=0,g=0,b=0;
             if(res.size() > 1)
             {
@@ -265,9 +267,10 @@ void AlgorithmManager::ClusterTest()
 
     // we fill in the canvas sampleColors for the alternative display types
     canvas->sampleColors.resize(samples.size());
+    vector<fvec> results = clusterer->TestSamples(samples);
     FOR(i, samples.size())
     {
-        fvec res = clusterer->Test(samples[i]);
+        fvec &res = results[i];
         float r=0,g=0,b=0;
         if(res.size() > 1)
         {
@@ -370,9 +373,10 @@ void AlgorithmManager::ClusterOptimize()
             float AICc = AIC + 2*(k*k + k)/(n-k-1);
 
             vector<fvec> clusterScores(samples.size());
+            vector<fvec> results = clusterer->TestSamples(samples);
             FOR(i, samples.size())
             {
-                fvec result = clusterer->Test(samples[i]);
+                fvec &result = results[i];
                 if(clusterer->NbClusters()==1) clusterScores[i] = result;
                 else if(result.size()>1) clusterScores[i] = result;
                 else if(result.size())
@@ -523,9 +527,10 @@ void AlgorithmManager::ClusterIterate()
     ivec inputDims = GetInputDimensions();
     vector<fvec> samples = canvas->data->GetSampleDims(inputDims);
     canvas->sampleColors.resize(samples.size());
+    vector<fvec> results = clusterer->TestSamples(samples);
     FOR(i, samples.size())
     {
-        fvec res = clusterer->Test(samples[i]);
+        fvec &res = results[i];
         float r=0,g=0,b=0;
         if(res.size() > 1)
         {
@@ -585,6 +590,11 @@ void AlgorithmManager::Train(Clusterer *clusterer, float trainRatio, bvec trainL
         delete [] perm;
     }
     else clusterer->Train(samples);
+    // with an out-of-core dataset the canvas only holds a subset, which initializes the model before the passes on the whole file
+    if(canvas->data->IsStreaming() && !trainList.size())
+    {
+        canvas->data->GetStream()->Train(clusterer, DatasetManager::GetDimsColumns(inputDims));
+    }
     // we test the clusters to see how well they classify the samples
 
     if(!testFMeasures) return;
@@ -599,9 +609,10 @@ void AlgorithmManager::Train(Clusterer *clusterer, float trainRatio, bvec trainL
     map<int,float> labelScores;
 
     vector<fvec> scores(samples.size());
-    FOR(i, canvas->data->GetCount())
+    vector<fvec> results = clusterer->TestSamples(samples);
+    FOR(i, samples.size())
     {
-        fvec result = clusterer->Test(samples[i]);
+        fvec &result = results[i];
         if(clusterer->NbClusters()==1) scores[i] = result;
         else if(result.size()>1) scores[i] = result;
         else scores[i] = fvec(nbClusters,0);
@@ -19,24 +19,218 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 *********************************************************************/
 #include "algorithmmanager.h"
 #include "mldemos.h"
+#include "parallel.h"
 
 using namespace std;
+
+// measures computed for each kind of algorithm, in the order they are shown
+static QStringList compareMeasureNames(const QString &type)
+{
+    QStringList measures;
+    if(type == "Optimization") measures << "Evaluations" << "Reward" << "Iterations";
+    if(type == "Classification") measures << "F-Measure (Test)" << "Error (Test)" << "Precision (Test)" << "Recall (Test)"
+                                           << "F-Measure (Training)" << "Error (Training)" << "Precision (Training)" << "Recall (Training)";
+    if(type == "Regression") measures << "Error (Testing)" << "Error (Training)";
+    if(type == "Dynamical") measures << "Reconstruction Error" << "Target Error (trajectories)" << "Target Error (random points)";
+    return measures;
+}
+
+static int rocErrors(const std::vector<f32pair> &rocdata, const int labelCount)
+{
+    int errors = 0;
+    FOR(j, rocdata.size())
+    {
+        if(rocdata[j].first != rocdata[j].second)
+        {
+            if(labelCount > 2) errors++;
+            else if((rocdata[j].first < 0) != rocdata[j].second) errors++;
+        }
+    }
+    return errors;
+}
+
+static void evaluateClassifier(CompareJob &job, const CompareData &data)
+{
+    Classifier *classifier = job.classifier;
+    job.results.resize(8);
+    fvec &fmeasureTest = job.results[0], &errorTest = job.results[1], &precisionTest = job.results[2], &recallTest = job.results[3];
+    fvec &fmeasureTrain = job.results[4], &errorTrain = job.results[5], &precisionTrain = job.results[6], &recallTrain = job.results[7];
+    AlgorithmManager::TrainClassifier(classifier, job.classifierMulti, data.classSamples.View(data.classColumns),
+                                      data.classLabels, data.trainRatio, data.classTrainList, -1, 0, data.classGram);
+    bool bMulti = classifier->IsMultiClass() && data.labelCount > 2;
+    int classes = data.labelCount;
+    if(classifier->rocdata.size()>0)
+    {
+        const std::vector<f32pair> &rocdata = classifier->rocdata[0];
+        if(!bMulti || classes <= 2)
+        {
+            fvec res = GetBestFMeasure(rocdata);
+            fmeasureTrain.push_back(res[0]);
+            precisionTrain.push_back(res[1]);
+            recallTrain.push_back(res[2]);
+            errorTrain.push_back(rocErrors(rocdata, classes)/(float)rocdata.size());
+        }
+        else
+        {
+            int errors = rocErrors(rocdata, classes);
+            if(classes <= 2)
+            {
+                float e = min(errors,(int)rocdata.size()-errors)/(float)rocdata.size();
+                fmeasureTrain.push_back(1-e);
+            }
+            else
+            {
+                // compute the micro and macro f-measure
+                fpair fmeasure = GetMicroMacroFMeasure(rocdata);
+                fmeasureTrain.push_back(fmeasure.first);
+                errorTrain.push_back(errors/(float)rocdata.size());
+            }
+        }
+    }
+    if(classifier->rocdata.size()>1)
+    {
+        const std::vector<f32pair> &rocdata = classifier->rocdata[1];
+        if(!bMulti || classes <= 2)
+        {
+            fvec res = GetBestFMeasure(rocdata);
+            fmeasureTest.push_back(res[0]);
+            precisionTest.push_back(res[1]);
+            recallTest.push_back(res[2]);
+        }
+        else
+        {
+            int errors = rocErrors(rocdata, classes);
+            if(classes <= 2) fmeasureTest.push_back(min(errors,(int)rocdata.size()-errors)/(float)rocdata.size());
+            else
+            {
+                // compute the micro and macro f-measure
+                fpair fmeasure = GetMicroMacroFMeasure(rocdata);
+                fmeasureTest.push_back(fmeasure.first);
+                errorTest.push_back(errors/(float)rocdata.size());
+            }
+        }
+    }
+}
+
+static void evaluateRegressor(CompareJob &job, const CompareData &data)
+{
+    Regressor *regressor = job.regressor;
+    job.results.resize(2);
+    AlgorithmManager::TrainRegressor(regressor, data.regressSamples, data.regressLabels, data.trainRatio, data.regressTrainList,
+                                     false, data.regressGram);
+    if(regressor->testErrors.size())
+    {
+        float error = 0.f;
+        FOR(i, regressor->testErrors.size()) error += regressor->testErrors[i];
+        job.results[0].push_back(error / regressor->testErrors.size());
+    }
+    if(regressor->trainErrors.size())
+    {
+        float error = 0.f;
+        FOR(i, regressor->trainErrors.size()) error += regressor->trainErrors[i];
+        job.results[1].push_back(error / regressor->trainErrors.size());
+    }
+}
+
+static void evaluateDynamical(CompareJob &job, const CompareData &data)
+{
+    job.results.resize(3);
+    fvec results = AlgorithmManager::TrainDynamical(job.dynamical, data.trajectories, data.trajectoryLabels);
+    if(!results.size()) return;
+    FOR(m, 3) job.results[m].push_back(results[m]);
+}
+
+static void evaluateMaximizer(CompareJob &job, const CompareData &data)
+{
+    Maximizer *maximizer = job.maximizer;
+    job.results.resize(3);
+    maximizer->Train(data.rewardData, fVec(data.w,data.h), job.startingPoint);
+    maximizer->age = 0;
+    AlgorithmManager::Test(maximizer);
+    job.results[0].push_back(maximizer->Evaluations());
+    job.results[1].push_back(maximizer->MaximumValue());
+    job.results[2].push_back(maximizer->age);
+}
+
+static void deleteModels(CompareJob &job)
+{
+    if(!job.classifierMulti.size()) DEL(job.classifier);
+    job.classifier = 0;
+    FOR(c, job.classifierMulti.size()) DEL(job.classifierMulti[c]);
+    job.classifierMulti.clear();
+    DEL(job.regressor);
+    DEL(job.dynamical);
+    DEL(job.maximizer);
+}
+
+void CompareThread::Evaluate(const CompareData *data, vector<CompareJob> jobs)
+{
+    this->data = data;
+    this->jobs = jobs;
+    bCanceled = false;
+    start();
+}
+
+void CompareThread::run()
+{
+    // the dynamical systems and the maximizers draw from the process-wide drand48 generator and many models
+    // go through libraries with a global state (newmat, ANN), so their jobs are evaluated one after the other
+    // by the first task, every other job is a task of its own
+    ivec serial, tasks(1, -1);
+    FOR(i, jobs.size())
+    {
+        const CompareJob &job = jobs[i];
+        bool bUnsafe = (job.classifier && !job.classifier->IsTrainThreadSafe()) ||
+                (job.regressor && !job.regressor->IsTrainThreadSafe());
+        FOR(c, job.classifierMulti.size()) bUnsafe |= !job.classifierMulti[c]->IsTrainThreadSafe();
+        if(job.dynamical || job.maximizer || bUnsafe) serial.push_back(i);
+        else tasks.push_back(i);
+    }
+    auto evaluate = [&](int i)
+    {
+        CompareJob &job = jobs[i];
+        if(!bCanceled)
+        {
+            if(job.classifier) evaluateClassifier(job, *data);
+            else if(job.regressor) evaluateRegressor(job, *data);
+            else if(job.dynamical) evaluateDynamical(job, *data);
+            else if(job.maximizer) evaluateMaximizer(job, *data);
+        }
+        deleteModels(job);
+        if(!bCanceled) emit Evaluated(job.algorithm, job.fold);
+    };
+    ParallelFor(tasks.size(), [&](int t)
+    {
+        if(tasks[t] >= 0) evaluate(tasks[t]);
+        else FOR(i, serial.size()) evaluate(serial[i]);
+    });
+}
+
 void AlgorithmManager::Compare()
 {
     if(!canvas) return;
     if(!compare->compareOptions.size()) return;
+    // while a comparison is running, asking for another one cancels it
+    if(compareThread->isRunning())
+    {
+        compareThread->Cancel();
+        return;
+    }
+    if(compareData) return; // the last comparison is still being wrapped up
 
-    QMutexLocker lock(mutex);
-    drawTimer->Stop();
-    DEL(clusterer);
-    DEL(regressor);
-    DEL(dynamical);
-    if(!classifierMulti.size()) DEL(classifier);
-    classifier = 0;
-    sourceDims.clear();
-    FOR(i,classifierMulti.size()) DEL(classifierMulti[i]); classifierMulti.clear();
-    DEL(maximizer);
-    DEL(projector);
+    {
+        QMutexLocker lock(mutex);
+        drawTimer->Stop();
+        DEL(clusterer);
+        DEL(regressor);
+        DEL(dynamical);
+        if(!classifierMulti.size()) DEL(classifier);
+        classifier = 0;
+        sourceDims.clear();
+        FOR(i,classifierMulti.size()) DEL(classifierMulti[i]); classifierMulti.clear();
+        DEL(maximizer);
+        DEL(projector);
+    }
     // we start parsing the algorithm list
     int folds = compare->params->foldCountSpin->value();
     float ratios [] = {.1f,.25f,1.f/3.f,.5f,2.f/3.f,.75f,.9f,1.f};
@@ -91,301 +285,211 @@ void AlgorithmManager::Compare()
     }
 
     compare->Clear();
+    compareData = new CompareData();
+    CompareData &data = *compareData;
+    data.trainRatio = trainRatio;
+    compareNames.clear();
+    compareMeasures.clear();
 
-    QProgressDialog progress("Comparing Algorithms", "cancel", 0, folds*compare->compareOptions.size());
-    progress.show();
+    // the models of every fold are created here, as the interfaces read their widgets
+    // and the data they are trained on is gathered once for all of them
+    bool bClassData = false, bRegressData = false, bDynamicalData = false, bRewardData = false;
+    vector<CompareJob> jobs;
     FOR(i, compare->compareOptions.size())
     {
         QString string = compare->compareOptions[i];
         QTextStream stream(&string);
         QString line = stream.readLine();
         QString paramString = stream.readAll();
-        if(line.startsWith("Optimization"))
+        QStringList s = line.split(":");
+        QString type = s[0];
+        int tab = s.size() > 1 ? s[1].toInt() : -1;
+        if(tab < 0) continue;
+        int algorithm = compareNames.size();
+        QTextStream paramStream(&paramString);
+        QString paramName;
+        float paramValue;
+        if(type == "Optimization")
         {
-            QStringList s = line.split(":");
-            int tab = s[1].toInt();
             if(tab >= maximizers.size() || !maximizers[tab]) continue;
-            QTextStream paramStream(&paramString);
-            QString paramName;
-            float paramValue;
             while(!paramStream.atEnd())
             {
                 paramStream >> paramName;
                 paramStream >> paramValue;
                 maximizers[tab]->LoadParams(paramName, paramValue);
             }
-            QString algoName = maximizers[tab]->GetAlgoString();
-            fvec resultIt, resultVal, resultEval;
+            if(!bRewardData)
+            {
+                data.rewardData = GetRewardData(data.w, data.h);
+                bRewardData = true;
+            }
+            if(!data.rewardData) continue;
+            compareNames << maximizers[tab]->GetAlgoString();
             FOR(f, folds)
             {
-                maximizer = maximizers[tab]->GetMaximizer();
-                if(!maximizer) continue;
-                maximizer->maxAge = optionsMaximize->iterationsSpin->value();
-                maximizer->stopValue = optionsMaximize->stoppingSpin->value();
-                Train(maximizer);
-                Test(maximizer);
-                resultIt.push_back(maximizer->age);
-                resultVal.push_back(maximizer->MaximumValue());
-                resultEval.push_back(maximizer->Evaluations());
-                progress.setValue(f + i*folds);
-                DEL(maximizer);
-                qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-                if(progress.wasCanceled())
-                {
-                    compare->AddResults(resultEval, "Evaluations", algoName);
-                    compare->AddResults(resultVal, "Reward", algoName);
-                    compare->AddResults(resultIt, "Iterations", algoName);
-                    compare->Show();
-                    return;
-                }
+                CompareJob job(algorithm, f);
+                job.maximizer = maximizers[tab]->GetMaximizer();
+                if(!job.maximizer) continue;
+                job.maximizer->maxAge = optionsMaximize->iterationsSpin->value();
+                job.maximizer->stopValue = optionsMaximize->stoppingSpin->value();
+                job.startingPoint = GetStartingPoint(data.w, data.h);
+                jobs.push_back(job);
             }
-            compare->AddResults(resultEval, "Evaluations", algoName);
-            compare->AddResults(resultVal, "Reward", algoName);
-            compare->AddResults(resultIt, "Iterations", algoName);
         }
-        if(line.startsWith("Classification"))
+        else if(type == "Classification")
         {
-            QStringList s = line.split(":");
-            int tab = s[1].toInt();
             if(tab >= classifiers.size() || !classifiers[tab]) continue;
-            QTextStream paramStream(&paramString);
-            QString paramName;
-            float paramValue;
             while(!paramStream.atEnd())
             {
                 paramStream >> paramName;
                 paramStream >> paramValue;
                 classifiers[tab]->LoadParams(paramName, paramValue);
             }
-            QString algoName = classifiers[tab]->GetAlgoString();
-            fvec fmeasureTrain, fmeasureTest, errorTrain, errorTest, precisionTrain, precisionTest, recallTrain, recallTest;
-
-            map<int,int> classes;
-            FOR(j, canvas->data->GetLabels().size()) classes[canvas->data->GetLabels()[j]]++;
-
-            if (!samples.size() && optionsClassify->manualTrainButton->isChecked()) {
-                trainList = GetManualSelection();
+            if(!bClassData)
+            {
+                ivec inputDims = GetInputDimensions();
+                data.classColumns = DatasetManager::GetDimsColumns(inputDims);
+                if(!samples.size()) data.classSamples = canvas->data->GetSampleMatrix();
+                else data.classSamples.SetRows(samples);
+                data.classLabels = labels.size() ? labels : canvas->data->GetLabels();
+                data.classCount = DatasetManager::GetClassCount(data.classLabels);
+                map<int,int> classes;
+                ivec canvasLabels = canvas->data->GetLabels();
+                FOR(j, canvasLabels.size()) classes[canvasLabels[j]]++;
+                data.labelCount = classes.size();
+                data.classTrainList = trainList;
+                if (!samples.size() && optionsClassify->manualTrainButton->isChecked()) {
+                    data.classTrainList = GetManualSelection();
+                }
+                data.classGram = new GramCache(data.classSamples.View(data.classColumns), gramCacheBytes, 1);
+                bClassData = true;
             }
-
+            compareNames << classifiers[tab]->GetAlgoString();
             FOR(f, folds)
             {
-                classifier = classifiers[tab]->GetClassifier();
-                if(!classifier) continue;
-                Train(classifier, trainRatio, trainList, -1, samples, labels);
-                bool bMulti = classifier->IsMultiClass() && DatasetManager::GetClassCount(canvas->data->GetLabels()) > 2;
-                if(classifier->rocdata.size()>0)
-                {
-                    if(!bMulti || classes.size() <= 2)
-                    {
-                        fvec res = GetBestFMeasure(classifier->rocdata[0]);
-                        fmeasureTrain.push_back(res[0]);
-                        precisionTrain.push_back(res[1]);
-                        recallTrain.push_back(res[2]);
-                        int errors = 0;
-                        std::vector<f32pair> rocdata = classifier->rocdata[0];
-                        FOR(j, rocdata.size())
-                        {
-                            if(rocdata[j].first != rocdata[j].second)
-                            {
-                                if(classes.size() > 2) errors++;
-                                else if((rocdata[j].first < 0) != rocdata[j].second) errors++;
-                            }
-                        }
-                        errorTrain.push_back(errors/(float)rocdata.size());
-                    }
-                    else
-                    {
-                        int errors = 0;
-                        std::vector<f32pair> rocdata = classifier->rocdata[0];
-                        FOR(j, rocdata.size())
-                        {
-                            if(rocdata[j].first != rocdata[j].second)
-                            {
-                                if(classes.size() > 2) errors++;
-                                else if((rocdata[j].first < 0) != rocdata[j].second) errors++;
-                            }
-                        }
-                        if(classes.size() <= 2)
-                        {
-                            float e = min(errors,(int)rocdata.size()-errors)/(float)rocdata.size();
-                            fmeasureTrain.push_back(1-e);
-                        }
-                        else
-                        {
-                            // compute the micro and macro f-measure
-                            fpair fmeasure = GetMicroMacroFMeasure(rocdata);
-                            fmeasureTrain.push_back(fmeasure.first);
-                            errorTrain.push_back(errors/(float)rocdata.size());
-                        }
-                    }
-                }
-                if(classifier->rocdata.size()>1)
-                {
-                    if(!bMulti || classes.size() <= 2)
-                    {
-                        fvec res = GetBestFMeasure(classifier->rocdata[1]);
-                        fmeasureTest.push_back(res[0]);
-                        precisionTest.push_back(res[1]);
-                        recallTest.push_back(res[2]);
-                    }
-                    else
-                    {
-                        int errors = 0;
-                        std::vector<f32pair> rocdata = classifier->rocdata[1];
-                        FOR(j, rocdata.size())
-                        {
-                            if(rocdata[j].first != rocdata[j].second)
-                            {
-                                if(classes.size() > 2) errors++;
-                                else if((rocdata[j].first < 0) != rocdata[j].second) errors++;
-                            }
-                        }
-                        if(classes.size() <= 2) fmeasureTest.push_back(min(errors,(int)rocdata.size()-errors)/(float)rocdata.size());
-                        else
-                        {
-                            // compute the micro and macro f-measure
-                            fpair fmeasure = GetMicroMacroFMeasure(rocdata);
-                            fmeasureTest.push_back(fmeasure.first);
-                            errorTest.push_back(errors/(float)rocdata.size());
-                        }
-                    }
-                }
-                if(!classifierMulti.size()) DEL(classifier);
-                classifier = 0;
-                sourceDims.clear();
-                FOR(c,classifierMulti.size()) DEL(classifierMulti[c]); classifierMulti.clear();
-
-                progress.setValue(f + i*folds);
-                qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-                if(progress.wasCanceled())
+                CompareJob job(algorithm, f);
+                job.classifier = classifiers[tab]->GetClassifier();
+                if(!job.classifier) continue;
+                // binary classifiers learn multiclass problems with one model per class (one-vs-all)
+                if(!job.classifier->IsMultiClass() && data.classCount > 2)
                 {
-                    compare->AddResults(fmeasureTest,   "F-Measure (Test)", algoName);
-                    compare->AddResults(errorTest,      "Error (Test)", algoName);
-                    compare->AddResults(precisionTest,  "Precision (Test)", algoName);
-                    compare->AddResults(recallTest,     "Recall (Test)", algoName);
-                    compare->AddResults(fmeasureTrain,  "F-Measure (Training)", algoName);
-                    compare->AddResults(errorTrain,     "Error (Training)", algoName);
-                    compare->AddResults(precisionTrain, "Precision (Training)", algoName);
-                    compare->AddResults(recallTrain,    "Recall (Training)", algoName);
-                    //compare->SetActiveResult(1);
-                    compare->Show();
-                    return;
+                    job.classifierMulti.push_back(job.classifier);
+                    for(int c=1; c<data.classCount; c++) job.classifierMulti.push_back(classifiers[tab]->GetClassifier());
                 }
+                jobs.push_back(job);
             }
-            compare->AddResults(fmeasureTest,   "F-Measure (Test)", algoName);
-            compare->AddResults(errorTest,      "Error (Test)", algoName);
-            compare->AddResults(precisionTest,  "Precision (Test)", algoName);
-            compare->AddResults(recallTest,     "Recall (Test)", algoName);
-            compare->AddResults(fmeasureTrain,  "F-Measure (Training)", algoName);
-            compare->AddResults(errorTrain,     "Error (Training)", algoName);
-            compare->AddResults(precisionTrain, "Precision (Training)", algoName);
-            compare->AddResults(recallTrain,    "Recall (Training)", algoName);
-            //compare->SetActiveResult(1);
         }
-        if(line.startsWith("Regression"))
+        else if(type == "Regression")
         {
-            QStringList s = line.split(":");
-            int tab = s[1].toInt();
             if(tab >= regressors.size() || !regressors[tab]) continue;
             int outputDim = compare->params->outputDimCombo->currentIndex();
-            QTextStream paramStream(&paramString);
-            QString paramName;
-            float paramValue;
             while(!paramStream.atEnd())
             {
                 paramStream >> paramName;
                 paramStream >> paramValue;
                 regressors[tab]->LoadParams(paramName, paramValue);
             }
-
-            if (!samples.size() && optionsRegress->manualTrainButton->isChecked()) {
-                trainList = GetManualSelection();
-            }
-
-            QString algoName = regressors[tab]->GetAlgoString();
-            fvec resultTrain, resultTest;
-            FOR(f, folds)
+            if(!bRegressData)
             {
-                regressor = regressors[tab]->GetRegressor();
-                if(!regressor) continue;
-                //qDebug() << " training: " << regressors[tab]->GetName();
-                Train(regressor, outputDim, trainRatio, trainList);
-                if(regressor->trainErrors.size())
-                {
-                    float error = 0.f;
-                    FOR(i, regressor->trainErrors.size()) error += regressor->trainErrors[i];
-                    error /= regressor->trainErrors.size();
-                    resultTrain.push_back(error);
-                }
-                if(regressor->testErrors.size())
-                {
-                    float error = 0.f;
-                    FOR(i, regressor->testErrors.size()) error += regressor->testErrors[i];
-                    error /= regressor->testErrors.size();
-                    resultTest.push_back(error);
-                }
-                DEL(regressor);
+                data.regressSamples = GetRegressionSamples(outputDim);
                 sourceDims.clear();
-
-                progress.setValue(f + i*folds);
-                qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-                if(progress.wasCanceled())
-                {
-                    compare->AddResults(resultTest, "Error (Testing)", algoName);
-                    compare->AddResults(resultTrain, "Error (Training)", algoName);
-                    compare->Show();
-                    return;
+                if(data.regressSamples.size() && data.regressSamples[0].size() < 2) data.regressSamples.clear();
+                data.regressLabels = canvas->data->GetLabels();
+                data.regressTrainList = trainList;
+                if (!samples.size() && optionsRegress->manualTrainButton->isChecked()) {
+                    data.regressTrainList = GetManualSelection();
                 }
+                data.regressBlock.SetRows(data.regressSamples);
+                data.regressGram = new GramCache(data.regressBlock.View(), gramCacheBytes, 1);
+                bRegressData = true;
+            }
+            if(!data.regressSamples.size()) continue;
+            compareNames << regressors[tab]->GetAlgoString();
+            FOR(f, folds)
+            {
+                CompareJob job(algorithm, f);
+                job.regressor = regressors[tab]->GetRegressor();
+                if(!job.regressor) continue;
+                job.regressor->SetOutputDim(outputDim);
+                jobs.push_back(job);
             }
-            compare->AddResults(resultTest, "Error (Testing)", algoName);
-            compare->AddResults(resultTrain, "Error (Training)", algoName);
         }
-        if(line.startsWith("Dynamical"))
+        else if(type == "Dynamical")
         {
-            QStringList s = line.split(":");
-            int tab = s[1].toInt();
             if(tab >= dynamicals.size() || !dynamicals[tab]) continue;
-            QTextStream paramStream(&paramString);
-            QString paramName;
-            float paramValue;
             while(!paramStream.atEnd())
             {
                 paramStream >> paramName;
                 paramStream >> paramValue;
                 dynamicals[tab]->LoadParams(paramName, paramValue);
             }
-            QString algoName = dynamicals[tab]->GetAlgoString();
-            fvec resultReconst, resultTargetTraj, resultTarget;
+            float dT = optionsDynamic->dtSpin->value();
+            if(!bDynamicalData)
+            {
+                data.trajectories = GetTrainingTrajectories(data.trajectoryLabels, dT);
+                bDynamicalData = true;
+            }
+            if(!data.trajectories.size()) continue;
+            compareNames << dynamicals[tab]->GetAlgoString();
             FOR(f, folds)
             {
-                dynamical = dynamicals[tab]->GetDynamical();
-                if(!dynamical) continue;
-                fvec results = Train(dynamical);
-                if(results.size())
-                {
-                    resultReconst.push_back(results[0]);
-                    resultTargetTraj.push_back(results[1]);
-                    resultTarget.push_back(results[2]);
-                }
-                DEL(dynamical);
-
-                progress.setValue(f + i*folds);
-                qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-                if(progress.wasCanceled())
-                {
-                    compare->AddResults(resultReconst, "Reconstruction Error", algoName);
-                    compare->AddResults(resultTargetTraj, "Target Error (trajectories)", algoName);
-                    compare->AddResults(resultTarget, "Target Error (random points)", algoName);
-                    compare->Show();
-                    return;
-                }
+                CompareJob job(algorithm, f);
+                job.dynamical = dynamicals[tab]->GetDynamical();
+                if(!job.dynamical) continue;
+                job.dynamical->dT = dT;
+                jobs.push_back(job);
             }
-            compare->AddResults(resultReconst, "Reconstruction Error", algoName);
-            compare->AddResults(resultTargetTraj, "Target Error (trajectories)", algoName);
-            compare->AddResults(resultTarget, "Target Error (random points)", algoName);
         }
+        else continue;
+        compareMeasures.push_back(compareMeasureNames(type));
+    }
+
+    if(!jobs.size())
+    {
+        DEL(compareData);
         compare->Show();
+        return;
     }
+    compareProgress = new QProgressDialog("Comparing Algorithms", "cancel", 0, jobs.size());
+    connect(compareProgress, SIGNAL(canceled()), this, SLOT(CompareCancel()));
+    compareProgress->show();
+    compareThread->Evaluate(compareData, jobs);
+}
+
+void AlgorithmManager::CompareEvaluated(int, int)
+{
+    if(!compareProgress) return;
+    compareProgress->setValue(compareProgress->value() + 1);
+}
+
+void AlgorithmManager::CompareCancel()
+{
+    compareThread->Cancel();
+}
+
+void AlgorithmManager::CompareFinished()
+{
+    if(compareThread->isRunning() || !compareData) return;
+    // the folds are gathered in the order of the comparison, whichever finished first
+    // (a canceled comparison shows what it got through)
+    const vector<CompareJob> &jobs = compareThread->Jobs();
+    FOR(a, compareNames.size())
+    {
+        const QStringList &measures = compareMeasures[a];
+        vector<fvec> results(measures.size());
+        FOR(i, jobs.size())
+        {
+            if(jobs[i].algorithm != (int)a) continue;
+            FOR(m, min(results.size(), jobs[i].results.size()))
+            {
+                results[m].insert(results[m].end(), jobs[i].results[m].begin(), jobs[i].results[m].end());
+            }
+        }
+        FOR(m, measures.size()) compare->AddResults(results[m], measures[m], compareNames[a]);
+    }
+    DEL(compareProgress);
+    DEL(compareData);
+    compare->Show();
 }
 
 void AlgorithmManager::CompareAdd()
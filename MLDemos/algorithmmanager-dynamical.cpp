@@ -18,6 +18,7 @@ License along with this library; if not, write to the Free
 Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 *********************************************************************/
 #include "algorithmmanager.h"
+#include "streamIntegrator.h"
 
 using namespace std;
 
@@ -75,15 +76,15 @@ void AlgorithmManager::Dynamize()
     int steps = 300;
     if(trajectories.size())
     {
-        testTrajectories.resize(trajectories.size());
         int dim = trajectories[0][0].size() / 2;
+        vector<fvec> starts(trajectories.size());
         FOR(i, trajectories.size())
         {
-            fvec start(dim,0);
-            FOR(d, dim) start[d] = trajectories[i][0][d];
-            vector<fvec> result = dynamical->Test(start, steps);
-            testTrajectories[i] = result;
+            starts[i].resize(dim,0);
+            FOR(d, dim) starts[i][d] = trajectories[i][0][d];
         }
+        StreamIntegrator integrator(dynamical);
+        testTrajectories = integrator.Integrate(starts, steps);
         canvas->maps.model = QPixmap(w,h);
         //QBitmap bitmap(w,h);
         //bitmap.clear();
@@ -161,29 +162,45 @@ void AlgorithmManager::Avoidance()
 fvec AlgorithmManager::Train(Dynamical *dynamical)
 {
     if(!dynamical) return fvec();
+    ivec trajLabels;
+    float dT;
+    vector< vector<fvec> > trajectories = GetTrainingTrajectories(trajLabels, dT);
+    if(!trajectories.size()) return fvec();
+    dynamical->dT = dT;
+    return TrainDynamical(dynamical, trajectories, trajLabels);
+}
+
+// the resampled trajectories of the dataset, their labels and the time span between their frames
+vector< vector<fvec> > AlgorithmManager::GetTrainingTrajectories(ivec &trajLabels, float &dT)
+{
     vector<fvec> samples = canvas->data->GetSamples();
     vector<ipair> sequences = canvas->data->GetSequences();
-    if(!samples.size() || !sequences.size()) return fvec();
+    if(!samples.size() || !sequences.size()) return vector< vector<fvec> >();
     int count = optionsDynamic->resampleSpin->value();
     int resampleType = optionsDynamic->resampleCombo->currentIndex();
     int centerType = optionsDynamic->centerCombo->currentIndex();
     bool zeroEnding = optionsDynamic->zeroCheck->isChecked();
 
-    ivec trajLabels(sequences.size());
+    trajLabels.resize(sequences.size());
     FOR(i, sequences.size())
     {
         trajLabels[i] = canvas->data->GetLabel(sequences[i].first);
     }
 
     //float dT = 10.f; // time span between each data frame
-    float dT = optionsDynamic->dtSpin->value();
-    dynamical->dT = dT;
+    dT = optionsDynamic->dtSpin->value();
     //dT = 10.f;
     vector< vector<fvec> > trajectories = canvas->data->GetTrajectories(resampleType, count, centerType, dT, zeroEnding);
     interpolate(trajectories[0],count);
+    return trajectories;
+}
 
-    dynamical->Train(trajectories, trajLabels);
-    return Test(dynamical, trajectories, trajLabels);
+// trains dynamical on the trajectories and returns its errors (see Test), only the arguments are touched
+fvec AlgorithmManager::TrainDynamical(Dynamical *dynamical, vector< vector<fvec> > trajectories, ivec labels)
+{
+    if(!dynamical || !trajectories.size()) return fvec();
+    dynamical->Train(trajectories, labels);
+    return Test(dynamical, trajectories, labels);
 }
 
 // returns respectively the reconstruction error for the training points individually, per trajectory, and the error to target
@@ -198,24 +215,36 @@ fvec AlgorithmManager::Test(Dynamical *dynamical, vector< vector<fvec> > traject
     fvec xMin(dim, FLT_MAX);
     fvec xMax(dim, -FLT_MAX);
 
+    // the velocities at all the training points are computed in a single batch
+    SampleMatrix points(dim);
+    FOR(i, trajectories.size())
+    {
+        FOR(j, trajectories[i].size())
+        {
+            FOR(d, dim)
+            {
+                sample[d] = trajectories[i][j][d];
+                if(xMin[d] > sample[d]) xMin[d] = sample[d];
+                if(xMax[d] < sample[d]) xMax[d] = sample[d];
+            }
+            points.AddRow(sample);
+        }
+    }
+    fvec velocities;
+    dynamical->TestBatch(points.View(), velocities);
+
     // test each trajectory for errors
     int errorCnt=0;
     float errorOne = 0;
     //float errorAll = 0;
     FOR(i, trajectories.size())
     {
-        vector<fvec> t = trajectories[i];
+        vector<fvec> &t = trajectories[i];
         float errorTraj = 0;
         FOR(j, t.size())
         {
-            FOR(d, dim)
-            {
-                sample[d] = t[j][d];
-                vTrue[d] = t[j][d+dim];
-                if(xMin[d] > sample[d]) xMin[d] = sample[d];
-                if(xMax[d] < sample[d]) xMax[d] = sample[d];
-            }
-            fvec v = dynamical->Test(sample);
+            FOR(d, dim) vTrue[d] = t[j][d+dim];
+            const float *v = &velocities[errorCnt*dim];
             float error = 0;
             FOR(d, dim) error += (v[d] - vTrue[d])*(v[d] - vTrue[d]);
             errorTraj += error;
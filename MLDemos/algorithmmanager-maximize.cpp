@@ -137,11 +137,24 @@ void AlgorithmManager::MaximizeContinue()
 void AlgorithmManager::Train(Maximizer *maximizer)
 {
     if(!maximizer) return;
-    if(canvas->maps.reward.isNull()) return;
+    int w, h;
+    float *data = GetRewardData(w, h);
+    if(!data) return;
+    fvec startingPoint = GetStartingPoint(w, h);
+    //data = canvas->data->GetReward()->GetRewardFloat();
+    maximizer->Train(data, fVec(w,h), startingPoint);
+    maximizer->age = 0;
+    delete [] data;
+}
+
+// the reward map normalized in a 0-1 range (w x h values, to be deleted by the caller), which becomes the dataset reward
+float *AlgorithmManager::GetRewardData(int &w, int &h)
+{
+    if(canvas->maps.reward.isNull()) return 0;
     QImage rewardImage = canvas->maps.reward.toImage();
     QRgb *pixels = (QRgb*) rewardImage.bits();
-    int w = rewardImage.width();
-    int h = rewardImage.height();
+    w = rewardImage.width();
+    h = rewardImage.height();
 
     float *data = new float[w*h];
     float maxData = 0;
@@ -160,8 +173,12 @@ void AlgorithmManager::Train(Maximizer *maximizer)
     fvec low(2,0.f);
     fvec high(2,1.f);
     canvas->data->GetReward()->SetReward(data, size, low, high);
-    //    delete [] data;
+    return data;
+}
 
+// the last target placed on the canvas, or a random point, in reward map coordinates
+fvec AlgorithmManager::GetStartingPoint(int w, int h)
+{
     fvec startingPoint;
     if(canvas->targets.size())
     {
@@ -176,10 +193,7 @@ void AlgorithmManager::Train(Maximizer *maximizer)
         startingPoint[0] = drand48();
         startingPoint[1] = drand48();
     }
-    //data = canvas->data->GetReward()->GetRewardFloat();
-    maximizer->Train(data, fVec(w,h), startingPoint);
-    maximizer->age = 0;
-    delete [] data;
+    return startingPoint;
 }
 
 void AlgorithmManager::Test(Maximizer *maximizer)
@@ -29,14 +29,14 @@ void AlgorithmManager::QueryClassifier(std::vector<fvec> samples)
     result.resize(1);
     if (classifier && samples.size()) {
         results.resize(samples.size());
+        SampleMatrix matrix(samples);
+        SampleView view = sourceDims.size() ? matrix.View(sourceDims) : matrix.View();
+        // multi-class classifiers answer Test() with their own convention, we only batch single-output ones
+        fvec scores;
+        bool bBatch = !classifier->IsMultiClass();
+        if (bBatch) classifier->TestBatch(view, scores);
         FOR (i, samples.size()) {
-            fvec sample = samples[i];
-            if (sourceDims.size()) {
-                fvec newSample(sourceDims.size());
-                FOR (d, sourceDims.size()) newSample[d] = sample[sourceDims[d]];
-                sample = newSample;
-            }
-            result[0] = classifier->Test(sample);
+            result[0] = bBatch ? scores[i] : classifier->Test(view.Row(i));
             results[i] = result;
         }
     }
@@ -49,8 +49,12 @@ void AlgorithmManager::QueryRegressor(std::vector<fvec> samples)
     QMutexLocker lock(mutex);
     if (regressor && samples.size()) {
         results.resize(samples.size());
+        fvec means, confidences;
+        regressor->TestBatch(SampleMatrix(samples).View(), means, confidences);
         FOR (i, samples.size()) {
-            results[i] = regressor->Test(samples[i]);
+            results[i].resize(2);
+            results[i][0] = means[i];
+            results[i][1] = confidences[i];
         }
     }
     emit SendResults(results);
@@ -62,8 +66,12 @@ void AlgorithmManager::QueryDynamical(std::vector<fvec> samples)
     QMutexLocker lock(mutex);
     if (dynamical && samples.size()) {
         results.resize(samples.size());
+        SampleMatrix matrix(samples);
+        int dim = matrix.Cols();
+        fvec velocities;
+        dynamical->TestBatch(matrix.View(), velocities);
         FOR (i, samples.size()) {
-            results[i] = dynamical->Test(samples[i]);
+            results[i] = fvec(velocities.begin() + i*dim, velocities.begin() + (i+1)*dim);
         }
     }
     emit SendResults(results);
@@ -100,10 +108,7 @@ void AlgorithmManager::QueryProjector(std::vector<fvec> samples)
     std::vector<fvec> results;
     QMutexLocker lock(mutex);
     if (projector && samples.size()) {
-        results.resize(samples.size());
-        FOR (i, samples.size()) {
-            results[i] = projector->Project(samples[i]);
-        }
+        results = projector->ProjectSamples(samples);
     }
     emit SendResults(results);
 }
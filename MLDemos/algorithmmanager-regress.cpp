@@ -107,13 +107,14 @@ void AlgorithmManager::Regression()
             painter.drawEllipse(point, 6,6);
         }
         // we draw the estimated sample
+        fvec estimates, confidences;
+        if(subsamples.size()) regressor->TestBatch(SampleMatrix(subsamples).View(), estimates, confidences);
         painter.setPen(Qt::white);
         painter.setBrush(Qt::black);
         FOR(i, samples.size())
         {
             fvec sample = samples[i];
-            fvec estimate = regressor->Test(subsamples[i]);
-            sample[outputDim] = estimate[0];
+            sample[outputDim] = estimates[i];
             QPointF point2 = canvas->toCanvasCoords(sample);
             painter.drawEllipse(point2, 5,5);
         }
@@ -122,9 +123,8 @@ void AlgorithmManager::Regression()
         FOR(i, samples.size())
         {
             fvec sample = samples[i];
-            fvec estimate = regressor->Test(subsamples[i]);
             QPointF point = canvas->toCanvasCoords(sample);
-            sample[outputDim] = estimate[0];
+            sample[outputDim] = estimates[i];
             QPointF point2 = canvas->toCanvasCoords(sample);
             QColor color = SampleColor[labels[i]%SampleColorCnt];
             if(!labels[i]) color = Qt::black;
@@ -140,6 +140,30 @@ void AlgorithmManager::Train(Regressor *regressor, int outputDim, float trainRat
 {
     if(!regressor || !canvas->data->GetCount()) return;
 
+    samples = GetRegressionSamples(outputDim, samples);
+    if(!labels.size()) labels = canvas->data->GetLabels();
+
+    if(!samples.size()) return;
+    int dim = samples[0].size();
+    if(dim < 2) return;
+
+    regressor->SetOutputDim(outputDim);
+
+    // with an out-of-core dataset the learners that support it are trained on the whole file
+    bool bStreamed = false;
+    if(trainRatio == 1.f && !trainList.size() && canvas->data->IsStreaming() && regressor->StreamPasses())
+    {
+        canvas->data->GetStream()->Train(regressor, DatasetManager::GetDimsColumns(sourceDims));
+        bStreamed = true;
+    }
+    TrainRegressor(regressor, samples, labels, trainRatio, trainList, bStreamed);
+    //bIsCrossNew = true;
+}
+
+// the input dimensions followed by the output one, for the dataset samples or for the ones given
+// returns nothing when there are not enough dimensions to regress on
+std::vector<fvec> AlgorithmManager::GetRegressionSamples(int outputDim, std::vector<fvec> samples)
+{
     ivec inputDims = GetInputDimensions();
     // Bug Regression crashing --- Guillaume
     if(inputDims.size() == 0){
@@ -151,7 +175,7 @@ void AlgorithmManager::Train(Regressor *regressor, int outputDim, float trainRat
     }
 
     int outputIndexInList = -1;
-    if(inputDims.size()==1 && inputDims[0] == outputDim) return; // we dont have enough dimensions for training
+    if(inputDims.size()==1 && inputDims[0] == outputDim) return std::vector<fvec>(); // we dont have enough dimensions for training
     FOR(i, inputDims.size()) {
         if(outputDim == inputDims[i]) {
             outputIndexInList = i;
@@ -162,25 +186,32 @@ void AlgorithmManager::Train(Regressor *regressor, int outputDim, float trainRat
     outputIndexInList = inputDims.size()-1;
     sourceDims = inputDims;
 
-    if(!samples.size()) samples = canvas->data->GetSampleDims(inputDims, outputIndexInList == -1 ? outputDim : -1);
-    else samples = canvas->data->GetSampleDims(samples, inputDims, outputIndexInList == -1 ? outputDim : -1);
-    if(!labels.size()) labels = canvas->data->GetLabels();
-
-    if(!samples.size()) return;
-    int dim = samples[0].size();
-    if(dim < 2) return;
-
-    regressor->SetOutputDim(outputDim);
+    if(!samples.size()) return canvas->data->GetSampleDims(inputDims, outputIndexInList == -1 ? outputDim : -1);
+    return canvas->data->GetSampleDims(samples, inputDims, outputIndexInList == -1 ? outputDim : -1);
+}
 
+// trains regressor on samples (output in the last column) and fills in its training and testing errors
+// bTrained skips the training on the whole set when the caller already did it (e.g. from a stream)
+// nothing but the arguments is touched, so that the comparisons can train several models at once
+void AlgorithmManager::TrainRegressor(Regressor *regressor, const std::vector<fvec> &samples, const ivec &labels,
+                                      float trainRatio, const bvec &trainList, bool bTrained, GramCache *gram)
+{
+    if(!regressor || !samples.size()) return;
     fvec trainErrors, testErrors;
     if(trainRatio == 1.f && !trainList.size()) {
-        regressor->Train(samples, labels);
+        if(!bTrained) {
+            GramScope scope(gram, ivec(samples.size()));
+            FOR(i, samples.size()) scope.rows[i] = i;
+            regressor->gramScope = &scope;
+            regressor->Train(samples, labels);
+            regressor->gramScope = 0;
+        }
         trainErrors.clear();
+        fvec means, confidences;
+        regressor->TestBatch(SampleMatrix(samples).View(), means, confidences);
         FOR(i, samples.size())
         {
-            fvec sample = samples[i];
-            fvec res = regressor->Test(sample);
-            float error = fabs(res[0] - sample.back());
+            float error = fabs(means[i] - samples[i].back());
             trainErrors.push_back(error);
         }
         regressor->trainErrors = trainErrors;
@@ -190,12 +221,13 @@ void AlgorithmManager::Train(Regressor *regressor, int outputDim, float trainRat
         int testCnt = samples.size() - trainCnt;
         u32 *perm = randPerm(samples.size());
         vector<fvec> trainSamples, testSamples;
-        ivec trainLabels, testLabels;
+        ivec trainLabels, testLabels, trainRows; // where the training samples are in samples
         if(trainList.size()) {
             FOR(i, trainList.size()) {
                 if(trainList[i]) {
                     trainSamples.push_back(samples[i]);
                     trainLabels.push_back(labels[i]);
+                    trainRows.push_back(i);
                 } else {
                     testSamples.push_back(samples[i]);
                     testLabels.push_back(labels[i]);
@@ -208,6 +240,7 @@ void AlgorithmManager::Train(Regressor *regressor, int outputDim, float trainRat
             trainLabels.resize(trainCnt);
             testSamples.resize(testCnt);
             testLabels.resize(testCnt);
+            trainRows.assign(perm, perm + trainCnt);
             FOR(i, trainCnt) {
                 trainSamples[i] = samples[perm[i]];
                 trainLabels[i] = labels[perm[i]];
@@ -217,17 +250,19 @@ void AlgorithmManager::Train(Regressor *regressor, int outputDim, float trainRat
                 testLabels[i] = labels[perm[i+trainCnt]];
             }
         }
+        GramScope scope(gram, trainRows);
+        regressor->gramScope = &scope;
         regressor->Train(trainSamples, trainLabels);
+        regressor->gramScope = 0;
+        fvec means, confidences;
+        if(trainCnt) regressor->TestBatch(SampleMatrix(trainSamples).View(), means, confidences);
         FOR(i, trainCnt) {
-            fvec sample = trainSamples[i];
-            fvec res = regressor->Test(sample);
-            float error = fabs(res[0] - sample.back());
+            float error = fabs(means[i] - trainSamples[i].back());
             trainErrors.push_back(error);
         }
+        if(testCnt) regressor->TestBatch(SampleMatrix(testSamples).View(), means, confidences);
         FOR(i, testCnt) {
-            fvec sample = testSamples[i];
-            fvec res = regressor->Test(sample);
-            float error = fabs(res[0] - sample.back());
+            float error = fabs(means[i] - testSamples[i].back());
             testErrors.push_back(error);
             //qDebug() << " test error: " << i << error;
         }
@@ -235,5 +270,4 @@ void AlgorithmManager::Train(Regressor *regressor, int outputDim, float trainRat
         regressor->testErrors = testErrors;
         KILL(perm);
     }
-    //bIsCrossNew = true;
 }
@@ -41,8 +41,13 @@ AlgorithmManager::AlgorithmManager(MLDemos *mldemos, Canvas *canvas, GLWidget *g
       mutex(mutex),
       drawTimer(drawTimer),
       compare(compare),
+      compareThread(new CompareThread(this)),
+      compareData(0),
+      compareProgress(0),
       gridSearch(gridSearch)
 {
+    connect(compareThread, SIGNAL(Evaluated(int,int)), this, SLOT(CompareEvaluated(int,int)));
+    connect(compareThread, SIGNAL(finished()), this, SLOT(CompareFinished()));
     options = new Ui::algorithmOptions();
     optionsClassify = new Ui::optionsClassifyWidget();
     optionsCluster = new Ui::optionsClusterWidget();
@@ -233,6 +238,10 @@ AlgorithmManager::AlgorithmManager(MLDemos *mldemos, Canvas *canvas, GLWidget *g
 
 AlgorithmManager::~AlgorithmManager()
 {
+    compareThread->Cancel();
+    compareThread->wait();
+    DEL(compareData);
+    DEL(compareProgress);
     mutex->lock();
     DEL(clusterer);
     DEL(regressor);
@@ -2,6 +2,8 @@
 #define ALGORITHMMANAGER_H
 
 #include <QList>
+#include <QThread>
+#include <atomic>
 #include "canvas.h"
 #include "classifier.h"
 #include "regressor.h"
@@ -15,6 +17,7 @@
 #include "widget.h"
 #include "drawTimer.h"
 #include "gridsearch.h"
+#include "gramCache.h"
 #include "basewidget.h"
 
 #include "ui_algorithmOptions.h"
@@ -29,6 +32,68 @@
 #include "ui_inputDimensions.h"
 
 class MLDemos;
+class QProgressDialog;
+
+// everything the comparison of algorithms reads: built once on the gui thread
+// and shared, untouched, by all the folds while they are evaluated
+struct CompareData
+{
+    SampleMatrix classSamples; // classification samples, restricted to classColumns
+    ivec classColumns, classLabels;
+    bvec classTrainList;
+    int classCount, labelCount; // classes in the training labels and in the canvas ones
+    std::vector<fvec> regressSamples; // input dimensions followed by the output one
+    SampleMatrix regressBlock; // regressSamples in one block, for their kernel matrices
+    ivec regressLabels;
+    bvec regressTrainList;
+    GramCache *classGram, *regressGram; // kernel matrices shared by the kernel methods of every fold
+    std::vector< std::vector<fvec> > trajectories;
+    ivec trajectoryLabels;
+    float *rewardData;
+    int w, h;
+    float trainRatio;
+    CompareData() : classCount(0), labelCount(0), classGram(0), regressGram(0), rewardData(0), w(0), h(0), trainRatio(1.f){}
+    ~CompareData(){DEL(classGram); DEL(regressGram); KILL(rewardData);}
+};
+
+// training and testing of one model, for one of the compared algorithms and one fold
+// the models are created and parametrized on the gui thread, as the interfaces read their widgets
+struct CompareJob
+{
+    int algorithm, fold;
+    Classifier *classifier;
+    std::vector<Classifier *> classifierMulti; // one-vs-all models of a binary classifier, classifier first
+    Regressor *regressor;
+    Dynamical *dynamical;
+    Maximizer *maximizer;
+    fvec startingPoint;
+    std::vector<fvec> results; // the value of each measure of the algorithm, empty when the fold did not produce it
+    CompareJob(int algorithm=0, int fold=0) : algorithm(algorithm), fold(fold), classifier(0), regressor(0), dynamical(0), maximizer(0){}
+};
+
+// evaluates the folds of an algorithm comparison on a pool of worker threads, away from the gui thread
+class CompareThread : public QThread
+{
+    Q_OBJECT
+public:
+    CompareThread(QObject *parent=0) : QThread(parent), data(0), bCanceled(false){}
+    // the thread deletes the models of the jobs once it is done with them
+    void Evaluate(const CompareData *data, std::vector<CompareJob> jobs);
+    void Cancel() {bCanceled = true;}
+    bool IsCanceled() const {return bCanceled;}
+    const std::vector<CompareJob> &Jobs() const {return jobs;}
+
+signals:
+    void Evaluated(int algorithm, int fold);
+
+protected:
+    void run();
+
+private:
+    const CompareData *data;
+    std::vector<CompareJob> jobs;
+    std::atomic<bool> bCanceled;
+};
 
 class AlgorithmManager : public QObject
 {
@@ -90,6 +155,11 @@ public:
     QMutex *mutex;
     DrawTimer *drawTimer;
     CompareAlgorithms *compare;
+    CompareThread *compareThread;
+    CompareData *compareData;
+    QProgressDialog *compareProgress;
+    QStringList compareNames; // name and measures of each compared algorithm, in the order of the comparison
+    std::vector<QStringList> compareMeasures;
     GridSearch *gridSearch;
     MLDemos *mldemos;
 
@@ -120,8 +190,21 @@ public:
     void Train(Maximizer *maximizer);
     void Train(Reinforcement *reinforcement);
     void Train(Projector *projector, bvec trainList = bvec());
-    fvec Test(Dynamical *dynamical, std::vector< std::vector<fvec> > trajectories, ivec labels);
-    void Test(Maximizer *maximizer);
+    static fvec Test(Dynamical *dynamical, std::vector< std::vector<fvec> > trajectories, ivec labels);
+    static void Test(Maximizer *maximizer);
+
+    // the training itself, which only touches its arguments and can run on any thread
+    static bool TrainClassifier(Classifier *classifier, std::vector<Classifier *> &classifierMulti, const SampleView &samples,
+                                ivec labels, float trainRatio=1, const bvec &trainList=bvec(), int positiveIndex=-1, QString *info=0,
+                                GramCache *gram=0);
+    static void TrainRegressor(Regressor *regressor, const std::vector<fvec> &samples, const ivec &labels,
+                               float trainRatio=1, const bvec &trainList=bvec(), bool bTrained=false, GramCache *gram=0);
+    static fvec TrainDynamical(Dynamical *dynamical, std::vector< std::vector<fvec> > trajectories, ivec labels);
+    // and what it is trained on, taken from the canvas and the options
+    std::vector<fvec> GetRegressionSamples(int outputDim, std::vector<fvec> samples=std::vector<fvec>());
+    std::vector< std::vector<fvec> > GetTrainingTrajectories(ivec &labels, float &dT);
+    float *GetRewardData(int &w, int &h);
+    fvec GetStartingPoint(int w, int h);
     float ClusterFMeasure(std::vector<fvec> samples, ivec labels, std::vector<fvec> scores, float ratio = 1.f);
     void DrawClassifiedSamples(Canvas *canvas, Classifier *classifier, std::vector<Classifier *> classifierMulti);
     void UpdateLearnedModel();
@@ -167,6 +250,9 @@ public slots:
     void Avoidance();
     void Compare();
     void CompareAdd();
+    void CompareEvaluated(int algorithm, int fold);
+    void CompareFinished();
+    void CompareCancel();
 
     // saving/loading the algorithms
     void LoadClassifier();
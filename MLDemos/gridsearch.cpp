@@ -2,7 +2,9 @@
 #include <QPixmap>
 #include <QClipboard>
 #include <basicMath.h>
+#include "parallel.h"
 #include "ui_gridsearch.h"
+#include <limits>
 
 using namespace std;
 
@@ -36,13 +38,28 @@ GridSearch::GridSearch(Canvas *canvas, QWidget *parent) :
     avoider(0),
     maximizer(0),
     reinforcement(0),
-    projector(0)
+    projector(0),
+    primaryMeasure(0),
+    bMinimizePrimary(true),
+    searchThread(new GridSearchThread(this)),
+    searchData(0),
+    searchFolds(1),
+    rung(0),
+    optimizer(0),
+    trialBudget(0),
+    trialsStarted(0),
+    trialsRunning(0),
+    trialsConcurrent(1),
+    evaluatedCount(0)
 {
     ui->setupUi(this);
     installEventFilter(this);
+    connect(searchThread, SIGNAL(Evaluated(int,int,float,float,float)), this, SLOT(Evaluated(int,int,float,float,float)));
+    connect(searchThread, SIGNAL(finished()), this, SLOT(Finished()));
     connect(ui->closeButton, SIGNAL(clicked()), this, SLOT(Close()));
     connect(ui->names1Combo, SIGNAL(currentIndexChanged(int)), this, SLOT(OptionsChanged()));
     connect(ui->names2Combo, SIGNAL(currentIndexChanged(int)), this, SLOT(OptionsChanged()));
+    connect(ui->searchCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(OptionsChanged()));
     connect(ui->runButton, SIGNAL(clicked()), this, SLOT(Run()));
     connect(ui->clipboardButton, SIGNAL(clicked()), this, SLOT(Clipboard()));
     connect(ui->displayLabel, SIGNAL(MouseMove(QMouseEvent*)), this, SLOT(MouseMove(QMouseEvent*)));
@@ -55,6 +72,10 @@ GridSearch::GridSearch(Canvas *canvas, QWidget *parent) :
 
 GridSearch::~GridSearch()
 {
+    searchThread->Cancel();
+    searchThread->wait();
+    DEL(searchData);
+    DEL(optimizer);
     delete ui;
 }
 
@@ -141,10 +162,6 @@ void GridSearch::paintEvent(QPaintEvent *event)
     int pY = (y+0.5)*H/mapY;
     int rW = 100;
     int rH = 40;
-    int rX = pX + 5;
-    int rY = pY + 5;
-    if(rX + rW > W) rX = pX - rW - 5;
-    if(rY + rH > H) rY = pY - rH - 5;
 
     int index1 = ui->names1Combo->currentIndex();
     int index2 = ui->names2Combo->currentIndex();
@@ -168,6 +185,16 @@ void GridSearch::paintEvent(QPaintEvent *event)
     }
     else displayString += QString("None\n");
     displayString += QString("%1: %2").arg(ui->resultCombo->currentText()).arg(value, 0, 'f', 4);
+    int cell = x+y*mapX;
+    if(cell < cellBudget.size() && cellBudget[cell] < 1.f && value == value)
+    {
+        displayString += QString("\n(%1% of the evaluation)").arg((int)(cellBudget[cell]*100 + 0.5f));
+        rH += 14;
+    }
+    int rX = pX + 5;
+    int rY = pY + 5;
+    if(rX + rW > W) rX = pX - rW - 5;
+    if(rY + rH > H) rY = pY - rH - 5;
 
     QPixmap newPixmap = pixmap;
     QPainter painter(&newPixmap);
@@ -207,13 +234,15 @@ void GridSearch::DisplayResults()
     if(index == -1) return;
     map = mapList[ui->resultCombo->currentText()];
 
+    // the cells still being evaluated hold nan and are left out
     float minVal = FLT_MAX, maxVal = -FLT_MAX;
     FOR(i, map.size())
     {
+        if(map[i] != map[i]) continue;
         minVal = min(minVal, map[i]);
         maxVal = max(maxVal, map[i]);
     }
-    if(minVal == maxVal)
+    if(minVal == FLT_MAX || minVal == maxVal)
     {
         minVal = 0;
         maxVal = 1;
@@ -227,7 +256,7 @@ void GridSearch::DisplayResults()
         FOR(x, xSteps)
         {
             float v = (map[x+y*xSteps]-minVal)/(maxVal-minVal);
-            QRgb color = Canvas::GetColorMapValue(v, colorScheme);
+            QRgb color = v == v ? Canvas::GetColorMapValue(v, colorScheme) : qRgb(128,128,128);
             tinyMap.setPixel(x,y,color);
         }
     }
@@ -249,8 +278,35 @@ void GridSearch::DisplayResults()
         if((int)x == xSteps) w = pixmap.width()-1;
         painter.drawLine(w, 0, w, pixmap.height());
     }
+    // the cells left out of the later rungs of successive halving only had part of the evaluation
+    if((int)cellBudget.size() == xSteps*ySteps)
+    {
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(QBrush(QColor(255,255,255,110), Qt::BDiagPattern));
+        FOR(i, cellBudget.size())
+        {
+            if(cellBudget[i] >= 1.f || map[i] != map[i]) continue;
+            int x = (i%xSteps)*pixmap.width()/xSteps, y = (i/xSteps)*pixmap.height()/ySteps;
+            int x1 = (i%xSteps+1)*pixmap.width()/xSteps, y1 = (i/xSteps+1)*pixmap.height()/ySteps;
+            painter.drawRect(x, y, x1-x, y1-y);
+        }
+    }
+    // the configurations evaluated by the bayesian optimization, on top of its surrogate
+    if(surrogateMap.size() && ui->resultCombo->currentText() == surrogateMap)
+    {
+        painter.setPen(QPen(Qt::black, 1));
+        FOR(i, trialCells.size())
+        {
+            if(trialCells[i].x() < 0) continue;
+            QPointF point((trialCells[i].x()+0.5f)*pixmap.width()/xSteps, (trialCells[i].y()+0.5f)*pixmap.height()/ySteps);
+            painter.setBrush(Qt::white);
+            painter.drawEllipse(point, 3, 3);
+        }
+    }
     ivec minIndices;
-    if(ui->resultCombo->currentIndex() == 0) {
+    bool bMinimum = ui->resultCombo->currentIndex() == 0;
+    if(surrogateMap.size() && ui->resultCombo->currentText() == surrogateMap) bMinimum = bMinimizePrimary;
+    if(bMinimum) {
         FOR(i, map.size()) { if(map[i] == minVal) minIndices.push_back(i); }
     } else {
         FOR(i, map.size()) { if(map[i] == maxVal) minIndices.push_back(i); }
@@ -351,9 +407,223 @@ fPair GridSearch::GetParamsRange()
     return ranges;
 }
 
+static fvec evaluateClassifier(Classifier *c, const GridSearchData &data, const ivec &train, const int trainCount, const ivec &test)
+{
+    fvec measures(3, 0.f);
+    const ivec &trainSource = c->IsMultiClass() ? data.labels : data.binLabels;
+    vector<fvec> trainSamples(trainCount);
+    ivec trainLabels(trainCount);
+    FOR(i, trainCount)
+    {
+        trainSamples[i] = data.samples.Row(train[i]);
+        trainLabels[i] = trainSource[train[i]];
+    }
+    GramScope scope(data.gram, ivec(train.begin(), train.begin() + trainCount));
+    c->gramScope = &scope;
+    c->Train(trainSamples, trainLabels);
+    c->gramScope = 0;
+
+    float error=0, invError=0;
+    bool bBinary = false;
+    rocData rocdata;
+    fvec scores;
+    int outputs = test.size() ? c->TestBatch(FoldIndex::Gather(data.samples.View(), test).View(), scores) : 0;
+    FOR(i, test.size())
+    {
+        int testLabel = data.labels[test[i]];
+        int testBinLabel = data.binLabels[test[i]];
+        if(c->IsMultiClass())
+        {
+            fvec res(&scores[(size_t)i*outputs], &scores[(size_t)i*outputs] + outputs);
+            if(res.size() == 1)
+            {
+                bBinary = true;
+                // we use invError because we don't know in which order the classifier
+                // has learned the classes, and which has become the de facto positive class
+                if(res[0] * testBinLabel < 0) error += 1.f;
+                else invError += 1.f;
+                rocdata.push_back(f32pair(res[0], (testBinLabel+1)/2));
+            }
+            else
+            {
+                int winner = 0;
+                float score = res[0];
+                FOR(j, res.size())
+                {
+                    if(res[j] > score)
+                    {
+                        score = res[j];
+                        winner = j;
+                    }
+                }
+                if(winner != testLabel) error += 1.f;
+                rocdata.push_back(f32pair(winner, testLabel));
+            }
+        }
+        else
+        {
+            bBinary = true;
+            float res = scores[i];
+            if(res * testBinLabel < 0) error += 1.f;
+            else invError += 1.f;
+            rocdata.push_back(f32pair(res, (testBinLabel+1)/2));
+        }
+    }
+    rocdata = FixRocData(rocdata);
+    if(bBinary) error = min(error, invError);
+    error /= test.size();
+    measures[0] = error;
+    // we use micro f-measure for multi-class
+    measures[1] = bBinary ? GetRocValueAt(rocdata, 0) : GetMicroMacroFMeasure(rocdata).first;
+    return measures;
+}
+
+static fvec evaluateRegressor(Regressor *r, const GridSearchData &data, const ivec &train, const int trainCount, const ivec &test)
+{
+    fvec measures(3, 0.f);
+    vector<fvec> trainSamples(trainCount);
+    ivec trainLabels(trainCount);
+    FOR(i, trainCount)
+    {
+        trainSamples[i] = data.samples.Row(train[i]);
+        trainLabels[i] = data.labels[train[i]];
+    }
+    GramScope scope(data.gram, ivec(train.begin(), train.begin() + trainCount));
+    r->gramScope = &scope;
+    r->Train(trainSamples, trainLabels);
+    r->gramScope = 0;
+    int outputDim = data.samples.Cols()-1;
+    float error = 0;
+    fvec means, confidences;
+    if(test.size()) r->TestBatch(FoldIndex::Gather(data.samples.View(), test).View(), means, confidences);
+    FOR(i, test.size())
+    {
+        // we compute the mse
+        float target = data.samples.RowData(test[i])[outputDim];
+        error += sqrtf((means[i] - target)*(means[i] - target));
+    }
+    error /= test.size();
+    measures[0] = error;
+    return measures;
+}
+
+static fvec evaluateMaximizer(Maximizer *m, const GridSearchData &data, const fvec &startingPoint)
+{
+    fvec measures(3, 0.f);
+    m->maxAge = 500;
+    m->stopValue = 0.99;
+    m->Train(data.rewardData, fVec(data.w,data.h), startingPoint);
+    m->age = 0;
+    // and now we test for a while
+    do
+    {
+        m->Test(m->Maximum());
+        m->age++;
+    }
+    while(m->age < m->maxAge && m->MaximumValue() < m->stopValue);
+    measures[0] = m->age;
+    measures[1] = m->MaximumValue();
+    measures[2] = m->Evaluations();
+    return measures;
+}
+
+static void deleteModels(GridSearchJob &job)
+{
+    DEL(job.classifier);
+    DEL(job.regressor);
+    DEL(job.maximizer);
+}
+
+void GridSearchThread::Evaluate(const GridSearchData *data, vector<GridSearchJob> jobs, bool bOpen)
+{
+    this->data = data;
+    this->jobs.assign(jobs.begin(), jobs.end());
+    this->bOpen = bOpen;
+    // the maximizers draw from the process-wide drand48 generator and many models go through libraries
+    // with a global state (newmat, ANN), their jobs stay on a single thread unless the model says otherwise
+    bSerial = jobs.size() && (jobs[0].maximizer ||
+                              (jobs[0].classifier && !jobs[0].classifier->IsTrainThreadSafe()) ||
+                              (jobs[0].regressor && !jobs[0].regressor->IsTrainThreadSafe()));
+    bCanceled = false;
+    start();
+}
+
+void GridSearchThread::Append(vector<GridSearchJob> jobs)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(bOpen && !bCanceled)
+        {
+            this->jobs.insert(this->jobs.end(), jobs.begin(), jobs.end());
+            jobs.clear();
+        }
+    }
+    wakeup.notify_all();
+    // the search is over, nobody will take them
+    FOR(i, jobs.size()) deleteModels(jobs[i]);
+}
+
+void GridSearchThread::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bOpen = false;
+    }
+    wakeup.notify_all();
+}
+
+void GridSearchThread::Cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bCanceled = true;
+    }
+    wakeup.notify_all();
+}
+
+void GridSearchThread::run()
+{
+    // every worker takes the jobs one at a time from the queue
+    int threads = bSerial ? 1 : ThreadCount();
+    ParallelFor(threads, [&](int)
+    {
+        while(true)
+        {
+            GridSearchJob job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeup.wait(lock, [&]{return jobs.size() || !bOpen || bCanceled;});
+                if(!jobs.size() || bCanceled) return;
+                job = jobs.front();
+                jobs.pop_front();
+            }
+            // the training rows of a fold are in random order, a fraction of them is a random subset
+            const ivec &train = data->folds.Train(job.fold), &test = data->folds.Test(job.fold);
+            int trainCount = max(1, (int)(train.size()*job.fraction + 0.5f));
+            fvec measures(3, 0.f);
+            if(job.classifier) measures = evaluateClassifier(job.classifier, *data, train, trainCount, test);
+            else if(job.regressor) measures = evaluateRegressor(job.regressor, *data, train, trainCount, test);
+            else if(job.maximizer) measures = evaluateMaximizer(job.maximizer, *data, job.startingPoint);
+            deleteModels(job);
+            if(bCanceled) return;
+            emit Evaluated(job.cell, job.fold, measures[0], measures[1], measures[2]);
+        }
+    }, threads);
+    std::lock_guard<std::mutex> lock(mutex);
+    FOR(i, jobs.size()) deleteModels(jobs[i]);
+    jobs.clear();
+    bOpen = false;
+}
+
 void GridSearch::Run()
 {
-    mapList.clear();
+    // while a search is running the button cancels it
+    if(searchThread->isRunning())
+    {
+        searchThread->Cancel();
+        return;
+    }
+    if(searchData) return; // the last search is still being wrapped up
     int xSteps = ui->steps1Spin->value();
     int ySteps = ui->steps2Spin->value();
     int xIndex = ui->names1Combo->currentIndex();
@@ -402,25 +672,28 @@ void GridSearch::Run()
     if(maximizer) oldParams = maximizer->GetParams();
     fvec params = oldParams;
     float trainRatio = 0.66;
-    vector<fvec> samples = canvas->data->GetSamples();
-    ivec labels = canvas->data->GetLabels();
-    ivec binLabels = toBinary(labels);
-    ui->progressBar->setValue(0);
-    ui->progressBar->setMaximum(xSteps*ySteps);
-    int w = 0;
-    int h = 0;
+    int count = canvas->data->GetCount();
+    if((classifier || regressor) && !count) return;
 
+    searchData = new GridSearchData();
+    GridSearchData &data = *searchData;
+    data.samples = canvas->data->GetSampleMatrix();
+    data.labels = canvas->data->GetLabels();
+    data.binLabels = toBinary(data.labels);
 
-    float *rewardData = 0;
     if(maximizer)
     {
-        if(canvas->maps.reward.isNull()) return;
+        if(canvas->maps.reward.isNull())
+        {
+            DEL(searchData);
+            return;
+        }
         QImage rewardImage = canvas->maps.reward.toImage();
         QRgb *pixels = (QRgb*) rewardImage.bits();
-        w = rewardImage.width();
-        h = rewardImage.height();
+        int w = data.w = rewardImage.width();
+        int h = data.h = rewardImage.height();
 
-        rewardData = new float[w*h];
+        float *rewardData = data.rewardData = new float[w*h];
         float maxData = 0;
         FOR(i, w*h)
         {
@@ -439,207 +712,62 @@ void GridSearch::Run()
         canvas->data->GetReward()->SetReward(rewardData, size, low, high);
     }
 
-    u32 *perm = randPerm(samples.size());
-    fvec measure1Map(xSteps*ySteps);
-    fvec measure2Map(xSteps*ySteps);
-    fvec measure3Map(xSteps*ySteps);
+    // every fold trains on a window of the same random permutation and tests on the rest
+    // the folds only hold indices, shared by all the cells of the grid, and so do the kernel matrices
+    // (each computed by the worker that first asks for it, the others are busy with cells of their own)
+    data.folds.Windows(count, folds, trainRatio);
+    data.gram = new GramCache(data.samples.View(), gramCacheBytes, 1);
+
+    // the parameters of every cell, the models are created from them as the search goes
+    int cellCount = xSteps*ySteps;
+    searchFolds = folds;
+    cellParams.resize(cellCount);
     FOR(y, ySteps)
     {
         FOR(x, xSteps)
         {
             if(!bNone1) params[xIndex] = x / (float) (xSteps-1) * (xMax - xMin) + xMin;
             if(!bNone2) params[yIndex] = y / (float) (ySteps-1) * (yMax - yMin) + yMin;
-            int trainCount = (int)(trainRatio * samples.size());
-            vector<fvec> trainSamples(trainCount);
-            ivec trainLabels(trainCount);
-            ivec trainBinLabels(trainCount);
-            vector<fvec> testSamples(samples.size()-trainCount);
-            ivec testLabels(samples.size()-trainCount);
-            ivec testBinLabels(samples.size()-trainCount);
-            fvec measure1(folds, 0);
-            fvec measure2(folds, 0);
-            fvec measure3(folds, 0);
-            FOR(f, folds)
-            {
-                int foldOffset = (f*samples.size()/folds);
-                FOR(i, samples.size())
-                {
-                    if(i < trainCount)
-                    {
-                        trainSamples[i] = samples[perm[(foldOffset + i) % samples.size()]];
-                        trainLabels[i] = labels[perm[(foldOffset + i) % labels.size()]];
-                        trainBinLabels[i] = binLabels[perm[(foldOffset + i) % labels.size()]];
-                    }
-                    else
-                    {
-                        testSamples[i-trainCount] = samples[perm[(foldOffset + i) % samples.size()]];
-                        testLabels[i-trainCount] = labels[perm[(foldOffset + i) % labels.size()]];
-                        testBinLabels[i-trainCount] = binLabels[perm[(foldOffset + i) % labels.size()]];
-                    }
-                }
-
-                if(classifier)
-                {
-                    if(!samples.size()) return;
-                    Classifier *c = classifier->GetClassifier();
-                    classifier->SetParams(c, params);
-                    if(c->IsMultiClass()) c->Train(trainSamples, trainLabels);
-                    else c->Train(trainSamples, trainBinLabels);
-                    float error=0, invError=0;
-                    bool bBinary = false;
-                    rocData rocdata;
-                    FOR(i, testSamples.size())
-                    {
-                        if(c->IsMultiClass())
-                        {
-                            fvec res = c->TestMulti(testSamples[i]);
-                            if(res.size() == 1)
-                            {
-                                bBinary = true;
-                                // we use invError because we don't know in which order the classifier
-                                // has learned the classes, and which has become the de facto positive class
-                                if(res[0] * testBinLabels[i] < 0) error += 1.f;
-                                else invError += 1.f;
-                                rocdata.push_back(f32pair(res[0], (testBinLabels[i]+1)/2));
-                            }
-                            else
-                            {
-
-                                int winner = 0;
-                                float score = res[0];
-                                FOR(j, res.size())
-                                {
-                                    if(res[j] > score)
-                                    {
-                                        score = res[j];
-                                        winner = j;
-                                    }
-                                }
-                                if(winner != testLabels[i]) error += 1.f;
-                                rocdata.push_back(f32pair(winner, testLabels[i]));
-                            }
-                        }
-                        else
-                        {
-                            bBinary = true;
-                            float res = c->Test(testSamples[i]);
-                            if(res * testBinLabels[i] < 0) error += 1.f;
-                            else invError += 1.f;
-                            rocdata.push_back(f32pair(res, (testBinLabels[i]+1)/2));
-                        }
-                    }
-                    rocdata = FixRocData(rocdata);
-                    if(bBinary) error = min(error, invError);
-                    error /= testSamples.size();
-                    measure1[f] = error;
-                    // we use micro f-measure for multi-class
-                    float eff = bBinary ? GetRocValueAt(rocdata, 0) : GetMicroMacroFMeasure(rocdata).first;
-                    measure2[f] = eff;
-                    DEL(c);
-                }
-                else if(clusterer);
-                else if(regressor)
-                {
-                    if(!samples.size()) return;
-                    Regressor *r = regressor->GetRegressor();
-                    regressor->SetParams(r, params);
-                    int outputDim = samples[0].size()-1;
-                    r->SetOutputDim(outputDim);
-                    r->Train(trainSamples, trainLabels);
-                    float error = 0;
-                    FOR(i, testSamples.size())
-                    {
-                        fvec res = r->Test(testSamples[i]);
-                        // we compute the mse
-                        error += sqrtf((res[0] - trainSamples[i][outputDim])*(res[0] - trainSamples[i][outputDim]));
-                    }
-                    error /= testSamples.size();
-                    measure1[f] = error;
-                    delete r;
-                }
-                else if(dynamical);
-                else if(avoider);
-                else if(maximizer)
-                {
-                    fvec startingPoint(2);
-                    if(canvas->targets.size())
-                    {
-                        startingPoint = canvas->targets.back();
-                        QPointF starting = canvas->toCanvasCoords(startingPoint);
-                        startingPoint[0] = starting.x()/w;
-                        startingPoint[1] = starting.y()/h;
-                    }
-                    else
-                    {
-                        startingPoint[0] = drand48();
-                        startingPoint[1] = drand48();
-                    }
-                    Maximizer *m = maximizer->GetMaximizer();
-                    maximizer->SetParams(m, params);
-                    m->maxAge = 500;
-                    m->stopValue = 0.99;
-                    //data = canvas->data->GetReward()->GetRewardFloat();
-                    m->Train(rewardData, fVec(w,h), startingPoint);
-                    m->age = 0;
-                    // and now we test for a while
-                    do
-                    {
-                        m->Test(m->Maximum());
-                        m->age++;
-                    }
-                    while(m->age < m->maxAge && m->MaximumValue() < m->stopValue);
-                    int iterations = m->age;
-                    float maxVal = m->MaximumValue();
-                    float evals = m->Evaluations();
-                    measure1[f] = iterations;
-                    measure2[f] = maxVal;
-                    measure3[f] = evals;
-                    delete m;
-                }
-                else if(reinforcement)
-                    ;
-                else if(projector)
-                    ;
-            }
-            // now we fill the error map
-            float measure1Mean = 0, measure2Mean = 0, measure3Mean = 0;
-            FOR(f, folds)
-            {
-                measure1Mean += measure1[f];
-                measure2Mean += measure2[f];
-                measure3Mean += measure3[f];
-            }
-            measure1Mean /= folds;
-            measure2Mean /= folds;
-            measure3Mean /= folds;
-            //qDebug() << "mean" << mean << "fmeasure" << effMean;
-            measure1Map[x+y*xSteps] = measure1Mean;
-            measure2Map[x+y*xSteps] = measure2Mean;
-            measure3Map[x+y*xSteps] = measure3Mean;
-            ui->progressBar->setValue(x+y*xSteps);
-            ui->progressBar->repaint();
-            qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
+            cellParams[x+y*xSteps] = params;
         }
     }
-    KILL(perm);
-    KILL(rewardData);
 
+    // the maps are filled as the folds come in, the cells not evaluated yet hold nan
+    const float nan = numeric_limits<float>::quiet_NaN();
+    mapList.clear();
+    measureNames.clear();
     if(classifier)
     {
-        mapList["Error"] = measure1Map;
-        mapList["FMeasure"] = measure2Map;
-        map = measure1Map;
+        measureNames.push_back("Error");
+        measureNames.push_back("FMeasure");
     }
     else if(regressor)
     {
-        mapList["Error"] = measure1Map;
+        measureNames.push_back("Error");
     }
     else if(maximizer)
     {
-        mapList["Iterations"] = measure1Map;
-        mapList["End Value"] = measure2Map;
-        mapList["Evaluations"] = measure3Map;
+        measureNames.push_back("Iterations");
+        measureNames.push_back("End Value");
+        measureNames.push_back("Evaluations");
+    }
+    // the candidates are ranked by their error, or by the value the maximizers reach
+    primaryMeasure = maximizer ? 1 : 0;
+    bMinimizePrimary = !maximizer;
+    surrogateMap = QString();
+    if(ui->searchCombo->currentIndex() == 2 && measureNames.size())
+    {
+        // the bayesian optimization fills a single map, with the mean of its surrogate
+        surrogateMap = measureNames[primaryMeasure] + " (surrogate)";
+        mapList[surrogateMap] = fvec(cellCount, nan);
     }
+    else
+    {
+        FOR(i, measureNames.size()) mapList[measureNames[i]] = fvec(cellCount, nan);
+    }
+    foldResults = fvec(cellCount*folds*3, nan);
+    cellFraction = fvec(cellCount, 1.f);
+    cellBudget = fvec(cellCount, 0.f);
     bool bSig = ui->resultCombo->blockSignals(true);
     ui->resultCombo->clear();
     for(std::map<QString,fvec>::iterator it = mapList.begin(); it != mapList.end(); it++)
@@ -650,13 +778,460 @@ void GridSearch::Run()
     ui->resultCombo->blockSignals(bSig);
     mapX = xSteps;
     mapY = ySteps;
+    map = fvec();
+    if(surrogateMap.size())
+    {
+        StartOptimization(oldParams);
+        return;
+    }
+
+    // successive halving starts with every cell on a small share of the evaluation, and gives
+    // eta times more of it to the best 1/eta of the cells at every rung, the last rung gets all of it.
+    // The share is taken in folds first, then in training rows once a single fold is left
+    rungs.clear();
+    candidates.resize(cellCount);
+    FOR(i, cellCount) candidates[i] = i;
+    if(ui->searchCombo->currentIndex() == 1 && measureNames.size() && cellCount > 1)
+    {
+        const int eta = 3;
+        int last = 0;
+        while(last < 4 && powf(eta, last+1) <= cellCount) last++;
+        // we keep enough training samples to learn something from
+        float minFraction = min(1.f, 20.f / max(1, trainCount));
+        FOR(k, last+1)
+        {
+            float share = folds * powf(eta, (int)k - last);
+            GridSearchRung r;
+            r.candidates = max(1, (int)ceilf(cellCount / powf(eta, k)));
+            r.folds = max(1, min(folds, (int)(share + 0.5f)));
+            r.fraction = max(minFraction, min(1.f, share));
+            rungs.push_back(r);
+        }
+    }
+    else
+    {
+        GridSearchRung r = {cellCount, folds, 1.f};
+        rungs.push_back(r);
+    }
+    // folds evaluated on the same share of the training rows carry over to the next rung
+    int jobCount = 0;
+    FOR(k, rungs.size())
+    {
+        bool bCarried = k && rungs[k].fraction == rungs[k-1].fraction;
+        jobCount += rungs[k].candidates*(rungs[k].folds - (bCarried ? rungs[k-1].folds : 0));
+    }
+    evaluatedCount = 0;
+    ui->progressBar->setMaximum(max(1, jobCount));
+    ui->progressBar->setValue(0);
+    SetRunning(true);
+    DisplayResults();
+    displayTime.start();
+    rung = 0;
+    StartRung();
+}
+
+// the models are created here as the interfaces read their parameters from the gui
+GridSearchJob GridSearch::CreateJob(int cell, int fold, float fraction)
+{
+    GridSearchJob job(cell, fold, fraction);
+    const fvec &params = cellParams[cell];
+    if(classifier)
+    {
+        job.classifier = classifier->GetClassifier();
+        classifier->SetParams(job.classifier, params);
+    }
+    else if(regressor)
+    {
+        job.regressor = regressor->GetRegressor();
+        regressor->SetParams(job.regressor, params);
+        job.regressor->SetOutputDim(searchData->samples.Cols()-1);
+    }
+    else if(maximizer)
+    {
+        fvec startingPoint(2);
+        if(canvas->targets.size())
+        {
+            startingPoint = canvas->targets.back();
+            QPointF starting = canvas->toCanvasCoords(startingPoint);
+            startingPoint[0] = starting.x()/searchData->w;
+            startingPoint[1] = starting.y()/searchData->h;
+        }
+        else
+        {
+            startingPoint[0] = drand48();
+            startingPoint[1] = drand48();
+        }
+        job.maximizer = maximizer->GetMaximizer();
+        maximizer->SetParams(job.maximizer, params);
+        job.startingPoint = startingPoint;
+    }
+    return job;
+}
+
+void GridSearch::StartRung()
+{
+    const GridSearchRung &r = rungs[rung];
+    const float nan = numeric_limits<float>::quiet_NaN();
+    vector<GridSearchJob> jobs;
+    FOR(i, candidates.size())
+    {
+        int cell = candidates[i];
+        // results obtained on another share of the training rows are not comparable, the cell starts over
+        if(cellFraction[cell] != r.fraction)
+        {
+            FOR(j, searchFolds*3) foldResults[cell*searchFolds*3 + j] = nan;
+            cellFraction[cell] = r.fraction;
+        }
+        FOR(f, r.folds)
+        {
+            float result = foldResults[(cell*searchFolds + f)*3];
+            if(result == result) continue; // evaluated in a previous rung
+            jobs.push_back(CreateJob(cell, f, r.fraction));
+        }
+    }
+    searchThread->Evaluate(searchData, jobs);
+}
+
+void GridSearch::UpdateCell(int cell)
+{
+    float sums[3] = {0, 0, 0};
+    int count = 0;
+    FOR(f, searchFolds)
+    {
+        const float *results = &foldResults[(cell*searchFolds + f)*3];
+        if(results[0] != results[0]) continue;
+        FOR(m, 3) sums[m] += results[m];
+        count++;
+    }
+    cellBudget[cell] = count * cellFraction[cell] / searchFolds;
+    FOR(i, min((int)measureNames.size(), 3))
+    {
+        mapList[measureNames[i]][cell] = count ? sums[i] / count : numeric_limits<float>::quiet_NaN();
+    }
+}
+
+void GridSearch::Evaluated(int cell, int fold, float measure1, float measure2, float measure3)
+{
+    if(optimizer)
+    {
+        TrialEvaluated(cell, fold, measure1, measure2, measure3);
+        return;
+    }
+    if(!searchData || cell >= cellBudget.size() || fold >= searchFolds) return;
+    float *results = &foldResults[(cell*searchFolds + fold)*3];
+    results[0] = measure1;
+    results[1] = measure2;
+    results[2] = measure3;
+    UpdateCell(cell);
+    ui->progressBar->setValue(++evaluatedCount);
+    // redrawing the map for every fold would slow large grids down, a few times per second is enough
+    if(displayTime.elapsed() < 250) return;
+    displayTime.restart();
     DisplayResults();
+    repaint();
+}
+
+void GridSearch::Finished()
+{
+    if(searchThread->isRunning() || !searchData) return;
+    if(optimizer)
+    {
+        UpdateSurrogateMap();
+        DEL(optimizer);
+    }
+    if(!searchThread->IsCanceled() && rung+1 < (int)rungs.size())
+    {
+        // the best candidates of this rung go on to the next one, the cells that failed go last
+        const fvec &measure = mapList[measureNames[primaryMeasure]];
+        vector< pair<float,int> > ranking(candidates.size());
+        FOR(i, candidates.size())
+        {
+            float value = measure[candidates[i]];
+            if(value != value) value = numeric_limits<float>::max();
+            else if(!bMinimizePrimary) value = -value;
+            ranking[i] = make_pair(value, candidates[i]);
+        }
+        sort(ranking.begin(), ranking.end());
+        rung++;
+        candidates.resize(min((int)candidates.size(), rungs[rung].candidates));
+        FOR(i, candidates.size()) candidates[i] = ranking[i].second;
+        DisplayResults();
+        repaint();
+        StartRung();
+        return;
+    }
+    DEL(searchData);
+    SetRunning(false);
+    DisplayResults();
+    ui->progressBar->setValue(0);
+    repaint();
+}
+
+float GridSearchDimension::Value(const float u) const
+{
+    if(levels > 0) return low + min(levels-1, max(0, (int)(u*levels)));
+    if(bLog) return low*powf(high/low, u);
+    return low + u*(high-low);
+}
+
+float GridSearchDimension::Coordinate(const float value) const
+{
+    float u = 0.5f;
+    if(levels > 0) u = ((int)(value - low + 0.5f) + 0.5f) / levels;
+    else if(bLog && value > 0) u = logf(value/low) / logf(high/low);
+    else if(high > low) u = (value - low) / (high - low);
+    return min(1.f, max(0.f, u));
+}
+
+// bounds given by GetParameterList, some of them are written with a trailing f
+static float parameterBound(const vector<QString> &values, const int index, const float fallback)
+{
+    if(index >= (int)values.size()) return fallback;
+    QString text = values[index].trimmed();
+    if(text.endsWith('f')) text.chop(1);
+    bool bOk = false;
+    float value = text.toFloat(&bOk);
+    return bOk ? value : fallback;
+}
+
+vector<GridSearchDimension> GridSearch::SearchDimensions(const fvec &params)
+{
+    vector<GridSearchDimension> dims;
+    fPair ranges = GetParamsRange();
+    int displayed[2] = {ui->names1Combo->currentIndex(), ui->names2Combo->currentIndex()};
+    float lows[2] = {ranges.first.first, ranges.second.first};
+    float highs[2] = {ranges.first.second, ranges.second.second};
+    mapDimensions = ivec(2, -1);
+    // the displayed parameters are searched over the ranges of the grid
+    FOR(k, 2)
+    {
+        int i = displayed[k];
+        if(i < 0 || i >= (int)names.size() || i >= (int)params.size() || (k && i == displayed[0])) continue;
+        GridSearchDimension d = {i, 0, min(lows[k], highs[k]), max(lows[k], highs[k]), false};
+        if(types[i] == "List")
+        {
+            d.low = 0;
+            d.levels = values[i].size();
+            d.high = d.levels-1;
+        }
+        else if(types[i] == "Integer")
+        {
+            d.low = ceilf(d.low);
+            d.high = floorf(d.high);
+            d.levels = (int)(d.high - d.low) + 1;
+        }
+        if(d.levels == 1 || d.high <= d.low) continue;
+        mapDimensions[k] = dims.size();
+        dims.push_back(d);
+    }
+    if(!ui->tuneAllCheck->isChecked()) return dims;
+
+    // the others are searched around the value they have in the algorithm options
+    FOR(i, names.size())
+    {
+        if((int)i == displayed[0] || (int)i == displayed[1] || i >= params.size()) continue;
+        float current = params[i];
+        float lower = parameterBound(values[i], 0, -FLT_MAX), upper = parameterBound(values[i], 1, FLT_MAX);
+        GridSearchDimension d = {(int)i, 0, 0, 0, false};
+        if(types[i] == "List")
+        {
+            d.levels = values[i].size();
+            d.high = d.levels-1;
+        }
+        else if(types[i] == "Integer")
+        {
+            float a = floorf(current*0.5f), b = ceilf(current*2.f + 1.f);
+            d.low = max(ceilf(lower), min(a, b));
+            d.high = min(floorf(upper), max(a, b));
+            d.levels = (int)(d.high - d.low) + 1;
+        }
+        else if(current > 0)
+        {
+            d.low = max(lower, current*0.1f);
+            d.high = min(upper, current*10.f);
+            d.bLog = d.low > 0;
+        }
+        else
+        {
+            d.low = max(lower, current - 1.f);
+            d.high = min(upper, current + 1.f);
+        }
+        if(d.levels == 1 || d.high <= d.low) continue;
+        dims.push_back(d);
+    }
+    return dims;
+}
+
+// value of the parameter shown along axis (0 for x, 1 for y) at a step of the map, and the reverse
+float GridSearch::MapValue(int axis, int step)
+{
+    const GridSearchDimension &d = dimensions[mapDimensions[axis]];
+    int steps = axis ? mapY : mapX;
+    float low = axis ? mapRanges.second.first : mapRanges.first.first;
+    float high = axis ? mapRanges.second.second : mapRanges.first.second;
+    if(d.levels && types[d.param] == "List") return min(d.levels-1, step*d.levels/max(1, steps));
+    return steps > 1 ? step / (float)(steps-1) * (high - low) + low : low;
+}
+
+float GridSearch::MapCell(int axis, float value)
+{
+    const GridSearchDimension &d = dimensions[mapDimensions[axis]];
+    int steps = axis ? mapY : mapX;
+    float low = axis ? mapRanges.second.first : mapRanges.first.first;
+    float high = axis ? mapRanges.second.second : mapRanges.first.second;
+    if(d.levels && types[d.param] == "List") return value * steps / d.levels;
+    return high != low ? (value - low) / (high - low) * (steps-1) : 0;
+}
+
+void GridSearch::StartOptimization(const fvec &params)
+{
+    mapRanges = GetParamsRange();
+    dimensions = SearchDimensions(params);
+    if(!dimensions.size())
+    {
+        DEL(searchData);
+        return;
+    }
+    baseParams = params;
+    ivec levels(dimensions.size());
+    FOR(d, dimensions.size()) levels[d] = dimensions[d].levels;
+    DEL(optimizer);
+    optimizer = new BayesianOptimizer(levels, rand());
+    rungs.clear();
+    rung = 0;
+    trialPoints.clear();
+    trialFolds.clear();
+    trialCells.clear();
+    observedTrials.clear();
+    cellParams.clear();
+    foldResults.clear();
+    cellBudget.clear();
+    trialBudget = ui->evaluationsSpin->value();
+    trialsStarted = trialsRunning = 0;
+    // enough configurations to keep every thread busy, and one more waiting for them
+    // a maximizer runs alone, so that nothing draws from drand48 while it does
+    trialsConcurrent = maximizer ? 1 : (ThreadCount() + searchFolds - 1) / searchFolds + 1;
+
+    // the surrogate starts from a latin hypercube, the configurations after it are proposed one by one
+    int initialCount = min(trialBudget, max(trialsConcurrent, max(5, 2*(int)dimensions.size())));
+    vector<fvec> design = optimizer->InitialDesign(initialCount);
+    vector<GridSearchJob> jobs;
+    FOR(i, design.size()) StartTrial(design[i], jobs);
+    evaluatedCount = 0;
+    ui->progressBar->setMaximum(max(1, trialBudget*searchFolds));
     ui->progressBar->setValue(0);
+    ui->displayLabel->setToolTip(QString());
+    SetRunning(true);
+    DisplayResults();
+    displayTime.start();
+    searchThread->Evaluate(searchData, jobs, true);
+}
+
+void GridSearch::StartTrial(const fvec &point, vector<GridSearchJob> &jobs)
+{
+    int trial = trialPoints.size();
+    fvec params = baseParams;
+    FOR(d, dimensions.size()) params[dimensions[d].param] = dimensions[d].Value(point[d]);
+    trialPoints.push_back(point);
+    cellParams.push_back(params);
+    trialFolds.push_back(0);
+    foldResults.resize(trialPoints.size()*searchFolds*3, numeric_limits<float>::quiet_NaN());
+    FOR(f, searchFolds) jobs.push_back(CreateJob(trial, f, 1.f));
+    trialsStarted++;
+    trialsRunning++;
+}
+
+void GridSearch::TrialEvaluated(int trial, int fold, float measure1, float measure2, float measure3)
+{
+    if(trial >= (int)trialPoints.size() || fold >= searchFolds) return;
+    float *results = &foldResults[(trial*searchFolds + fold)*3];
+    results[0] = measure1;
+    results[1] = measure2;
+    results[2] = measure3;
+    ui->progressBar->setValue(++evaluatedCount);
+    if(++trialFolds[trial] < searchFolds) return;
+
+    // the configuration is complete, the optimizer minimizes the mean of its folds
+    trialsRunning--;
+    float value = 0;
+    FOR(f, searchFolds) value += foldResults[(trial*searchFolds + f)*3 + primaryMeasure] / searchFolds;
+    optimizer->AddObservation(trialPoints[trial], bMinimizePrimary ? value : -value);
+    observedTrials.push_back(trial);
+    const fvec &params = cellParams[trial];
+    QPointF cell(0, 0);
+    if(mapDimensions[0] >= 0) cell.setX(MapCell(0, params[dimensions[mapDimensions[0]].param]));
+    if(mapDimensions[1] >= 0) cell.setY(MapCell(1, params[dimensions[mapDimensions[1]].param]));
+    trialCells.resize(trialPoints.size(), QPointF(-1, -1));
+    trialCells[trial] = cell;
+
+    // a new configuration takes its place, knowing which ones are still being evaluated
+    vector<GridSearchJob> jobs;
+    while(trialsStarted < trialBudget && trialsRunning < trialsConcurrent && !searchThread->IsCanceled())
+    {
+        vector<fvec> pending;
+        FOR(i, trialPoints.size())
+        {
+            if(trialFolds[i] < searchFolds) pending.push_back(trialPoints[i]);
+        }
+        StartTrial(optimizer->Propose(pending), jobs);
+    }
+    if(jobs.size()) searchThread->Append(jobs);
+    if(!trialsRunning) searchThread->Close();
+
+    if(displayTime.elapsed() < 250 && trialsRunning) return;
+    displayTime.restart();
+    UpdateSurrogateMap();
+    DisplayResults();
     repaint();
 }
 
+void GridSearch::UpdateSurrogateMap()
+{
+    int best = optimizer ? optimizer->Best() : -1;
+    if(best < 0) return;
+    // the map is a slice of the surrogate through the best configuration so far
+    fvec point = optimizer->Point(best);
+    fvec &surrogate = mapList[surrogateMap];
+    surrogate.resize(mapX*mapY);
+    FOR(y, mapY)
+    {
+        FOR(x, mapX)
+        {
+            if(mapDimensions[0] >= 0) point[mapDimensions[0]] = dimensions[mapDimensions[0]].Coordinate(MapValue(0, x));
+            if(mapDimensions[1] >= 0) point[mapDimensions[1]] = dimensions[mapDimensions[1]].Coordinate(MapValue(1, y));
+            float mean = optimizer->Mean(point);
+            surrogate[x + y*mapX] = bMinimizePrimary ? mean : -mean;
+        }
+    }
+
+    // the other parameters are not on the map, the best configuration is listed instead
+    int trial = observedTrials[best];
+    QString text = QString("Best %1: %2").arg(measureNames[primaryMeasure]).arg(bMinimizePrimary ? optimizer->Value(best) : -optimizer->Value(best));
+    FOR(d, dimensions.size())
+    {
+        int i = dimensions[d].param;
+        float value = cellParams[trial][i];
+        if(types[i] == "List") text += QString("\n%1: %2").arg(names[i]).arg(values[i][(int)value]);
+        else text += QString("\n%1: %2").arg(names[i]).arg(value);
+    }
+    ui->displayLabel->setToolTip(text);
+}
+
+void GridSearch::SetRunning(bool bRunning)
+{
+    ui->runButton->setText(bRunning ? "Cancel" : "Run");
+    ui->names1Combo->setEnabled(!bRunning);
+    ui->names2Combo->setEnabled(!bRunning);
+    ui->foldSpin->setEnabled(!bRunning);
+    ui->searchCombo->setEnabled(!bRunning);
+    ui->evaluationsSpin->setEnabled(!bRunning && ui->searchCombo->currentIndex() == 2);
+    ui->tuneAllCheck->setEnabled(!bRunning && ui->searchCombo->currentIndex() == 2);
+}
+
 void GridSearch::OptionsChanged()
 {
+    ui->evaluationsSpin->setEnabled(ui->searchCombo->currentIndex() == 2);
+    ui->tuneAllCheck->setEnabled(ui->searchCombo->currentIndex() == 2);
     int index1 = ui->names1Combo->currentIndex();
     int index2 = ui->names2Combo->currentIndex();
     if(index1 < types.size())
@@ -737,6 +1312,8 @@ void GridSearch::OptionsChanged()
 
 void GridSearch::Update()
 {
+    // the search in progress was set up for the previous algorithm
+    searchThread->Cancel();
     names.clear();
     types.clear();
     values.clear();
@@ -4,9 +4,18 @@
 #include <QWidget>
 #include "basewidget.h"
 #include <QLabel>
+#include <QTime>
 #include <QList>
+#include <QThread>
 #include <vector>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include "interfaces.h"
+#include "bayesianOptimizer.h"
+#include "foldIndex.h"
+#include "gramCache.h"
 
 namespace Ui {
 class GridSearch;
@@ -25,6 +34,84 @@ signals:
 };
 
 typedef std::pair< std::pair<float,float>, std::pair<float,float> > fPair;
+
+// everything the evaluations of a grid search read: built once on the gui thread
+// and shared, untouched, by all the cells and folds while they are evaluated
+struct GridSearchData
+{
+    SampleMatrix samples;
+    ivec labels, binLabels;
+    FoldIndex folds; // rows of samples used by each fold
+    GramCache *gram; // kernel matrices of samples, shared by the kernel methods of every cell and fold
+    float *rewardData;
+    int w, h;
+    GridSearchData() : gram(0), rewardData(0), w(0), h(0){}
+    ~GridSearchData(){DEL(gram); KILL(rewardData);}
+};
+
+// training and testing of one model, for one cell of the grid and one fold
+// the model is created and parametrized on the gui thread, as the interfaces read their widgets
+struct GridSearchJob
+{
+    int cell, fold;
+    float fraction; // share of the training rows of the fold the model is trained on
+    Classifier *classifier;
+    Regressor *regressor;
+    Maximizer *maximizer;
+    fvec startingPoint;
+    GridSearchJob(int cell=0, int fold=0, float fraction=1.f) : cell(cell), fold(fold), fraction(fraction), classifier(0), regressor(0), maximizer(0){}
+};
+
+// evaluates the jobs of a grid search on a pool of worker threads, away from the gui thread
+// the measures of each job are sent as soon as it is done
+class GridSearchThread : public QThread
+{
+    Q_OBJECT
+public:
+    GridSearchThread(QObject *parent=0) : QThread(parent), data(0), bOpen(false), bSerial(false), bCanceled(false){}
+    // the thread deletes the models of the jobs once it is done with them
+    // an open search waits for more jobs when it runs out of them, until it is closed
+    void Evaluate(const GridSearchData *data, std::vector<GridSearchJob> jobs, bool bOpen=false);
+    void Append(std::vector<GridSearchJob> jobs);
+    void Close();
+    void Cancel();
+    bool IsCanceled() const {return bCanceled;}
+
+signals:
+    void Evaluated(int cell, int fold, float measure1, float measure2, float measure3);
+
+protected:
+    void run();
+
+private:
+    const GridSearchData *data;
+    std::deque<GridSearchJob> jobs;
+    bool bOpen, bSerial;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::atomic<bool> bCanceled;
+};
+
+// one round of successive halving: the candidates left are evaluated on a share of the folds
+// (and of the training rows once a single fold is left) and the best of them go to the next round
+struct GridSearchRung
+{
+    int candidates;
+    int folds;
+    float fraction;
+};
+
+// a parameter searched by the bayesian optimization, mapped onto the unit interval
+struct GridSearchDimension
+{
+    int param;
+    int levels; // number of values of integer and list parameters, 0 for real ones
+    float low, high;
+    bool bLog; // real parameters spanning orders of magnitude are searched on a log scale
+    float Value(const float u) const;
+    float Coordinate(const float value) const;
+};
+
 class GridSearch : public BaseWidget
 {
     Q_OBJECT
@@ -44,6 +131,36 @@ private:
     std::vector< std::vector<QString> > values;
     fvec map;
     std::map<QString,fvec> mapList;
+    std::vector<QString> measureNames; // maps filled by the current search, in the order of the measures
+    int primaryMeasure; // measure the candidates are ranked by
+    bool bMinimizePrimary;
+
+    // state of the search in progress
+    GridSearchThread *searchThread;
+    GridSearchData *searchData;
+    int searchFolds;
+    std::vector<fvec> cellParams; // parameters of each cell of the grid
+    fvec foldResults; // measure m of cell c on fold f at ((c*folds)+f)*3+m, nan until evaluated
+    fvec cellFraction; // share of the training rows the results of each cell come from
+    fvec cellBudget; // share of the complete evaluation (all folds, all rows) each cell has had
+    std::vector<GridSearchRung> rungs;
+    int rung;
+    ivec candidates; // cells evaluated in the current rung
+
+    // state of the bayesian optimization, its configurations are indexed like the cells of the grid
+    BayesianOptimizer *optimizer;
+    std::vector<GridSearchDimension> dimensions;
+    fvec baseParams; // values of the parameters that are not searched
+    std::vector<fvec> trialPoints; // each configuration in the unit hypercube of the dimensions
+    ivec trialFolds; // folds evaluated for each configuration
+    std::vector<QPointF> trialCells; // where the configurations fall on the map
+    ivec observedTrials; // configuration behind each observation of the optimizer
+    int trialBudget, trialsStarted, trialsRunning, trialsConcurrent;
+    QString surrogateMap; // map holding the mean of the surrogate, empty for the other searches
+    ivec mapDimensions; // dimensions shown along x and y, -1 for none
+    fPair mapRanges;
+    int evaluatedCount;
+    QTime displayTime;
     QPixmap pixmap;
     int mapX;
     int mapY;
@@ -60,6 +177,17 @@ protected:
 private:
     fPair GetParamsRange();
     void DisplayResults();
+    void SetRunning(bool bRunning);
+    GridSearchJob CreateJob(int cell, int fold, float fraction);
+    void StartRung();
+    void UpdateCell(int cell);
+    std::vector<GridSearchDimension> SearchDimensions(const fvec &params);
+    float MapValue(int axis, int step);
+    float MapCell(int axis, float value);
+    void StartOptimization(const fvec &params);
+    void StartTrial(const fvec &point, std::vector<GridSearchJob> &jobs);
+    void TrialEvaluated(int trial, int fold, float measure1, float measure2, float measure3);
+    void UpdateSurrogateMap();
 
 signals:
     void Hiding();
@@ -70,6 +198,8 @@ public slots:
     void OptionsChanged();
     void DisplayChanged();
     void Run();
+    void Evaluated(int cell, int fold, float measure1, float measure2, float measure3);
+    void Finished();
     void Clipboard();
     void Update();
     void SetClassifier(ClassifierInterface *c);
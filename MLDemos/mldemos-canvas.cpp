@@ -34,7 +34,7 @@ void MLDemos::FitToData()
     viewOptions->spinZoom->setValue(zoom);
     viewOptions->spinZoom->blockSignals(false);
     drawTimer->Stop();
-    drawTimer->Clear();
+    drawTimer->ViewChanged();
     drawTimer->inputDims = algo->GetInputDimensions();
     if (!canvas->canvasType) {
         QMutexLocker lock(&mutex);
@@ -68,7 +68,7 @@ void MLDemos::CanvasMoveEvent()
 {
     if (canvas->canvasType) return;
     drawTimer->Stop();
-    drawTimer->Clear();
+    drawTimer->ViewChanged();
     algo->UpdateLearnedModel();
     drawTimer->inputDims = algo->GetInputDimensions();
     QMutexLocker lock(&mutex);
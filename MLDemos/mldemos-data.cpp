@@ -224,6 +224,29 @@ void MLDemos::SetData(std::vector<fvec> samples, ivec labels, std::vector<ipair>
     canvas->repaint();
 }
 
+void MLDemos::AddData(std::vector<fvec> samples, ivec labels, bool bLast)
+{
+    // used by the importers that send large datasets in several batches after a first SetData
+    // the samples are only appended until the last batch, the view is fitted and redrawn once
+    if (!canvas) return;
+    if (samples.size()) canvas->data->AddSamples(samples, labels);
+    if (!bLast)
+    {
+        if (bImporting) return;
+        bImporting = true;
+        algo->algorithmWidget->setEnabled(false);
+        ui.status->setText("Importing Data...");
+        return;
+    }
+    bImporting = false;
+    algo->algorithmWidget->setEnabled(true);
+    ui.status->setText("Raw Data");
+    FitToData();
+    ManualSelectionUpdated();
+    canvas->ResetSamples();
+    canvas->repaint();
+}
+
 void MLDemos::SetDimensionNames(QStringList headers)
 {
     //qDebug() << "setting dimension names" << headers;
@@ -285,9 +285,7 @@ void MLDemos::Editing(int editType, fvec position, int label)
             {
                 int newLabel = drawToolbar->classSpin->value();
                 selectedData = canvas->SelectSamples(center, radius);
-                FOR (i, selectedData.size()) {
-                    canvas->data->SetLabel(selectedData[i], newLabel);
-                }
+                canvas->data->SetLabels(selectedData, newLabel);
                 selectedData.clear();
                 canvas->sampleColors.clear();
             }
@@ -20,26 +20,34 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "mldemos.h"
 #include "drawSVG.h"
 
+// binary datasets larger than this are streamed from disk instead of being loaded in memory
+static const qint64 streamingThreshold = 1024*1024*1024;
+
 void MLDemos::SaveData()
 {
     if (!canvas) return;
-    QString filename = QFileDialog::getSaveFileName(this, tr("Save Data"), "", tr("ML Files (*.ml)"));
+    QString binaryFilter = tr("ML Binary Files (*.ml)");
+    QString selectedFilter;
+    QString filename = QFileDialog::getSaveFileName(this, tr("Save Data"), "", tr("ML Files (*.ml)") + ";;" + binaryFilter, &selectedFilter);
     if (filename.isEmpty()) return;
     if (!filename.endsWith(".ml")) filename += ".ml";
-    Save(filename);
+    Save(filename, selectedFilter == binaryFilter);
 }
-void MLDemos::Save(QString filename)
+void MLDemos::Save(QString filename, bool bBinary)
 {
-    QFile file(filename);
-    if (!file.open(QIODevice::WriteOnly)) {
-        ui.statusBar->showMessage("WARNING: Unable to save file");
+    const DatasetStream *stream = canvas->data->GetStream();
+    if (stream && QFileInfo(filename).canonicalFilePath() == QFileInfo(stream->GetFilename().c_str()).canonicalFilePath()) {
+        ui.statusBar->showMessage("WARNING: Unable to save over the dataset being streamed");
         return;
     }
-    file.close();
     if (!canvas->maps.reward.isNull()) RewardFromMap(canvas->maps.reward.toImage());
-    canvas->data->Save(filename.toLatin1());
+    if (!canvas->data->Save(filename.toLatin1(), bBinary)) {
+        ui.statusBar->showMessage("WARNING: Unable to save file");
+        return;
+    }
     SaveParams(filename);
-    ui.statusBar->showMessage("Data saved successfully");
+    if (stream) ui.statusBar->showMessage("Only the subset of the streamed dataset was saved");
+    else ui.statusBar->showMessage("Data saved successfully");
 }
 
 void MLDemos::LoadData()
@@ -58,9 +66,15 @@ void MLDemos::Load(QString filename)
         ui.statusBar->showMessage("WARNING: Unable to open file");
         return;
     }
+    qint64 fileSize = file.size();
     file.close();
     ClearData();
-    canvas->data->Load(filename.toLatin1());
+    // text and binary datasets are told apart by the data manager
+    if(fileSize > streamingThreshold && DatasetManager::IsBinaryFile(filename.toLatin1()))
+    {
+        canvas->data->LoadStream(filename.toLatin1());
+    }
+    else canvas->data->Load(filename.toLatin1());
     MapFromReward();
     LoadParams(filename);
     //    QImage reward(filename + "-reward.png");
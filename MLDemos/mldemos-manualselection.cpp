@@ -83,22 +83,23 @@ void MLDemos::ManualSelectionRemove()
     if (!canvas || !canvas->data->GetCount()) return;
     QList<QListWidgetItem*> selected = manualSelection->sampleList->selectedItems();
     if (!selected.size()) return;
-    ivec removeList(selected.count());
+    bvec removeMask(canvas->data->GetCount(), false);
     FOR (i, selected.count())
     {
-        removeList[i] = manualSelection->sampleList->row(selected[i]);
+        int index = manualSelection->sampleList->row(selected[i]);
+        if (index >= 0 && index < removeMask.size()) removeMask[index] = true;
     }
-    canvas->data->RemoveSamples(removeList);
-    if (canvas->sampleColors.size() && removeList.size() < canvas->sampleColors.size())
+    canvas->data->RemoveSamples(removeMask);
+    if (canvas->sampleColors.size() == removeMask.size())
     {
-        int offset = 0;
-        FOR (i, removeList.size())
+        // we compact the sample colors the same way as the samples
+        int count = 0;
+        FOR (i, removeMask.size())
         {
-            int index = i - offset;
-            if (index < 0 || index >= canvas->sampleColors.size()) continue;
-            canvas->sampleColors.erase(canvas->sampleColors.begin()+index);
-            offset++;
+            if (removeMask[i]) continue;
+            canvas->sampleColors[count++] = canvas->sampleColors[i];
         }
+        canvas->sampleColors.erase(canvas->sampleColors.begin()+count, canvas->sampleColors.end());
     }
     ManualSelectionUpdated();
     ManualSelectionChanged();
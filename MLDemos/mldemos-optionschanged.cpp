@@ -58,7 +58,7 @@ void MLDemos::DisplayOptionsChanged()
 
     if (zoom != canvas->GetZoom()) {
         drawTimer->Stop();
-        drawTimer->Clear();
+        drawTimer->ViewChanged();
         drawTimer->inputDims = algo->GetInputDimensions();
         canvas->SetZoom(zoom);
         if (mutex.tryLock()) {
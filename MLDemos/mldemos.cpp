@@ -27,7 +27,8 @@ MLDemos::MLDemos(QString filename, QWidget *parent, Qt::WindowFlags flags)
       bIsCrossNew(true),
       compare(0),
       trajectory(ipair(-1,-1)),
-      bNewObstacle(false)
+      bNewObstacle(false),
+      bImporting(false)
 {
     QApplication::setWindowIcon(QIcon(":/MLDemos/logo.png"));
     ui.setupUi(this);
@@ -107,6 +107,7 @@ private:
 	ipair trajectory;
 	Obstacle obstacle;
 	bool bNewObstacle;
+	bool bImporting; // more batches of the dataset are coming, the algorithms are disabled until the last one
     QString lastTrainingInfo;
 
 	CompareAlgorithms *compare;
@@ -121,7 +122,7 @@ private:
 	void SaveParams(QString filename);
 	void LoadParams(QString filename);
 	void Load(QString filename);
-	void Save(QString filename);
+	void Save(QString filename, bool bBinary=false);
     void ImportData(QString filename);
 
     std::vector<bool> GetManualSelection();
@@ -140,6 +141,7 @@ public:
 
 public slots:
     void SetData(std::vector<fvec> samples, ivec labels, std::vector<ipair> trajectories, bool bProjected);
+    void AddData(std::vector<fvec> samples, ivec labels, bool bLast);
 	void SetTimeseries(std::vector<TimeSerie> timeseries);
     void SetDimensionNames(QStringList headers);
     void SetClassNames(std::map<int,QString> classNames);
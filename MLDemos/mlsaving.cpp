@@ -465,7 +465,8 @@ void MLDemos::SaveParams( QString filename )
     QTextStream out(&file);
     if(!file.isOpen()) return;
 
-    if(!canvas->data->GetCount()) out << "0 2\n";
+    // binary datasets get an empty sample header so that LoadParams can skip straight to the parameters
+    if(!canvas->data->GetCount() || DatasetManager::IsBinaryFile(filename.toLatin1())) out << "0 2\n";
     char groupName[255];
 
     if(canvas->dimNames.size())
@@ -631,6 +632,8 @@ void MLDemos::LoadParams( QString filename )
 {
     QFile file(filename);
     file.open(QFile::ReadOnly);
+    size_t payloadSize = 0;
+    if(DatasetManager::IsBinaryFile(filename.toLatin1(), &payloadSize)) file.seek(payloadSize);
     QTextStream in(&file);
     if(!file.isOpen()) return;
 
@@ -839,11 +842,11 @@ void MLDemos::ExportOutput()
     {
         //out << "#Sample x (n-dims), Label, Projected x (m-dims)\n";
         vector<fvec> samples = algo->projector->source;
+        vector<fvec> allProjected = algo->projector->ProjectSamples(samples);
         //ivec labels = canvas->data->GetLabels();
         FOR(i, samples.size())
         {
-            fvec &sample = samples[i];
-            fvec projected = algo->projector->Project(sample);
+            fvec &projected = allProjected[i];
             //FOR(d, sample.size()) out << QString("%1,").arg(sample[d]);
             //out << QString("%1").arg(labels[i]);
             FOR(d, projected.size()) out << QString("%1%2").arg(projected[d]).arg(d<projected.size()-1?",":"");
@@ -206,6 +206,7 @@ void PluginManager::AddPlugin(InputOutputInterface *iIO)
     connect(algo, SIGNAL(SendResults(std::vector<fvec>)), iIO->object(), iIO->FetchResultsSlot());
     connect(iIO->object(), iIO->SetDataSignal(), mldemos, SLOT(SetData(std::vector<fvec>, ivec, std::vector<ipair>, bool)));
     connect(iIO->object(), iIO->SetTimeseriesSignal(), mldemos, SLOT(SetTimeseries(std::vector<TimeSerie>)));
+    if(iIO->AddDataSignal()) connect(iIO->object(), iIO->AddDataSignal(), mldemos, SLOT(AddData(std::vector<fvec>, ivec, bool)));
     connect(iIO->object(), iIO->QueryClassifierSignal(), algo, SLOT(QueryClassifier(std::vector<fvec>)));
     connect(iIO->object(), iIO->QueryRegressorSignal(), algo, SLOT(QueryRegressor(std::vector<fvec>)));
     connect(iIO->object(), iIO->QueryDynamicalSignal(), algo, SLOT(QueryDynamical(std::vector<fvec>)));
@@ -235,6 +235,45 @@ fvec DynamicalASVM::Test( const fvec &sample)
     return vel;
 }
 
+void DynamicalASVM::TestBatch(const SampleView &samples, fvec &velocities)
+{
+    int rows = samples.Rows();
+    int dim = samples.Cols();
+    velocities.assign(rows*dim, 0.f);
+    if(!asvms.size() || !dim) return;
+    // same computation as Test, with the buffers allocated once for all the samples
+    fvec sample(dim), sigma(dim*(dim+1)/2), deriv(dim);
+    vector<double> point(dim), derivative(dim);
+    FOR(i, rows)
+    {
+        samples.CopyRow(i, &sample[0]);
+        FOR(d, dim) point[d] = sample[d];
+        double maxScore = -DBL_MAX;
+        int maxIndex = 0;
+        FOR(j, asvms.size())
+        {
+            double score = asvms[j].getclassifiervalue(&point[0]);
+            if(maxScore < score)
+            {
+                maxScore = score;
+                maxIndex = j;
+            }
+        }
+        float *vel = &velocities[i*dim];
+        gmms[maxIndex]->doRegression(&sample[0], vel, &sigma[0]);
+        asvms[maxIndex].getclassifierderivative(&point[0], &derivative[0]);
+        FOR(d, dim) deriv[d] = derivative[d] / resizeFactor;
+        float norm = sqrtf(deriv*deriv);
+        FOR(d, dim) deriv[d] /= norm;
+
+        // here we must combine the derivative from ASVM and the velocity from the DS
+        float dot = 0;
+        FOR(d, dim) dot += vel[d]*deriv[d];
+        float blend = max(epsilon,dot);
+        FOR(d, dim) vel[d] += deriv[d]*(blend - dot);
+    }
+}
+
 fVec DynamicalASVM::Test( const fVec &sample)
 {
     return Test(fvec(sample));
@@ -48,6 +48,7 @@ public:
     fvec Classify( const fvec &sample);
     fvec Test( const fvec &sample);
     fVec Test( const fVec &sample);
+    void TestBatch(const SampleView &samples, fvec &velocities);
     const char *GetInfoString();
     void SaveModel(string filename);
     bool LoadModel(string filename);
@@ -98,7 +98,7 @@ void CCAProjection::DrawInfo(Canvas *canvas, QPainter &painter, Projector *proje
     if(!canvas || !projector) return;
     if(canvas->canvasType) return;
     vector<fvec> samples = projector->source;
-    vector<fvec> projected = projector->projected;
+    vector<fvec> projected = projector->ProjectSamples(samples);
     ivec labels = canvas->data->GetLabels();
     if(!samples.size()) return;
     painter.setRenderHint(QPainter::Antialiasing);
@@ -106,7 +106,6 @@ void CCAProjection::DrawInfo(Canvas *canvas, QPainter &painter, Projector *proje
     QPointF start(FLT_MAX, FLT_MAX), stop(-FLT_MAX, -FLT_MAX);
     FOR(i, samples.size())
     {
-        projected[i] = projector->Project(samples[i]);
         QPointF p1 = canvas->toCanvasCoords(samples[i]);
         QPointF p2 = canvas->toCanvasCoords(projected[i]);
         if(start.x() > p2.x()) start = p2;
@@ -205,6 +205,47 @@ fvec ProjectorCCA::Project(const fvec &sample)
 
 }
 
+int ProjectorCCA::ProjectBatch(const SampleView &samples, fvec &projections)
+{
+    int q = separating_index;
+    int p = samples.Cols() - q;
+    int count = min(p,q);
+    if(count <= 0 || Wx.rows() != q || Wy.rows() != p || Wx.cols() < count || Wy.cols() < count)
+    {
+        return Projector::ProjectBatch(samples, projections);
+    }
+    int rows = samples.Rows();
+    int outputs = count*2;
+    projections.resize((size_t)rows*outputs);
+
+    // both sets are projected one block of samples at a time
+    const int blockRows = 4096;
+    fvec buffer(samples.Cols());
+    for(int start=0; start<rows; start+=blockRows)
+    {
+        int blockCount = min(blockRows, rows-start);
+        MatrixXd x(q, blockCount), y(p, blockCount);
+        FOR(j, blockCount)
+        {
+            samples.CopyRow(start+j, &buffer[0]);
+            FOR(i, q) x(i,j) = buffer[i];
+            FOR(i, p) y(i,j) = buffer[q + i];
+        }
+        MatrixXd newX = Wx.transpose()*x;
+        MatrixXd newY = Wy.transpose()*y;
+        FOR(j, blockCount)
+        {
+            float *projection = &projections[(size_t)(start+j)*outputs];
+            FOR(i, count)
+            {
+                projection[2*i] = newX(i,j);
+                projection[2*i+1] = newY(i,j);
+            }
+        }
+    }
+    return outputs;
+}
+
 std::vector< fvec >& ProjectorCCA::getCLPS(){
     return CLPS;
 }
@@ -20,6 +20,7 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include "public.h"
 #include "clustererDBSCAN.h"
 #include <boost/foreach.hpp>
+#include <algorithm>
 
 using namespace std;
 
@@ -189,6 +190,101 @@ fvec ClustererDBSCAN::Test( const fvec &sample)
     return res;
 }
 
+// same distances as the Metric classes above, computed on raw rows
+static inline double RowDistance(const int metric, const float *a, const float *b, const int dim)
+{
+    double dist = 0;
+    switch(metric)
+    {
+    case 0:
+        FOR(i, dim) {
+            double d = (a[i]-b[i]);
+            dist += d*d;
+        }
+        return dist;
+    case 1:
+        FOR(i, dim) {
+            float d = fabs(a[i]-b[i]);
+            dist += d;
+        }
+        return dist;
+    case 2:
+        FOR(i, dim) {
+            double d = fabs(a[i]-b[i]);
+            if(d > dist) dist = d;
+        }
+        return dist;
+    default:
+        FOR(i, dim) {
+            double d = fabs(a[i]-b[i]);
+            dist += pow(d,2./3.f);
+        }
+        return pow(dist,3.f/2.f);
+    }
+}
+
+fvec ClustererDBSCAN::TestMany(const fvec &sampleMatrix, const int dim, const int count)
+{
+    // the cosine distance is not bounded by the coordinates, it goes through the per-sample test
+    if(_metric < 0 || _metric > 3 || !pts.size() || dim != pts[0].size()) return Clusterer::TestMany(sampleMatrix, dim, count);
+    fvec results;
+    if(sampleMatrix.size() != dim*count) return results;
+    int resDim = nbClusters+1;
+    results.resize(count*resDim, 0);
+
+    float realEps = _eps;
+    if(_metric == 0) realEps = _eps*_eps;
+    if (_type==0) //if DBSCAN we set _depth like _eps
+    {
+        _depth=realEps;
+    }
+
+    // only the core points that belong to a cluster can be picked, we copy them in a flat buffer sorted by
+    // their first coordinate: all the metrics are bounded below by the largest coordinate difference, so
+    // the points closer than eps lie in the slab [x-eps, x+eps]
+    vector< pair<float,int> > order;
+    FOR(j, pts.size())
+    {
+        if(_pointId_to_clusterId[j] > 0 && _core[j]) order.push_back(make_pair(pts[j](0), (int)j));
+    }
+    sort(order.begin(), order.end());
+    int candidateCount = order.size();
+    fvec firsts(candidateCount), candidates(candidateCount*dim);
+    FOR(k, candidateCount)
+    {
+        firsts[k] = order[k].first;
+        FOR(d, dim) candidates[k*dim + d] = pts[order[k].second](d);
+    }
+    float radius = fabs(_eps)*1.001f; // slightly wider to stay on the safe side of rounding
+
+    FOR(i, count)
+    {
+        const float *sample = &sampleMatrix[i*dim];
+        int start = lower_bound(firsts.begin(), firsts.end(), sample[0] - radius) - firsts.begin();
+        int nearest = -1;
+        double dist = INFINITY;
+        for(int k=start; k<candidateCount && firsts[k] <= sample[0] + radius; k++)
+        {
+            double temp_d = RowDistance(_metric, sample, &candidates[k*dim], dim);
+            int j = order[k].second;
+            // ties go to the lowest point index, as in the sequential scan of Test
+            if ((temp_d < dist || (temp_d == dist && j < nearest)) && temp_d < realEps) {
+                dist = temp_d;
+                nearest = j;
+            }
+        }
+        if (nearest > -1) {
+            float *res = &results[i*resDim];
+            if (dist < _depth){ // is it near enough?
+                res[_pointId_to_clusterId[nearest]-1] = 1; //take the color of that cluster
+            } else if (abs(dist - realEps) < realEps*0.01) { //in OPTICS, we are at the border of _eps : draw a thin line, darker
+                res[_pointId_to_clusterId[nearest]-1] = 0.5;
+            }
+        }
+    }
+    return results;
+}
+
 const char *ClustererDBSCAN::GetInfoString()
 {
     char *text = new char[1024];
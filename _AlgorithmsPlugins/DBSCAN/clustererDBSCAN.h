@@ -67,7 +67,11 @@ public:
       The testing function, returns a vector of size nbClusters, with the contribution/weight of the point for each cluster
       */
     fvec Test( const fvec &sample);
-    //fvec TestMany( const fvec &sampleMatrix, const int dim, const int count);
+
+    /**
+      Batch version of Test: the samples are stored row-major in sampleMatrix, the results hold nbClusters+1 values per sample
+      */
+    fvec TestMany( const fvec &sampleMatrix, const int dim, const int count);
 
     /**
       Information string for the Algorithm Information and Statistics panel in the main program interface.
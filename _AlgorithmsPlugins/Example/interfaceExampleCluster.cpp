@@ -101,7 +101,7 @@ void ClustExample::DrawModel(Canvas *canvas, QPainter &painter, Clusterer *clust
     painter.setRenderHint(QPainter::Antialiasing);
 
     // for every point in the current dataset
-    FOR(i, canvas->data->GetSamples().size())
+    FOR(i, canvas->data->GetCount())
 	{
         // we get the sample
         fvec sample = canvas->data->GetSample(i);
@@ -159,6 +159,24 @@ fvec ClustererFlame::Test( const fvec &sample) {
     return res;
 }
 
+fvec ClustererFlame::TestMany(const fvec &sampleMatrix, const int dim, const int count) {
+    fvec results;
+    if (sampleMatrix.size() != dim*count) return results;
+    results.resize(count*nbClusters, 0);
+    // a single lookup per sample, with the key buffer reused across samples
+    fvec sample(dim);
+    for (int i = 0; i < count; i++) {
+        sample.assign(sampleMatrix.begin() + i*dim, sampleMatrix.begin() + (i+1)*dim);
+        boost::unordered_map<fvec, vector<int>, container_hash<fvec> >::const_iterator it = resultMap.find(sample);
+        if (it == resultMap.end()) continue;
+        const vector<int> &indices = it->second;
+        for (int j = 0; j < indices.size(); j++) {
+            results[i*nbClusters + indices[j]] = 1/indices.size();
+        }
+    }
+    return results;
+}
+
 // Not always called properly by the main program :-(
 const char *ClustererFlame::GetInfoString() {
     stringstream s;
@@ -85,6 +85,11 @@ public:
     with the contribution/weight of the point for each cluster */
     fvec Test(const fvec &sample);
 
+    /**
+    Batch version of Test, with nbClusters values per sample
+    (the samples that were not in the training set get zeros) */
+    fvec TestMany(const fvec &sampleMatrix, const int dim, const int count);
+
     /**
     Information string for the Algorithm Information and Statistics
     panel in the main program interface. Here you probably will put
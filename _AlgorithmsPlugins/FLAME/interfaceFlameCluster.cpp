@@ -168,7 +168,7 @@ void ClustFlame::DrawModel(Canvas *canvas, QPainter &painter, Clusterer *cluster
     painter.setRenderHint(QPainter::Antialiasing);
 
     // for every point in the current dataset
-    FOR(i, canvas->data->GetSamples().size())
+    FOR(i, canvas->data->GetCount())
 	{
         // we get the sample
         fvec sample = canvas->data->GetSampleDim(i,canvas->sourceDims);
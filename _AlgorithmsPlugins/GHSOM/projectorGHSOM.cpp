@@ -94,3 +94,11 @@ fvec ProjectorGHSOM::Project(const fvec &sample)
 {
     return sample;
 }
+
+int ProjectorGHSOM::ProjectBatch(const SampleView &samples, fvec &projections)
+{
+    // the map is drawn on top of the data, which stays where it is
+    projections.resize((size_t)samples.Rows()*samples.Cols());
+    if(projections.size()) samples.CopyTo(&projections[0]);
+    return samples.Cols();
+}
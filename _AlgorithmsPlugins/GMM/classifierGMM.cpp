@@ -34,6 +34,8 @@ ClassifierGMM::ClassifierGMM()
 {
 	bSingleClass = false;
 	bMultiClass = true;
+	bThreadSafe = true;
+	bTrainThreadSafe = true;
     bUseClassPriors = false;
 }
 
@@ -136,6 +138,36 @@ fvec ClassifierGMM::TestMulti(const fvec &sample) const
     return pdfMulti;
 }
 
+int ClassifierGMM::TestBatch(const SampleView &samples, fvec &scores) const
+{
+    int rows = samples.Rows();
+    int count = gmms.size();
+    int outputs = count == 2 ? 1 : max(1, count);
+    scores.assign((size_t)rows*outputs, 0.f);
+    if(!count || !rows) return outputs;
+    // same responses as TestMulti, without going through the shared pdf buffers
+    fvec sample(samples.Cols()), pdf(count);
+    float prior0 = bUseClassPriors ? priors[0] : 1.f;
+    float prior1 = bUseClassPriors && count > 1 ? priors[1] : 1.f;
+    float xmin=-1000.f, xmax=1000.f;
+    FOR(i, rows)
+    {
+        samples.CopyRow(i, &sample[0]);
+        FOR(c, count) pdf[c] = gmms[c]->pdf(&sample[0]);
+        if(count == 2)
+        {
+            scores[i] = logf(pdf[1]*prior1) - logf(pdf[0]*prior0);
+            continue;
+        }
+        FOR(c, count)
+        {
+            float value = logf(bUseClassPriors ? pdf[c]*priors[c] : pdf[c]);
+            scores[(size_t)i*outputs + c] = (min(xmax,max(xmin, value)) - xmin) / (xmax);
+        }
+    }
+    return outputs;
+}
+
 float ClassifierGMM::Test( const fvec &sample) const
 {
 	fvec pdf = TestMulti(sample);
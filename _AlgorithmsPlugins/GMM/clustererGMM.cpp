@@ -72,6 +72,28 @@ fvec ClustererGMM::Test( const fVec &sample)
 	return res;
 }
 
+fvec ClustererGMM::TestMany(const fvec &sampleMatrix, const int dim, const int count)
+{
+    fvec results;
+    if(sampleMatrix.size() != dim*count) return results;
+    results.resize(count*nbClusters, 0);
+    if(!gmm || dim < gmm->dim) return results;
+    // the samples are read in place and the memberships are written straight into the results
+    FOR(i, count)
+    {
+        const float *sample = &sampleMatrix[i*dim];
+        float *res = &results[i*nbClusters];
+        float sum = 0;
+        FOR(c, nbClusters)
+        {
+            res[c] = gmm->pdf(sample, c);
+            sum += res[c];
+        }
+        if(sum > FLT_MIN*3) FOR(c, nbClusters) res[c] /= sum;
+    }
+    return results;
+}
+
 float ClustererGMM::GetLogLikelihood(std::vector<fvec> samples)
 {
     float *weights = new float[nbClusters];
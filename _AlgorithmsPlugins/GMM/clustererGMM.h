@@ -32,7 +32,7 @@ private:
 	u32 initType;
 	float *data;
 public:
-    ClustererGMM() : gmm(0), data(0), covarianceType(2), initType(1){}
+    ClustererGMM() : gmm(0), data(0), covarianceType(2), initType(1){bThreadSafe = true;}
     ~ClustererGMM();
     ClustererGMM(const ClustererGMM& other) : Clusterer(other)
     {
@@ -45,6 +45,7 @@ public:
 	void Train(std::vector< fvec > samples);
 	fvec Test( const fvec &sample);
 	fvec Test( const fVec &sample);
+    fvec TestMany( const fvec &sampleMatrix, const int dim, const int count);
     const char *GetInfoString();
     float GetLogLikelihood(std::vector<fvec> samples);
     float GetParameterCount();
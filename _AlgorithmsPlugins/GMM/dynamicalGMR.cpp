@@ -88,6 +88,31 @@ fvec DynamicalGMR::Test( const fvec &sample)
 	return res;
 }
 
+void DynamicalGMR::TestBatch(const SampleView &samples, fvec &velocities)
+{
+    int rows = samples.Rows();
+    dim = samples.Cols();
+    velocities.resize(rows*dim);
+    if(!gmm || !dim)
+    {
+        std::fill(velocities.begin(), velocities.end(), 0.f);
+        return;
+    }
+    // the regression writes straight into the output, contiguous rows are read in place
+    fvec sample(dim);
+    fvec sigma(dim*(dim+1)/2);
+    FOR(i, rows)
+    {
+        const float *point = samples.RowData(i);
+        if(!samples.Contiguous())
+        {
+            samples.CopyRow(i, &sample[0]);
+            point = &sample[0];
+        }
+        gmm->doRegression(point, &velocities[i*dim], &sigma[0]);
+    }
+}
+
 
 fVec DynamicalGMR::Test( const fVec &sample)
 {
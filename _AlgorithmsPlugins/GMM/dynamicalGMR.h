@@ -38,6 +38,7 @@ public:
 	std::vector<fvec> Test( const fvec &sample, const int count);
 	fvec Test( const fvec &sample);
 	fVec Test( const fVec &sample);
+    void TestBatch(const SampleView &samples, fvec &velocities);
     const char *GetInfoString();
     void SaveModel(std::string filename);
     bool LoadModel(std::string filename);
@@ -203,7 +203,7 @@ void ClustGMM::DrawModel(Canvas *canvas, QPainter &painter, Clusterer *clusterer
 {
 	painter.setRenderHint(QPainter::Antialiasing);
 
-	FOR(i, canvas->data->GetSamples().size())
+	FOR(i, canvas->data->GetCount())
 	{
         fvec sample = canvas->data->GetSampleDim(i, canvas->sourceDims);
         fvec fullSample = canvas->data->GetSample(i);
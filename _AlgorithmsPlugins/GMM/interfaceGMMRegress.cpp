@@ -286,13 +286,18 @@ void RegrGMM::DrawModel(Canvas *canvas, QPainter &painter, Regressor *regressor)
 	fvec sample;sample.resize(2, 0);
 	painter.setBrush(Qt::NoBrush);
     QPainterPath path, pathUp, pathDown, pathUpUp, pathDownDown;
+	// the whole curve is evaluated in a single batch
+	SampleMatrix curve;
+	FOR(x, steps) curve.AddRow(canvas->toSampleCoords(x,0));
+	fvec means, confidences;
+	regressor->TestBatch(curve.View(), means, confidences);
 	FOR(x, steps)
 	{
-        sample = canvas->toSampleCoords(x, 0);
+        sample = curve.Row(x);
         int dim = sample.size();
         if(dim > 2) continue;
         if(outputDim==-1) outputDim = dim-1;
-        fvec res = regressor->Test(sample);
+        const float res[2] = {means[x], confidences[x]};
 		if(res[0] != res[0] || res[1] != res[1]) continue;
         sample[outputDim] = res[0];
         QPointF point = canvas->toCanvasCoords(sample);
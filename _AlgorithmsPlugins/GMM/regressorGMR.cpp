@@ -83,6 +83,32 @@ fvec RegressorGMR::Test( const fvec &sample)
 	return res;
 }
 
+void RegressorGMR::TestBatch(const SampleView &samples, fvec &means, fvec &confidences)
+{
+    int rows = samples.Rows();
+    int dim = samples.Cols();
+    means.resize(rows);
+    confidences.resize(rows);
+    if(!gmm || !dim)
+    {
+        std::fill(means.begin(), means.end(), 0.f);
+        std::fill(confidences.begin(), confidences.end(), 0.f);
+        return;
+    }
+    // a single buffer holds the current sample, with the desired output swapped into the last dimension
+    bool bSwap = outputDim != -1 && outputDim < dim-1;
+    fvec sample(dim);
+    float estimate, sigma;
+    FOR(i, rows)
+    {
+        samples.CopyRow(i, &sample[0]);
+        if(bSwap) std::swap(sample[dim-1], sample[outputDim]);
+        gmm->doRegression(&sample[0], &estimate, &sigma);
+        means[i] = estimate;
+        confidences[i] = sqrt(sigma);
+    }
+}
+
 fVec RegressorGMR::Test( const fVec &sample)
 {
 	fVec res;
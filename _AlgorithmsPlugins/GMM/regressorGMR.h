@@ -33,10 +33,11 @@ private:
 	u32 initType;
 	float *data;
 public:
-    RegressorGMR() : gmm(0), data(0), nbClusters(2), covarianceType(2), initType(1){type = REGR_GMR;}
+    RegressorGMR() : gmm(0), data(0), nbClusters(2), covarianceType(2), initType(1){type = REGR_GMR; bTrainThreadSafe = true;}
 	void Train(std::vector< fvec > samples, ivec labels);
 	fvec Test( const fvec &sample);
 	fVec Test( const fVec &sample);
+    void TestBatch(const SampleView &samples, fvec &means, fvec &confidences);
     const char *GetInfoString();
     void SaveModel(std::string filename);
     bool LoadModel(std::string filename);
@@ -190,12 +190,39 @@ void SOGP::delete_bv(int loc){
 
 
 //Predict on a chunk of data.
+//Same as predict() on each column, with the kernel values of all the columns computed at once
 ReturnMatrix SOGP::predictM(const Matrix& in, ColumnVector &sigconf,bool conf){
     //printf("SOGP::Predicting on %d points\n",in.Ncols());
+    int count = in.Ncols();
+    Matrix out(alpha.Ncols(),count);
+    sigconf.ReSize(count);
+    Matrix K, CK;
+    if(current_size==0) out=0;
+    else{
+        K=m_params.m_kernel->kernelMM(in,BV);
+        out=alpha.t()*K;//Page 33
+        CK=C*K;
+    }
+    for(int c=1;c<=count;c++){
+        double kstar = m_params.m_kernel->kstar(in.Column(c));
+        double sigma = m_params.s20 + kstar;
+        if(current_size) for(int i=1;i<=current_size;i++) sigma += K(i,c)*CK(i,c);
+        if(sigma<0){//Numerical instability?
+            printf("SOGP:: sigma (%lf) < 0!\n",sigma);
+            sigma=0;
+        }
+        if(conf) sigma = (1-sigma/(kstar+m_params.s20))*100;
+        else sigma=sqrt(sigma);
+        sigconf(c) = sigma;
+    }
+    out.Release();
+    return out;
+}
+
+ReturnMatrix SOGP::predictM(const Matrix& in){
     Matrix out(alpha.Ncols(),in.Ncols());
-    sigconf.ReSize(in.Ncols());
-    for(int c=1;c<=in.Ncols();c++)
-        out.Column(c) = predict(in.Column(c),sigconf(c),conf);
+    if(current_size==0) out=0;
+    else out=alpha.t()*m_params.m_kernel->kernelMM(in,BV);
     out.Release();
     return out;
 }
@@ -49,10 +49,8 @@ class SOGP{
   //These two just wrap the single-data versions
   void addM(const Matrix& in, const Matrix& out);
   ReturnMatrix predictM(const Matrix& in, ColumnVector &sigconf,bool conf=false);
-  ReturnMatrix predictM(const Matrix& in){
-    ColumnVector foo;
-    return predictM(in,foo);
-  }
+  // means only, skips the variance computation
+  ReturnMatrix predictM(const Matrix& in);
 
   //Return the log probability of this pair under the GP
   double log_prob(const ColumnVector& in, const ColumnVector& out);
@@ -12,6 +12,13 @@ ReturnMatrix SOGPKernel::kernelM(const ColumnVector& in, const Matrix &BV){
 	k.Release();
 	return k;
 }
+ReturnMatrix SOGPKernel::kernelMM(const Matrix& in, const Matrix &BV){
+	Matrix K(BV.Ncols(),in.Ncols());
+	for(int c=1;c<=in.Ncols();c++)
+		K.Column(c) = kernelM(in.Column(c),BV);
+	K.Release();
+	return K;
+}
 double SOGPKernel::kstar(const ColumnVector& in){
 	return kernel(in,in);
 }
@@ -37,6 +44,31 @@ double RBFKernel::kernel(const ColumnVector &a, const ColumnVector &b){
 	Real ss = SumSquare(SP(c,widths.t()));
 	return A*exp(-(1/(2*d)) * ss);
 }
+//Same as kernel() on every pair, but straight on the matrix storage (row-major in newmat)
+ReturnMatrix RBFKernel::kernelMM(const Matrix& in, const Matrix &BV){
+	int d = in.Nrows();
+	if(d!=widths.Ncols() || d!=BV.Nrows()) return SOGPKernel::kernelMM(in,BV);
+	int n = BV.Ncols(), count = in.Ncols();
+	Matrix K(n,count);
+	const Real *a = in.Store(), *b = BV.Store(), *w = widths.Store();
+	Real *k = K.Store();
+	double scale = -(1/(2*(double)d));
+	for(int i=0;i<n;i++)
+	{
+		for(int c=0;c<count;c++)
+		{
+			Real ss = 0;
+			for(int j=0;j<d;j++)
+			{
+				Real v = (a[j*count+c]-b[j*n+i])*w[j];
+				ss += v*v;
+			}
+			k[i*count+c] = A*exp(scale * ss);
+		}
+	}
+	K.Release();
+	return K;
+}
 //POL
 double POLKernel::kernel(const ColumnVector &a, const ColumnVector &b){
     double d = a.Nrows();
@@ -38,6 +38,8 @@ public:
     virtual ~SOGPKernel(){}
     virtual double kernel(const ColumnVector& a, const ColumnVector& b)=0;
     virtual ReturnMatrix kernelM(const ColumnVector& in, const Matrix &BV);
+    //Kernel values between all the columns of in and BV (BV.Ncols() x in.Ncols())
+    virtual ReturnMatrix kernelMM(const Matrix& in, const Matrix &BV);
     virtual double kstar(const ColumnVector& in);
     virtual double kstar();
     virtual void printTo(FILE *fp,bool ascii=false){
@@ -59,6 +61,7 @@ class RBFKernel: public SOGPKernel{
 public:
     virtual ~RBFKernel(){}
     double kernel(const ColumnVector &a, const ColumnVector &b);
+    ReturnMatrix kernelMM(const Matrix& in, const Matrix &BV);
     void printTo(FILE *fp,bool ascii = false){
         fprintf(fp,"A %lf\n",A);printRV(widths,fp,"widths",ascii);
     }
@@ -261,6 +261,58 @@ float ClassifierGP::Test(const fvec &sample) const
 
 }
 
+int ClassifierGP::TestBatch(const SampleView &samples, fvec &scores) const
+{
+    int rows = samples.Rows();
+    if(!rows || samples.Cols() < dim || dim > MAX_DIM) return Classifier::TestBatch(samples, scores);
+    scores.resize(rows);
+    // the products are computed directly on the newmat storage: the newmat operators keep a global
+    // trace of the calls in progress, which would prevent several threads from testing at the same time
+    const int blockSize = 256;
+    const Real *g = g_logprob_yf.Store();
+    const Real *LX = LinvXsqrtW.Store();
+    float smp_raw_array[MAX_DIM];
+    vector<float> k_star(blockSize*Ntrain); // one row k(x*,X) per sample
+    vector<Real> posterior_mean(blockSize), posterior_var(blockSize);
+    for(int start=0; start<rows; start += blockSize)
+    {
+        int count = min(blockSize, rows-start);
+        FOR(j, count)
+        {
+            FOR(d, dim) smp_raw_array[d] = samples(start+j, d);
+            mSECovFunc.ComputeCovarianceVector(training_data_raw_array,Ntrain,smp_raw_array,&k_star[j*Ntrain]);
+            const float *k = &k_star[j*Ntrain];
+            posterior_var[j] = mSECovFunc.ComputeCovariance(smp_raw_array,smp_raw_array);
+            Real mean = 0;
+            FOR(n, Ntrain) mean += g[n]*k[n];
+            posterior_mean[j] = mean;
+        }
+        FOR(n, Ntrain)
+        {
+            const Real *row = LX + (size_t)n*Ntrain;
+            FOR(j, count)
+            {
+                const float *k = &k_star[j*Ntrain];
+                Real v = 0;
+                FOR(m, Ntrain) v += row[m]*k[m];
+                posterior_var[j] -= v*v;
+            }
+        }
+        FOR(j, count)
+        {
+            if(posterior_var[j]<FLT_MIN) posterior_var[j] = FLT_MIN;
+            float p_pos;
+            if(!bMonteCarlo)
+                p_pos = IntegrateLogisticGaussian(posterior_mean[j],posterior_var[j],Neval);
+            else
+                p_pos = MonteCarloLogisticGaussian(posterior_mean[j],posterior_var[j],Neval);
+            float p_neg = 1-p_pos;
+            scores[start+j] = 3*(p_pos - p_neg);
+        }
+    }
+    return 1;
+}
+
 const char *ClassifierGP::GetInfoString() const
 {
     char *text = new char[1024];
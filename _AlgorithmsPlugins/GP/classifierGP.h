@@ -83,6 +83,7 @@ public:
 
         float params[2] = {0.1,0.1}; //lengthscales for the two input dimensions
         mSECovFunc.SetParams(2,params,0.1,1.0);
+        bThreadSafe = true;
     }
     /**
       Deconstructor, deinstanciating everything that has been in            interfaceGPRRegress.cpp \
@@ -100,6 +101,13 @@ public:
       */
     float Test(const fvec &sample) const ;
 
+    /**
+      Batch version of Test: the covariances of a block of samples are gathered in a matrix,
+      and the posterior means and variances of the whole block are computed in one pass over the training data.
+      It does not modify the model and can be called from several threads at once
+      */
+    int TestBatch(const SampleView &samples, fvec &scores) const ;
+
 
     /**
       Information string for the Algorithm Information and Statistics panel in the main program interface.
@@ -112,6 +112,25 @@ fvec DynamicalGPR::Test( const fvec &sample )
 	return res;
 }
 
+void DynamicalGPR::TestBatch(const SampleView &samples, fvec &velocities)
+{
+    int rows = samples.Rows();
+    int cols = samples.Cols();
+    velocities.assign(rows*cols, 0.f);
+    if(!sogp || cols < dim) return;
+    // the predictions are computed by blocks, which bounds the size of the kernel matrix
+    const int blockSize = 1024;
+    for(int start=0; start<rows; start+=blockSize)
+    {
+        int count = std::min(blockSize, rows-start);
+        Matrix _testin(dim, count);
+        FOR(i, count) FOR(d, dim) _testin(d+1, i+1) = samples(start+i, d);
+        Matrix _testout = sogp->predictM(_testin);
+        int outputs = std::min(dim, _testout.Nrows());
+        FOR(i, count) FOR(d, outputs) velocities[(start+i)*cols + d] = _testout(d+1, i+1);
+    }
+}
+
 fVec DynamicalGPR::Test( const fVec &sample )
 {
 	fVec res;
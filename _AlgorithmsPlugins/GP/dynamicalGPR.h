@@ -45,6 +45,7 @@ public:
 	std::vector<fvec> Test( const fvec &sample, const int count);
 	fvec Test(const fvec &sample);
 	fVec Test(const fVec &sample);
+    void TestBatch(const SampleView &samples, fvec &velocities);
     const char *GetInfoString();
 
     void SetParams(double p1, double p2, int capacity, int kType, int d=1){param1=p1; param2=p2; kernelType=kType; degree = d;this->capacity=capacity;}
@@ -277,22 +277,19 @@ void RegrGPR::DrawConfidence(Canvas *canvas, Regressor *regressor)
             canvas->maps.confidence = QPixmap();
             return;
         }
-        int outputDim = regressor->outputDim;
         int yIndex = canvas->yIndex;
-        Matrix _testout;
-        ColumnVector _testin(dim);
         QImage density(QSize(256,256), QImage::Format_RGB32);
         density.fill(0);
+        // the mean and variance of every column are predicted in a single batch
+        SampleMatrix columns;
+        for (int i=0; i < density.width(); i++) columns.AddRow(canvas->toSampleCoords(i*w/density.width(),0));
+        fvec means, variances;
+        gpr->TestBatch(columns.View(), means, variances);
         // we draw a density map for the probability
         for (int i=0; i < density.width(); i++)
         {
-            fvec sampleIn = canvas->toSampleCoords(i*w/density.width(),0);
-            FOR(d, dim) _testin(d+1) = sampleIn[d];
-            if(outputDim != -1 && outputDim < dim) _testin(outputDim+1) = sampleIn[dim];
-            double sigma;
-            _testout = gpr->sogp->predict(_testin, sigma);
-            sigma = sigma*sigma;
-            float testout = _testout(1,1);
+            double sigma = variances[i];
+            float testout = means[i];
             for (int j=0; j< density.height(); j++)
             {
                 fvec sampleOut = canvas->toSampleCoords(i*w/density.width(),j*h/density.height());
@@ -323,10 +320,15 @@ void RegrGPR::DrawModel(Canvas *canvas, QPainter &painter, Regressor *regressor)
     QPointF oldPoint(-FLT_MAX,-FLT_MAX);
     QPointF oldPointUp(-FLT_MAX,-FLT_MAX);
     QPointF oldPointDown(-FLT_MAX,-FLT_MAX);
+    // the whole curve is evaluated in a single batch
+    SampleMatrix curve;
+    FOR(x, steps) curve.AddRow(canvas->toSampleCoords(x,0));
+    fvec means, confidences;
+    regressor->TestBatch(curve.View(), means, confidences);
     FOR(x, steps)
     {
-        sample = canvas->toSampleCoords(x,0);
-        fvec res = regressor->Test(sample);
+        sample = curve.Row(x);
+        const float res[2] = {means[x], confidences[x]};
         if(res[0] != res[0] || res[1] != res[1]) continue;
         QPointF point = canvas->toCanvasCoords(sample[xIndex], res[0]);
         QPointF pointUp = canvas->toCanvasCoords(sample[xIndex],res[0] + res[1]);
@@ -292,6 +292,40 @@ fvec RegressorGPR::Test( const fvec &sample )
     return res;
 }
 
+void RegressorGPR::TestBatch(const SampleView &samples, fvec &means, fvec &confidences)
+{
+    int rows = samples.Rows();
+    means.resize(rows);
+    confidences.resize(rows);
+    if(!sogp)
+    {
+        std::fill(means.begin(), means.end(), 0.f);
+        std::fill(confidences.begin(), confidences.end(), 0.f);
+        return;
+    }
+    // the predictions are computed by blocks, which bounds the size of the kernel matrix
+    const int blockSize = 1024;
+    int dim = sogp->dim();
+    bool bSwap = outputDim != -1 && outputDim < dim && dim < samples.Cols();
+    for(int start=0; start<rows; start+=blockSize)
+    {
+        int count = min(blockSize, rows-start);
+        Matrix _testin(dim, count);
+        FOR(i, count)
+        {
+            FOR(d, dim) _testin(d+1, i+1) = samples(start+i, d);
+            if(bSwap) _testin(outputDim+1, i+1) = samples(start+i, dim);
+        }
+        ColumnVector confidence;
+        Matrix _testout = sogp->predictM(_testin, confidence);
+        FOR(i, count)
+        {
+            means[start+i] = _testout.Nrows() ? _testout(1, i+1) : 0;
+            confidences[start+i] = confidence(i+1)*confidence(i+1);
+        }
+    }
+}
+
 fVec RegressorGPR::Test( const fVec &sample )
 {
     fVec res;
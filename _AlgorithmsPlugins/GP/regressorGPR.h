@@ -45,6 +45,7 @@ public:
 	void Train(std::vector<fvec> inputs, ivec labels);
 	fvec Test(const fvec &sample);
 	fVec Test(const fVec &sample);
+    void TestBatch(const SampleView &samples, fvec &means, fvec &confidences);
     const char *GetInfoString();
 
     void SetParams(double p1, double p2, int capacity, int kType, int d=1, bool bOptimize=false, bool bOptimizeLikelihood=true){param1=p1; param2=p2; kernelType=kType; degree = d;this->capacity=capacity;this->bOptimize=bOptimize;this->bOptimizeLikelihood=bOptimizeLikelihood;}
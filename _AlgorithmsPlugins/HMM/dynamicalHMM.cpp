@@ -195,6 +195,12 @@ fVec DynamicalHMM::Test( const fVec &sample)
 	return res;
 }
 
+void DynamicalHMM::TestBatch(const SampleView &samples, fvec &velocities)
+{
+    // the hmm does not generate a velocity field, we skip the per-sample calls altogether
+    velocities.assign(samples.Rows()*samples.Cols(), 0.f);
+}
+
 void DynamicalHMM::SetParams(int mixtures, int states, int trainType, int obsType, int initType, int transType)
 {
 	this->mixtures = mixtures;
@@ -50,6 +50,7 @@ public:
     std::vector<fvec> Test( const fvec &sample, const int count);
     fvec Test( const fvec &sample);
     fVec Test( const fVec &sample);
+    void TestBatch(const SampleView &samples, fvec &velocities);
     char *GetInfoString();
     bool IsOrphanedState(int HMMClass, int state);
 
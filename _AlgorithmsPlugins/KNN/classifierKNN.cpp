@@ -113,6 +113,53 @@ fvec ClassifierKNN::TestMulti(const fvec &sample) const
 	return score;
 }
 
+int ClassifierKNN::TestBatch(const SampleView &samples, fvec &scores) const
+{
+    int rows = samples.Rows();
+    if(!this->samples.size() || !rows)
+    {
+        scores.clear();
+        return 1;
+    }
+    // the labels are mapped and the query buffers allocated once for the whole batch
+    int classCount = min(256, (int)classMap.size());
+    int outputs = bBinary ? 1 : max(1, classCount);
+    ivec newLabels(labels.size());
+    FOR(i, newLabels.size()) newLabels[i] = classMap.at(labels.at(i));
+    int positive = bBinary && classMap.at(0) == 0 ? 1 : -1;
+
+    scores.assign((size_t)rows*outputs, 0.f);
+    int cols = samples.Cols();
+    ANNpoint queryPt = annAllocPt(cols);
+    ANNidxArray nnIdx = new ANNidx[k];
+    ANNdistArray dists = new ANNdist[k];
+    ivec counts(max(1, (int)classMap.size()));
+    FOR(i, rows)
+    {
+        FOR(d, cols) queryPt[d] = samples(i,d);
+        kdTree->annkSearch(queryPt, k, nnIdx, dists, 0);
+        std::fill(counts.begin(), counts.end(), 0);
+        FOR(j, k)
+        {
+            if(nnIdx[j] < 0 || nnIdx[j] >= (int)newLabels.size()) continue;
+            counts[newLabels[nnIdx[j]]]++;
+        }
+        float *score = &scores[(size_t)i*outputs];
+        if(bBinary)
+        {
+            score[0] = positive*(counts[1] - counts[0])/(float)(counts[0]+counts[1])*3;
+            continue;
+        }
+        float sum = 0;
+        FOR(c, classCount) sum += counts[c];
+        FOR(c, classCount) score[c] = sum > 0 ? counts[c]/sum : counts[c];
+    }
+    annDeallocPt(queryPt);
+    delete [] nnIdx;
+    delete [] dists;
+    return outputs;
+}
+
 float ClassifierKNN::Test( const fvec &sample ) const
 {
 	if(!samples.size()) return 0;
@@ -43,6 +43,7 @@ public:
 	~ClassifierKNN();
     void Train(std::vector< fvec > samples, ivec labels);
     fvec TestMulti(const fvec &sample) const ;
+    int TestBatch(const SampleView &samples, fvec &scores) const ;
     float Test( const fvec &sample) const ;
     float Test( const fVec &sample) const ;
 	void SetParams(u32 k, int metricType, u32 metricP);
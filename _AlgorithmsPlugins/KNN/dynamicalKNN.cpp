@@ -149,6 +149,43 @@ fvec DynamicalKNN::Test( const fvec &sample )
 	return res;
 }
 
+void DynamicalKNN::TestBatch(const SampleView &samples, fvec &velocities)
+{
+    int rows = samples.Rows();
+    int dim = samples.Cols();
+    velocities.assign(rows*dim, 0.f);
+    if(!points.size() || !kdTree || !rows) return;
+
+    // the query point and the neighbor buffers are allocated once for all the samples
+    double eps = 0; // error bound
+    ANNpoint queryPt = annAllocPt(dim);
+    ANNidxArray nnIdx = new ANNidx[k];
+    ANNdistArray dists = new ANNdist[k];
+    FOR(r, rows)
+    {
+        FOR(d, dim) queryPt[d] = samples(r,d);
+        kdTree->annkSearch(queryPt, k, nnIdx, dists, eps);
+
+        float dsum = 0;
+        FOR(i, k)
+        {
+            if(nnIdx[i] >= points.size()) continue;
+            if(dists[i] != 0) dsum += 1./dists[i];
+        }
+        float *velocity = &velocities[r*dim];
+        FOR(i, k)
+        {
+            if(nnIdx[i] >= points.size() || dists[i] == 0) continue;
+            float weight = 1./(dists[i])/dsum;
+            const fvec &neighbor = this->velocities[nnIdx[i]]; // the training velocities
+            FOR(d, dim) velocity[d] += neighbor[d]*weight;
+        }
+    }
+    annDeallocPt(queryPt);
+    delete [] nnIdx;
+    delete [] dists;
+}
+
 
 fVec DynamicalKNN::Test( const fVec &sample )
 {
@@ -43,6 +43,7 @@ public:
 	std::vector<fvec> Test( const fvec &sample, const int count);
 	fvec Test( const fvec &sample);
 	fVec Test( const fVec &sample);
+    void TestBatch(const SampleView &samples, fvec &velocities);
     const char *GetInfoString();
 
 	void SetParams(u32 k, int metricType, u32 metricP);
@@ -129,10 +129,15 @@ void RegrKNN::DrawModel(Canvas *canvas, QPainter &painter, Regressor *regressor)
 	QPointF oldPoint(-FLT_MAX,-FLT_MAX);
 	QPointF oldPointUp(-FLT_MAX,-FLT_MAX);
 	QPointF oldPointDown(-FLT_MAX,-FLT_MAX);
+	// the whole curve is evaluated in a single batch
+	SampleMatrix curve;
+	FOR(x, steps) curve.AddRow(canvas->toSampleCoords(x,0));
+	fvec means, confidences;
+	regressor->TestBatch(curve.View(), means, confidences);
 	FOR(x, steps)
 	{
-		sample = canvas->toSampleCoords(x,0);
-		fvec res = regressor->Test(sample);
+		sample = curve.Row(x);
+		const float res[2] = {means[x], confidences[x]};
 		if(res[0] != res[0] || res[1] != res[1]) continue;
 		QPointF point = canvas->toCanvasCoords(sample[0], res[0]);
 		QPointF pointUp = canvas->toCanvasCoords(sample[0],res[0] + res[1]);
@@ -116,6 +116,64 @@ fvec RegressorKNN::Test( const fvec &sample )
 }
 
 
+void RegressorKNN::TestBatch(const SampleView &queries, fvec &means, fvec &confidences)
+{
+    int rows = queries.Rows();
+    means.assign(rows, 0.f);
+    confidences.assign(rows, 0.f);
+    if(!samples.size() || !kdTree || !rows) return;
+    int dim = queries.Cols()-1;
+    int oDim = outputDim == -1 || outputDim > dim ? dim : outputDim;
+    if(k > samples.size()) k = samples.size();
+
+    // the query point and the neighbor buffers are allocated once for all the samples
+    double eps = 0; // error bound
+    ANNpoint queryPt = annAllocPt(dim);
+    ANNidxArray nnIdx = new ANNidx[k];
+    ANNdistArray dists = new ANNdist[k];
+    fvec scores(k);
+    FOR(r, rows)
+    {
+        FOR(i, dim) queryPt[i] = queries(r,i);
+        if(outputDim != -1 && outputDim < dim) queryPt[outputDim] = queries(r,dim);
+        kdTree->annkSearch(queryPt, k, nnIdx, dists, eps);
+
+        float dsum = 0;
+        std::fill(scores.begin(), scores.end(), 0.f);
+        FOR(i, k)
+        {
+            if(nnIdx[i] >= samples.size()) continue;
+            if(dists[i] != 0) dsum += 1./dists[i];
+            scores[i] = samples[nnIdx[i]][oDim];
+        }
+        FOR(i, k)
+        {
+            if(nnIdx[i] >= samples.size()) continue;
+            if(dists[i] == 0) continue;
+            dists[i] = 1./(dists[i])/dsum;
+        }
+        float mean = 0, stdev = 0;
+        int cnt = 0;
+        FOR(i, k)
+        {
+            if(nnIdx[i] >= samples.size()) continue;
+            mean += scores[i] * dists[i];
+            cnt++;
+        }
+        FOR(i, k)
+        {
+            if(nnIdx[i] >= samples.size()) continue;
+            stdev += (scores[i] - mean)*(scores[i] - mean);
+        }
+        if(cnt) stdev /= cnt;
+        means[r] = mean;
+        confidences[r] = sqrtf(stdev);
+    }
+    annDeallocPt(queryPt);
+    delete [] nnIdx;
+    delete [] dists;
+}
+
 fVec RegressorKNN::Test( const fVec &sample )
 {
 	fVec res;
@@ -40,6 +40,7 @@ public:
 	void Train(std::vector< fvec > samples, ivec labels);
 	fvec Test( const fvec &sample);
 	fVec Test( const fVec &sample);
+    void TestBatch(const SampleView &samples, fvec &means, fvec &confidences);
     const char *GetInfoString();
 
 	void SetParams(u32 k, int metricType, u32 metricP);
@@ -19,6 +19,7 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 *********************************************************************/
 #include <public.h>
 #include "classifierSVM.h"
+#include <gramCache.h>
 #include <nlopt/nlopt.hpp>
 #include <QDebug>
 #include <iostream>
@@ -33,6 +34,8 @@ ClassifierSVM::ClassifierSVM()
 {
     dim = 2;
     bMultiClass = true;
+    bThreadSafe = true;
+    bTrainThreadSafe = true;
     classCount = 0;
     // default values
     param.svm_type = C_SVC;
@@ -484,9 +487,33 @@ void ClassifierSVM::Train(std::vector< fvec > samples, ivec labels)
         problem.y[i] = newLabels[i];
     }
 
+    // inside a cross-validation the kernel of the training samples is read from the matrix shared by the folds
+    ivec rows;
+    std::shared_ptr<const GramMatrix> gram;
+    if(param.kernel_type <= SIGMOID)
+    {
+        ivec columns(dim);
+        FOR(d, dim) columns[d] = d;
+        gram = GramScope::Lookup(gramScope, samples, GramKernel(param.kernel_type, param.degree, param.gamma, param.coef0, columns), rows);
+    }
+    if(gram)
+    {
+        FOR(i, problem.l) x_space[(dim +1)*i + dim].value = rows[i];
+        param.gram = gram->Data();
+        param.gram_size = gram->Size();
+    }
+
     delete(svm);
     DEL(node);
     svm = svm_train(&problem, &param);
+    param.gram = 0;
+    param.gram_size = 0;
+    // the model keeps a copy of param, it must not point to the cache once we let go of it
+    if(svm)
+    {
+        svm->param.gram = 0;
+        svm->param.gram_size = 0;
+    }
 
     if(bOptimize) OptimizeGradient(&problem);
 
@@ -653,6 +680,115 @@ fvec ClassifierSVM::TestMulti(const fvec &sample) const
     return resp;
 }
 
+int ClassifierSVM::TestBatch(const SampleView &samples, fvec &scores) const
+{
+    int rows = samples.Rows();
+    int cols = samples.Cols();
+    int outputs = 1;
+    if(classCount != 2)
+    {
+        outputs = classCount;
+        FOR(i, classCount) outputs = max(outputs, classes.at(i));
+    }
+    scores.assign((size_t)rows*outputs, 0.f);
+    if(!svm || !rows) return outputs;
+
+    int nr_class = svm->nr_class;
+    int l = svm->l;
+    const svm_parameter &p = svm->param;
+    bool bDense = (p.svm_type == C_SVC || p.svm_type == NU_SVC) &&
+            (p.kernel_type == LINEAR || p.kernel_type == POLY || p.kernel_type == RBF);
+    vector<double> decisions(max(nr_class, nr_class*(nr_class-1)/2));
+
+    if(!bDense)
+    {
+        // other kernels go through libsvm, with a single node buffer for all the samples
+        vector<svm_node> x(cols+1);
+        FOR(d, cols) x[d].index = d+1;
+        x[cols].index = -1;
+        FOR(i, rows)
+        {
+            FOR(d, cols) x[d].value = samples(i,d);
+            if(classCount == 2)
+            {
+                float estimate = (float)svm_predict(svm, &x[0]);
+                if(svm->label[0] != -1) estimate *= -1;
+                scores[i] = estimate;
+                continue;
+            }
+            svm_predict_votes(svm, &x[0], &decisions[0]);
+            FOR(c, classCount) if(classes.at(c) < outputs) scores[(size_t)i*outputs + classes.at(c)] = decisions[c];
+        }
+        return outputs;
+    }
+
+    // we unpack the support vectors in a dense matrix once, and compute the kernel values directly on it
+    int D = cols;
+    FOR(k, l) for(const svm_node *n = svm->SV[k]; n->index != -1; n++) D = max(D, n->index);
+    vector<double> sv((size_t)l*D, 0);
+    FOR(k, l) for(const svm_node *n = svm->SV[k]; n->index != -1; n++) sv[(size_t)k*D + n->index-1] = n->value;
+    ivec start(nr_class, 0);
+    for(int c=1; c<nr_class; c++) start[c] = start[c-1] + svm->nSV[c-1];
+    double norm = p.kernel_type == RBF && p.normalizeKernel ? p.kernel_norm : 1.;
+
+    vector<double> x(D, 0), kvalue(l);
+    ivec votes(nr_class);
+    FOR(i, rows)
+    {
+        FOR(d, cols) x[d] = samples(i,d);
+        FOR(k, l)
+        {
+            const double *s = &sv[(size_t)k*D];
+            double sum = 0;
+            if(p.kernel_type == RBF)
+            {
+                FOR(d, D) sum += (x[d]-s[d])*(x[d]-s[d]);
+                kvalue[k] = norm*exp(-p.gamma*sum);
+            }
+            else
+            {
+                FOR(d, D) sum += x[d]*s[d];
+                kvalue[k] = p.kernel_type == LINEAR ? sum : pow(p.gamma*sum + p.coef0, p.degree);
+            }
+        }
+        // same pairwise decision functions as svm_predict_values
+        int pair = 0;
+        FOR(a, nr_class)
+        {
+            for(int b=a+1; b<nr_class; b++)
+            {
+                double sum = 0;
+                const double *coef1 = svm->sv_coef[b-1];
+                const double *coef2 = svm->sv_coef[a];
+                for(int k=start[a]; k<start[a]+svm->nSV[a]; k++) sum += coef1[k]*kvalue[k];
+                for(int k=start[b]; k<start[b]+svm->nSV[b]; k++) sum += coef2[k]*kvalue[k];
+                decisions[pair] = sum - svm->rho[pair];
+                pair++;
+            }
+        }
+        if(classCount == 2)
+        {
+            double decision = svm->label[0] == 1 ? decisions[0] : -decisions[0];
+            float estimate = (float)decision;
+            if(svm->label[0] != -1) estimate *= -1;
+            scores[i] = estimate;
+            continue;
+        }
+        std::fill(votes.begin(), votes.end(), 0);
+        pair = 0;
+        FOR(a, nr_class)
+        {
+            for(int b=a+1; b<nr_class; b++)
+            {
+                if(decisions[pair++] > 0) votes[a]++;
+                else votes[b]++;
+            }
+        }
+        FOR(c, min(classCount, nr_class)) if(classes.at(c) < outputs) scores[(size_t)i*outputs + classes.at(c)] = votes[c];
+    }
+    return outputs;
+}
+
 const char *ClassifierSVM::GetInfoString() const
 {
     if(!svm) return NULL;
@@ -44,6 +44,7 @@ public:
     float Test(const fvec &sample) const ;
     float Test(const fVec &sample) const ;
     fvec TestMulti(const fvec &sample) const ;
+    int TestBatch(const SampleView &samples, fvec &scores) const ;
     const char *GetInfoString() const ;
 	void SetParams(int svmType, float svmC, u32 kernelType, float kernelParam);
     svm_model *GetModel(){return svm;}
@@ -319,6 +319,54 @@ fvec ClustererKKM::TestUnnormalizedDim(const fvec &_sample)
     return res;
 }
 
+// memberships of count samples in a single pass, the kernel is resolved once for the whole batch
+template <int N, typename K>
+static void TestManyKKM(kkmeans<K> *kkm, const fvec &sampleMatrix, const int dim, const int inputDim,
+                        const int count, const int nbClusters, fvec &results)
+{
+    sampletype sample;
+    FOR(i, count)
+    {
+        FOR(d, dim) sample(d) = sampleMatrix[i*inputDim + d];
+        float *res = &results[i*nbClusters];
+        float sum = 0;
+        float vmax = -FLT_MAX;
+        int index = 0;
+        FOR(j, nbClusters)
+        {
+            res[j] = exp(-kkm->getDistance(sample, j));
+            if(vmax < res[j])
+            {
+                vmax = res[j];
+                index = j;
+            }
+            sum += res[j];
+        }
+        FOR(j, nbClusters) res[j] /= sum;
+        res[index] = 1;
+    }
+}
+
+template <int N>
+fvec ClustererKKM::TestManyDim(const fvec &sampleMatrix, const int inputDim, const int count)
+{
+    fvec results(count*nbClusters, 0);
+    if(!decFunction) return results;
+    switch(kernelTypeTrained)
+    {
+    case 0:
+        TestManyKKM<N>((kkmeans<linkernel>*)decFunction, sampleMatrix, dim, inputDim, count, nbClusters, results);
+        break;
+    case 1:
+        TestManyKKM<N>((kkmeans<polkernel>*)decFunction, sampleMatrix, dim, inputDim, count, nbClusters, results);
+        break;
+    case 2:
+        TestManyKKM<N>((kkmeans<rbfkernel>*)decFunction, sampleMatrix, dim, inputDim, count, nbClusters, results);
+        break;
+    }
+    return results;
+}
+
 fvec ClustererKKM::Test( const fvec &_sample )
 {
 #define TESTCASE(a) case a:{return TestDim<a>(_sample);}
@@ -383,10 +431,34 @@ fvec ClustererKKM::TestUnnormalized(const fvec &_sample )
     }
 }
 
+fvec ClustererKKM::TestMany(const fvec &sampleMatrix, const int inputDim, const int count)
+{
+    if(sampleMatrix.size() != inputDim*count) return fvec();
+    if(inputDim < dim || dim > 12) return Clusterer::TestMany(sampleMatrix, inputDim, count);
+#define TESTMANYCASE(a) case a:{return TestManyDim<a>(sampleMatrix, inputDim, count);}
+    switch(dim)
+    {
+    TESTMANYCASE(2);
+    TESTMANYCASE(3);
+    TESTMANYCASE(4);
+    TESTMANYCASE(5);
+    TESTMANYCASE(6);
+    TESTMANYCASE(7);
+    TESTMANYCASE(8);
+    TESTMANYCASE(9);
+    TESTMANYCASE(10);
+    TESTMANYCASE(11);
+    TESTMANYCASE(12);
+    default:
+        return TestManyDim<2>(sampleMatrix, inputDim, count);
+    }
+}
+
 #undef TRAINCASE
 #undef TESTCASE
 #undef SCORECASE
 #undef TESTUNCASE
+#undef TESTMANYCASE
 #undef rbfkernel
 #undef linkernel
 #undef polkernel
@@ -50,9 +50,11 @@ public:
     template <int N> fvec TestDim(const fvec &sample);
     template <int N> double TestScoreDim(const fvec &sample, int index);
     template <int N> fvec TestUnnormalizedDim(const fvec &sample);
+    template <int N> fvec TestManyDim(const fvec &sampleMatrix, const int inputDim, const int count);
     fvec Test( const fvec &sample);
     double TestScore(const fvec &_sample, const int index);
     fvec TestUnnormalized( const fvec &sample);
+    fvec TestMany( const fvec &sampleMatrix, const int inputDim, const int count);
     const char *GetInfoString();
 
     void SetParams(int clusters, int kernelType, float kernelGamma, int kernelDegree, float kernelOffset)
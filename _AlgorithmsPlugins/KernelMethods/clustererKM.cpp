@@ -59,6 +59,68 @@ void ClustererKM::Train(std::vector< fvec > samples)
     }
 }
 
+// the streaming passes refine the means obtained on a subset with exact Lloyd iterations over the whole dataset
+// only hard k-means is supported (and not while animating), the soft and gmm variants need the per-sample responsibilities
+int ClustererKM::StreamPasses()
+{
+    return (kmeans && !bSoft && !bGmm && !bIterative) ? 20 : 0;
+}
+
+void ClustererKM::StreamBegin(const int pass, const int dim)
+{
+    streamSums.assign(nbClusters, dvec(dim, 0.));
+    streamCounts.assign(nbClusters, 0);
+}
+
+void ClustererKM::StreamBlock(const SampleView &block)
+{
+    if(!kmeans) return;
+    vector<fvec> means = kmeans->GetMeans();
+    int dim = block.Cols();
+    fvec sample(dim);
+    FOR(i, block.Rows())
+    {
+        block.CopyRow(i, &sample[0]);
+        int closest = 0;
+        float minDist = FLT_MAX;
+        FOR(k, means.size())
+        {
+            float dist = 0;
+            FOR(d, dim)
+            {
+                float diff = sample[d] - means[k][d];
+                dist += diff*diff;
+            }
+            if(dist < minDist)
+            {
+                minDist = dist;
+                closest = k;
+            }
+        }
+        FOR(d, dim) streamSums[closest][d] += sample[d];
+        streamCounts[closest]++;
+    }
+}
+
+bool ClustererKM::StreamEnd(const int pass)
+{
+    if(!kmeans) return false;
+    vector<fvec> means = kmeans->GetMeans();
+    float shift = 0;
+    FOR(k, means.size())
+    {
+        if(!streamCounts[k]) continue; // empty clusters keep their previous position
+        FOR(d, means[k].size())
+        {
+            float value = streamSums[k][d] / streamCounts[k];
+            shift += (value - means[k][d])*(value - means[k][d]);
+            means[k][d] = value;
+        }
+    }
+    kmeans->SetMeans(means);
+    return shift > 1e-10f;
+}
+
 fvec ClustererKM::Test( const fvec &sample)
 {
     fvec res;
@@ -83,6 +145,30 @@ fvec ClustererKM::Test( const fVec &sample)
     return res;
 }
 
+fvec ClustererKM::TestMany(const fvec &sampleMatrix, const int dim, const int count)
+{
+    fvec results;
+    if(sampleMatrix.size() != dim*count) return results;
+    if(!kmeans)
+    {
+        results.resize(count*nbClusters, 0);
+        return results;
+    }
+    if(dim < (int)kmeans->GetMean().size()) return Clusterer::TestMany(sampleMatrix, dim, count);
+    int clusters = kmeans->GetClusters();
+    results.resize(count*clusters);
+    if(!count) return results;
+    kmeans->TestMany(&sampleMatrix[0], dim, count, &results[0]);
+    FOR(i, count)
+    {
+        float *res = &results[i*clusters];
+        float sum = 0;
+        FOR(j, clusters) sum += res[j];
+        FOR(j, clusters) res[j] /= sum;
+    }
+    return results;
+}
+
 void ClustererKM::SetParams(u32 clusters, int method, float beta, int power, bool kmeansPlusPlus)
 {
 
@@ -31,11 +31,13 @@ private:
 	bool bGmm;
 	int power;
 	bool kmeansPlusPlus;
+	std::vector<dvec> streamSums;
+	ivec streamCounts;
 
 public:
 	KMeansCluster *kmeans;
 
-    ClustererKM() : beta(1), bSoft(false), bGmm(false), kmeans(0), kmeansPlusPlus(true) {}
+    ClustererKM() : beta(1), bSoft(false), bGmm(false), kmeans(0), kmeansPlusPlus(true) {bThreadSafe = true;}
     ~ClustererKM();
     ClustererKM(const ClustererKM& other) : beta(other.beta), bSoft(other.bSoft), bGmm(other.bGmm),
         power(other.power), kmeansPlusPlus(other.kmeansPlusPlus)
@@ -47,8 +49,14 @@ public:
 	void Train(std::vector< fvec > samples);
 	fvec Test( const fvec &sample);
 	fvec Test( const fVec &sample);
+    fvec TestMany( const fvec &sampleMatrix, const int dim, const int count);
     const char *GetInfoString();
 
+    int StreamPasses();
+    void StreamBegin(const int pass, const int dim);
+    void StreamBlock(const SampleView &block);
+    bool StreamEnd(const int pass);
+
     void SetParams(u32 nbClusters, int method, float beta, int power, bool kmeansPlusPlus);
 };
 
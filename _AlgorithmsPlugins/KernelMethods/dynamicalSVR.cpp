@@ -52,6 +52,7 @@ DynamicalSVR::DynamicalSVR()
 : node(0)
 {
 	type = DYN_SVR;
+	bThreadSafe = true;
 	// default values
 	param.svm_type = EPSILON_SVR;
 	//param.svm_type = NU_SVR;
@@ -177,6 +178,69 @@ fvec DynamicalSVR::Test( const fvec &sample )
 	return res;
 }
 
+void DynamicalSVR::TestBatch(const SampleView &samples, fvec &velocities)
+{
+    int rows = samples.Rows();
+    int dim = samples.Cols();
+    velocities.resize(rows*dim);
+    if(svms.size() != dim)
+    {
+        // same fallback as Test: the samples are returned unchanged
+        FOR(i, rows) FOR(d, dim) velocities[i*dim + d] = samples(i,d);
+        return;
+    }
+    vector<double> x;
+    vector<svm_node> node(dim+1);
+    FOR(d, dim) node[d].index = d+1;
+    node[dim].index = -1;
+    // each output dimension has its own model, we evaluate them one after the other over all the samples
+    FOR(o, dim)
+    {
+        const svm_model *svm = svms[o];
+        const svm_parameter &p = svm->param;
+        if(p.kernel_type != LINEAR && p.kernel_type != POLY && p.kernel_type != RBF)
+        {
+            FOR(i, rows)
+            {
+                FOR(d, dim) node[d].value = samples(i,d);
+                velocities[i*dim + o] = (float)svm_predict(svm, &node[0]);
+            }
+            continue;
+        }
+        // dense copy of the support vectors, the kernel values are computed directly on it
+        int l = svm->l;
+        int D = dim;
+        FOR(k, l) for(const svm_node *n = svm->SV[k]; n->index != -1; n++) D = max(D, n->index);
+        vector<double> sv((size_t)l*D, 0);
+        FOR(k, l) for(const svm_node *n = svm->SV[k]; n->index != -1; n++) sv[(size_t)k*D + n->index-1] = n->value;
+        const double *coef = svm->sv_coef[0];
+        double norm = p.kernel_type == RBF && p.normalizeKernel ? p.kernel_norm : 1.;
+        x.assign(D, 0);
+        FOR(i, rows)
+        {
+            FOR(d, dim) x[d] = samples(i,d);
+            double estimate = 0;
+            FOR(k, l)
+            {
+                const double *s = &sv[(size_t)k*D];
+                double sum = 0, kvalue;
+                if(p.kernel_type == RBF)
+                {
+                    FOR(d, D) sum += (x[d]-s[d])*(x[d]-s[d]);
+                    kvalue = norm*exp(-p.gamma*sum);
+                }
+                else
+                {
+                    FOR(d, D) sum += x[d]*s[d];
+                    kvalue = p.kernel_type == LINEAR ? sum : pow(p.gamma*sum + p.coef0, p.degree);
+                }
+                estimate += coef[k]*kvalue;
+            }
+            velocities[i*dim + o] = (float)(estimate - svm->rho[0]);
+        }
+    }
+}
+
 fVec DynamicalSVR::Test( const fVec &sample )
 {
 	int dim = 2;
@@ -82,7 +82,7 @@ void ClustKKM::DrawModel(Canvas *canvas, QPainter &painter, Clusterer *clusterer
 {
     painter.setRenderHint(QPainter::Antialiasing);
 
-    FOR(i, canvas->data->GetSamples().size())
+    FOR(i, canvas->data->GetCount())
     {
         fvec sample = canvas->data->GetSample(i);
         QPointF point = canvas->toCanvasCoords(sample);
@@ -371,7 +371,7 @@ void ClustKM::DrawModel(Canvas *canvas, QPainter &painter, Clusterer *clusterer)
     if(!canvas || !clusterer) return;
     painter.setRenderHint(QPainter::Antialiasing);
 
-    FOR(i, canvas->data->GetSamples().size())
+    FOR(i, canvas->data->GetCount())
     {
         fvec sample = canvas->data->GetSampleDim(i, canvas->sourceDims);
         fvec fullSample = canvas->data->GetSample(i);
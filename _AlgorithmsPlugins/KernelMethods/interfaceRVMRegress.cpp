@@ -248,10 +248,15 @@ void RegrRVM::DrawModel(Canvas *canvas, QPainter &painter, Regressor *regressor)
     canvas->maps.confidence = QPixmap();
     int steps = w;
     QPainterPath path;
+    // the whole curve is evaluated in a single batch
+    SampleMatrix curve;
+    FOR(x, steps) curve.AddRow(canvas->toSampleCoords(x,0));
+    fvec means, confidences;
+    regressor->TestBatch(curve.View(), means, confidences);
     FOR(x, steps)
     {
-        sample = canvas->toSampleCoords(x,0);
-        fvec res = regressor->Test(sample);
+        sample = curve.Row(x);
+        const float res[2] = {means[x], confidences[x]};
         if(res[0] != res[0]) continue;
         QPointF point = canvas->toCanvasCoords(sample[xIndex], res[0]);
         if(x)
@@ -381,10 +381,11 @@ void RegrSVM::DrawInfo(Canvas *canvas, QPainter &painter, Regressor *regressor)
             fvec sv(2,0);
             if(params.svm_type == NU_SVR){
                 float epsilon = fabs(svm->eps[0]) - 1e-5;
+                fvec means, confidences;
+                if(samples.size()) regr->TestBatch(SampleMatrix(samples).View(), means, confidences);
                 FOR(i, samples.size())
                 {
-                    fvec res = regr->Test(samples[i]);
-                    if(fabs(samples[i][regr->outputDim] - res[0]) < epsilon) continue;
+                    if(fabs(samples[i][regr->outputDim] - means[i]) < epsilon) continue;
                     QPointF point = canvas->toCanvasCoords(samples[i]);
                     int radius = 9;
                     painter.drawEllipse(point, radius, radius);
@@ -427,10 +428,15 @@ void RegrSVM::DrawModel(Canvas *canvas, QPainter &painter, Regressor *regressor)
         canvas->maps.confidence = QPixmap();
         int steps = w;
         QPainterPath path;
+        // the whole curve is evaluated in a single batch
+        SampleMatrix curve;
+        FOR(x, steps) curve.AddRow(canvas->toSampleCoords(x,0));
+        fvec means, confidences;
+        regressor->TestBatch(curve.View(), means, confidences);
         FOR(x, steps)
         {
-            sample = canvas->toSampleCoords(x,0);
-            fvec res = regressor->Test(sample);
+            sample = curve.Row(x);
+            const float res[2] = {means[x], confidences[x]};
             if(res[0] != res[0]) continue;
             QPointF point = canvas->toCanvasCoords(sample[xIndex], res[0]);
             if(x)
@@ -453,10 +459,15 @@ void RegrSVM::DrawModel(Canvas *canvas, QPainter &painter, Regressor *regressor)
 
         int steps = w;
         QPainterPath path, pathUp, pathDown;
+        // the whole curve is evaluated in a single batch
+        SampleMatrix curve;
+        FOR(x, steps) curve.AddRow(canvas->toSampleCoords(x,0));
+        fvec means, confidences;
+        regressor->TestBatch(curve.View(), means, confidences);
         FOR(x, steps)
         {
-            sample = canvas->toSampleCoords(x,0);
-            fvec res = regressor->Test(sample);
+            sample = curve.Row(x);
+            const float res[2] = {means[x], confidences[x]};
             if(res[0] != res[0]) continue;
             QPointF point = canvas->toCanvasCoords(sample[xIndex], res[0]);
             if(x)
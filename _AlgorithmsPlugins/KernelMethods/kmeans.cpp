@@ -69,6 +69,34 @@ float KMeansCluster::Distance( fvec a, fvec b )
     return d;
 }
 
+float KMeansCluster::Distance( const float *a, const float *b )
+{
+    float d = 0;
+    if(power == 0) // infinite distance
+    {
+        FOR(i, dim) d = max(d, abs(a[i]-b[i]));
+    }
+    else if(power == 1) // manhattan distance
+    {
+        FOR(i, dim) d += abs(a[i]-b[i]);
+    }
+    else if(power == 2)
+    {
+        FOR(i, dim) d += (a[i]-b[i])*(a[i]-b[i]);
+    }
+    else if(power > 2)
+    {
+        FOR(i, dim)
+        {
+            float p = abs(a[i]-b[i]);
+            float p2 = 1;
+            FOR(j, power) p2 *= p;
+            d += p2;
+        }
+    }
+    return d;
+}
+
 float KMeansCluster::Distance2( fvec a, fvec b )
 {
     float d = 0;
@@ -391,6 +419,47 @@ void KMeansCluster::Test( fvec sample, fvec &res )
     }
 }
 
+void KMeansCluster::TestMany(const float *samples, const int stride, const int count, float *res)
+{
+    // the means are packed in a single buffer, the samples are read in place
+    fvec packed(clusters*dim);
+    FOR(j, clusters) FOR(d, dim) packed[j*dim + d] = means[j][d];
+    FOR(i, count)
+    {
+        const float *sample = samples + (size_t)i*stride;
+        float *r = res + (size_t)i*clusters;
+        if(bSoft)
+        {
+            float distanceSum = 0;
+            FOR(j, clusters)
+            {
+                const float *mean = &packed[j*dim];
+                float distance = 0;
+                FOR(d, dim) distance += (mean[d] - sample[d])*(mean[d] - sample[d]);
+                r[j] = fastExp(-beta * sqrtf(distance));
+                distanceSum += r[j];
+            }
+            FOR(j, clusters) r[j] /= distanceSum;
+        }
+        else
+        {
+            int minIndex = 0;
+            float minDist = FLT_MAX;
+            FOR(j, clusters)
+            {
+                float distance = Distance(sample, &packed[j*dim]);
+                if(distance < minDist)
+                {
+                    minIndex = j;
+                    minDist = distance;
+                }
+            }
+            FOR(j, clusters) r[j] = 0;
+            r[minIndex] = 1;
+        }
+    }
+}
+
 
 /**
 * performs the K-mean clustering algorithm
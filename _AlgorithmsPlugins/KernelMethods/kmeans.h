@@ -84,6 +84,8 @@ public:
 
 	void Clear();
 	void Test(fvec sample, fvec &res);
+    // tests count samples stored row-major with the given stride, res receives GetClusters() values per sample
+    void TestMany(const float *samples, const int stride, const int count, float *res);
 
     void SetPoint(u32 index, fvec point){if(index<points.size()) points[index].point = point;}
 
@@ -92,6 +94,7 @@ public:
 
     fvec GetMean(u32 index=0) {return index<clusters ? means[index] : fvec();}
     std::vector<fvec> GetMeans(){return means;}
+    void SetMeans(std::vector<fvec> newMeans){if(newMeans.size() == clusters) means = newMeans;}
 	ivec GetClosestPoints();
 
 	void SetClusters(u32 clusters);
@@ -101,6 +104,7 @@ public:
 
 	inline float Distance(fvec a, fvec b);
 	inline float Distance2(fvec a, fvec b);
+    inline float Distance(const float *a, const float *b);
 
     void SetSoft(bool soft){bSoft = soft;}
     void SetBeta(float b){beta = b > 0 ? b : 0.01f;}
@@ -131,6 +131,37 @@ fvec  RegressorKRLS::Test( const fvec &_sample )
 	return res;
 }
 
+// the sample buffer is allocated once and the kernel type is resolved once for the whole batch
+template<typename Trainer>
+static void TestKRLSBatch(const Trainer &trainer, const SampleView &samples, const int dim, const int outputDim, fvec &means)
+{
+    reg_sample_type sample(dim);
+    FOR(i, samples.Rows())
+    {
+        FOR(d, dim) sample(d) = samples(i,d);
+        if(outputDim != -1 && outputDim < dim) sample(outputDim) = samples(i,dim);
+        means[i] = trainer(sample);
+    }
+}
+
+void RegressorKRLS::TestBatch(const SampleView &samples, fvec &means, fvec &confidences)
+{
+    means.assign(samples.Rows(), 0.f);
+    confidences.assign(samples.Rows(), 0.f);
+    switch(kernelType)
+    {
+    case 0:
+        if(linTrainer) TestKRLSBatch(*linTrainer, samples, dim, outputDim, means);
+        break;
+    case 1:
+        if(polTrainer) TestKRLSBatch(*polTrainer, samples, dim, outputDim, means);
+        break;
+    case 2:
+        if(rbfTrainer) TestKRLSBatch(*rbfTrainer, samples, dim, outputDim, means);
+        break;
+    }
+}
+
 fVec  RegressorKRLS::Test( const fVec &_sample )
 {
 	fVec res;
@@ -50,6 +50,7 @@ public:
 	void Train(std::vector< fvec > samples, ivec labels);
 	fvec Test( const fvec &sample);
 	fVec Test(const fVec &sample);
+    void TestBatch(const SampleView &samples, fvec &means, fvec &confidences);
     const char *GetInfoString();
 
 	void SetParams(float epsilon, int capacity, int kernelType, float kernelParam, int kernelDegree)
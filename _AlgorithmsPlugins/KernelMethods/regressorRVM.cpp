@@ -162,6 +162,46 @@ fvec  RegressorRVM::Test( const fvec &_sample )
 	return res;
 }
 
+// the relevance vectors, their covariance and the noise precision are fetched once for the whole batch
+// instead of being copied out of the trainer for every sample
+template<typename Trainer, typename Function>
+static void TestRVMBatch(const Trainer &trainer, const Function &func, const SampleView &samples, const int dim, const int outputDim, fvec &means, fvec &confidences)
+{
+    const double beta = trainer.GetBeta();
+    const auto &sigma = trainer.GetSigma();
+    const auto &vectors = trainer.GetVectors();
+    const auto &kernel = trainer.GetKernel();
+    reg_sample_type sample(dim), phi;
+    phi.set_size(vectors.size());
+    FOR(i, samples.Rows())
+    {
+        FOR(d, dim) sample(d) = samples(i,d);
+        if(outputDim != -1 && outputDim < dim) sample(outputDim) = samples(i,dim);
+        means[i] = func(sample);
+        FOR(k, vectors.size()) phi(k) = kernel(sample, vectors[k]);
+        float variance = 1./beta + dlib::trans(phi)*sigma*phi;
+        confidences[i] = sqrt(variance);
+    }
+}
+
+void RegressorRVM::TestBatch(const SampleView &samples, fvec &means, fvec &confidences)
+{
+    means.assign(samples.Rows(), 0.f);
+    confidences.assign(samples.Rows(), 0.f);
+    switch(kernelType)
+    {
+    case 0:
+        TestRVMBatch(linTrainer, linFunc, samples, dim, outputDim, means, confidences);
+        break;
+    case 1:
+        TestRVMBatch(polTrainer, polFunc, samples, dim, outputDim, means, confidences);
+        break;
+    case 2:
+        TestRVMBatch(rbfTrainer, rbfFunc, samples, dim, outputDim, means, confidences);
+        break;
+    }
+}
+
 fVec  RegressorRVM::Test( const fVec &_sample )
 {
 	fVec res;
@@ -47,6 +47,7 @@ public:
 	void Train(std::vector< fvec > samples, ivec labels);
 	fvec Test( const fvec &sample);
 	fVec Test(const fVec &sample);
+    void TestBatch(const SampleView &samples, fvec &means, fvec &confidences);
     const char *GetInfoString();
 
 	void SetParams(float epsilon, int kernelType, float kernelParam, int kernelDegree)
@@ -19,6 +19,7 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 *********************************************************************/
 #include <public.h>
 #include "regressorSVR.h"
+#include <gramCache.h>
 #include <nlopt/nlopt.hpp>
 #include <QDebug>
 
@@ -54,6 +55,7 @@ RegressorSVR::RegressorSVR()
     : svm(0), node(0)
 {
     type = REGR_SVR;
+    bTrainThreadSafe = true;
     // default values
     param.svm_type = EPSILON_SVR;
     //param.svm_type = NU_SVR;
@@ -281,9 +283,34 @@ void RegressorSVR::Train(std::vector< fvec > samples, ivec labels)
         problem.y[i] = samples[i][oDim];
     }
 
+    // inside a cross-validation the kernel of the training samples is read from the matrix shared by the folds
+    ivec rows;
+    std::shared_ptr<const GramMatrix> gram;
+    if(param.kernel_type <= SIGMOID)
+    {
+        ivec columns(dim);
+        FOR(d, dim) columns[d] = d;
+        if(outputDim != -1 && outputDim < dim) columns[outputDim] = dim;
+        gram = GramScope::Lookup(gramScope, samples, GramKernel(param.kernel_type, param.degree, param.gamma, param.coef0, columns), rows);
+    }
+    if(gram)
+    {
+        FOR(i, problem.l) x_space[(dim+1)*i + dim].value = rows[i];
+        param.gram = gram->Data();
+        param.gram_size = gram->Size();
+    }
+
     DEL(svm);
     DEL(node);
     svm = svm_train(&problem, &param);
+    param.gram = 0;
+    param.gram_size = 0;
+    // the model keeps a copy of param, it must not point to the cache once we let go of it
+    if(svm)
+    {
+        svm->param.gram = 0;
+        svm->param.gram_size = 0;
+    }
     if(bOptimize) Optimize(&problem);
 
     delete [] problem.x;
@@ -315,6 +342,65 @@ fvec RegressorSVR::Test( const fvec &sample )
     return res;
 }
 
+void RegressorSVR::TestBatch(const SampleView &samples, fvec &means, fvec &confidences)
+{
+    int rows = samples.Rows();
+    int dim = samples.Cols()-1;
+    means.assign(rows, 0.f);
+    confidences.assign(rows, 1.f);
+    if(!svm || !rows || dim < 0) return;
+    bool bSwap = outputDim != -1 && outputDim < dim;
+    const svm_parameter &p = svm->param;
+    int l = svm->l;
+    const double *coef = svm->sv_coef[0];
+
+    if(p.kernel_type != LINEAR && p.kernel_type != POLY && p.kernel_type != RBF)
+    {
+        // other kernels go through libsvm, with a single node buffer for all the samples
+        vector<svm_node> x(dim+1);
+        FOR(d, dim) x[d].index = d+1;
+        x[dim].index = -1;
+        FOR(i, rows)
+        {
+            FOR(d, dim) x[d].value = samples(i,d);
+            if(bSwap) x[outputDim].value = samples(i,dim);
+            means[i] = (float)svm_predict(svm, &x[0]);
+        }
+        return;
+    }
+
+    // we unpack the support vectors in a dense matrix once, and compute the kernel values directly on it
+    int D = dim;
+    FOR(k, l) for(const svm_node *n = svm->SV[k]; n->index != -1; n++) D = max(D, n->index);
+    vector<double> sv((size_t)l*D, 0);
+    FOR(k, l) for(const svm_node *n = svm->SV[k]; n->index != -1; n++) sv[(size_t)k*D + n->index-1] = n->value;
+    double norm = p.kernel_type == RBF && p.normalizeKernel ? p.kernel_norm : 1.;
+    vector<double> x(D, 0);
+    FOR(i, rows)
+    {
+        FOR(d, dim) x[d] = samples(i,d);
+        if(bSwap) x[outputDim] = samples(i,dim);
+        double estimate = 0;
+        FOR(k, l)
+        {
+            const double *s = &sv[(size_t)k*D];
+            double sum = 0, kvalue;
+            if(p.kernel_type == RBF)
+            {
+                FOR(d, D) sum += (x[d]-s[d])*(x[d]-s[d]);
+                kvalue = norm*exp(-p.gamma*sum);
+            }
+            else
+            {
+                FOR(d, D) sum += x[d]*s[d];
+                kvalue = p.kernel_type == LINEAR ? sum : pow(p.gamma*sum + p.coef0, p.degree);
+            }
+            estimate += coef[k]*kvalue;
+        }
+        means[i] = (float)(estimate - svm->rho[0]);
+    }
+}
+
 fVec RegressorSVR::Test( const fVec &sample )
 {
     int dim = 1;
@@ -37,6 +37,7 @@ public:
 	void Train(std::vector< fvec > samples, ivec labels);
 	fvec Test( const fvec &sample);
 	fVec Test(const fVec &sample);
+    void TestBatch(const SampleView &samples, fvec &means, fvec &confidences);
     void Optimize(svm_problem *problem);
     const char *GetInfoString();
 
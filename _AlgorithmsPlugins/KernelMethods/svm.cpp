@@ -166,7 +166,8 @@ void Cache::swap_index(int i, int j)
 
 Kernel::Kernel(int l, svm_node * const * x_, const svm_parameter& param)
 :kernel_type(param.kernel_type), degree(param.degree),
- gamma(param.gamma), coef0(param.coef0), kernel_weight(param.kernel_weight), kernel_norm(param.kernel_norm)
+ gamma(param.gamma), coef0(param.coef0), kernel_weight(param.kernel_weight), kernel_norm(param.kernel_norm),
+ gram(param.gram), gram_size(param.gram_size), rows(0)
 {
 	switch(kernel_type)
 	{
@@ -201,6 +202,19 @@ Kernel::Kernel(int l, svm_node * const * x_, const svm_parameter& param)
 		while(x[0][dim].index != -1) dim++;
 	}
 
+	if(gram && (kernel_type == LINEAR || kernel_type == POLY || kernel_type == RBF || kernel_type == SIGMOID))
+	{
+		// the kernel values are read from the precomputed matrix, at the rows held by the terminating nodes
+		rows = new int[l];
+		for(int i=0;i<l;i++)
+		{
+			const svm_node *px = x[i];
+			while(px->index != -1) ++px;
+			rows[i] = (int)px->value;
+		}
+		kernel_function = &Kernel::kernel_gram;
+	}
+
 	if(kernel_type == RBF)
 	{
 		x_square = new double[l];
@@ -221,12 +235,20 @@ Kernel::~Kernel()
 {
     delete [] x;
     delete [] x_square;
+    delete [] rows;
 }
 
 void Kernel::swap_index(int i, int j) const	// no so const...
 {
 	swap(x[i],x[j]);
 	if(x_square) swap(x_square[i],x_square[j]);
+	if(rows) swap(rows[i],rows[j]);
+}
+
+double Kernel::kernel_gram(const int i, const int j) const
+{
+	double value = gram[(size_t)rows[i]*gram_size + rows[j]];
+	return kernel_type == SIGMOID ? value : kernel_norm*value;
 }
 
 double Kernel::kernel_linear(const int i, const int j) const
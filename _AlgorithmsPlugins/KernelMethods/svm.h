@@ -65,6 +65,8 @@ struct svm_parameter
 	int kernel_dim;			/* for rbfweight/rbfwmatrix */
 	bool normalizeKernel;
 	double kernel_norm;
+	const double *gram;		/* precomputed kernel of a block of samples (gram_size x gram_size), for linear/poly/rbf/sigmoid */
+	int gram_size;			/* the index -1 node ending each training sample holds its row in the block as value */
 
 	/* these are for training only */
 	double cache_size;		/* in MB */
@@ -78,7 +80,7 @@ struct svm_parameter
 	int shrinking;			/* use the shrinking heuristics */
 	int probability;		/* do probability estimates */
 
-    svm_parameter() : kernel_weight(0), weight_label(0), weight(0), kernel_dim(0), nr_weight(0){}
+    svm_parameter() : kernel_weight(0), weight_label(0), weight(0), kernel_dim(0), nr_weight(0), gram(0), gram_size(0){}
     svm_parameter& operator= (const svm_parameter &param);
 
 };
@@ -186,6 +188,9 @@ private:
 	const double gamma;
 	const double coef0;
 	double kernel_norm;
+	const double *gram;
+	int gram_size;
+	int *rows;	// row of each sample in gram
 
 	static double dot(const svm_node *px, const svm_node *py);
 	static double dot(const svm_node *px, const svm_node *py, const double *weight);
@@ -197,6 +202,7 @@ private:
 	double kernel_rbf_w(const int i, const int j) const;
 	double kernel_sigmoid(const int i, const int j) const;
 	double kernel_precomputed(const int i, const int j) const;
+	double kernel_gram(const int i, const int j) const;
 };
 
 struct	svm_model *svm_train(const struct svm_problem *prob, const struct svm_parameter *param);
@@ -97,6 +97,23 @@ fvec DynamicalLWPR::Test( const fvec &sample)
 	return res;
 }
 
+void DynamicalLWPR::TestBatch(const SampleView &samples, fvec &velocities)
+{
+    int rows = samples.Rows();
+    int dim = samples.Cols();
+    velocities.assign(rows*dim, 0.f);
+    if(!model || !dim || model->model.nIn != dim) return;
+    // the input and output buffers are shared by all the samples, and we call the C predictor on them directly
+    int outputs = std::min(dim, model->model.nOut);
+    dvec x(dim), y(model->model.nOut);
+    FOR(i, rows)
+    {
+        FOR(d, dim) x[d] = samples(i,d);
+        lwpr_predict(&model->model, &x[0], 0.001, &y[0], NULL, NULL);
+        FOR(d, outputs) velocities[i*dim + d] = y[d];
+    }
+}
+
 fVec DynamicalLWPR::Test( const fVec &sample)
 {
 	int dim = 2;
@@ -55,6 +55,34 @@ void RegressorLWPR::Train(std::vector< fvec > samples, ivec labels)
 	}
 }
 
+// lwpr is an incremental learner, a single pass over the blocks is equivalent to Train
+void RegressorLWPR::StreamBegin(const int pass, const int dim)
+{
+    this->dim = dim;
+    DEL(model);
+    model = new LWPR_Object(dim-1,1);
+    model->setInitD(initD);
+    model->setInitAlpha(initAlpha);
+    model->wGen(wGen);
+}
+
+void RegressorLWPR::StreamBlock(const SampleView &block)
+{
+    if(!model) return;
+    dvec x(dim-1), y(1);
+    FOR(i, block.Rows())
+    {
+        FOR(d, dim-1) x[d] = block(i,d);
+        if(outputDim != -1 && outputDim < dim-1)
+        {
+            x[outputDim] = block(i,dim-1);
+            y[0] = block(i,outputDim);
+        }
+        else y[0] = block(i,dim-1);
+        model->update(x,y);
+    }
+}
+
 fvec RegressorLWPR::Test( const fvec &sample)
 {
 	fvec res;
@@ -74,6 +102,26 @@ fvec RegressorLWPR::Test( const fvec &sample)
 	return res;
 }
 
+void RegressorLWPR::TestBatch(const SampleView &samples, fvec &means, fvec &confidences)
+{
+    int rows = samples.Rows();
+    int dim = samples.Cols();
+    means.assign(rows, 0.f);
+    confidences.assign(rows, 0.f);
+    if(!model || dim < 2 || model->model.nIn != dim-1) return;
+    // the input and output buffers are shared by all the samples, and we call the C predictor on them directly
+    dvec x(dim-1), y(model->model.nOut), sigma(model->model.nOut);
+    bool bSwap = outputDim != -1 && outputDim < dim-1;
+    FOR(i, rows)
+    {
+        FOR(d, dim-1) x[d] = samples(i,d);
+        if(bSwap) x[outputDim] = samples(i,dim-1);
+        lwpr_predict(&model->model, &x[0], 0.001, &y[0], &sigma[0], NULL);
+        means[i] = y[0];
+        confidences[i] = sqrtf(sigma[0]);
+    }
+}
+
 void RegressorLWPR::SetParams(double initD, double initAlpha, double wGen)
 {
 	this->initD = initD;
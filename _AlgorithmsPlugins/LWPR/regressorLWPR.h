@@ -36,8 +36,14 @@ public:
 	RegressorLWPR();
 	void Train(std::vector< fvec > samples, ivec labels);
 	fvec Test( const fvec &sample);
+    void TestBatch(const SampleView &samples, fvec &means, fvec &confidences);
     const char *GetInfoString();
 
+    int StreamPasses(){return 1;}
+    void StreamBegin(const int pass, const int dim);
+    void StreamBlock(const SampleView &block);
+    bool StreamEnd(const int pass){return false;}
+
 	void SetParams(double initD, double initAlpha, double wGen);
     LWPR_Object *GetModel(){return model;}
 };
@@ -237,14 +237,45 @@ fvec RegressorLowess::Test(const fvec &sample)
         return res;
     }
 
-    //Compute distance of current sample to training samples
     fvec distances(samples.size());
+    size_t *sortIndexes = new size_t[samples.size()];
+    calcEstimate(sample, distances, sortIndexes, res[0], res[1]);
+
+    //Clean up
+    delete[] sortIndexes;
+    sortIndexes = NULL;
+
+    return res;
+}
+
+void RegressorLowess::TestBatch(const SampleView &queries, fvec &estimates, fvec &variances)
+{
+    int rows = queries.Rows();
+    estimates.assign(rows, 0.f);
+    variances.assign(rows, 0.f);
+    if (!Ready() || !rows) return;
+
+    //The sample, distance and sorting buffers are shared by all the queries
+    fvec sample(queries.Cols());
+    fvec distances(samples.size());
+    size_t *sortIndexes = new size_t[samples.size()];
+    FOR(i, rows)
+    {
+        queries.CopyRow(i, &sample[0]);
+        calcEstimate(sample, distances, sortIndexes, estimates[i], variances[i]);
+    }
+    delete[] sortIndexes;
+}
+
+//Local regression at the location of sample, distances and sortIndexes are work buffers of samples.size() elements
+void RegressorLowess::calcEstimate(const fvec &sample, fvec &distances, size_t *sortIndexes, float &estimate, float &variance)
+{
+    //Compute distance of current sample to training samples
     calcDistances(sample, distances);
 
     //Sort the distances to find the nearest neighbors
     //We need to use a stable sort, otherwise points that have identical
     //coordinates except for outputDim may be selected in a random fashion.
-    size_t *sortIndexes = new size_t[samples.size()];
     FOR(i, samples.size())
         sortIndexes[i] = i;
     mergesort_perm(&distances[0], sortIndexes, 0, samples.size()-1);
@@ -329,15 +360,9 @@ fvec RegressorLowess::Test(const fvec &sample)
     double y_est, y_err;
     gsl_multifit_linear_est(x, c, cov, &y_est, &y_err);
 
-    res[0]  = y_est;  // the regression estimation
-    res[1]  = y_err;  // stdev of the estimation
-    res[1] *= res[1]; //convert stdev to variance
-
-    //Clean up
-    delete[] sortIndexes;
-    sortIndexes = NULL;
-
-    return res;
+    estimate  = y_est;     // the regression estimation
+    variance  = y_err;     // stdev of the estimation
+    variance *= variance;  //convert stdev to variance
 }
 
 void RegressorLowess::StoreLastRadius()
@@ -50,6 +50,7 @@ public:
     ~RegressorLowess();
     void Train(std::vector< fvec > trainSamples, ivec labels);
     fvec Test(const fvec &sample);
+    void TestBatch(const SampleView &queries, fvec &estimates, fvec &variances);
     const char *GetInfoString();
 
     void SetParams(double param1, lowessWeightFunc param2, lowessFitType param3, lowessNormType param4);
@@ -86,6 +87,7 @@ private:
     gsl_vector *x;
 
     void  calcDistances(const fvec &sample, fvec &distances);
+    void  calcEstimate (const fvec &sample, fvec &distances, size_t *sortIndexes, float &estimate, float &variance);
     float calcWeighting(float distance, float radius, float minWeight);
     void  showErrorMsg_zeroSpread  ();
     void  showErrorMsg_tooFewPoints();
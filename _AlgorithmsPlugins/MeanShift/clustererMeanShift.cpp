@@ -107,6 +107,35 @@ fvec ClustererMeanShift::Test( const fvec &sample) {
     return res;
 }
 
+fvec ClustererMeanShift::TestMany(const fvec &sampleMatrix, const int dim, const int count) {
+    fvec results;
+    if(sampleMatrix.size() != dim*count) return results;
+    results.resize(count*nbClusters, 0);
+    if(clusters.empty()) return results;
+    float kernelW = kernelWidth;
+    if(testMax > 1) {
+        float ratio = (testCount) / (float)testMax;
+        kernelW = kernelW*(1-ratio);
+    }
+    // the input and shifted points are reused for all the samples
+    dvec point(dim), outputPoint;
+    FOR(i, count) {
+        FOR(d, dim) point[d] = sampleMatrix[i*dim + d];
+        meanShift->shift_point(point, points, kernelW, outputPoint);
+        int closest = 0;
+        float closestDistance = FLT_MAX;
+        FOR(c, clusters.size()) {
+            float distance = meanShift->distance(outputPoint, clusters[c].mode);
+            if(distance < closestDistance) {
+                closest = c;
+                closestDistance = distance;
+            }
+        }
+        results[i*nbClusters + closest] = 1;
+    }
+    return results;
+}
+
 const char *ClustererMeanShift::GetInfoString() {
     stringstream s;
     s << "MeanShift\n\n";
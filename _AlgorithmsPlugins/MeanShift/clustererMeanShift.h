@@ -37,6 +37,7 @@ public:
 
     void Train(std::vector< fvec > samples);
     fvec Test(const fvec &sample);
+    fvec TestMany(const fvec &sampleMatrix, const int dim, const int count);
     const char *GetInfoString();
     void SetParams(float kernelWidth, float mergeRadius);
     bool SetClusterTestValue(int count, int max);
@@ -304,3 +304,22 @@ CVOLearner::fvec CVOLearner::project( const fvec& sample )
     // A^1/2 * x
     return fromColumnVec( m_A.cwiseSqrt() * toColumnVec(sample) );
 }
+
+bool CVOLearner::project( const float* samples, int count, int rowStride, float* result ) const
+{
+    if( m_A.trace() == 0 )
+        return false;
+
+    // Test for nan
+    for( int i = 0; i < m_A.rows(); ++i ) {
+        if( m_A(i,i) != m_A(i,i) ) {
+            return false;
+        }
+    }
+    typedef Eigen::Map<const MatrixXXf, 0, Eigen::OuterStride<> > SampleMap;
+    SampleMap X(samples, count, m_A.cols(), Eigen::OuterStride<>(rowStride));
+    Eigen::Map<MatrixXXf> Y(result, count, m_A.rows());
+    // (A^1/2 * x)^T for every row x of X, in a single product
+    Y.noalias() = X * m_A.cwiseSqrt().transpose();
+    return true;
+}
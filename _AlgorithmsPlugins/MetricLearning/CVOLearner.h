@@ -32,6 +32,14 @@ public:
     void train( const fvecVec& similar, const fvecVec& dissimilar );
     fvec project( const fvec& sample );
 
+    /**
+     * @brief Project count samples stored one row after the other (rowStride floats apart)
+     * @param result count x dim() output, row-major
+     * @return false if there are no usable coefficients, result is left untouched
+     */
+    bool project( const float* samples, int count, int rowStride, float* result ) const;
+    int dim() const { return m_A.rows(); }
+
     /**
      * @brief Return learned coefficient for matrix A
      * @return
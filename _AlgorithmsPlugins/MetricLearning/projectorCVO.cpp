@@ -170,12 +170,7 @@ void ProjectorCVO::Train( fvecVec samples, ivec labels )
     m_learner->train(data.first, data.second);
 
     // Project new
-    projected.clear();
-    projected.reserve(samples.size());
-    for( size_t i = 0; i < samples.size(); ++i ) {
-        fvec tmp = Project(samples.at(i));
-        projected.push_back(tmp);
-    }
+    projected = ProjectSamples(samples);
 }
 
 fvec ProjectorCVO::Project( const fvec& sample )
@@ -186,6 +181,35 @@ fvec ProjectorCVO::Project( const fvec& sample )
         return sample;
 }
 
+int ProjectorCVO::ProjectBatch( const SampleView& samples, fvec& projections )
+{
+    int dim = samples.Cols();
+    if( !m_learner->isValid() || dim != m_learner->dim() )
+        return Projector::ProjectBatch(samples, projections);
+
+    int rows = samples.Rows();
+    projections.resize(size_t(rows) * dim);
+    if( !rows )
+        return dim;
+
+    // Eigen maps the rows directly when they are contiguous
+    fvec packed;
+    const float* data = samples.RowData(0);
+    int stride = samples.stride;
+    if( !samples.Contiguous() ) {
+        packed.resize(size_t(rows) * dim);
+        samples.CopyTo(&packed[0]);
+        data = &packed[0];
+        stride = dim;
+    }
+    if( !m_learner->project(data, rows, stride, &projections[0]) ) { // samples returned as they are
+        for( int i = 0; i < rows; ++i ) {
+            samples.CopyRow(i, &projections[size_t(i) * dim]);
+        }
+    }
+    return dim;
+}
+
 void ProjectorCVO::setAlpha( float alpha )
 {
     m_learner->setAlpha(alpha);
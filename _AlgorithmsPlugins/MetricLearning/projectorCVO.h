@@ -25,6 +25,7 @@ public:
 
     void Train( fvecVec samples, ivec labels );
     fvec Project( const fvec& sample );
+    int ProjectBatch( const SampleView& samples, fvec& projections );
     const char* GetInfoString() { return "CVX Opt Metric Learner"; }
     fvecVec matrixCoeff();
 
@@ -4,6 +4,7 @@
 DSAvoid::DSAvoid()
 	: dim(2), obs(0)
 {
+	bThreadSafe = true;
 }
 
 DSAvoid::~DSAvoid()
@@ -14,6 +15,7 @@ DSAvoid::~DSAvoid()
 void DSAvoid::Clear()
 {
 	KILL(obs);
+	prepared.clear();
 }
 
 void DSAvoid::SetObstacles(std::vector< Obstacle > newObstacles)
@@ -36,6 +38,7 @@ void DSAvoid::SetObstacles(std::vector< Obstacle > newObstacles)
 		}
 	}
 
+	if(!obs) prepared.clear();
 	if(!obs && obstacles.size())
 	{
 		obs = new DSObstacle[obstacles.size()];
@@ -47,6 +50,97 @@ void DSAvoid::SetObstacles(std::vector< Obstacle > newObstacles)
 		num_obs = obstacles.size();
 
 		init(num_obs);
+
+		prepared.resize(obstacles.size());
+		FOR(i, obstacles.size())
+		{
+			const Obstacle &o = obstacles[i];
+			DSPreparedObstacle &p = prepared[i];
+			p.cx = o.center[0];
+			p.cy = o.center[1];
+			p.cosA = cosf(o.angle);
+			p.sinA = sinf(o.angle);
+			p.ix = 1.f / (o.axes[0]*o.repulsion[0]);
+			p.iy = 1.f / (o.axes[1]*o.repulsion[1]);
+			p.nx = o.power[0] / o.axes[0];
+			p.ny = o.power[1] / o.axes[1];
+			p.px = o.power[0];
+			p.py = o.power[1];
+			p.bLinear = o.power[0] == 1.f && o.power[1] == 1.f;
+		}
+	}
+}
+
+// same modulation as Avoid, without the contouring (it follows a single trajectory from one call to the next)
+// in 2D the modulation matrix of an obstacle R*E*D*inv(E)*R' reduces to d0*n*n' + d1*t*t' with n the rotated unit normal
+// and t its tangent, so each obstacle is a pass over all the samples that fills the three terms of its symmetric matrix,
+// and the matrices are then applied to each velocity from the farthest obstacle to the closest one
+void DSAvoid::AvoidBatch(const SampleView &samples, fvec &velocities)
+{
+	int count = samples.Rows(), cols = samples.Cols(), obsCount = prepared.size();
+	if(!obsCount || cols < 2 || (int)velocities.size() < count*cols) return;
+
+	fvec gamma((size_t)obsCount*count), m00((size_t)obsCount*count), m01((size_t)obsCount*count), m11((size_t)obsCount*count);
+	FOR(o, obsCount)
+	{
+		const DSPreparedObstacle &p = prepared[o];
+		float *g = &gamma[(size_t)o*count], *a = &m00[(size_t)o*count], *b = &m01[(size_t)o*count], *c = &m11[(size_t)o*count];
+		FOR(i, count)
+		{
+			const float *x = samples.RowData(i);
+			float dx = x[0] - p.cx, dy = x[1] - p.cy;
+			float tx = (p.cosA*dx + p.sinA*dy)*p.ix;
+			float ty = (p.cosA*dy - p.sinA*dx)*p.iy;
+			float nx, ny;
+			if(p.bLinear)
+			{
+				nx = p.nx*tx;
+				ny = p.ny*ty;
+				g[i] = tx*tx + ty*ty;
+			}
+			else
+			{
+				nx = p.nx*powf(tx, 2*p.px-1);
+				ny = p.ny*powf(ty, 2*p.py-1);
+				g[i] = powf(tx, 2*p.px) + powf(ty, 2*p.py);
+			}
+			float rx = p.cosA*nx - p.sinA*ny, ry = p.sinA*nx + p.cosA*ny;
+			float norm = rx*rx + ry*ry;
+			float inv = norm > 0 && g[i] > 0 ? 1.f/(norm*g[i]) : 0;
+			// d0 = 1 - 1/gamma along the normal, d1 = 1 + 1/gamma along the tangent
+			a[i] = 1 + (ry*ry - rx*rx)*inv;
+			b[i] = -2*rx*ry*inv;
+			c[i] = 1 + (rx*rx - ry*ry)*inv;
+		}
+	}
+
+	ivec order(obsCount);
+	FOR(i, count)
+	{
+		float *xd = &velocities[(size_t)i*cols];
+		bool bInside = false;
+		FOR(o, obsCount)
+		{
+			order[o] = o;
+			bInside |= gamma[(size_t)o*count + i] < 1;
+		}
+		if(bInside) // we are inside an obstacle, we stop
+		{
+			xd[0] = xd[1] = 0;
+			continue;
+		}
+		FOR(o, obsCount)
+		{
+			FOR(k, obsCount-o-1)
+			{
+				int j = o+k+1;
+				if(gamma[(size_t)order[o]*count + i] < gamma[(size_t)order[j]*count + i]) std::swap(order[o], order[j]);
+			}
+			size_t index = (size_t)order[o]*count + i;
+			float vx = xd[0], vy = xd[1];
+			xd[0] = m00[index]*vx + m01[index]*vy;
+			xd[1] = m01[index]*vx + m11[index]*vy;
+		}
 	}
 }
 
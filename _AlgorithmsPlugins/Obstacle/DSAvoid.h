@@ -32,6 +32,16 @@ struct DSObstacle{
 	void Print();
 };
 
+// obstacle prepared for the batch modulation: rotation, scaling and exponents are computed once per SetObstacles
+struct DSPreparedObstacle{
+	float cx, cy;		//the center of the obstacle
+	float cosA, sinA;	//the orientation
+	float ix, iy;		//inverse of axes*safetyFactor
+	float nx, ny;		//power/axes, scale of the normal vector
+	float px, py;		//power
+	bool bLinear;		//unit power on both axes, the exponents reduce to products
+};
+
 class DSAvoid : public ObstacleAvoidance
 {
 public:
@@ -42,11 +52,13 @@ public:
 	fvec Avoid(fvec &x, fvec &xdot);
 	fVec Avoid(fVec &x, fVec &xdot);
 	void SetObstacles(std::vector< Obstacle > obstacles);
+	void AvoidBatch(const SampleView &samples, fvec &velocities);
 
 protected:
 	bool Avoid(Vector &x,Vector &xd);
 	int dim;
 	DSObstacle*		obs; //to model the obstacle
+	std::vector<DSPreparedObstacle> prepared; //the same obstacles, for AvoidBatch
 	Vector			x_t,d,nv,nv_rotated,e; //nv is the normal vector
 	Matrix			D;
 	bool			b_obstacle;  //check if the obstacle module is activated
@@ -88,6 +88,26 @@ float ClassifierMLP::Test( const fvec &sample) const
     return output.at<float>(0);
 }
 
+int ClassifierMLP::TestBatch(const SampleView &samples, fvec &scores) const
+{
+    int rows = samples.Rows();
+    if(!mlp || !rows || samples.Cols() < (int)dim) return Classifier::TestBatch(samples, scores);
+    // the whole batch goes through the network in a single predict call,
+    // directly on the samples when their rows are laid out as the network expects
+    Mat input;
+    if(samples.Contiguous() && samples.Cols() == (int)dim) input = Mat(rows, dim, CV_32FC1, (void *)samples.data, samples.stride*sizeof(float));
+    else
+    {
+        input = Mat(rows, dim, CV_32FC1);
+        FOR(i, rows) FOR(d, dim) input.at<float>(i,d) = samples(i,d);
+    }
+    Mat output;
+    mlp->predict(input, output);
+    scores.resize(rows);
+    FOR(i, rows) scores[i] = output.at<float>(i,0);
+    return 1;
+}
+
 void ClassifierMLP::SetParams(u32 functionType, u32 neuronCount, u32 layerCount, f32 alpha, f32 beta, u32 trainingType)
 {
 	this->functionType = functionType;
@@ -46,6 +46,7 @@ ClassifierTrees::ClassifierTrees()
 
     bSingleClass = false;
     bMultiClass = true;
+    bThreadSafe = true;
 
     treePainter = 0;
     treeDepth = 1;
@@ -265,6 +266,35 @@ fvec ClassifierTrees::TestMulti(const fvec &sample) const
     return res;
 }
 
+int ClassifierTrees::TestBatch(const SampleView &samples, fvec &scores) const
+{
+    int rows = samples.Rows();
+    if(!tree || !rows || samples.Cols() < (int)dim || maxClass < 1) return Classifier::TestBatch(samples, scores);
+    Mat input;
+    if(samples.Contiguous() && samples.Cols() == (int)dim) input = Mat(rows, dim, CV_32FC1, (void *)samples.data, samples.stride*sizeof(float));
+    else
+    {
+        input = Mat(rows, dim, CV_32FC1);
+        FOR(i, rows) FOR(d, dim) input.at<float>(i,d) = samples(i,d);
+    }
+    if(classMap.size() == 2)
+    {
+        scores.resize(rows);
+        FOR(i, rows) scores[i] = (tree->predict_prob(input.row(i))-0.5)*3;
+        return 1;
+    }
+    // multi-class forests vote on the whole batch in a single predict call
+    Mat output;
+    tree->predict(input, output);
+    scores.assign((size_t)rows*maxClass, 0.f);
+    FOR(i, rows)
+    {
+        int c = output.at<float>(i,0);
+        if(c >= 0 && c < maxClass) scores[(size_t)i*maxClass + c] = 1.0f;
+    }
+    return maxClass;
+}
+
 float ClassifierTrees::Test( const fvec &sample) const
 {
     if (tree == NULL){
@@ -55,6 +55,7 @@ public:
 	void Train(std::vector< fvec > samples, ivec labels);
     float Test(const fvec &sample) const ;
     fvec TestMulti(const fvec &sample) const ;
+    int TestBatch(const SampleView &samples, fvec &scores) const ;
     const char *GetInfoString() const ;
     fvec GetImportance() const ;
     void PrintTree(cv::ml::DTrees *tree, int count) const;
@@ -133,6 +133,21 @@ fvec DynamicalMLP::Test( const fvec &sample)
 	return res;
 }
 
+void DynamicalMLP::TestBatch(const SampleView &samples, fvec &velocities)
+{
+    int rows = samples.Rows();
+    int dim = samples.Cols();
+    velocities.assign(rows*dim, 0.f);
+    if(!mlp || !rows || !dim) return;
+    // the whole batch goes through the network in a single predict call
+    Mat input(rows, dim, CV_32FC1);
+    FOR(i, rows) FOR(d, dim) input.at<float>(i,d) = samples(i,d);
+    Mat output;
+    mlp->predict(input, output);
+    int outputs = min(dim, output.cols);
+    FOR(i, rows) FOR(d, outputs) velocities[i*dim + d] = output.at<float>(i,d);
+}
+
 void DynamicalMLP::SetParams(u32 functionType, u32 neuronCount, u32 layerCount, f32 alpha, f32 beta, u32 trainingType)
 {
 	this->functionType = functionType;
@@ -159,10 +159,15 @@ void RegrMLP::DrawModel(Canvas *canvas, QPainter &painter, Regressor *regressor)
     if(dim > 2) return;
 	int steps = w;
 	QPointF oldPoint(-FLT_MAX,-FLT_MAX);
+	// the whole curve is evaluated in a single batch
+	SampleMatrix curve;
+	FOR(x, steps) curve.AddRow(canvas->toSampleCoords(x,0));
+	fvec means, confidences;
+	regressor->TestBatch(curve.View(), means, confidences);
 	FOR(x, steps)
 	{
-        sample = canvas->toSampleCoords(x,0);
-		fvec res = regressor->Test(sample);
+        sample = curve.Row(x);
+        const float res[2] = {means[x], confidences[x]};
         if(res[0] != res[0]) continue; // NaN!
         QPointF point = canvas->toCanvasCoords(sample[xIndex], res[0]);
 		if(x)
@@ -119,6 +119,30 @@ fvec RegressorMLP::Test( const fvec &sample)
     return res;
 }
 
+void RegressorMLP::TestBatch(const SampleView &samples, fvec &means, fvec &confidences)
+{
+    int rows = samples.Rows();
+    int cols = samples.Cols();
+    means.assign(rows, 0.f);
+    confidences.assign(rows, 0.f);
+    if(!mlp || !rows) return;
+    // the whole batch goes through the network in a single predict call, with the
+    // desired output swapped out of the inputs and the missing dimensions set to zero as in Test
+    Mat input = Mat::zeros(rows, dim, CV_32FC1);
+    int swapDim = outputDim != -1 && outputDim < cols ? outputDim : -1;
+    FOR(i, rows)
+    {
+        FOR(d, min((int)dim, cols))
+        {
+            int source = d == swapDim ? cols-1 : (d == cols-1 && swapDim != -1 ? swapDim : d);
+            input.at<float>(i,d) = samples(i,source);
+        }
+    }
+    Mat output;
+    mlp->predict(input, output);
+    FOR(i, rows) means[i] = output.at<float>(i,0);
+}
+
 void RegressorMLP::SetParams(u32 functionType, u32 neuronCount, u32 layerCount, f32 alpha, f32 beta, u32 trainingType)
 {
 	this->functionType = functionType;
@@ -42,6 +42,7 @@ public:
 	~RegressorMLP();
 	void Train(std::vector< fvec > samples, ivec labels);
 	fvec Test( const fvec &sample);
+    void TestBatch(const SampleView &samples, fvec &means, fvec &confidences);
     const char *GetInfoString();
 
     void SetParams(u32 functionType, u32 neuronCount, u32 layerCount, f32 alpha, f32 beta, u32 trainingType);
@@ -19,6 +19,7 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 *********************************************************************/
 #include <public.h>
 #include "classifierKPCA.h"
+#include <gramCache.h>
 #include <QDebug>
 
 using namespace std;
@@ -79,6 +80,21 @@ void ClassifierKPCA::Train(std::vector< fvec > samples, ivec labels)
 	int count = samples.size();
 	int dim = samples[0].size();
 
+	// inside a cross-validation the rbf kernel (which centering leaves unchanged) is read from the matrix shared by the folds
+	// it is computed on the samples before centering, so its values can differ from ours in the last bits
+	MatrixXd kernelMatrix;
+	if(kernelType == 2)
+	{
+		ivec columns(dim), rows;
+		FOR(d, dim) columns[d] = d;
+		std::shared_ptr<const GramMatrix> gram = GramScope::Lookup(gramScope, samples, GramKernel(GRAM_RBF, 1, kernelGamma, 0, columns), rows);
+		if(gram)
+		{
+			kernelMatrix.resize(count, count);
+			FOR(i, count) FOR(j, count) kernelMatrix(i,j) = (*gram)(rows[i], rows[j]);
+		}
+	}
+
 	// we center the data
 	mean = samples[0];
 	FOR(i, count-1) mean += samples[i+1];
@@ -100,7 +116,7 @@ void ClassifierKPCA::Train(std::vector< fvec > samples, ivec labels)
 	pca->gamma = kernelGamma;
     pca->offset = kernelOffset;
 
-	pca->kernel_pca(data, dim);
+	pca->kernel_pca(data, dim, kernelMatrix.size() ? &kernelMatrix : 0);
 	MatrixXd projections = pca->get();
 	results.clear();
 	results.resize(projections.rows());
@@ -145,6 +145,26 @@ float ClassifierLinear::Test(const fvec &sample ) const
     return response;
 }
 
+int ClassifierLinear::TestBatch(const SampleView &samples, fvec &scores) const
+{
+    if(linearType >= 4 || samples.Cols() < 2) return Classifier::TestBatch(samples, scores);
+    // pca, lda and fisher give an affine function of the first two dimensions,
+    // we fold the centering, threshold and normalization in its coefficients
+    float a0 = -W.x, a1 = -W.y;
+    float b = W.x*meanAll.at(0) + W.y*meanAll.at(1) + threshold;
+    if(minResponse != FLT_MAX)
+    {
+        float scale = 6.f/fabs(maxResponse-minResponse);
+        a0 *= scale;
+        a1 *= scale;
+        b = (b - minResponse)*scale - midResponse*6.f;
+    }
+    int rows = samples.Rows();
+    scores.resize(rows);
+    FOR(i, rows) scores[i] = a0*samples(i,0) + a1*samples(i,1) + b;
+    return 1;
+}
+
 const char *ClassifierLinear::GetInfoString() const
 {
 	char *text = new char[1024];
@@ -75,7 +75,7 @@ public:
 	 * @brief Default Constructor
 	 *
 	 */
-    ClassifierLinear() : threshold(0), linearType(0), Transf(0) {bUsesDrawTimer = false;}
+    ClassifierLinear() : threshold(0), linearType(0), Transf(0) {bUsesDrawTimer = false; bThreadSafe = true; bTrainThreadSafe = true;}
     ~ClassifierLinear();
 	/**
 	 * @brief Perform the training, by gather the training parameters from the ui, and then training the corresponding classifier
@@ -90,6 +90,14 @@ public:
 	 * @param sample
 	 */
     float Test(const fvec &sample) const ;
+	/**
+	 * @brief Test all the rows of samples at once, writing one response per row in scores
+	 *
+	 * @param samples
+	 * @param scores
+	 * @return int the number of responses per row (1)
+	 */
+    int TestBatch(const SampleView &samples, fvec &scores) const ;
 	/**
 	 * @brief Get the algorithm information and statistics to be displayed in the main interface
 	 *
@@ -26,6 +26,7 @@ class Kernel
 
 public:
     const MatrixXd & get() const { return _kernel; }
+    void set(const MatrixXd &kernel) { _kernel = kernel; }
     virtual ~Kernel(){}
 
     virtual void Compute(MatrixXd &data)
@@ -232,10 +233,13 @@ public:
     //
     // compute the kernel pca
     //
-    void kernel_pca(MatrixXd & dataPoints, unsigned int dimSpace);
+    // kernelMatrix (if given) is the kernel of the data points, already computed elsewhere
+    void kernel_pca(MatrixXd & dataPoints, unsigned int dimSpace, const MatrixXd *kernelMatrix=0);
     VectorXd project(VectorXd &point);
     MatrixXd project(MatrixXd &dataPoints, unsigned int dimSpace);
     float test(VectorXd point, int dim=0, double multiplier=1.);
+    // same as test for every column of points, the kernel is built once for all of them
+    VectorXd testMany(MatrixXd &points, int dim=0, double multiplier=1.);
     // get
     const MatrixXd & get() const { return _result; }
     PCA& operator= (const PCA &p) {
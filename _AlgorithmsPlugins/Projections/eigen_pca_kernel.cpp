@@ -4,7 +4,7 @@
 #include <algorithm>
 #include <QDebug>
 
-void PCA::kernel_pca(MatrixXd & dataPoints, unsigned int dimSpace)
+void PCA::kernel_pca(MatrixXd & dataPoints, unsigned int dimSpace, const MatrixXd *kernelMatrix)
 {
     int m = dataPoints.rows();
     int n = dataPoints.cols();
@@ -46,7 +46,8 @@ void PCA::kernel_pca(MatrixXd & dataPoints, unsigned int dimSpace)
     default:
         k = new Kernel();
     }
-    k->Compute(dataPoints);
+    if(kernelMatrix) k->set(*kernelMatrix);
+    else k->Compute(dataPoints);
 
     //std::cout << "K:\n" << k->get() << "\n";
 
@@ -172,6 +173,35 @@ float PCA::test(VectorXd point, int dim, double multiplier)
     return result;
 }
 
+VectorXd PCA::testMany(MatrixXd &points, int dim, double multiplier)
+{
+    if(dim >= eigenVectors.cols()) return VectorXd::Zero(points.cols());
+    if(k) delete k; k=0;
+
+    switch(kernelType)
+    {
+    case 0:
+        k = new LinearKernel();
+        break;
+    case 1:
+        k = new PolyKernel(degree, offset);
+        break;
+    case 2:
+        k = new RBFKernel(gamma);
+        break;
+    case 3:
+        k = new TANHKernel(degree, offset);
+        break;
+    default:
+        k = new Kernel();
+    }
+    k->Compute(points, sourcePoints);
+
+    // one product of the kernel block with the eigenvector instead of one sum per point
+    VectorXd result = k->get() * eigenVectors.col(pi[dim].second);
+    return result * multiplier;
+}
+
 VectorXd PCA::project(VectorXd &point)
 {
     int n = eigenVectors.cols();
@@ -234,8 +234,7 @@ void KPCAProjection::GetContoursPixmap(int index)
     }
     //qDebug() << "KPCAProjection::GetContoursPixmap - xIndex:" << xIndex << ", yIndex:" << yIndex << ", zoom:" << zoom << ".";
     double multiplier = 1000.; // this is used to avoid numerical instabilities when computing the contour lines
-    VectorXd point(dim);
-    FOR(d,dim) point(d) = 0.0;
+    MatrixXd points = MatrixXd::Zero(dim, w*h);
     double xdiff = xmax - xmin;
     double ydiff = ymax - ymin;
     //qDebug() << "KPCAProjection::GetContoursPixmap - xmin:" << xmin << ", ymin:" << ymin << ", xman:" << xmax << ", ymax:" << ymax << ".";
@@ -252,14 +251,18 @@ void KPCAProjection::GetContoursPixmap(int index)
     {
         FOR(j, h)
         {
-            if ( xIndex < dim ) point( xIndex ) = i * zxdiff / (double)w + zxmin;
-            if ( yIndex < dim ) point( yIndex ) = j * zydiff / (double)h + zymin;
-            double value = pcaPointer->test( point, index-1, multiplier ); // indices start from 1 in params.dimCountSpin
-            vmin = min(value, vmin);
-            vmax = max(value, vmax);
-            values[j*w + i] = value;
+            if ( xIndex < dim ) points( xIndex, j*w + i ) = i * zxdiff / (double)w + zxmin;
+            if ( yIndex < dim ) points( yIndex, j*w + i ) = j * zydiff / (double)h + zymin;
         }
     }
+    VectorXd pointValues = pcaPointer->testMany( points, index-1, multiplier ); // indices start from 1 in params.dimCountSpin
+    FOR(i, w*h)
+    {
+        double value = pointValues(i);
+        vmin = min(value, vmin);
+        vmax = max(value, vmax);
+        values[i] = value;
+    }
     double vdiff=vmax-vmin;
     //qDebug() << "KPCAProjection::GetContoursPixmap - vmin:" << vmin << ", vmax:" << vmax << " - vdiff: " << vdiff << ".";
     if(vdiff == 0) vdiff = 1.f;
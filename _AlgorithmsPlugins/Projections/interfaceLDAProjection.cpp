@@ -39,7 +39,7 @@ void LDAProjection::DrawInfo(Canvas *canvas, QPainter &painter, Projector *proje
     if(canvas->canvasType) return;
     if(canvas->data->bProjected) return;
     vector<fvec> samples = projector->source;
-    vector<fvec> projected = projector->projected;
+    vector<fvec> projected = projector->ProjectSamples(samples);
     if(!samples.size()) return;
     int xIndex = canvas->xIndex;
     int yIndex = canvas->yIndex;
@@ -49,7 +49,6 @@ void LDAProjection::DrawInfo(Canvas *canvas, QPainter &painter, Projector *proje
     QPointF start(FLT_MAX, FLT_MAX), stop(-FLT_MAX, -FLT_MAX);
     FOR(i, samples.size())
     {
-        projected[i] = projector->Project(samples[i]);
         QPointF p1 = canvas->toCanvasCoords(projected[i]);
         if(start.x() > p1.x()) start = p1;
         if(stop.x() < p1.x()) stop = p1;
@@ -66,7 +65,7 @@ void LDAProjection::DrawModel(Canvas *canvas, QPainter &painter, Projector *proj
     if(canvas->canvasType) return;
     if(canvas->data->bProjected) return;
     vector<fvec> samples = projector->source;
-    vector<fvec> projected = projector->projected;
+    vector<fvec> projected = projector->ProjectSamples(samples);
     ivec labels = canvas->data->GetLabels();
     if(!samples.size()) return;
     int xIndex = canvas->xIndex;
@@ -76,7 +75,6 @@ void LDAProjection::DrawModel(Canvas *canvas, QPainter &painter, Projector *proj
     painter.setPen(QPen(Qt::black,0.5f));
     FOR(i, samples.size())
     {
-        projected[i] = projector->Project(samples[i]);
         QPointF p1 = canvas->toCanvasCoords(samples[i]);
         QPointF p2 = canvas->toCanvasCoords(projected[i]);
         if(xIndex == yIndex)
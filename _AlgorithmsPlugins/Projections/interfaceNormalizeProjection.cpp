@@ -130,14 +130,13 @@ void NormalizeProjection::DrawModel(Canvas *canvas, QPainter &painter, Projector
     if(!canvas || !projector) return;
     if(canvas->canvasType) return;
     vector<fvec> samples = projector->source;
-    vector<fvec> projected = projector->projected;
+    vector<fvec> projected = projector->ProjectSamples(samples);
     ivec labels = canvas->data->GetLabels();
     if(!samples.size()) return;
     painter.setRenderHint(QPainter::Antialiasing);
     painter.setPen(QPen(Qt::black,0.5f));
     FOR(i, samples.size())
     {
-        projected[i] = projector->Project(samples[i]);
         QPointF p1 = canvas->toCanvasCoords(samples[i]);
         QPointF p2 = canvas->toCanvasCoords(projected[i]);
         painter.drawLine(p1, p2);
@@ -90,3 +90,28 @@ fvec ProjectorICA::Project(const fvec &sample)
     newSample *= 0.25f;
     return newSample;
 }
+
+int ProjectorICA::ProjectBatch(const SampleView &samples, fvec &projections)
+{
+    int dim = samples.Cols();
+    if(!Transf || !dim || dim != (int)meanAll.size()) return Projector::ProjectBatch(samples, projections);
+    int rows = samples.Rows();
+    projections.resize((size_t)rows*dim);
+    // Transform works on a whole block of samples stored one after the other
+    const int blockRows = 4096;
+    double *X = new double[min(rows, blockRows)*dim];
+    fvec buffer(dim);
+    for(int start=0; start<rows; start+=blockRows)
+    {
+        int count = min(blockRows, rows-start);
+        FOR(i, count)
+        {
+            samples.CopyRow(start+i, &buffer[0]);
+            FOR(d, dim) X[i*dim + d] = buffer[d];
+        }
+        Transform(X, Transf, dim, count);
+        FOR(i, count*dim) projections[(size_t)start*dim + i] = (float)X[i]*0.25f;
+    }
+    delete [] X;
+    return dim;
+}
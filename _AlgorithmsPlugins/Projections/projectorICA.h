@@ -17,6 +17,7 @@ public:
 
     void Train(std::vector< fvec > samples, ivec labels);
     fvec Project(const fvec &sample);
+    int ProjectBatch(const SampleView &samples, fvec &projections);
     const char *GetInfoString(){return "Independent Component Analysis";}
     double *GetTransf(){return Transf;}
 };
@@ -171,6 +171,31 @@ fvec ProjectorKPCA::Project(const fvec &sample)
     return estimate;
 }
 
+int ProjectorKPCA::ProjectBatch(const SampleView &samples, fvec &projections)
+{
+    int dim = samples.Cols();
+    if(!pca || dim != pca->sourcePoints.rows()) return Projector::ProjectBatch(samples, projections);
+    int rows = samples.Rows();
+    projections.resize(rows);
+    // the kernel block grows with the number of training points, we keep it bounded
+    const int blockRows = 1024;
+    MatrixXd points(dim, min(rows, blockRows));
+    fvec buffer(dim);
+    for(int start=0; start<rows; start+=blockRows)
+    {
+        int count = min(blockRows, rows-start);
+        if(count != points.cols()) points.resize(dim, count);
+        FOR(i, count)
+        {
+            samples.CopyRow(start+i, &buffer[0]);
+            FOR(d, dim) points(d,i) = buffer[d];
+        }
+        VectorXd values = pca->testMany(points);
+        FOR(i, count) projections[start+i] = values(i);
+    }
+    return 1;
+}
+
 void ProjectorKPCA::SetParams(int kernelType, float kernelDegree, float kernelGamma)
 {
     this->kernelType = kernelType;
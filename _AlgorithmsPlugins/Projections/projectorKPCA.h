@@ -42,6 +42,7 @@ public:
     ~ProjectorKPCA();
     void Train(std::vector< fvec > samples, ivec labels);
     fvec Project(const fvec &sample);
+    int ProjectBatch(const SampleView &samples, fvec &projections);
 
     const char *GetInfoString();
     void SetParams(int kernelType, float kernelDegree, float kernelGamma);
@@ -164,12 +164,7 @@ void ProjectorLDA::Train(std::vector< fvec > samples, ivec labels)
     w.resize(dim);
     FOR(d, dim) w[d] = W(d);
 
-    projected = vector<fvec>(samples.size());
-    FOR(i, samples.size())
-    {
-        float p = w*(samples[i]-mean);
-        projected[i] = w*p + mean;
-    }
+    projected = ProjectSamples(samples);
 }
 
 fvec ProjectorLDA::Project(const fvec &sample)
@@ -178,3 +173,22 @@ fvec ProjectorLDA::Project(const fvec &sample)
     return w*p + mean;
 }
 
+int ProjectorLDA::ProjectBatch(const SampleView &samples, fvec &projections)
+{
+    int dim = w.size();
+    if(!dim || samples.Cols() != dim) return Projector::ProjectBatch(samples, projections);
+    int rows = samples.Rows();
+    projections.resize((size_t)rows*dim);
+    fvec buffer(dim);
+    FOR(i, rows)
+    {
+        const float *sample = samples.Contiguous() ? samples.RowData(i) : &buffer[0];
+        if(!samples.Contiguous()) samples.CopyRow(i, &buffer[0]);
+        float p = 0;
+        FOR(d, dim) p += w[d]*(sample[d]-mean[d]);
+        float *projection = &projections[(size_t)i*dim];
+        FOR(d, dim) projection[d] = w[d]*p + mean[d];
+    }
+    return dim;
+}
+
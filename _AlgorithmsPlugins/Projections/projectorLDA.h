@@ -14,6 +14,7 @@ public:
 
     void Train(std::vector< fvec > samples, ivec labels);
     fvec Project(const fvec &sample);
+    int ProjectBatch(const SampleView &samples, fvec &projections);
     const char *GetInfoString(){return "Linear Discriminant Analysis";}
 };
 
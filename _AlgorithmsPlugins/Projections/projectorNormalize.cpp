@@ -41,7 +41,7 @@ void ProjectorNormalize::Train(std::vector< fvec > samples, ivec labels)
     }
     dataSigma /= samples.size();
     dataDiff = dataMax-dataMin;
-    FOR(i, samples.size()) projected[i] = Project(samples[i]);
+    projected = ProjectSamples(samples);
 }
 
 fvec ProjectorNormalize::Project(const fvec &sample)
@@ -79,6 +79,45 @@ fvec ProjectorNormalize::Project(const fvec &sample)
     return newSample;
 }
 
+int ProjectorNormalize::ProjectBatch(const SampleView &samples, fvec &projections)
+{
+    int cols = samples.Cols();
+    if(cols != (int)dim || (int)dataMin.size() != cols) return Projector::ProjectBatch(samples, projections);
+    // every dimension becomes ((x - shift) / divisor) * factor + offset, the ones left untouched keep x
+    fvec shift(cols, 0.f), divisor(cols, 1.f), factor(cols, 1.f), offset(cols, 0.f);
+    FOR(d, cols)
+    {
+        if(dimension >= 0 && dimension < (int)dim && d != dimension) continue;
+        switch(type){
+        case 0: // range
+            shift[d] = dataMin[d];
+            divisor[d] = dataDiff[d];
+            factor[d] = rangeDiff;
+            offset[d] = rangeMin;
+            break;
+        case 1: // variance
+            shift[d] = dataMean[d];
+            divisor[d] = sqrtf(dataSigma[d]);
+            factor[d] = rangeMax;
+            offset[d] = rangeMin;
+            break;
+        case 2: // center
+            shift[d] = dataMean[d];
+            offset[d] = rangeMin;
+            break;
+        }
+    }
+    int rows = samples.Rows();
+    projections.resize((size_t)rows*cols);
+    FOR(i, rows)
+    {
+        float *projection = &projections[(size_t)i*cols];
+        samples.CopyRow(i, projection);
+        FOR(d, cols) projection[d] = ((projection[d] - shift[d]) / divisor[d])*factor[d] + offset[d];
+    }
+    return cols;
+}
+
 void ProjectorNormalize::SetParams(int type, float rangeMin, float rangeMax, int dimension)
 {
     this->type = type;
@@ -16,6 +16,7 @@ public:
 
     void Train(std::vector< fvec > samples, ivec labels);
     fvec Project(const fvec &sample);
+    int ProjectBatch(const SampleView &samples, fvec &projections);
     const char *GetInfoString(){return "Normalization";}
     void SetParams(int type, float rangeMin, float rangeMax, int dimension);
 };
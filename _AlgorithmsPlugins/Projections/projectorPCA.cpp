@@ -133,6 +133,15 @@ void ProjectorPCA::TrainPCA(std::vector<fvec> samples, int pcaCount)
         if(bNan[d] = pca.eigenvalues.at<float>(d) != pca.eigenvalues.at<float>(d)) nanCnt++;
 #endif
     }
+    basis.create(pcaCount-nanCnt, dim, CV_32F);
+    int row = 0;
+    FOR(d, pcaCount)
+    {
+        if(bNan[d]) continue;
+        Mat eigenvector = basis.row(row);
+        pca.eigenvectors.row(d).copyTo(eigenvector);
+        row++;
+    }
     FOR(i, count)
     {
         projected[i].resize(pcaCount-nanCnt);
@@ -178,7 +187,41 @@ void ProjectorPCA::Train(std::vector< fvec > samples, ivec labels)
 
 fvec ProjectorPCA::Project(const fvec &sample)
 {
-    return sample;
+    if(!basis.rows || (int)sample.size() != basis.cols) return sample;
+    const float *mean = pca.mean.ptr<float>(0);
+    fvec projection(basis.rows, 0.f);
+    FOR(c, basis.rows)
+    {
+        const float *eigenvector = basis.ptr<float>(c);
+        FOR(d, basis.cols) projection[c] += (sample[d] - mean[d])*eigenvector[d];
+    }
+    return projection;
+}
+
+int ProjectorPCA::ProjectBatch(const SampleView &samples, fvec &projections)
+{
+    if(!basis.rows || samples.Cols() != basis.cols) return Projector::ProjectBatch(samples, projections);
+    int rows = samples.Rows();
+    int outputs = basis.rows;
+    projections.resize((size_t)rows*outputs);
+    const float *mean = pca.mean.ptr<float>(0);
+    // the samples are centered one block at a time and projected with a single product per block
+    const int blockRows = 4096;
+    Mat centered(min(rows, blockRows), basis.cols, CV_32F);
+    for(int start=0; start<rows; start+=blockRows)
+    {
+        int count = min(blockRows, rows-start);
+        Mat block = centered.rowRange(0, count);
+        FOR(i, count)
+        {
+            float *row = block.ptr<float>(i);
+            samples.CopyRow(start+i, row);
+            FOR(d, basis.cols) row[d] -= mean[d];
+        }
+        Mat output(count, outputs, CV_32F, &projections[(size_t)start*outputs]);
+        gemm(block, basis, 1, Mat(), 0, output, GEMM_2_T);
+    }
+    return outputs;
 }
 
 fvec ProjectorPCA::GetEigenValues()
@@ -13,6 +13,7 @@ using namespace cv;
 class ProjectorPCA : public Projector
 {
     PCA pca;
+    Mat basis; // eigenvectors kept in projected (one per row), used to project new samples
     PCA compressPCA(const Mat& pcaset, int maxComponents, const Mat& testset, Mat& compressed);
     void TrainPCA(std::vector<fvec> samples, int count=2);
 public:
@@ -23,6 +24,7 @@ public:
 
     void Train(std::vector< fvec > samples, ivec labels);
     fvec Project(const fvec &sample);
+    int ProjectBatch(const SampleView &samples, fvec &projections);
     const char *GetInfoString(){return "Principal Component Analysis";}
 
 };
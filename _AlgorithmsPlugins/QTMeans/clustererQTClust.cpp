@@ -82,6 +82,14 @@ fvec ClustererQTClust::Test( const fVec &sample)
 	return res;
 }
 
+fvec ClustererQTClust::TestMany( const fvec &sampleMatrix, const int dim, const int count)
+{
+	fvec res;
+	if(sampleMatrix.size() != dim*count) return res;
+	res.resize(count*centers.size(),0);
+	return res;
+}
+
 void ClustererQTClust::SetParams(double distance, int minCount)
 {
 	this->distance = distance;
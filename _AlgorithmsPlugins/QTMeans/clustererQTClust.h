@@ -40,6 +40,7 @@ public:
 	void Train(std::vector< fvec > samples);
 	fvec Test( const fvec &sample);
 	fvec Test( const fVec &sample);
+	fvec TestMany( const fvec &sampleMatrix, const int dim, const int count);
 	char *GetInfoString();
 
 	void SetParams(double distance, int minCount);
@@ -242,6 +242,27 @@ fvec DynamicalSEDS::Test( const fvec &sample)
 	return res;
 }
 
+void DynamicalSEDS::TestBatch(const SampleView &samples, fvec &velocities)
+{
+    int rows = samples.Rows();
+    int dim = samples.Cols();
+    velocities.resize(rows*dim);
+    if(!gmm || !dim || (int)endpoint.size() < dim)
+    {
+        std::fill(velocities.begin(), velocities.end(), 0.f);
+        return;
+    }
+    fvec point(dim);
+    fvec sigma(dim*(dim+1)/2);
+    FOR(i, rows)
+    {
+        FOR(d, dim) point[d] = (samples(i,d) - endpoint[d])*resizeFactor;
+        float *velocity = &velocities[i*dim];
+        gmm->doRegression(&point[0], velocity, &sigma[0]);
+        FOR(d, dim) velocity[d] /= resizeFactor;
+    }
+}
+
 fVec DynamicalSEDS::Test( const fVec &sample)
 {
 	fVec res;
@@ -51,6 +51,7 @@ public:
     std::vector<fvec> Test( const fvec &sample, const int count);
     fvec Test( const fvec &sample);
     fVec Test( const fVec &sample);
+    void TestBatch(const SampleView &samples, fvec &velocities);
     const char *GetInfoString();
     void SaveModel(string filename);
     bool LoadModel(string filename);
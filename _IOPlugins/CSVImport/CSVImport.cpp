@@ -21,14 +21,79 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 
 Q_EXPORT_PLUGIN2(IO_CSVImport, CSVImport)
 
+// the preview reads the beginning of the file and a sample of lines spread over the rest of it
+static const int previewPrefixRows = 200;
+static const int previewSampledRows = 300;
+static const int previewTimeBudget = 250; // milliseconds
+// the table only shows as many preview rows as fit in this number of cells, for files with many columns
+static const int previewCellBudget = 50000;
+
+void CSVImportThread::Import(QString filename, ivec excludeIndices, int outputColumn, int maxSamples)
+{
+    if(isRunning()) return;
+    this->filename = filename;
+    this->excludeIndices = excludeIndices;
+    this->outputColumn = outputColumn;
+    this->maxSamples = maxSamples;
+    bCanceled = false;
+    bLabelsDropped = false;
+    start();
+}
+
+void CSVImportThread::run()
+{
+    // parsing accounts for the first 80 percents, the progress comes from all the parsing threads
+    std::atomic<int> progress(0);
+    parser->setProgressCallback([&](float fraction)
+    {
+        int percent = (int)(fraction*80);
+        int last = progress;
+        if(percent > last && progress.compare_exchange_strong(last, percent)) emit Progress(percent);
+        return !bCanceled;
+    });
+    parser->parse(filename.toStdString().c_str());
+    parser->setProgressCallback(std::function<bool(float)>());
+    if(bCanceled || !parser->hasData()) return;
+
+    // the parsing drops the empty columns, the preview still has them
+    ivec excluded;
+    FOR(i, excludeIndices.size())
+    {
+        int index = parser->getColumnIndex(excludeIndices[i]);
+        if(index != -1) excluded.push_back(index);
+    }
+    int outputIndex = outputColumn == -1 ? -1 : parser->getColumnIndex(outputColumn);
+    bLabelsDropped = outputColumn != -1 && outputIndex == -1;
+    parser->setOutputColumn(outputIndex);
+
+    // the samples are sent batch by batch as they are read from the parsed file
+    if(!parser->beginData(excluded, maxSamples)) return;
+    int count = parser->getDataCount(), done = 0;
+    vector<fvec> samples;
+    ivec labels;
+    while(!bCanceled && parser->getDataBatch(batchSize, samples, labels))
+    {
+        bool bFirst = done == 0;
+        done += samples.size();
+        emit Batch(samples, labels, bFirst, done == count);
+        emit Progress(80 + 20*done/count);
+    }
+}
+
 CSVImport::CSVImport()
-    : guiDialog(0), gui(0), inputParser(0)
+    : guiDialog(0), gui(0), inputParser(0), importThread(0), rowCount(0), bPartial(false)
 {
 }
 
 CSVImport::~CSVImport()
 {
     if(gui && guiDialog) guiDialog->hide();
+    if(importThread)
+    {
+        importThread->Cancel();
+        importThread->wait();
+    }
+    DEL(importThread);
     DEL(inputParser);
 }
 
@@ -49,10 +114,21 @@ void CSVImport::Start()
         connect(gui->importLimitSpin, SIGNAL(valueChanged(int)), this, SLOT(on_importLimitSpin_valueChanged(int)));
         connect(gui->importLimitCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(on_importLimitCombo_currentIndexChanged(int)));
 //        connect(gui->pcaButton, SIGNAL(clicked()),this,SLOT(on_pcaButton_clicked()));
+        gui->importProgress->hide();
         guiDialog->show();
     }
     else guiDialog->show();
     if(!inputParser) inputParser = new CSVParser();
+    if(!importThread)
+    {
+        // the batches are queued from the import thread
+        qRegisterMetaType<ivec>("ivec");
+        qRegisterMetaType<std::vector<fvec> >("std::vector<fvec>");
+        importThread = new CSVImportThread(inputParser);
+        connect(importThread, SIGNAL(Progress(int)), gui->importProgress, SLOT(setValue(int)));
+        connect(importThread, SIGNAL(Batch(std::vector<fvec>,ivec,bool,bool)), this, SLOT(importBatch(std::vector<fvec>,ivec,bool,bool)));
+        connect(importThread, SIGNAL(finished()), this, SLOT(importFinished()));
+    }
 }
 
 void CSVImport::Stop()
@@ -85,9 +161,10 @@ void CSVImport::LoadFile()
     if(filename.isEmpty()) return;
     Parse(filename);
     gui->tabWidget->setCurrentIndex(0);
-    gui->importLimitSpin->setMaximum(inputParser->getCount());
-    gui->importLimitSpin->setValue(inputParser->getCount());
+    gui->importLimitSpin->setMaximum(rowCount);
+    gui->importLimitSpin->setValue(rowCount);
     gui->importLimitCombo->setEnabled(true);
+    gui->importLimitCombo->clear();
     gui->importLimitCombo->addItem(QString("-->"));
     gui->importLimitCombo->addItem(QString("10%"),QVariant(0.10));
     gui->importLimitCombo->addItem(QString("25%"),QVariant(0.25));
@@ -100,35 +177,44 @@ void CSVImport::LoadFile()
 void CSVImport::Parse(QString filename)
 {
     if(filename.isEmpty()) return;
-    inputParser->clear();
-    inputParser->parse(filename.toStdString().c_str());
-    vector<vector<string> > rawData = inputParser->getRawData();
-    qDebug() << "Dataset extracted";
-    if(rawData.size() < 2) return;
+    this->filename = filename;
+    // the whole file is only parsed when the data is sent, we show a sample of it in the meantime
+    previewRows = inputParser->preview(filename.toStdString().c_str(), previewPrefixRows, previewSampledRows, previewTimeBudget);
+    rowCount = inputParser->getEstimatedCount();
+    FillTable();
+}
+
+void CSVImport::FillTable()
+{
+    if(previewRows.size() < 2) return;
     bool bUseHeader = gui->headerCheck->isChecked();
+    int cols = previewRows[0].size();
+    int rows = min((int)previewRows.size(), max(2, previewCellBudget / max(1, cols)));
 
+    gui->tableWidget->setUpdatesEnabled(false);
     gui->tableWidget->clear();
-    gui->tableWidget->setRowCount(rawData.size());
-    gui->tableWidget->setColumnCount(rawData[0].size());
+    gui->tableWidget->setRowCount(rows - bUseHeader);
+    gui->tableWidget->setColumnCount(cols);
     if(bUseHeader)
     {
         QStringList headerLabels;
-        FOR(i, rawData[0].size())
+        FOR(i, cols)
         {
-            headerLabels <<  QString("%1:").arg(i+1) + rawData[0][i].c_str();
+            headerLabels <<  QString("%1:").arg(i+1) + previewRows[0][i].c_str();
         }
         gui->tableWidget->setHorizontalHeaderLabels(headerLabels);
     }
-    for(size_t r = 0; r < rawData.size(); r++)
+    for(int r = 0; r < rows; r++)
     {
         if(!r && bUseHeader) continue;
-        for(size_t c = 0; c < rawData[r].size(); c++)
+        for(int c = 0; c < (int)previewRows[r].size() && c < cols; c++)
         {
-            QTableWidgetItem *newItem = new  QTableWidgetItem(QString(rawData[r][c].c_str()));
+            QTableWidgetItem *newItem = new  QTableWidgetItem(QString(previewRows[r][c].c_str()));
             gui->tableWidget->setItem(r-bUseHeader, c, newItem);
         }
     }
-    gui->classColumnSpin->setRange(1,rawData[0].size());
+    gui->tableWidget->setUpdatesEnabled(true);
+    gui->classColumnSpin->setRange(1,cols);
 }
 
 void CSVImport::FetchResults(std::vector<fvec> results)
@@ -143,33 +229,7 @@ void CSVImport::classIgnoreChanged()
 
 void CSVImport::headerChanged()
 {
-    vector<vector<string> > rawData = inputParser->getRawData();
-    qDebug() << "Dataset extracted";
-    if(rawData.size() < 2) return;
-    bool bUseHeader = gui->headerCheck->isChecked();
-
-    gui->tableWidget->clear();
-    gui->tableWidget->setRowCount(rawData.size());
-    gui->tableWidget->setColumnCount(rawData[0].size());
-    if(bUseHeader)
-    {
-        QStringList headerLabels;
-        FOR(i, rawData[0].size())
-        {
-            headerLabels <<  QString("%1:").arg(i) + rawData[0][i].c_str();
-        }
-        gui->tableWidget->setHorizontalHeaderLabels(headerLabels);
-    }
-    for(size_t r = 0; r < rawData.size(); r++)
-    {
-        if(!r && bUseHeader) continue;
-        for(size_t c = 0; c < rawData[r].size(); c++)
-        {
-            QTableWidgetItem *newItem = new  QTableWidgetItem(QString(rawData[r][c].c_str()));
-            gui->tableWidget->setItem(r-bUseHeader, c, newItem);
-        }
-    }
-    gui->classColumnSpin->setRange(1,rawData[0].size());
+    FillTable();
 }
 
 void CSVImport::classColumnChanged(int value)
@@ -183,8 +243,17 @@ void CSVImport::classColumnChanged(int value)
 
 void CSVImport::on_dumpButton_clicked()
 {
+    // while importing, the button cancels the import
+    if(importThread->isRunning())
+    {
+        importThread->Cancel();
+        return;
+    }
+    if(filename.isEmpty()) return;
     ivec excludeIndices;
     int maxSamples = gui->importLimitSpin->value();
+    // the number of rows is only estimated until the file has been parsed, 100% takes all of them
+    if(gui->importLimitCombo->currentIndex() == gui->importLimitCombo->count()-1) maxSamples = -1;
     vector<bool> bExcluded(gui->tableWidget->columnCount(), false);
     QModelIndexList indexes = gui->tableWidget->selectionModel()->selection().indexes();
     FOR(i, indexes.count())
@@ -197,14 +266,59 @@ void CSVImport::on_dumpButton_clicked()
         if(bExcluded[i]) excludeIndices.push_back(i);
     }
     inputParser->setFirstRowAsHeader(gui->headerCheck->isChecked());
-    pair<vector<fvec>,ivec> data = inputParser->getData(excludeIndices, maxSamples);
-    emit(SetData(data.first, data.second, vector<ipair>(), false));
+    int outputColumn = gui->classIgnoreCheck->isChecked() ? -1 : gui->classColumnSpin->value()-1;
+    SetImporting(true);
+    importThread->Import(filename, excludeIndices, outputColumn, maxSamples);
+}
+
+void CSVImport::importBatch(std::vector<fvec> samples, ivec labels, bool bFirst, bool bLast)
+{
+    // the first batch replaces the current dataset, the following ones are appended to it
+    // and the dataset stays incomplete until the last one
+    if(bFirst)
+    {
+        emit(SetData(samples, labels, vector<ipair>(), false));
+        if(!bLast) emit(AddData(vector<fvec>(), ivec(), false));
+    }
+    else emit(AddData(samples, labels, bLast));
+    bPartial = !bLast;
+}
+
+void CSVImport::importFinished()
+{
+    // a canceled import leaves what it has sent so far
+    if(bPartial) emit(AddData(vector<fvec>(), ivec(), true));
+    bPartial = false;
+    if(!importThread->IsCanceled() && importThread->LabelsDropped())
+    {
+        QMessageBox labelWarning;
+        labelWarning.setText("The class column is empty: the data was imported without labels");
+        labelWarning.exec();
+    }
+    if(!importThread->IsCanceled() && inputParser->hasData())
+    {
+        rowCount = inputParser->getCount() - (gui->headerCheck->isChecked() ? 1 : 0);
+    }
+    SetImporting(false);
+}
+
+void CSVImport::SetImporting(bool bImporting)
+{
+    gui->loadFile->setEnabled(!bImporting);
+    gui->headerCheck->setEnabled(!bImporting);
+    gui->classColumnSpin->setEnabled(!bImporting);
+    gui->classIgnoreCheck->setEnabled(!bImporting);
+    gui->importLimitCombo->setEnabled(!bImporting);
+    gui->importLimitSpin->setEnabled(!bImporting && gui->importLimitCombo->currentIndex() == 0);
+    gui->dumpButton->setText(bImporting ? "Cancel" : "Send Data");
+    gui->importProgress->setValue(0);
+    gui->importProgress->setVisible(bImporting);
 }
 
 void CSVImport::on_importLimitSpin_valueChanged(int arg1)
 {
     int spinnerValue = gui->importLimitSpin->value();
-    int nbSamples = inputParser->getCount();
+    int nbSamples = rowCount;
     if (nbSamples <= 0) return;
     int percentage = floor(100*spinnerValue/nbSamples);
     // TODO: send that info to status in the plugin
@@ -223,7 +337,7 @@ void CSVImport::on_importLimitCombo_currentIndexChanged(int index)
     else
     {
         gui->importLimitSpin->setEnabled(false);
-        int nbSamples = inputParser->getCount();
+        int nbSamples = rowCount;
         float percentage = gui->importLimitCombo->itemData(index).toFloat();
         gui->importLimitSpin->setValue(floor(nbSamples*percentage));
     }
@@ -32,7 +32,39 @@ Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 #include <QFileDialog>
 #include <QTableView>
 #include <QMessageBox>
+#include <QThread>
 #include <QDebug>
+#include <atomic>
+
+// parses the whole file and sends the samples in batches, away from the gui thread
+class CSVImportThread : public QThread
+{
+    Q_OBJECT
+public:
+    CSVImportThread(CSVParser *parser) : parser(parser), outputColumn(-1), maxSamples(-1), batchSize(50000), bCanceled(false), bLabelsDropped(false){}
+    // the columns are those of the file (as in the preview), outputColumn is -1 when there is none
+    void Import(QString filename, ivec excludeIndices, int outputColumn, int maxSamples);
+    void Cancel(){bCanceled = true;}
+    bool IsCanceled() const {return bCanceled;}
+    bool LabelsDropped() const {return bLabelsDropped;} // the output column was empty and the data has no labels
+
+signals:
+    void Progress(int percent);
+    void Batch(std::vector<fvec> samples, ivec labels, bool bFirst, bool bLast);
+
+protected:
+    void run();
+
+private:
+    CSVParser *parser;
+    QString filename;
+    ivec excludeIndices;
+    int outputColumn;
+    int maxSamples;
+    int batchSize;
+    std::atomic<bool> bCanceled;
+    bool bLabelsDropped;
+};
 
 class CSVImport : public QObject, public InputOutputInterface
 {
@@ -46,6 +78,7 @@ public:
 	const char* QueryClustererSignal() {return SIGNAL(QueryClusterer(std::vector<fvec>));}
 	const char* QueryMaximizerSignal() {return SIGNAL(QueryMaximizer(std::vector<fvec>));}
     const char* SetDataSignal() {return SIGNAL(SetData(std::vector<fvec>, ivec, std::vector<ipair>, bool));}
+    const char* AddDataSignal() {return SIGNAL(AddData(std::vector<fvec>, ivec, bool));}
 	const char* SetTimeseriesSignal() {return SIGNAL(SetTimeseries(std::vector<TimeSerie>));}
 	const char* FetchResultsSlot() {return SLOT(FetchResults(std::vector<fvec>));}
 	const char* DoneSignal() {return SIGNAL(Done(QObject *));}
@@ -62,13 +95,21 @@ private:
     Ui::CSVImportDialog *gui;
 	QDialog *guiDialog;
     CSVParser *inputParser;
+    CSVImportThread *importThread;
+    QString filename;
+    vector< vector<string> > previewRows;
+    int rowCount; // estimated from the preview until the file has been imported
+    bool bPartial; // the batches sent so far are not the whole dataset
 //    QLabel *eigLabel;
 
     bool saveFile(const QString &filename, QIODevice *data);
+    void FillTable();
+    void SetImporting(bool bImporting);
 
 signals:
 	void Done(QObject *);
     void SetData(std::vector<fvec> samples, ivec labels, std::vector<ipair> trajectories, bool bProjected);
+    void AddData(std::vector<fvec> samples, ivec labels, bool bLast);
 	void SetTimeseries(std::vector<TimeSerie> series);
 	void QueryClassifier(std::vector<fvec> samples);
 	void QueryRegressor(std::vector<fvec> samples);
@@ -85,6 +126,8 @@ private slots:
     void headerChanged();
     void classColumnChanged(int value);
     void on_dumpButton_clicked();
+    void importBatch(std::vector<fvec> samples, ivec labels, bool bFirst, bool bLast);
+    void importFinished();
 //    void on_pcaButton_clicked();
     void on_importLimitSpin_valueChanged(int arg1);
     void on_importLimitCombo_currentIndexChanged(int index);